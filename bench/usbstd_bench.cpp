@@ -0,0 +1,1067 @@
+/** usbstd_bench: micro-benchmarks of the usbstd hot paths, with no dependencies beyond the C++ standard library
+ * Every case runs a `usbstd_bench_*` kernel, a non-inlined function wrapping the library code under test, so the
+ * kernel symbol size is the code size of the inlined hot path. Results are the median of several timed repeats.
+ *
+ *   usbstd_bench [-j] [-f filter] [-t ms] [-r repeats] [-c baseline.json]
+ *
+ *   -j              JSON output, one result per line, for comparison across commits
+ *   -f filter       Only run cases whose name contains `filter`
+ *   -t ms           Minimum time of one repeat (default 20)
+ *   -r repeats      Timed repeats per case (default 5)
+ *   -c file         Print ns/op and code size deltas against a previous `-j` output on stderr
+ *
+ * Cycles/op come from the Linux perf cycle counter and are omitted where it is unavailable (e.g. containers).
+ * Build with `-DCMAKE_BUILD_TYPE=Release` (or `RelWithDebInfo`); unoptimised results are flagged in the output.
+*/
+#include <algorithm> //< std::sort
+#include <chrono> //< std::chrono::steady_clock
+#include <cmath> //< std::isnan, NAN
+#include <cstdint> //< uint8_t, uint16_t, uint32_t, uint64_t
+#include <cstdio> //< std::printf, std::fprintf, std::fopen
+#include <cstdlib> //< std::atoi, std::strtod, mkstemp
+#include <cstring> //< std::strcmp, std::strstr, std::memcpy
+#include <memory> //< std::unique_ptr
+#include <string> //< std::string
+#include <string_view> //< std::string_view
+#include <vector> //< std::vector
+
+#if defined(__linux__)
+#include <elf.h> //< Elf64_Ehdr, Elf64_Shdr, Elf64_Sym
+#include <linux/perf_event.h> //< perf_event_attr
+#include <sys/ioctl.h> //< ioctl
+#include <sys/syscall.h> //< SYS_perf_event_open
+#include <unistd.h> //< syscall, read, close, unlink
+#endif
+
+#include "usb_cdc_multiport.hpp" //< usbstd::cdc::MultiPortAcm
+#include "usb_control.hpp" //< usbstd::ControlPipe, usbstd::ControlLoopback
+#include "usb_dfu.hpp" //< usbstd::dfu::FirmwareUpdate, usbstd::dfu::RamFlash
+#include "usb_helper_composite.hpp" //< usbstd::helper::Composite
+#include "usb_helper_descriptorwalker.hpp" //< usbstd::helper::DescriptorRange, usbstd::helper::ConfigurationIndex
+#include "usb_helper_ringbuffer.hpp" //< usbstd::helper::SpscRingBuffer
+#include "usb_helper_router.hpp" //< usbstd::helper::RequestRouter
+#include "usb_helper_msos20.hpp" //< usbstd::helper::msos20
+#include "usb_helper_stringpool.hpp" //< usbstd::helper::StringPool
+#include "usb_helper_stringtable.hpp" //< usbstd::helper::StringDescriptorGenerator, usbstd::helper::StringDescriptorTable
+#include "usb_host_descriptorcache.hpp" //< usbstd::host::DescriptorCache
+#include "usb_host_enumeration.hpp" //< usbstd::host::VirtualDevice, usbstd::host::Enumerator
+
+#define USBSTD_BENCH_KERNEL extern "C" __attribute__((noinline, used))
+
+namespace {
+
+    using Kernel = uint64_t(*)(uint64_t iterations, uint32_t argument);
+
+    struct Case
+    {
+        std::string name;
+        Kernel kernel;
+        const char* symbol; ///< Kernel symbol, for the code size
+        uint32_t argument;
+        double bytesPerOp; ///< Payload bytes per operation, 0 when throughput is meaningless
+    };
+
+    struct Result
+    {
+        std::string name;
+        uint64_t ops = 0;
+        double nsPerOp = 0;
+        double cyclesPerOp = NAN;
+        double bytesPerOp = 0;
+        long codeBytes = -1;
+    };
+
+#if defined(__OPTIMIZE__)
+    constexpr bool Optimized = true;
+#else
+    constexpr bool Optimized = false;
+#endif
+
+    volatile uint64_t sink; //< Kernel checksums land here so the work cannot be optimised away
+
+    /** CPU cycle counter of the calling thread, when the kernel lets us have one
+    */
+    class CycleCounter
+    {
+    public:
+        CycleCounter()
+        {
+#if defined(__linux__)
+            perf_event_attr attr = {};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+        }
+        ~CycleCounter()
+        {
+#if defined(__linux__)
+            if (fd_ >= 0)
+                close(fd_);
+#endif
+        }
+
+        bool available() const { return fd_ >= 0; }
+
+        void start()
+        {
+#if defined(__linux__)
+            if (fd_ >= 0)
+            {
+                ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+        }
+
+        uint64_t stop()
+        {
+            uint64_t cycles = 0;
+#if defined(__linux__)
+            if ((fd_ >= 0) && (ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0) == 0) && (read(fd_, &cycles, sizeof(cycles)) != sizeof(cycles)))
+                cycles = 0;
+#endif
+            return cycles;
+        }
+
+    private:
+        int fd_ = -1;
+    };
+
+    /** Sizes of the `usbstd_bench_*` functions, from the symbol table of our own executable
+    */
+    class SymbolSizes
+    {
+    public:
+        SymbolSizes()
+        {
+#if defined(__linux__)
+            std::FILE* file = std::fopen("/proc/self/exe", "rb");
+            if (file == nullptr)
+                return;
+            std::vector<uint8_t> image;
+            uint8_t block[65536];
+            size_t length;
+            while ((length = std::fread(block, 1, sizeof(block), file)) != 0)
+                image.insert(image.end(), block, block + length);
+            std::fclose(file);
+
+            Elf64_Ehdr header;
+            if ((image.size() < sizeof(header)) || (std::memcmp(image.data(), ELFMAG, SELFMAG) != 0) || (image[EI_CLASS] != ELFCLASS64))
+                return;
+            std::memcpy(&header, image.data(), sizeof(header));
+            if (header.e_shoff + size_t(header.e_shnum) * sizeof(Elf64_Shdr) > image.size())
+                return;
+
+            const auto section = [&](size_t index) {
+                Elf64_Shdr entry;
+                std::memcpy(&entry, image.data() + header.e_shoff + index * sizeof(Elf64_Shdr), sizeof(entry));
+                return entry;
+            };
+            for (size_t i = 0; i < header.e_shnum; ++i)
+            {
+                const Elf64_Shdr symbols = section(i);
+                if ((symbols.sh_type != SHT_SYMTAB) || (symbols.sh_link >= header.e_shnum))
+                    continue;
+                const Elf64_Shdr strings = section(symbols.sh_link);
+                if ((symbols.sh_offset + symbols.sh_size > image.size()) || (strings.sh_offset + strings.sh_size > image.size()))
+                    return;
+                for (size_t offset = 0; offset + sizeof(Elf64_Sym) <= symbols.sh_size; offset += sizeof(Elf64_Sym))
+                {
+                    Elf64_Sym symbol;
+                    std::memcpy(&symbol, image.data() + symbols.sh_offset + offset, sizeof(symbol));
+                    if ((ELF64_ST_TYPE(symbol.st_info) != STT_FUNC) || (symbol.st_name >= strings.sh_size))
+                        continue;
+                    const char* name = reinterpret_cast<const char*>(image.data() + strings.sh_offset + symbol.st_name);
+                    if (std::strncmp(name, "usbstd_bench_", 13) == 0)
+                        sizes_.push_back({ name, static_cast<long>(symbol.st_size) });
+                }
+            }
+#endif
+        }
+
+        /** @return Size in bytes, or -1 when unknown (stripped executable, not ELF)
+        */
+        long find(const char* symbol) const
+        {
+            for (const auto& entry : sizes_)
+                if (entry.first == symbol)
+                    return entry.second;
+            return -1;
+        }
+
+    private:
+        std::vector<std::pair<std::string, long>> sizes_;
+    };
+
+    Result measure(const Case& test, CycleCounter& counter, double minimumNs, int repeats)
+    {
+        using Clock = std::chrono::steady_clock;
+        const auto run = [&](uint64_t iterations, uint64_t* cycles) {
+            const auto start = Clock::now();
+            counter.start();
+            sink = sink + test.kernel(iterations, test.argument);
+            const uint64_t elapsedCycles = counter.stop();
+            const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+            if (cycles != nullptr)
+                *cycles = elapsedCycles;
+            return ns;
+        };
+
+        // Calibrate: grow the iteration count until one repeat takes `minimumNs`
+        uint64_t iterations = 1;
+        for (double ns = run(iterations, nullptr); (ns < minimumNs) && (iterations < (uint64_t(1) << 40)); ns = run(iterations, nullptr))
+            iterations = (ns < minimumNs / 16) ? (iterations * 16) : static_cast<uint64_t>(iterations * (minimumNs * 1.1 / ns)) + 1;
+
+        std::vector<double> nsPerOp;
+        std::vector<double> cyclesPerOp;
+        for (int i = 0; i < repeats; ++i)
+        {
+            uint64_t cycles = 0;
+            nsPerOp.push_back(run(iterations, &cycles) / iterations);
+            if (cycles != 0)
+                cyclesPerOp.push_back(static_cast<double>(cycles) / iterations);
+        }
+        std::sort(nsPerOp.begin(), nsPerOp.end());
+        std::sort(cyclesPerOp.begin(), cyclesPerOp.end());
+
+        Result result;
+        result.name = test.name;
+        result.ops = iterations * repeats;
+        result.nsPerOp = nsPerOp[nsPerOp.size() / 2];
+        if (!cyclesPerOp.empty())
+            result.cyclesPerOp = cyclesPerOp[cyclesPerOp.size() / 2];
+        result.bytesPerOp = test.bytesPerOp;
+        return result;
+    }
+
+    /** Read `"name"`, `"ns_per_op"` and `"code_bytes"` of every result line of a previous `-j` output
+    */
+    std::vector<Result> readBaseline(const char* path)
+    {
+        std::vector<Result> baseline;
+        std::FILE* file = std::fopen(path, "r");
+        if (file == nullptr)
+            return baseline;
+        char line[1024];
+        while (std::fgets(line, sizeof(line), file) != nullptr)
+        {
+            const char* name = std::strstr(line, "\"name\": \"");
+            const char* ns = std::strstr(line, "\"ns_per_op\": ");
+            if ((name == nullptr) || (ns == nullptr))
+                continue;
+            name += 9;
+            const char* end = std::strchr(name, '"');
+            if (end == nullptr)
+                continue;
+            Result result;
+            result.name.assign(name, end);
+            result.nsPerOp = std::strtod(ns + 13, nullptr);
+            if (const char* code = std::strstr(line, "\"code_bytes\": "))
+                result.codeBytes = std::strtol(code + 14, nullptr, 10);
+            baseline.push_back(result);
+        }
+        std::fclose(file);
+        return baseline;
+    }
+
+    std::string jsonNumber(double value)
+    {
+        char text[32];
+        if (std::isnan(value))
+            return "null";
+        std::snprintf(text, sizeof(text), "%.3f", value);
+        return text;
+    }
+
+} //END: anonymous
+
+/// @{ String descriptors
+
+namespace {
+
+    uint16_t updateSerial(char16_t* const string, const uint16_t length)
+    {
+        static uint32_t serial = 0x1234;
+        for (uint16_t i = 0; i < 8; ++i)
+            string[length - 8 + i] = u"0123456789ABCDEF"[(serial >> (28 - 4 * i)) & 0xf];
+        ++serial;
+        return length;
+    }
+
+    // Pooled: "usbstd" is stored once inside the products, U+1F50C takes a surrogate pair
+    constexpr std::string_view benchUtf8Strings[] = { "usbstd", "usbstd benchmark device \xF0\x9F\x94\x8C", "SN00000000", "usbstd Testger\xC3\xA4t \xF0\x9F\x94\x8C" };
+    using BenchStringPool = usbstd::helper::StringPool<benchUtf8Strings>;
+    constexpr size_t BenchStringsUnpooled = usbstd::helper::StringPoolLayout<benchUtf8Strings>::upperBound();
+    static_assert(BenchStringPool::Size < BenchStringsUnpooled, "Equal and embedded strings share the pool");
+    static_assert((BenchStringPool::at(1)[24] == 0xD83D) && (BenchStringPool::at(1)[25] == 0xDD0C), "U+1F50C is a surrogate pair");
+
+    constexpr usbstd::helper::StringTable<3, BenchStringPool::String> benchStrings = {
+         0x0409
+        ,{ BenchStringPool::at(0), BenchStringPool::at(1), BenchStringPool::at(2) }
+        ,{ nullptr, nullptr, updateSerial }
+    };
+
+    constexpr usbstd::helper::MultiLanguageStringTable<2, 3, BenchStringPool::String> benchLanguages = {
+         { 0x0409, 0x0407 }
+        ,{
+             { BenchStringPool::at(0), BenchStringPool::at(1), BenchStringPool::at(2) }
+            ,{ BenchStringPool::at(0), BenchStringPool::at(3), BenchStringPool::at(2) }
+         }
+        ,{ nullptr, nullptr, updateSerial }
+    };
+
+    usbstd::helper::StringDescriptorGenerator<benchStrings> stringGenerator;
+    usbstd::helper::StringDescriptorTable<benchLanguages> stringTable;
+
+} //END: anonymous
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_string_generator(uint64_t iterations, uint32_t index)
+{
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        // Opaque index every iteration, so the loop-invariant generate() is not hoisted out of the loop
+        __asm__ volatile("" : "+r"(index));
+        sum += reinterpret_cast<const uint8_t*>(stringGenerator.generate(static_cast<uint8_t>(index), 0x0409))[0];
+    }
+    return sum;
+}
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_string_table(uint64_t iterations, uint32_t argument)
+{
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        __asm__ volatile("" : "+r"(argument));
+        sum += reinterpret_cast<const uint8_t*>(stringTable.generate(static_cast<uint8_t>(argument), static_cast<uint16_t>(argument >> 16)))[0];
+    }
+    return sum;
+}
+///@}
+
+/// @{ Descriptor walking
+
+namespace {
+
+    using BenchController = usbstd::helper::ControllerTraits<16, 4096>;
+    using BenchDevice = usbstd::helper::Composite<BenchController
+        , usbstd::helper::CdcAcmFunction<>, usbstd::helper::CdcAcmFunction<>, usbstd::helper::VendorFunction<>>;
+
+    constexpr usbstd::ConfigurationDescriptor makeBenchConfiguration()
+    {
+        usbstd::ConfigurationDescriptor configuration = {};
+        configuration.data.bConfigurationValue = 1;
+        configuration.data.bmAttributes = 0x80;
+        configuration.data.bMaxPower = 50;
+        return configuration;
+    }
+
+    constexpr auto benchConfiguration = BenchDevice::configuration(makeBenchConfiguration());
+
+    usbstd::Span<const uint8_t> configurationBytes()
+    {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&benchConfiguration);
+        return { bytes, static_cast<size_t>(bytes[2] | (bytes[3] << 8)) };
+    }
+
+} //END: anonymous
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_descriptor_walk(uint64_t iterations, uint32_t)
+{
+    const usbstd::helper::DescriptorRange range{ configurationBytes() };
+    uint64_t endpoints = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        for (auto descriptor : range)
+            endpoints += (descriptor.as<usbstd::EndpointDescriptor>() != nullptr);
+        __asm__ volatile("" ::: "memory");
+    }
+    return endpoints;
+}
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_descriptor_index(uint64_t iterations, uint32_t)
+{
+    const auto bytes = configurationBytes();
+    usbstd::helper::ConfigurationIndex<> index;
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        sum += index.build(bytes);
+        __asm__ volatile("" ::: "memory");
+    }
+    return sum;
+}
+///@}
+
+/// @{ Request dispatch
+
+namespace {
+
+    using Handler = bool(*)(const usbstd::Request&);
+
+    bool accept(const usbstd::Request&) { return true; }
+
+    constexpr usbstd::helper::Route<Handler> benchRoutes[] = {
+         { usbstd::USB_STANDARD_REQUEST, usbstd::USB_RECIPIENT_DEVICE, usbstd::USB_GET_DESCRIPTOR, accept }
+        ,{ usbstd::USB_STANDARD_REQUEST, usbstd::USB_RECIPIENT_DEVICE, usbstd::USB_SET_ADDRESS, accept }
+        ,{ usbstd::USB_STANDARD_REQUEST, usbstd::USB_RECIPIENT_DEVICE, usbstd::USB_SET_CONFIGURATION, accept }
+        ,{ usbstd::USB_STANDARD_REQUEST, usbstd::USB_RECIPIENT_INTERFACE, usbstd::USB_GET_INTERFACE, accept }
+        ,{ usbstd::USB_STANDARD_REQUEST, usbstd::USB_RECIPIENT_ENDPOINT, usbstd::USB_CLEAR_FEATURE, accept }
+        ,{ usbstd::USB_CLASS_REQUEST, usbstd::USB_RECIPIENT_INTERFACE, usbstd::USB_CDC_SET_LINE_CODING, accept, 0 }
+        ,{ usbstd::USB_CLASS_REQUEST, usbstd::USB_RECIPIENT_INTERFACE, usbstd::USB_CDC_SET_CONTROL_LINE_STATE, accept, 0 }
+        ,{ usbstd::USB_VENDOR_REQUEST, usbstd::USB_RECIPIENT_DEVICE, 0x20, accept }
+    };
+    using BenchRouter = usbstd::helper::RequestRouter<benchRoutes>;
+
+    constexpr usbstd::Request benchRequests[8] = {
+         { 0x80, usbstd::USB_GET_DESCRIPTOR, 0x0100, 0, 18 }
+        ,{ 0x00, usbstd::USB_SET_ADDRESS, 5, 0, 0 }
+        ,{ 0x80, usbstd::USB_GET_DESCRIPTOR, 0x0200, 0, 255 }
+        ,{ 0x00, usbstd::USB_SET_CONFIGURATION, 1, 0, 0 }
+        ,{ 0x21, usbstd::USB_CDC_SET_LINE_CODING, 0, 0, 7 }
+        ,{ 0x21, usbstd::USB_CDC_SET_CONTROL_LINE_STATE, 3, 0, 0 }
+        ,{ 0xa1, 0x7f, 0, 2, 0 } //< Unrouted
+        ,{ 0xc0, 0x20, 0, 0, 64 }
+    };
+
+    usbstd::ControlLoopback loopback;
+    usbstd::ControlPipe<usbstd::ControlLoopback> controlPipe{ loopback, 64 };
+
+} //END: anonymous
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_dispatch_router(uint64_t iterations, uint32_t)
+{
+    uint64_t routed = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const usbstd::Request& request = benchRequests[i & 7];
+        if (const auto handler = BenchRouter::find(request))
+            routed += handler(request);
+    }
+    return routed;
+}
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_control_in(uint64_t iterations, uint32_t wLength)
+{
+    // Configuration descriptor header from RAM, the rest of the blob from ROM
+    const auto bytes = configurationBytes();
+    uint8_t header[9];
+    std::memcpy(header, bytes.data(), sizeof(header));
+    const usbstd::Request request = { 0x80, usbstd::USB_GET_DESCRIPTOR, 0x0200, 0, static_cast<uint16_t>(wLength) };
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        sum += static_cast<uint64_t>(loopback.transfer(controlPipe, request, usbstd::Span<uint8_t>{}, [&](auto& ep0) {
+            ep0.send({ usbstd::Span<const uint8_t>{ header }, bytes.subspan(sizeof(header)) });
+        }));
+    }
+    return sum;
+}
+#if defined(USBSTD_BENCH_ASYNC)
+extern "C" uint64_t usbstd_bench_control_async(uint64_t iterations, uint32_t argument); //< bench/usbstd_bench_async.cpp, C++20
+#endif
+///@}
+
+/// @{ DFU
+
+namespace {
+
+    using BenchFlash = usbstd::dfu::RamFlash<16384, 4096>;
+    using BenchDfu = usbstd::dfu::FirmwareUpdate<BenchFlash, 256, 3>;
+
+    uint32_t dfuMicros()
+    {
+        static uint32_t now = 0;
+        return now += 10;
+    }
+
+    BenchFlash dfuFlash;
+    BenchDfu dfu{ dfuFlash, dfuMicros };
+    usbstd::ControlLoopback dfuLoopback;
+    usbstd::ControlPipe<usbstd::ControlLoopback> dfuPipe{ dfuLoopback, 64 };
+    uint8_t dfuImages[2][8192];
+
+    /** DFU class request to interface 0, as the host sends it
+     * @return Data stage bytes, or -1 when the device stalled
+    */
+    long dfuRequest(uint8_t bRequest, usbstd::Span<uint8_t> data = {})
+    {
+        const bool in = (bRequest == usbstd::USB_DFU_UPLOAD) || (bRequest == usbstd::USB_DFU_GETSTATUS) || (bRequest == usbstd::USB_DFU_GETSTATE);
+        const usbstd::Request request = { static_cast<uint8_t>(in ? 0xa1 : 0x21), bRequest, 0, 0, static_cast<uint16_t>(data.size()) };
+        return dfuLoopback.transfer(dfuPipe, request, data, [](auto& ep0) {
+            if (ep0.stage() == usbstd::ControlStage::Setup)
+                dfu.setup(ep0);
+            else
+                dfu.dataReceived(ep0);
+        });
+    }
+
+    /** GETSTATUS until the device leaves `DnBusy`/`Manifest`, running the task between polls
+     * @return State after the last GETSTATUS
+    */
+    usbstd::dfu::State dfuSettle()
+    {
+        uint8_t status[6] = {};
+        for (int poll = 0; poll < 16; ++poll)
+        {
+            if (dfuRequest(usbstd::USB_DFU_GETSTATUS, status) != sizeof(status))
+                return usbstd::dfu::State::Error;
+            const auto state = static_cast<usbstd::dfu::State>(status[4]);
+            if ((state != usbstd::dfu::State::DnBusy) && (state != usbstd::dfu::State::Manifest) && (state != usbstd::dfu::State::ManifestSync))
+                return state;
+            dfu.process();
+        }
+        return usbstd::dfu::State::Error;
+    }
+
+    /** Download `length` bytes of `image` in 256-byte blocks and manifest it
+     * @return `true` when the device returned to `DfuIdle` without error
+    */
+    bool dfuDownload(uint8_t* image, size_t length)
+    {
+        for (size_t offset = 0; offset < length; offset += 256)
+        {
+            if ((dfuRequest(usbstd::USB_DFU_DNLOAD, { image + offset, 256 }) != 256) || (dfuSettle() != usbstd::dfu::State::DnloadIdle))
+                return false;
+            dfu.process();
+        }
+        return (dfuRequest(usbstd::USB_DFU_DNLOAD) == 0) && (dfuSettle() == usbstd::dfu::State::DfuIdle) && (dfu.status() == usbstd::dfu::Status::Ok);
+    }
+
+} //END: anonymous
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_dfu_download(uint64_t iterations, uint32_t length)
+{
+    // One operation: DNLOAD of a `length` byte image, from the first block to the manifestation
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+        sum += dfuDownload(dfuImages[i & 1], length) ? length : 0;
+    return sum;
+}
+///@}
+
+/// @{ Enumeration
+
+namespace {
+
+    constexpr uint8_t BenchVendorCode = 0x20;
+
+    constexpr usbstd::DeviceDescriptor makeBenchDevice()
+    {
+        usbstd::DeviceDescriptor device = {};
+        device.data.bcdUSB = 0x0201;
+        device.data.bDeviceClass = 0xef; //< Miscellaneous, Interface Association
+        device.data.bDeviceSubClass = 0x02;
+        device.data.bDeviceProtocol = 0x01;
+        device.data.bMaxPacketSize0 = 64;
+        device.data.idVendor = 0x1209;
+        device.data.idProduct = 0x0001;
+        device.data.bcdDevice = 0x0100;
+        device.data.iManufacturer = 1;
+        device.data.iProduct = 2;
+        device.data.iSerialNumber = 3;
+        device.data.bNumConfigurations = 1;
+        return device;
+    }
+
+    constexpr auto benchDevice = makeBenchDevice();
+    constexpr auto benchMsOs20Set = usbstd::helper::msos20::descriptorSet(
+        usbstd::helper::msos20::configuration(0,
+            usbstd::helper::msos20::function(4, usbstd::helper::msos20::compatibleId("WINUSB")
+                , usbstd::helper::msos20::registryMultiString(u"DeviceInterfaceGUIDs", u"{a8e0f7c2-5d1b-4c3e-9f2a-6b7d8e9f0a1b}")) ));
+    constexpr auto benchBos = usbstd::helper::makeBos(usbstd::helper::msos20::capability(benchMsOs20Set, BenchVendorCode));
+
+    usbstd::host::VirtualDevice<decltype(stringTable)> virtualDevice{
+        { reinterpret_cast<const uint8_t*>(&benchDevice), sizeof(benchDevice) }, configurationBytes(), stringTable
+        , { benchBos.data(), benchBos.size() }, { benchMsOs20Set.data(), benchMsOs20Set.size() }, BenchVendorCode };
+    usbstd::host::Enumerator enumerator;
+    usbstd::host::EnumerationResult enumerationResult;
+
+} //END: anonymous
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_enumeration(uint64_t iterations, uint32_t)
+{
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+        sum += enumerator.run(virtualDevice, enumerationResult);
+    return sum;
+}
+///@}
+
+/// @{ Descriptor cache
+
+namespace {
+
+    std::unique_ptr<usbstd::host::DescriptorCache<>> descriptorCache; //< In an unlinked temporary file, see `main()`
+
+} //END: anonymous
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_cache_cold(uint64_t iterations, uint32_t)
+{
+    // A device not seen before: hash and walk the descriptors, as every lookup without the cache
+    const auto bytes = configurationBytes();
+    usbstd::host::DescriptorCache<>::Entry entry;
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        sum += usbstd::host::DescriptorCache<>::key(benchDevice, bytes).hash;
+        sum += entry.index.build(bytes);
+        __asm__ volatile("" ::: "memory");
+    }
+    return sum;
+}
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_cache_warm(uint64_t iterations, uint32_t)
+{
+    const auto bytes = configurationBytes();
+    usbstd::host::DescriptorCache<>::Entry entry;
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+        sum += descriptorCache->lookup(benchDevice, bytes, entry) && entry.cached;
+    return sum;
+}
+///@}
+
+/// @{ Wire field access
+
+namespace {
+
+#pragma pack(push, 1)
+
+    /// Endpoint and device descriptors as declared before `usb_endian.hpp`: C bitfields and native-endian integers
+    struct BitfieldEndpointDescriptor
+    {
+        uint8_t bLength;
+        uint8_t bDescriptorType;
+        uint8_t bEndpointAddress;
+        struct { uint8_t xfer : 2; uint8_t sync : 2; uint8_t usage : 2; uint8_t : 2; } bmAttributes;
+        struct { uint16_t size : 11; uint16_t hs_period_mult : 2; uint16_t : 3; } wMaxPacketSize;
+        uint8_t bInterval;
+    };
+
+    struct NativeDeviceDescriptor
+    {
+        uint8_t bLength;
+        uint8_t bDescriptorType;
+        uint16_t bcdUSB;
+        uint8_t bDeviceClass;
+        uint8_t bDeviceSubClass;
+        uint8_t bDeviceProtocol;
+        uint8_t bMaxPacketSize0;
+        uint16_t idVendor;
+        uint16_t idProduct;
+        uint16_t bcdDevice;
+        uint8_t iManufacturer;
+        uint8_t iProduct;
+        uint8_t iSerialNumber;
+        uint8_t bNumConfigurations;
+    };
+
+#pragma pack(pop)
+
+    static_assert(sizeof(BitfieldEndpointDescriptor) == sizeof(usbstd::EndpointDescriptor), "size is not correct");
+    static_assert(sizeof(NativeDeviceDescriptor) == sizeof(usbstd::DeviceDescriptor), "size is not correct");
+
+    constexpr size_t WireDescriptors = 64;
+
+    /// Back to back, so most fields are unaligned as in a configuration blob
+    struct WireDescriptorBlobs
+    {
+        uint8_t endpoints[WireDescriptors * sizeof(usbstd::EndpointDescriptor)];
+        uint8_t devices[WireDescriptors * sizeof(usbstd::DeviceDescriptor)];
+
+        WireDescriptorBlobs()
+        {
+            for (size_t i = 0; i < WireDescriptors; ++i)
+            {
+                usbstd::EndpointDescriptor endpoint = {};
+                endpoint.data.bEndpointAddress = static_cast<uint8_t>(0x81 + (i & 7));
+                endpoint.data.bmAttributes.xfer(static_cast<uint8_t>(i & 3));
+                endpoint.data.wMaxPacketSize.size(static_cast<uint16_t>(8 << (i & 7)));
+                endpoint.data.wMaxPacketSize.hsPeriodMult(static_cast<uint8_t>(i % 3));
+                endpoint.data.bInterval = 1;
+                std::memcpy(endpoints + i * sizeof(endpoint), &endpoint, sizeof(endpoint));
+
+                usbstd::DeviceDescriptor device = benchDevice;
+                device.data.idProduct = static_cast<uint16_t>(i);
+                device.data.bcdDevice = static_cast<uint16_t>(0x0100 + i);
+                std::memcpy(devices + i * sizeof(device), &device, sizeof(device));
+            }
+        }
+    };
+
+    const WireDescriptorBlobs wireBlobs;
+
+} //END: anonymous
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_wire_endpoint_bitfield(uint64_t iterations, uint32_t)
+{
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        for (size_t e = 0; e < WireDescriptors; ++e)
+        {
+            const auto* endpoint = reinterpret_cast<const BitfieldEndpointDescriptor*>(wireBlobs.endpoints + e * sizeof(BitfieldEndpointDescriptor));
+            sum += endpoint->wMaxPacketSize.size * (1u + endpoint->wMaxPacketSize.hs_period_mult) + endpoint->bmAttributes.xfer;
+        }
+        __asm__ volatile("" ::: "memory");
+    }
+    return sum;
+}
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_wire_endpoint_accessor(uint64_t iterations, uint32_t)
+{
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        for (size_t e = 0; e < WireDescriptors; ++e)
+        {
+            const auto& data = reinterpret_cast<const usbstd::EndpointDescriptor*>(wireBlobs.endpoints + e * sizeof(usbstd::EndpointDescriptor))->data;
+            sum += data.wMaxPacketSize.size() * (1u + data.wMaxPacketSize.hsPeriodMult()) + data.bmAttributes.xfer();
+        }
+        __asm__ volatile("" ::: "memory");
+    }
+    return sum;
+}
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_wire_device_native(uint64_t iterations, uint32_t)
+{
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        for (size_t d = 0; d < WireDescriptors; ++d)
+        {
+            const auto* device = reinterpret_cast<const NativeDeviceDescriptor*>(wireBlobs.devices + d * sizeof(NativeDeviceDescriptor));
+            sum += device->bcdUSB + device->idVendor + device->idProduct + device->bcdDevice;
+        }
+        __asm__ volatile("" ::: "memory");
+    }
+    return sum;
+}
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_wire_device_le(uint64_t iterations, uint32_t)
+{
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        for (size_t d = 0; d < WireDescriptors; ++d)
+        {
+            const auto& data = reinterpret_cast<const usbstd::DeviceDescriptor*>(wireBlobs.devices + d * sizeof(usbstd::DeviceDescriptor))->data;
+            sum += data.bcdUSB + data.idVendor + data.idProduct + data.bcdDevice;
+        }
+        __asm__ volatile("" ::: "memory");
+    }
+    return sum;
+}
+///@}
+
+/// @{ CDC ring buffer
+
+namespace {
+
+    usbstd::helper::SpscRingBuffer<1024> ring;
+
+} //END: anonymous
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_ringbuffer(uint64_t iterations, uint32_t packetSize)
+{
+    uint8_t packet[512] = {};
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        packet[0] = static_cast<uint8_t>(i);
+        ring.write(packet, packetSize);
+        sum += ring.read(packet, packetSize);
+    }
+    return sum + packet[0];
+}
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_ringbuffer_inplace(uint64_t iterations, uint32_t packetSize)
+{
+    // Zero-copy path: receive into reserved space, consume from the peeked span
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        auto space = ring.reserve();
+        const size_t count = (space.size() < packetSize) ? space.size() : packetSize;
+        space[0] = static_cast<uint8_t>(i);
+        ring.commit(count);
+        const auto filled = ring.peek();
+        sum += filled.first[0];
+        ring.consume(filled.size());
+    }
+    return sum;
+}
+///@}
+
+/// @{ Multi-port CDC-ACM
+
+namespace {
+
+    using BenchSerial = usbstd::cdc::MultiPortAcm<8, 1024, 1024>;
+    BenchSerial benchSerial;
+
+} //END: anonymous
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_multiport_transmit(uint64_t iterations, uint32_t busyPorts)
+{
+    // Ports below `busyPorts` stream and are refilled as they drain, the others get a byte every 16 transfers;
+    // one operation schedules and completes one bulk IN transfer
+    for (auto tx = benchSerial.nextTransmit(); tx.port != BenchSerial::NoPort; tx = benchSerial.nextTransmit())
+        benchSerial.transmitComplete(tx.port, tx.data.size());
+    for (uint32_t port = 0; port < busyPorts; ++port)
+        benchSerial.port(port).commit(benchSerial.port(port).writable().size());
+
+    const uint32_t quietPorts = BenchSerial::PortCount - busyPorts;
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        if ((quietPorts != 0) && ((i & 15) == 0))
+        {
+            const uint8_t byte = static_cast<uint8_t>(i);
+            benchSerial.port(busyPorts + (i >> 4) % quietPorts).write(&byte, 1);
+        }
+        const auto tx = benchSerial.nextTransmit();
+        if (tx.port == BenchSerial::NoPort)
+            continue;
+        sum += tx.port + tx.data.size();
+        benchSerial.transmitComplete(tx.port, tx.data.size());
+        if (tx.port < busyPorts)
+            benchSerial.port(tx.port).commit(tx.data.size());
+    }
+    return sum;
+}
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_multiport_notify(uint64_t iterations, uint32_t burst)
+{
+    // One operation: `burst` serial state changes on every port, collapsed into one notification per port
+    constexpr uint16_t Dcd = static_cast<uint16_t>(usbstd::CdcState::Dcd);
+    constexpr uint16_t Dsr = static_cast<uint16_t>(usbstd::CdcState::Dsr);
+    constexpr uint16_t Overrun = static_cast<uint16_t>(usbstd::CdcState::Overrun);
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        for (size_t port = 0; port < BenchSerial::PortCount; ++port)
+        {
+            for (uint32_t change = 0; change < burst; ++change)
+                benchSerial.serialState(port, static_cast<uint16_t>(Dcd | (((i + change) & 1) ? Dsr : 0) | ((change + 1 == burst) ? Overrun : 0)));
+        }
+        for (size_t port = 0; port < BenchSerial::PortCount; ++port)
+        {
+            const auto notification = benchSerial.nextNotification(port);
+            sum += notification.size();
+            if (!notification.empty())
+                benchSerial.notificationComplete(port);
+        }
+    }
+    return sum;
+}
+///@}
+
+int main(int argc, char* argv[])
+{
+    bool json = false;
+    const char* filter = nullptr;
+    const char* baselinePath = nullptr;
+    double minimumMs = 20;
+    int repeats = 5;
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = (i + 1 < argc);
+        if (std::strcmp(argv[i], "-j") == 0)
+            json = true;
+        else if ((std::strcmp(argv[i], "-f") == 0) && hasValue)
+            filter = argv[++i];
+        else if ((std::strcmp(argv[i], "-t") == 0) && hasValue)
+            minimumMs = std::strtod(argv[++i], nullptr);
+        else if ((std::strcmp(argv[i], "-r") == 0) && hasValue)
+            repeats = std::atoi(argv[++i]);
+        else if ((std::strcmp(argv[i], "-c") == 0) && hasValue)
+            baselinePath = argv[++i];
+        else
+        {
+            std::fprintf(stderr, "usage: %s [-j] [-f filter] [-t ms] [-r repeats] [-c baseline.json]\n", argv[0]);
+            return 2;
+        }
+    }
+    if ((repeats < 1) || !(minimumMs > 0))
+    {
+        std::fprintf(stderr, "%s: invalid configuration\n", argv[0]);
+        return 2;
+    }
+
+    // Both string-descriptor paths return the pooled UTF-16, surrogate pair included
+    for (uint8_t index = 1; index <= 2; ++index)
+    {
+        const auto expected = BenchStringPool::at(index - 1).view(); //< Descriptor indices are 1-based
+        const auto* generated = reinterpret_cast<const uint8_t*>(stringGenerator.generate(index, 0x0409));
+        const auto* stored = reinterpret_cast<const uint8_t*>(stringTable.generate(index, 0x0409));
+        if ((generated[0] != 2 + 2 * expected.size()) || (std::memcmp(generated + 2, expected.data(), 2 * expected.size()) != 0)
+            || (std::memcmp(stored, generated, generated[0]) != 0))
+        {
+            std::fprintf(stderr, "%s: string descriptor %u does not match the string pool\n", argv[0], unsigned(index));
+            return 1;
+        }
+    }
+
+    std::vector<Case> cases;
+    for (uint32_t index = 0; index <= 3; ++index)
+        cases.push_back({ "string/generator/" + std::to_string(index), usbstd_bench_string_generator, "usbstd_bench_string_generator", index, 0 });
+    for (uint16_t langid : { 0x0409, 0x0407 })
+    {
+        char language[8];
+        std::snprintf(language, sizeof(language), "%04x", langid);
+        for (uint32_t index = 0; index <= 3; ++index)
+            cases.push_back({ std::string("string/table/") + language + "/" + std::to_string(index), usbstd_bench_string_table, "usbstd_bench_string_table", (uint32_t(langid) << 16) | index, 0 });
+    }
+    const double configurationSize = static_cast<double>(configurationBytes().size());
+    cases.push_back({ "descriptor/walk", usbstd_bench_descriptor_walk, "usbstd_bench_descriptor_walk", 0, configurationSize });
+    cases.push_back({ "descriptor/index", usbstd_bench_descriptor_index, "usbstd_bench_descriptor_index", 0, configurationSize });
+    cases.push_back({ "dispatch/router", usbstd_bench_dispatch_router, "usbstd_bench_dispatch_router", 0, 0 });
+    cases.push_back({ "dispatch/control_in/9", usbstd_bench_control_in, "usbstd_bench_control_in", 9, 9 });
+    cases.push_back({ "dispatch/control_in/full", usbstd_bench_control_in, "usbstd_bench_control_in", 0xffff, configurationSize });
+#if defined(USBSTD_BENCH_ASYNC)
+    cases.push_back({ "dispatch/control_async", usbstd_bench_control_async, "usbstd_bench_control_async", 0, 0 });
+#endif
+    cases.push_back({ "dfu/download/4096", usbstd_bench_dfu_download, "usbstd_bench_dfu_download", 4096, 4096 });
+    {
+        // One enumeration up front, for its data stage bytes and as a check the sequence completes
+        usbstd::host::EnumerationResult probe;
+        if (!enumerator.run(virtualDevice, probe))
+        {
+            std::fprintf(stderr, "%s: enumeration failed at %s\n", argv[0], usbstd::host::stageName(probe.failedStage));
+            return 1;
+        }
+        cases.push_back({ "enumeration/full", usbstd_bench_enumeration, "usbstd_bench_enumeration", 0, double(probe.total().bytes) });
+    }
+    {
+        char path[] = "/tmp/usbstd_bench_cacheXXXXXX";
+        const int fd = ::mkstemp(path);
+        if (fd >= 0)
+        {
+            ::close(fd);
+            descriptorCache = std::make_unique<usbstd::host::DescriptorCache<>>(path);
+            ::unlink(path); //< The mapping keeps the file alive
+        }
+        usbstd::host::DescriptorCache<>::Entry entry;
+        if (!descriptorCache || !descriptorCache->ready() || !descriptorCache->lookup(benchDevice, configurationBytes(), entry))
+        {
+            std::fprintf(stderr, "%s: cannot create the descriptor cache\n", argv[0]);
+            return 1;
+        }
+        cases.push_back({ "cache/cold", usbstd_bench_cache_cold, "usbstd_bench_cache_cold", 0, configurationSize });
+        cases.push_back({ "cache/warm", usbstd_bench_cache_warm, "usbstd_bench_cache_warm", 0, configurationSize });
+    }
+    const double endpointBytes = static_cast<double>(sizeof(wireBlobs.endpoints));
+    const double deviceBytes = static_cast<double>(sizeof(wireBlobs.devices));
+    cases.push_back({ "wire/endpoint/bitfield", usbstd_bench_wire_endpoint_bitfield, "usbstd_bench_wire_endpoint_bitfield", 0, endpointBytes });
+    cases.push_back({ "wire/endpoint/accessor", usbstd_bench_wire_endpoint_accessor, "usbstd_bench_wire_endpoint_accessor", 0, endpointBytes });
+    cases.push_back({ "wire/device/native", usbstd_bench_wire_device_native, "usbstd_bench_wire_device_native", 0, deviceBytes });
+    cases.push_back({ "wire/device/le", usbstd_bench_wire_device_le, "usbstd_bench_wire_device_le", 0, deviceBytes });
+    for (uint32_t packetSize : { 8u, 64u, 512u })
+    {
+        cases.push_back({ "cdc/ringbuffer/copy/" + std::to_string(packetSize), usbstd_bench_ringbuffer, "usbstd_bench_ringbuffer", packetSize, double(packetSize) });
+        cases.push_back({ "cdc/ringbuffer/inplace/" + std::to_string(packetSize), usbstd_bench_ringbuffer_inplace, "usbstd_bench_ringbuffer_inplace", packetSize, double(packetSize) });
+    }
+    for (uint32_t busyPorts : { 1u, 7u })
+        cases.push_back({ "cdc/multiport/transmit/" + std::to_string(busyPorts), usbstd_bench_multiport_transmit, "usbstd_bench_multiport_transmit", busyPorts, 0 });
+    for (uint32_t burst : { 1u, 16u })
+        cases.push_back({ "cdc/multiport/notify/" + std::to_string(burst), usbstd_bench_multiport_notify, "usbstd_bench_multiport_notify", burst, 0 });
+
+    CycleCounter counter;
+    const SymbolSizes symbols;
+    std::vector<Result> results;
+    for (const auto& test : cases)
+    {
+        if ((filter != nullptr) && (test.name.find(filter) == std::string::npos))
+            continue;
+        Result result = measure(test, counter, minimumMs * 1e6, repeats);
+        result.codeBytes = symbols.find(test.symbol);
+        results.push_back(result);
+    }
+
+    if (json)
+    {
+        std::printf("{\n  \"usbstd_bench\": 1,\n  \"optimized\": %s,\n  \"cycles\": %s,\n  \"results\": [\n"
+            , Optimized ? "true" : "false", counter.available() ? "true" : "false");
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const auto& result = results[i];
+            std::printf("    { \"name\": \"%s\", \"ops\": %llu, \"ns_per_op\": %s, \"cycles_per_op\": %s, \"bytes_per_op\": %s, \"code_bytes\": %s }%s\n"
+                , result.name.c_str(), static_cast<unsigned long long>(result.ops), jsonNumber(result.nsPerOp).c_str()
+                , jsonNumber(result.cyclesPerOp).c_str(), jsonNumber(result.bytesPerOp).c_str()
+                , (result.codeBytes >= 0) ? std::to_string(result.codeBytes).c_str() : "null", (i + 1 < results.size()) ? "," : "");
+        }
+        std::printf("  ],\n  \"enumeration_stages\": [\n");
+        for (size_t i = 0; i < usbstd::host::EnumerationResult::StageCount; ++i)
+        {
+            const auto& stage = enumerationResult.stages[i];
+            std::printf("    { \"name\": \"%s\", \"transfers\": %llu, \"bytes\": %llu, \"stalls\": %llu, \"handler_ns\": %llu }%s\n"
+                , usbstd::host::stageName(static_cast<usbstd::host::EnumerationStage>(i)), static_cast<unsigned long long>(stage.transfers)
+                , static_cast<unsigned long long>(stage.bytes), static_cast<unsigned long long>(stage.stalls)
+                , static_cast<unsigned long long>(stage.handlerNanos), (i + 1 < usbstd::host::EnumerationResult::StageCount) ? "," : "");
+        }
+        std::printf("  ],\n  \"enumerations\": %llu,\n", static_cast<unsigned long long>(enumerationResult.enumerations));
+        std::printf("  \"string_pool\": { \"strings\": %zu, \"words\": %zu, \"unpooled_words\": %zu }\n}\n"
+            , BenchStringPool::Count, BenchStringPool::Size, BenchStringsUnpooled);
+    }
+    else
+    {
+        if (!Optimized)
+            std::printf("warning: unoptimised build, results are not representative\n");
+        std::printf("%-32s %12s %12s %12s %10s\n", "case", "ns/op", "cycles/op", "MB/s", "code");
+        for (const auto& result : results)
+        {
+            std::printf("%-32s %12.2f %12s %12s %10s\n", result.name.c_str(), result.nsPerOp
+                , std::isnan(result.cyclesPerOp) ? "-" : jsonNumber(result.cyclesPerOp).c_str()
+                , (result.bytesPerOp != 0) ? jsonNumber(result.bytesPerOp * 1e3 / result.nsPerOp).c_str() : "-"
+                , (result.codeBytes >= 0) ? std::to_string(result.codeBytes).c_str() : "-");
+        }
+        std::printf("\nstring pool: %zu strings in %zu UTF-16 words, %zu unpooled\n"
+            , BenchStringPool::Count, BenchStringPool::Size, BenchStringsUnpooled);
+
+        if (enumerationResult.enumerations != 0)
+        {
+            // Per enumeration averages over every timed run
+            const double enumerations = static_cast<double>(enumerationResult.enumerations);
+            std::printf("\n%-32s %12s %12s %12s\n", "enumeration stage", "transfers", "bytes", "handler ns");
+            for (size_t i = 0; i < usbstd::host::EnumerationResult::StageCount; ++i)
+            {
+                const auto& stage = enumerationResult.stages[i];
+                std::printf("%-32s %12.1f %12.1f %12.1f\n", usbstd::host::stageName(static_cast<usbstd::host::EnumerationStage>(i))
+                    , stage.transfers / enumerations, stage.bytes / enumerations, stage.handlerNanos / enumerations);
+            }
+        }
+    }
+
+    if (baselinePath != nullptr)
+    {
+        const auto baseline = readBaseline(baselinePath);
+        if (baseline.empty())
+        {
+            std::fprintf(stderr, "%s: no results in %s\n", argv[0], baselinePath);
+            return 1;
+        }
+        std::fprintf(stderr, "%-32s %12s %12s %8s %10s\n", "case", "base ns/op", "ns/op", "delta", "code delta");
+        for (const auto& result : results)
+        {
+            for (const auto& base : baseline)
+            {
+                if (base.name != result.name)
+                    continue;
+                std::fprintf(stderr, "%-32s %12.2f %12.2f %+7.1f%% ", result.name.c_str(), base.nsPerOp, result.nsPerOp
+                    , (base.nsPerOp != 0) ? (result.nsPerOp / base.nsPerOp - 1) * 100 : 0.0);
+                if ((base.codeBytes >= 0) && (result.codeBytes >= 0))
+                    std::fprintf(stderr, "%+10ld\n", result.codeBytes - base.codeBytes);
+                else
+                    std::fprintf(stderr, "%10s\n", "-");
+            }
+        }
+    }
+    return 0;
+}
\ No newline at end of file
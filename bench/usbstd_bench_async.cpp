@@ -0,0 +1,103 @@
+/** usbstd_bench C++20 cases: asynchronous control handlers of usb_control_async.hpp
+ * Built as a separate C++20 object when the compiler supports it, so the coroutine header is compiled in every
+ * usbstd build that has a C++20 compiler even though the library itself targets C++17.
+*/
+#include <cstdint> //< uint8_t, uint32_t, uint64_t
+#include <cstring> //< std::memcpy
+
+#include "usb_cdc.hpp" //< usbstd::USB_CDC_SET_LINE_CODING
+#include "usb_control_async.hpp" //< usbstd::AsyncControl, usbstd::ControlTask, usbstd::StaticFramePool
+
+#if !defined(USBSTD_HAS_COROUTINES)
+#error "usb_control_async.hpp found no coroutine support in this C++20 build"
+#endif
+
+#define USBSTD_BENCH_KERNEL extern "C" __attribute__((noinline, used))
+
+namespace {
+
+    /** Endpoint 0 that completes every packet as soon as the kernel asks, standing in for the controller and the host
+    */
+    struct AsyncBackend
+    {
+        void ep0Transmit(const uint8_t*, size_t length) { inLength = length; inPending = true; }
+        void ep0Receive(uint8_t* data, size_t length) { out = data; outLength = length; outPending = true; }
+        void ep0Stall() { stalled = true; }
+
+        size_t inLength = 0;
+        uint8_t* out = nullptr;
+        size_t outLength = 0;
+        bool inPending = false;
+        bool outPending = false;
+        bool stalled = false;
+    };
+
+    using AsyncPipe = usbstd::ControlPipe<AsyncBackend>;
+    using Control = usbstd::AsyncControl<AsyncPipe>;
+
+    AsyncBackend asyncBackend;
+    AsyncPipe asyncPipe{ asyncBackend, 64 };
+    usbstd::StaticFramePool<256> asyncPool;
+    Control asyncControl{ asyncPipe, asyncPool };
+
+    const uint8_t asyncDevice[18] = { 18, 1, 0x00, 0x02, 0xef, 0x02, 0x01, 64, 0x09, 0x12, 0x01, 0x00, 0x00, 0x01, 1, 2, 3, 1 };
+    uint8_t asyncLineCoding[7];
+    bool asyncLineReady = false; //< Condition a handler waits for, as a handler would wait for a peripheral
+
+    usbstd::ControlTask getDescriptor(Control& control, const usbstd::Request&)
+    {
+        co_await control.send(usbstd::Span<const uint8_t>{ asyncDevice });
+    }
+
+    usbstd::ControlTask setLineCoding(Control& control, const usbstd::Request&)
+    {
+        if (co_await control.receive(asyncLineCoding) == 0)
+            co_return;
+        co_await control.until([] { return asyncLineReady; });
+        co_await control.acknowledge();
+    }
+
+    usbstd::ControlTask handle(Control& control, const usbstd::Request& request)
+    {
+        return (request.bRequest == usbstd::USB_GET_DESCRIPTOR) ? getDescriptor(control, request) : setLineCoding(control, request);
+    }
+
+} //END: anonymous
+
+USBSTD_BENCH_KERNEL uint64_t usbstd_bench_control_async(uint64_t iterations, uint32_t)
+{
+    // One operation: a GET_DESCRIPTOR or a SET_LINE_CODING, alternately, from SETUP to the handler finishing
+    const usbstd::Request requests[2] = {
+         { 0x80, usbstd::USB_GET_DESCRIPTOR, 0x0100, 0, 18 }
+        ,{ 0x21, usbstd::USB_CDC_SET_LINE_CODING, 0, 0, 7 }
+    };
+    const uint8_t lineCoding[7] = { 0x00, 0xc2, 0x01, 0x00, 0, 0, 8 };
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        asyncBackend = {};
+        asyncLineReady = false;
+        asyncControl.setup(requests[i & 1]);
+        while (asyncControl.poll(handle))
+        {
+            if (asyncBackend.inPending)
+            {
+                asyncBackend.inPending = false;
+                sum += asyncBackend.inLength;
+                asyncControl.inComplete();
+            }
+            else if (asyncBackend.outPending)
+            {
+                asyncBackend.outPending = false;
+                if (asyncBackend.outLength != 0)
+                    std::memcpy(asyncBackend.out, lineCoding, asyncBackend.outLength);
+                sum += asyncBackend.outLength;
+                asyncControl.outComplete(asyncBackend.outLength);
+            }
+            else
+                asyncLineReady = true;
+        }
+        sum += asyncBackend.stalled ? 0 : 1;
+    }
+    return sum;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdio> //< std::fprintf
+
+/** Minimal checks for the usbstd host tests: each test is an executable run by ctest, failing with a non-zero exit code
+ * @code
+ *   USBSTD_CHECK(flash.ready());
+ *   return usbstd::test::result();
+ * @endcode
+*/
+#define USBSTD_CHECK(condition) usbstd::test::check((condition), #condition, __FILE__, __LINE__)
+
+namespace usbstd {
+namespace test {
+
+    inline int failures = 0;
+
+    /** Report a failed check
+     * @return `condition`, so a test can stop when a precondition fails
+    */
+    inline bool check(bool condition, const char* expression, const char* file, int line)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+            ++failures;
+        }
+        return condition;
+    }
+
+    /** Exit code of the test
+    */
+    inline int result()
+    {
+        if (failures != 0)
+            std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return (failures == 0) ? 0 : 1;
+    }
+
+} //END: test
+} //END: usbstd
\ No newline at end of file
@@ -0,0 +1,124 @@
+/** usbstd_test_bandwidth: `helper::periodicBudget()` of known full-speed and high-speed configurations
+ * The expected byte-times follow `BusTiming`: bit-stuffed payload plus protocol overhead, per transaction.
+ * Defining `USBSTD_TEST_OVER_BUDGET` adds a configuration that exceeds the high-speed microframe, which must not compile;
+ * ctest builds it as the `bandwidth_over_budget` test, expected to fail.
+*/
+#include <cstdint> //< uint8_t, uint16_t
+
+#include "usb_helper_bandwidth.hpp" //< usbstd::helper::periodicBudget, usbstd::helper::BusTiming
+#include "usb_helper_descriptorlist.hpp" //< usbstd::helper::makeConfiguration
+#include "usbstd_test.hpp" //< USBSTD_CHECK
+
+namespace {
+
+    constexpr usbstd::ConfigurationDescriptor makeTestConfiguration()
+    {
+        usbstd::ConfigurationDescriptor configuration = {};
+        configuration.data.bConfigurationValue = 1;
+        configuration.data.bmAttributes = 0x80;
+        configuration.data.bMaxPower = 50;
+        return configuration;
+    }
+
+    constexpr usbstd::InterfaceDescriptor makeInterface(uint8_t bInterfaceNumber, uint8_t bAlternateSetting)
+    {
+        usbstd::InterfaceDescriptor interface = {};
+        interface.data.bInterfaceNumber = bInterfaceNumber;
+        interface.data.bAlternateSetting = bAlternateSetting;
+        interface.data.bInterfaceClass = 0xff;
+        return interface;
+    }
+
+    constexpr usbstd::EndpointDescriptor makeEndpoint(uint8_t bEndpointAddress, uint8_t xfer, uint16_t size, uint8_t bInterval, uint8_t hsPeriodMult = 0)
+    {
+        usbstd::EndpointDescriptor endpoint = {};
+        endpoint.data.bEndpointAddress = bEndpointAddress;
+        endpoint.data.bmAttributes.xfer(xfer);
+        endpoint.data.wMaxPacketSize.size(size);
+        endpoint.data.wMaxPacketSize.hsPeriodMult(hsPeriodMult);
+        endpoint.data.bInterval = bInterval;
+        return endpoint;
+    }
+
+    /** Full speed: a 64-byte interrupt IN every 4 frames, and an isochronous OUT interface whose alternate settings
+     * 1 and 2 carry 192 and 288 bytes per frame; only the larger setting is reserved.
+     *   interrupt 64:     Stuffed(64) 75 + 13 = 88
+     *   isochronous 192:  Stuffed(192) 224 + 9 = 233
+     *   isochronous 288:  Stuffed(288) 336 + 9 = 345
+    */
+    constexpr auto fullSpeedConfiguration = usbstd::helper::makeConfiguration(makeTestConfiguration()
+        , makeInterface(0, 0), makeEndpoint(0x81, usbstd::USB_INTERRUPT_ENDPOINT, 64, 4)
+        , makeInterface(1, 0)
+        , makeInterface(1, 1), makeEndpoint(0x02, usbstd::USB_ISOCHRONOUS_ENDPOINT, 192, 1)
+        , makeInterface(1, 2), makeEndpoint(0x02, usbstd::USB_ISOCHRONOUS_ENDPOINT, 288, 1)
+        , makeEndpoint(0x03, usbstd::USB_BULK_ENDPOINT, 64, 0));
+
+    constexpr auto fullSpeed = usbstd::helper::periodicBudget<usbstd::BusSpeed::Full>(fullSpeedConfiguration);
+    static_assert(fullSpeed.limitBytes == 1350, "90% of a 1500 byte-time frame");
+    static_assert(fullSpeed.count == 3, "bulk endpoints are not periodic");
+    static_assert(fullSpeed.reservedBytes == 88 + 345, "interrupt plus the larger isochronous setting");
+    static_assert(fullSpeed.fits(), "Full-speed configuration exceeds the frame budget");
+
+    /** High speed: a 1024-byte interrupt IN with 2 additional transactions every 8 microframes, and a 512-byte
+     * isochronous IN every microframe.
+     *   interrupt 3 x 1024:  3 x (Stuffed(1024) 1195 + 55) = 3750
+     *   isochronous 512:     Stuffed(512) 598 + 38 = 636
+    */
+    constexpr auto highSpeedConfiguration = usbstd::helper::makeConfiguration(makeTestConfiguration()
+        , makeInterface(0, 0), makeEndpoint(0x81, usbstd::USB_INTERRUPT_ENDPOINT, 1024, 4, 2)
+        , makeInterface(1, 0), makeEndpoint(0x82, usbstd::USB_ISOCHRONOUS_ENDPOINT, 512, 1));
+
+    constexpr auto highSpeed = usbstd::helper::periodicBudget<usbstd::BusSpeed::High>(highSpeedConfiguration);
+    static_assert(highSpeed.limitBytes == 6000, "80% of a 7500 byte-time microframe");
+    static_assert(highSpeed.reservedBytes == 3750 + 636, "both endpoints in one microframe");
+    static_assert(highSpeed.fits(), "High-speed configuration exceeds the microframe budget");
+
+    /** High speed: two high-bandwidth interrupt endpoints, 2 x 3750 = 7500 byte-times, the whole microframe
+    */
+    constexpr auto overBudgetConfiguration = usbstd::helper::makeConfiguration(makeTestConfiguration()
+        , makeInterface(0, 0), makeEndpoint(0x81, usbstd::USB_INTERRUPT_ENDPOINT, 1024, 1, 2)
+        , makeEndpoint(0x82, usbstd::USB_INTERRUPT_ENDPOINT, 1024, 1, 2));
+
+    constexpr auto overBudget = usbstd::helper::periodicBudget<usbstd::BusSpeed::High>(overBudgetConfiguration);
+    static_assert((overBudget.reservedBytes == 7500) && !overBudget.fits(), "over budget");
+
+#if defined(USBSTD_TEST_OVER_BUDGET)
+    static_assert(overBudget.fits(), "High-speed configuration exceeds the microframe budget"); //< Must fail to compile
+#endif
+
+} //END: anonymous
+
+int main()
+{
+    // Full speed, per endpoint
+    USBSTD_CHECK(fullSpeed.speed == usbstd::BusSpeed::Full);
+    const auto& interrupt = fullSpeed.endpoints[0];
+    USBSTD_CHECK((interrupt.bEndpointAddress == 0x81) && (interrupt.xfer == usbstd::USB_INTERRUPT_ENDPOINT));
+    USBSTD_CHECK((interrupt.payloadBytes == 64) && (interrupt.busBytes == 88));
+    USBSTD_CHECK((interrupt.period == 4) && (interrupt.latencyMicroseconds == 4000));
+    const auto& isochronous192 = fullSpeed.endpoints[1];
+    USBSTD_CHECK((isochronous192.bInterfaceNumber == 1) && (isochronous192.bAlternateSetting == 1));
+    USBSTD_CHECK((isochronous192.busBytes == 233) && (isochronous192.latencyMicroseconds == 1000));
+    const auto& isochronous288 = fullSpeed.endpoints[2];
+    USBSTD_CHECK((isochronous288.bAlternateSetting == 2) && (isochronous288.payloadBytes == 288) && (isochronous288.busBytes == 345));
+    USBSTD_CHECK(fullSpeed.worstLatencyMicroseconds == 4000);
+    USBSTD_CHECK(fullSpeed.utilisation() == (433 * 100) / 1500);
+
+    // High speed, per endpoint
+    const auto& highBandwidth = highSpeed.endpoints[0];
+    USBSTD_CHECK((highBandwidth.payloadBytes == 3 * 1024) && (highBandwidth.busBytes == 3750));
+    USBSTD_CHECK((highBandwidth.period == 8) && (highBandwidth.latencyMicroseconds == 1000));
+    const auto& isochronous512 = highSpeed.endpoints[1];
+    USBSTD_CHECK((isochronous512.payloadBytes == 512) && (isochronous512.busBytes == 636));
+    USBSTD_CHECK((isochronous512.period == 1) && (isochronous512.latencyMicroseconds == 125));
+    USBSTD_CHECK(highSpeed.worstLatencyMicroseconds == 1000);
+    USBSTD_CHECK(highSpeed.utilisation() == (4386 * 100) / 7500);
+
+    // The same full-speed descriptors at high speed: bInterval becomes an exponent of 125 µs microframes
+    constexpr auto fullAtHigh = usbstd::helper::periodicBudget<usbstd::BusSpeed::High>(fullSpeedConfiguration);
+    USBSTD_CHECK((fullAtHigh.endpoints[0].period == 8) && (fullAtHigh.endpoints[0].latencyMicroseconds == 1000));
+    USBSTD_CHECK(fullAtHigh.endpoints[0].busBytes == 75 + 55);
+
+    USBSTD_CHECK(!overBudget.fits() && (overBudget.utilisation() == 100));
+    return usbstd::test::result();
+}
\ No newline at end of file
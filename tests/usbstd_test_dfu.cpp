@@ -0,0 +1,270 @@
+/** usbstd_test_dfu: `dfu::FirmwareUpdate` over the control loopback, writing a `host::FileFlash` with real flash latency
+ * The device clock is a 32-bit microsecond counter from `steady_clock` that starts close to its wrap, as a device clock
+ * running for an hour would, so times compared against a value the state machine never set show up as huge poll timeouts.
+*/
+#include <atomic> //< std::atomic
+#include <chrono> //< std::chrono::steady_clock
+#include <cstdint> //< uint8_t, uint32_t
+#include <cstdlib> //< mkstemp
+#include <cstring> //< std::memcmp
+#include <thread> //< std::thread, std::this_thread::sleep_for
+#include <vector> //< std::vector
+
+#include <unistd.h> //< close, unlink
+
+#include "usb_control.hpp" //< usbstd::ControlPipe, usbstd::ControlLoopback
+#include "usb_dfu.hpp" //< usbstd::dfu::FirmwareUpdate
+#include "usb_host_fileflash.hpp" //< usbstd::host::FileFlash
+#include "usbstd_test.hpp" //< USBSTD_CHECK
+
+namespace {
+
+    constexpr uint32_t FlashSize = 64 * 1024;
+    constexpr uint32_t SectorSize = 4096;
+    constexpr size_t TransferSize = 1024;
+    constexpr uint32_t EraseMicros = 8000;
+    constexpr uint32_t ProgramMicrosPerKiB = 2000;
+    constexpr uint32_t MaxPollTimeout = 1000; ///< ms, far longer than any block of the test flash takes
+
+    using Dfu = usbstd::dfu::FirmwareUpdate<usbstd::host::FileFlash, TransferSize, 2>;
+
+    /** Device clock, 2^30 µs (about 18 minutes) before it wraps when the test starts
+    */
+    uint32_t micros()
+    {
+        static const auto start = std::chrono::steady_clock::now();
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        return static_cast<uint32_t>(0xc0000000u + static_cast<uint64_t>(elapsed));
+    }
+
+    /** Flash image in a temporary file, removed once opened
+    */
+    struct TemporaryFlash
+    {
+        static const char* create(char* path)
+        {
+            const int fd = ::mkstemp(path);
+            if (fd < 0)
+                return "";
+            ::close(fd);
+            return path;
+        }
+
+        TemporaryFlash(uint32_t eraseMicros, uint32_t programMicrosPerKiB)
+            : flash(create(path), FlashSize, SectorSize, eraseMicros, programMicrosPerKiB)
+        {
+            ::unlink(path);
+        }
+
+        char path[32] = "/tmp/usbstd_test_dfuXXXXXX";
+        usbstd::host::FileFlash flash;
+    };
+
+    /** The host side: DFU class requests to interface 0 over the control loopback
+    */
+    template<typename Dfu_t>
+    struct Host
+    {
+        explicit Host(Dfu_t& dfu) : dfu(dfu) {}
+
+        /** @return Data stage bytes, or -1 when the device stalled
+        */
+        long request(uint8_t bRequest, usbstd::Span<uint8_t> data = {})
+        {
+            const bool in = (bRequest == usbstd::USB_DFU_UPLOAD) || (bRequest == usbstd::USB_DFU_GETSTATUS) || (bRequest == usbstd::USB_DFU_GETSTATE);
+            const usbstd::Request setup = { static_cast<uint8_t>(in ? 0xa1 : 0x21), bRequest, 0, 0, static_cast<uint16_t>(data.size()) };
+            return loopback.transfer(pipe, setup, data, [this](auto& ep0) {
+                if (ep0.stage() == usbstd::ControlStage::Setup)
+                    dfu.setup(ep0);
+                else
+                    dfu.dataReceived(ep0);
+            });
+        }
+
+        /** GETSTATUS
+         * @return State, or `State::Error` when the request failed; `pollTimeout` receives `bwPollTimeout` in ms
+        */
+        usbstd::dfu::State status(uint32_t& pollTimeout)
+        {
+            uint8_t response[6] = {};
+            if (request(usbstd::USB_DFU_GETSTATUS, response) != sizeof(response))
+                return usbstd::dfu::State::Error;
+            pollTimeout = uint32_t(response[1]) | (uint32_t(response[2]) << 8) | (uint32_t(response[3]) << 16);
+            return static_cast<usbstd::dfu::State>(response[4]);
+        }
+
+        /** GETSTATUS until the device is no longer busy, waiting `bwPollTimeout` in between as a host does
+         * @param task  Run the task between polls, for tests without a task thread
+         * @param timeouts  Receives the `bwPollTimeout` of every busy answer
+        */
+        usbstd::dfu::State settle(bool task, std::vector<uint32_t>* timeouts = nullptr)
+        {
+            for (int poll = 0; poll < 1000; ++poll)
+            {
+                uint32_t pollTimeout = 0;
+                const auto state = status(pollTimeout);
+                if ((state != usbstd::dfu::State::DnBusy) && (state != usbstd::dfu::State::Manifest) && (state != usbstd::dfu::State::ManifestSync))
+                    return state;
+                if (timeouts)
+                    timeouts->push_back(pollTimeout);
+                if (pollTimeout > MaxPollTimeout)
+                    return usbstd::dfu::State::Error;
+                if (task)
+                    dfu.process();
+                else
+                    std::this_thread::sleep_for(std::chrono::milliseconds(pollTimeout));
+            }
+            return usbstd::dfu::State::Error;
+        }
+
+        /** Download and manifest `length` bytes of `image`
+        */
+        bool download(uint8_t* image, size_t length, bool task, std::vector<uint32_t>* timeouts = nullptr)
+        {
+            for (size_t offset = 0; offset < length; offset += TransferSize)
+            {
+                if ((request(usbstd::USB_DFU_DNLOAD, { image + offset, TransferSize }) != long(TransferSize)) || (settle(task, timeouts) != usbstd::dfu::State::DnloadIdle))
+                    return false;
+                if (task)
+                    dfu.process();
+            }
+            return (request(usbstd::USB_DFU_DNLOAD) == 0) && (settle(task) == usbstd::dfu::State::DfuIdle) && (dfu.status() == usbstd::dfu::Status::Ok);
+        }
+
+        Dfu_t& dfu;
+        usbstd::ControlLoopback loopback;
+        usbstd::ControlPipe<usbstd::ControlLoopback> pipe{ loopback, 64 };
+    };
+
+    std::vector<uint8_t> makeImage(size_t length, unsigned seed)
+    {
+        std::vector<uint8_t> image(length);
+        for (size_t i = 0; i < length; ++i)
+            image[i] = static_cast<uint8_t>((i * (seed + 3)) ^ (i >> 8));
+        return image;
+    }
+
+    /** Two blocks queued before the task started: the first DnBusy answer predicts from measurements, there are none yet
+    */
+    void firstBusyPoll()
+    {
+        TemporaryFlash file{ EraseMicros, ProgramMicrosPerKiB };
+        if (!USBSTD_CHECK(file.flash.ready()))
+            return;
+        Dfu dfu{ file.flash, micros };
+        Host<Dfu> host{ dfu };
+        auto image = makeImage(2 * TransferSize, 0);
+
+        uint32_t pollTimeout = 0;
+        USBSTD_CHECK(host.request(usbstd::USB_DFU_DNLOAD, { image.data(), TransferSize }) == long(TransferSize));
+        USBSTD_CHECK(host.status(pollTimeout) == usbstd::dfu::State::DnloadIdle);
+        USBSTD_CHECK(host.request(usbstd::USB_DFU_DNLOAD, { image.data() + TransferSize, TransferSize }) == long(TransferSize));
+        USBSTD_CHECK(host.status(pollTimeout) == usbstd::dfu::State::DnBusy);
+        USBSTD_CHECK((pollTimeout >= 1) && (pollTimeout <= (EraseMicros + ProgramMicrosPerKiB) / 1000));
+    }
+
+    /** Download with the task in its own thread, as on a device, then read the image back with UPLOAD
+    */
+    void pipelinedDownload()
+    {
+        TemporaryFlash file{ EraseMicros, ProgramMicrosPerKiB };
+        if (!USBSTD_CHECK(file.flash.ready()))
+            return;
+        Dfu dfu{ file.flash, micros };
+        Host<Dfu> host{ dfu };
+        auto image = makeImage(16 * 1024, 1);
+
+        std::atomic<bool> running = { true };
+        std::thread task([&] {
+            while (running.load(std::memory_order_relaxed))
+                if (!dfu.process())
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+        });
+        std::vector<uint32_t> timeouts;
+        const bool downloaded = host.download(image.data(), image.size(), false, &timeouts);
+        running.store(false, std::memory_order_relaxed);
+        task.join();
+        if (!USBSTD_CHECK(downloaded))
+            return;
+
+        // The measurements follow the configured latency, with room for a loaded machine oversleeping
+        USBSTD_CHECK((dfu.eraseMicros() >= EraseMicros) && (dfu.eraseMicros() <= 4 * EraseMicros));
+        USBSTD_CHECK((dfu.programNanosPerByte() >= ProgramMicrosPerKiB * 1000 / 1024) && (dfu.programNanosPerByte() <= 4 * ProgramMicrosPerKiB * 1000 / 1024));
+
+        // A busy device is waiting for one block: at most a sector erase and the block, as measured
+        const uint32_t blockMillis = (4 * (EraseMicros + ProgramMicrosPerKiB)) / 1000;
+        USBSTD_CHECK(!timeouts.empty());
+        for (const uint32_t pollTimeout : timeouts)
+            USBSTD_CHECK((pollTimeout >= 1) && (pollTimeout <= blockMillis));
+
+        // UPLOAD asking for more than `wTransferSize`: every full block continues, the short one at the end stops
+        std::vector<uint8_t> readBack(FlashSize);
+        size_t uploaded = 0;
+        uint8_t block[2 * TransferSize];
+        for (int blocks = 0; blocks <= int(FlashSize / TransferSize); ++blocks)
+        {
+            const long length = host.request(usbstd::USB_DFU_UPLOAD, block);
+            if (!USBSTD_CHECK((length >= 0) && (size_t(length) <= FlashSize - uploaded)))
+                return;
+            std::memcpy(readBack.data() + uploaded, block, size_t(length));
+            uploaded += size_t(length);
+            if (dfu.state() != usbstd::dfu::State::UploadIdle)
+                break;
+        }
+        USBSTD_CHECK(uploaded == FlashSize);
+        USBSTD_CHECK(dfu.state() == usbstd::dfu::State::DfuIdle);
+        USBSTD_CHECK(std::memcmp(readBack.data(), image.data(), image.size()) == 0);
+    }
+
+    /** Downloads cut short by ABORT, and by an error and CLRSTATUS, with blocks still queued, each followed by a complete one
+    */
+    void abortRestart()
+    {
+        TemporaryFlash file{ 0, 0 };
+        if (!USBSTD_CHECK(file.flash.ready()))
+            return;
+        // Three buffers, so the task and the USB side can end up on different ones
+        usbstd::dfu::FirmwareUpdate<usbstd::host::FileFlash, TransferSize, 3> dfu{ file.flash, micros };
+        Host<decltype(dfu)> host{ dfu };
+
+        std::vector<uint8_t> images[2] = { makeImage(8192, 0), makeImage(8192, 1) };
+        for (int cut = 0; cut < 2; ++cut)
+        {
+            // Two blocks queued and the first written, leaving the task and the USB side on different buffers
+            for (size_t block = 0; block < 2; ++block)
+            {
+                USBSTD_CHECK(host.request(usbstd::USB_DFU_DNLOAD, { images[cut].data() + TransferSize * block, TransferSize }) == long(TransferSize));
+                USBSTD_CHECK(host.settle(true) == usbstd::dfu::State::DnloadIdle);
+            }
+            dfu.process();
+            if (cut == 0)
+                USBSTD_CHECK(host.request(usbstd::USB_DFU_ABORT) == 0);
+            else
+            {
+                // DETACH is only valid in `AppIdle`, it stalls into `Error`
+                USBSTD_CHECK(host.request(usbstd::USB_DFU_DETACH) == -1);
+                USBSTD_CHECK(dfu.state() == usbstd::dfu::State::Error);
+                USBSTD_CHECK(host.request(usbstd::USB_DFU_CLRSTATUS) == 0);
+            }
+            USBSTD_CHECK(!dfu.process()); //< The queued block is dropped
+            USBSTD_CHECK(dfu.state() == usbstd::dfu::State::DfuIdle);
+
+            auto& image = images[1 - cut];
+            const size_t length = (cut == 0) ? 6144 : 8192;
+            USBSTD_CHECK(host.download(image.data(), length, true));
+
+            std::vector<uint8_t> readBack(length);
+            USBSTD_CHECK(file.flash.read(0, readBack.data(), length) == length);
+            USBSTD_CHECK(std::memcmp(readBack.data(), image.data(), length) == 0);
+        }
+    }
+
+} //END: anonymous
+
+int main()
+{
+    firstBusyPoll();
+    pipelinedDownload();
+    abortRestart();
+    return usbstd::test::result();
+}
\ No newline at end of file
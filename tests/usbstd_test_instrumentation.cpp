@@ -0,0 +1,110 @@
+/** usbstd_test_instrumentation: `instrumentation::RequestStats` recording control requests of a `ControlPipe`
+ * Built twice, with `USBSTD_INSTRUMENTATION` 1 and 0: the enabled statistics round trip through a snapshot and
+ * `parseSnapshot()`, the disabled ones record nothing and export an empty snapshot.
+*/
+#include <cstdint> //< uint8_t, uint32_t
+#include <cstring> //< std::strstr, std::strlen
+
+#include "usb_control.hpp" //< usbstd::ControlPipe, usbstd::ControlLoopback
+#include "usb_instrumentation.hpp" //< usbstd::instrumentation::RequestStats, usbstd::instrumentation::parseSnapshot
+#include "usbstd_test.hpp" //< USBSTD_CHECK
+
+namespace {
+
+    using Stats = usbstd::instrumentation::RequestStats<8>;
+
+    const uint8_t device[18] = { 18, 1, 0x00, 0x02, 0, 0, 0, 64, 0x09, 0x12, 0x01, 0x00, 0x00, 0x01, 1, 2, 3, 1 };
+
+    /** Run `request` over the loopback, answered as a device would, and record it with `ticks` of latency
+    */
+    template<typename Pipe_t>
+    void run(usbstd::ControlLoopback& loopback, Pipe_t& pipe, Stats& stats, const usbstd::Request& request, uint32_t ticks)
+    {
+        uint8_t data[64] = {};
+        loopback.transfer(pipe, request, { data, request.wLength }, [](auto& ep0) {
+            if (ep0.request().bRequest == usbstd::USB_GET_DESCRIPTOR)
+                ep0.send(usbstd::Span<const uint8_t>{ device });
+            else if (ep0.request().bRequest == usbstd::USB_SET_CONFIGURATION)
+                ep0.acknowledge();
+            else
+                ep0.stall();
+        });
+        stats.record(pipe.request(), ticks, loopback.stalled());
+    }
+
+} //END: anonymous
+
+int main()
+{
+    usbstd::ControlLoopback loopback;
+    usbstd::ControlPipe<usbstd::ControlLoopback> pipe{ loopback, 64 };
+    Stats stats;
+
+    const usbstd::Request getDescriptor = { 0x80, usbstd::USB_GET_DESCRIPTOR, 0x0100, 0, 18 };
+    const usbstd::Request setConfiguration = { 0x00, usbstd::USB_SET_CONFIGURATION, 1, 0, 0 };
+    const usbstd::Request vendor = { 0xc0, 0x42, 0, 0, 4 };
+    run(loopback, pipe, stats, getDescriptor, 0);
+    run(loopback, pipe, stats, getDescriptor, 3);
+    run(loopback, pipe, stats, getDescriptor, 40000);
+    run(loopback, pipe, stats, setConfiguration, 7);
+    run(loopback, pipe, stats, vendor, 1);
+    USBSTD_CHECK(loopback.stalled());
+
+    uint8_t snapshot[1024] = {};
+    const size_t length = stats.snapshot(snapshot);
+    size_t visited = 0;
+    bool getDescriptorSeen = false;
+    bool setConfigurationSeen = false;
+    bool vendorSeen = false;
+    const auto header = usbstd::instrumentation::parseSnapshot({ snapshot, length }, [&](const usbstd::instrumentation::SnapshotEntry& entry) {
+        ++visited;
+        if ((entry.bmRequestType == 0x80) && (entry.bRequest == usbstd::USB_GET_DESCRIPTOR))
+        {
+            getDescriptorSeen = true;
+            USBSTD_CHECK((entry.count == 3u) && (entry.stalls == 0u) && (entry.maxTicks == 40000u) && (entry.totalTicks == 40003u));
+            USBSTD_CHECK((entry.histogram[0] == 1u) && (entry.histogram[2] == 1u) && (entry.histogram[usbstd::instrumentation::histogramBin(40000)] == 1u));
+        }
+        else if ((entry.bmRequestType == 0x00) && (entry.bRequest == usbstd::USB_SET_CONFIGURATION))
+        {
+            setConfigurationSeen = true;
+            USBSTD_CHECK((entry.count == 1u) && (entry.stalls == 0u) && (entry.histogram[3] == 1u));
+        }
+        else if ((entry.bmRequestType == 0xc0) && (entry.bRequest == 0x42))
+        {
+            vendorSeen = true;
+            USBSTD_CHECK((entry.count == 1u) && (entry.stalls == 1u));
+        }
+    });
+
+    char text[1024] = "unchanged";
+    const size_t printed = stats.print(text, sizeof(text));
+    USBSTD_CHECK(printed == std::strlen(text));
+
+    if (Stats::Enabled)
+    {
+        USBSTD_CHECK(length == sizeof(usbstd::instrumentation::SnapshotHeader) + 3 * sizeof(usbstd::instrumentation::SnapshotEntry));
+        USBSTD_CHECK((header.version == usbstd::instrumentation::SnapshotVersion) && (header.entries == 3u) && (header.overflow == 0u));
+        USBSTD_CHECK((visited == 3) && getDescriptorSeen && setConfigurationSeen && vendorSeen);
+        USBSTD_CHECK(std::strstr(text, "80 06 count=3 stalls=0 max=40000") != nullptr);
+        USBSTD_CHECK(std::strstr(text, "c0 42 count=1 stalls=1") != nullptr);
+
+        // A full table counts the requests it cannot record
+        for (uint8_t bRequest = 0; bRequest < 16; ++bRequest)
+            stats.record({ 0x40, bRequest, 0, 0, 0 }, 1);
+        const size_t full = stats.snapshot(snapshot);
+        const auto fullHeader = usbstd::instrumentation::parseSnapshot({ snapshot, full }, [](const auto&) {});
+        USBSTD_CHECK((fullHeader.entries == 8u) && (fullHeader.overflow == 16u - 5u));
+
+        stats.reset();
+        const auto cleared = usbstd::instrumentation::parseSnapshot({ snapshot, stats.snapshot(snapshot) }, [](const usbstd::instrumentation::SnapshotEntry& entry) {
+            USBSTD_CHECK(entry.count == 0u);
+        });
+        USBSTD_CHECK((cleared.entries == 8u) && (cleared.overflow == 0u));
+    }
+    else
+    {
+        USBSTD_CHECK((length == 0) && (header.version == 0) && (visited == 0));
+        USBSTD_CHECK((printed == 0) && (text[0] == '\0'));
+    }
+    return usbstd::test::result();
+}
\ No newline at end of file
@@ -0,0 +1,255 @@
+/** usbstd_test_msc: `msc::BulkOnlyTransport` driven by a simulated host, on a `RamDisk` and on a `host::FileDisk`
+ * The host sends CBWs and data, clears the halts the device requests, and checks the CSWs of the BOT 6.7 cases.
+*/
+#include <cstdint> //< uint8_t, uint32_t
+#include <cstdlib> //< mkstemp
+#include <cstring> //< std::memcpy, std::memcmp
+#include <vector> //< std::vector
+
+#include <unistd.h> //< close, unlink
+
+#include "usb_host_filedisk.hpp" //< usbstd::host::FileDisk
+#include "usb_msc.hpp" //< usbstd::msc::BulkOnlyTransport, usbstd::msc::RamDisk
+#include "usbstd_test.hpp" //< USBSTD_CHECK
+
+namespace {
+
+    constexpr uint32_t BlockCount = 64;
+    constexpr uint32_t BlockSize = 512;
+
+    /** Outcome of one command, as the host sees it
+    */
+    struct Result
+    {
+        usbstd::msc::CommandStatusWrapper csw = {};
+        std::vector<uint8_t> data; ///< Data stage received, device to host
+        size_t sent = 0; ///< Data stage bytes the device accepted, host to device
+        bool stalledIn = false;
+        bool stalledOut = false;
+        bool completed = false; ///< A valid CSW with the tag of the CBW
+    };
+
+    /** Host and bulk endpoints, with the storage task run inline between transfers
+    */
+    template<typename Disk_t>
+    struct Host
+    {
+        using Transport = usbstd::msc::BulkOnlyTransport<Disk_t>;
+
+        explicit Host(Disk_t& disk) : msc(disk, "usbstd", "Test disk", "0.1") {}
+
+        /** Run a command
+         * @param in  Data stage direction, device to host
+         * @param length  `dCBWDataTransferLength`
+         * @param out  Data the host sends, for `in == false`
+        */
+        Result command(const uint8_t (&cb)[10], bool in, uint32_t length, const uint8_t* out = nullptr)
+        {
+            usbstd::msc::CommandBlockWrapper cbw = {};
+            cbw.dCBWSignature = usbstd::msc::CommandBlockWrapper::Signature;
+            cbw.dCBWTag = ++tag;
+            cbw.dCBWDataTransferLength = length;
+            cbw.bmCBWFlags = in ? 0x80 : 0x00;
+            cbw.bCBWCBLength = sizeof(cb);
+            std::memcpy(cbw.CBWCB, cb, sizeof(cb));
+
+            Result result;
+            const auto rx = msc.rxBuffer();
+            if (rx.size() < sizeof(cbw))
+                return result;
+            std::memcpy(rx.data(), &cbw, sizeof(cbw));
+            msc.outComplete(sizeof(cbw));
+
+            for (int step = 0; step < 1000; ++step)
+            {
+                msc.process();
+                switch (msc.stall())
+                {
+                case Transport::Stall::In: result.stalledIn = true; msc.clearHalt(); continue;
+                case Transport::Stall::Out: result.stalledOut = true; msc.clearHalt(); continue;
+                case Transport::Stall::Both: return result; //< Reset recovery
+                default: break;
+                }
+
+                const auto phase = msc.phase();
+                if ((phase == Transport::Phase::DataIn) || (phase == Transport::Phase::Status))
+                {
+                    const auto tx = msc.txBuffer();
+                    if (tx.empty())
+                        continue;
+                    if (phase == Transport::Phase::Status)
+                    {
+                        if (tx.size() != sizeof(result.csw))
+                            return result;
+                        std::memcpy(&result.csw, tx.data(), sizeof(result.csw));
+                        msc.inComplete(tx.size());
+                        result.completed = (result.csw.dCSWSignature == usbstd::msc::CommandStatusWrapper::Signature) && (result.csw.dCSWTag == tag);
+                        return result;
+                    }
+                    if (!in || (result.data.size() + tx.size() > length))
+                        return result; //< More data than the host asked for
+                    result.data.insert(result.data.end(), tx.begin(), tx.end());
+                    msc.inComplete(tx.size());
+                }
+                else if (phase == Transport::Phase::DataOut)
+                {
+                    const auto rx = msc.rxBuffer();
+                    const size_t count = (rx.size() < length - result.sent) ? rx.size() : (length - result.sent);
+                    if (in || (count == 0))
+                        continue;
+                    std::memcpy(rx.data(), out + result.sent, count);
+                    result.sent += count;
+                    msc.outComplete(count);
+                }
+            }
+            return result;
+        }
+
+        Transport msc;
+        uint32_t tag = 0;
+    };
+
+    /** READ(10) or WRITE(10) command block
+    */
+    void blocks(uint8_t (&cb)[10], usbstd::msc::ScsiOpcode opcode, uint32_t lba, uint16_t count)
+    {
+        cb[0] = static_cast<uint8_t>(opcode);
+        usbstd::msc::storeBe32(cb + 2, lba);
+        usbstd::msc::storeBe16(cb + 7, count);
+    }
+
+    template<typename Disk_t>
+    void suite(Disk_t& disk)
+    {
+        Host<Disk_t> host{ disk };
+
+        // INQUIRY: standard data, removable direct access block device
+        {
+            const uint8_t cb[10] = { static_cast<uint8_t>(usbstd::msc::ScsiOpcode::Inquiry), 0, 0, 0, 36 };
+            const auto result = host.command(cb, true, 36);
+            USBSTD_CHECK(result.completed && (result.csw.bCSWStatus == usbstd::msc::CswStatus::Passed) && (result.csw.dCSWDataResidue == 0u));
+            USBSTD_CHECK(!result.stalledIn && (result.data.size() == sizeof(usbstd::msc::InquiryData)));
+            if (result.data.size() == sizeof(usbstd::msc::InquiryData))
+            {
+                usbstd::msc::InquiryData inquiry;
+                std::memcpy(&inquiry, result.data.data(), sizeof(inquiry));
+                USBSTD_CHECK((inquiry.peripheral == 0x00) && (inquiry.rmb == 0x80) && (inquiry.additionalLength == 31));
+                USBSTD_CHECK(std::memcmp(inquiry.vendorId, "usbstd  ", 8) == 0);
+                USBSTD_CHECK(std::memcmp(inquiry.productId, "Test disk       ", 16) == 0);
+            }
+        }
+
+        // READ CAPACITY(10)
+        {
+            const uint8_t cb[10] = { static_cast<uint8_t>(usbstd::msc::ScsiOpcode::ReadCapacity10) };
+            const auto result = host.command(cb, true, 8);
+            USBSTD_CHECK(result.completed && (result.csw.bCSWStatus == usbstd::msc::CswStatus::Passed) && (result.data.size() == 8));
+            if (result.data.size() == 8)
+            {
+                USBSTD_CHECK(usbstd::msc::loadBe32(result.data.data()) == BlockCount - 1);
+                USBSTD_CHECK(usbstd::msc::loadBe32(result.data.data() + 4) == BlockSize);
+            }
+        }
+
+        // WRITE(10) and READ(10) of more blocks than both transport buffers hold
+        constexpr uint16_t Count = 20;
+        std::vector<uint8_t> pattern(size_t(Count) * BlockSize);
+        for (size_t i = 0; i < pattern.size(); ++i)
+            pattern[i] = static_cast<uint8_t>((i * 7) ^ (i >> 9));
+        {
+            uint8_t cb[10] = {};
+            blocks(cb, usbstd::msc::ScsiOpcode::Write10, 5, Count);
+            const auto result = host.command(cb, false, uint32_t(pattern.size()), pattern.data());
+            USBSTD_CHECK(result.completed && (result.csw.bCSWStatus == usbstd::msc::CswStatus::Passed) && (result.csw.dCSWDataResidue == 0u));
+            USBSTD_CHECK((result.sent == pattern.size()) && !result.stalledOut);
+
+            std::vector<uint8_t> stored(pattern.size());
+            USBSTD_CHECK(disk.read(5, Count, stored.data()) && (stored == pattern));
+        }
+        {
+            uint8_t cb[10] = {};
+            blocks(cb, usbstd::msc::ScsiOpcode::Read10, 5, Count);
+            const auto result = host.command(cb, true, uint32_t(pattern.size()));
+            USBSTD_CHECK(result.completed && (result.csw.bCSWStatus == usbstd::msc::CswStatus::Passed) && (result.csw.dCSWDataResidue == 0u));
+            USBSTD_CHECK(!result.stalledIn && (result.data == pattern));
+        }
+
+        // Hi > Di (case 5): the host asks for a block more than READ(10) moves, the device halts IN and reports the residue
+        {
+            uint8_t cb[10] = {};
+            blocks(cb, usbstd::msc::ScsiOpcode::Read10, 5, 2);
+            const auto result = host.command(cb, true, 3 * BlockSize);
+            USBSTD_CHECK(result.completed && (result.csw.bCSWStatus == usbstd::msc::CswStatus::Passed));
+            USBSTD_CHECK(result.stalledIn && (result.csw.dCSWDataResidue == BlockSize));
+            USBSTD_CHECK((result.data.size() == 2 * BlockSize) && (std::memcmp(result.data.data(), pattern.data(), 2 * BlockSize) == 0));
+        }
+
+        // Hi > Di for a response shorter than the allocation: INQUIRY into a 64 byte data stage
+        {
+            const uint8_t cb[10] = { static_cast<uint8_t>(usbstd::msc::ScsiOpcode::Inquiry), 0, 0, 0, 64 };
+            const auto result = host.command(cb, true, 64);
+            USBSTD_CHECK(result.completed && (result.csw.bCSWStatus == usbstd::msc::CswStatus::Passed));
+            USBSTD_CHECK(result.stalledIn && (result.data.size() == 36) && (result.csw.dCSWDataResidue == 64u - 36u));
+        }
+
+        // Hi < Di (case 7): the host asks for less than READ(10) moves, phase error without data
+        {
+            uint8_t cb[10] = {};
+            blocks(cb, usbstd::msc::ScsiOpcode::Read10, 5, 4);
+            const auto result = host.command(cb, true, 2 * BlockSize);
+            USBSTD_CHECK(result.completed && (result.csw.bCSWStatus == usbstd::msc::CswStatus::PhaseError));
+            USBSTD_CHECK(result.stalledIn && result.data.empty() && (result.csw.dCSWDataResidue == 2 * BlockSize));
+        }
+
+        // Ho > Do (case 11): the host offers a block more than WRITE(10) takes, the device halts OUT after the blocks
+        {
+            uint8_t cb[10] = {};
+            blocks(cb, usbstd::msc::ScsiOpcode::Write10, 40, 2);
+            const auto result = host.command(cb, false, 3 * BlockSize, pattern.data());
+            USBSTD_CHECK(result.completed && (result.csw.bCSWStatus == usbstd::msc::CswStatus::Passed));
+            USBSTD_CHECK(result.stalledOut && (result.sent == 2 * BlockSize) && (result.csw.dCSWDataResidue == BlockSize));
+        }
+
+        // Ho < Do (case 13): the host offers less than WRITE(10) needs, phase error without data
+        {
+            uint8_t cb[10] = {};
+            blocks(cb, usbstd::msc::ScsiOpcode::Write10, 40, 4);
+            const auto result = host.command(cb, false, 2 * BlockSize, pattern.data());
+            USBSTD_CHECK(result.completed && (result.csw.bCSWStatus == usbstd::msc::CswStatus::PhaseError));
+            USBSTD_CHECK(result.stalledOut && (result.sent == 0) && (result.csw.dCSWDataResidue == 2 * BlockSize));
+        }
+
+        // Out of range: failed, and REQUEST SENSE reports LOGICAL BLOCK ADDRESS OUT OF RANGE
+        {
+            uint8_t cb[10] = {};
+            blocks(cb, usbstd::msc::ScsiOpcode::Read10, BlockCount - 1, 2);
+            const auto result = host.command(cb, true, 2 * BlockSize);
+            USBSTD_CHECK(result.completed && (result.csw.bCSWStatus == usbstd::msc::CswStatus::Failed) && result.data.empty());
+
+            const uint8_t sense[10] = { static_cast<uint8_t>(usbstd::msc::ScsiOpcode::RequestSense), 0, 0, 0, 18 };
+            const auto senseResult = host.command(sense, true, 18);
+            USBSTD_CHECK(senseResult.completed && (senseResult.data.size() == 18));
+            if (senseResult.data.size() == 18)
+                USBSTD_CHECK(((senseResult.data[2] & 0x0f) == uint8_t(usbstd::msc::SenseKey::IllegalRequest)) && (senseResult.data[12] == 0x21));
+        }
+    }
+
+} //END: anonymous
+
+int main()
+{
+    static usbstd::msc::RamDisk<BlockCount, BlockSize> ramDisk;
+    suite(ramDisk);
+
+    char path[] = "/tmp/usbstd_test_mscXXXXXX";
+    const int fd = ::mkstemp(path);
+    if (USBSTD_CHECK(fd >= 0))
+    {
+        ::close(fd);
+        usbstd::host::FileDisk fileDisk{ path, BlockCount, BlockSize };
+        ::unlink(path); //< The open descriptor keeps the image
+        if (USBSTD_CHECK(fileDisk.ready() && (fileDisk.blockCount() == BlockCount)))
+            suite(fileDisk);
+    }
+    return usbstd::test::result();
+}
\ No newline at end of file
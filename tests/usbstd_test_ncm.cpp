@@ -0,0 +1,126 @@
+/** usbstd_test_ncm: Ethernet frames packed into NTBs by `cdc::NtbEncoder` and unpacked by `cdc::NtbDecoder`, NTB-16 and NTB-32
+*/
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t, uintptr_t
+#include <cstdio> //< std::fprintf
+#include <cstring> //< std::memcpy
+#include <utility> //< std::move
+#include <vector> //< std::vector
+
+#include "usb_cdc_ncm.hpp" //< usbstd::cdc::NtbEncoder, usbstd::cdc::NtbDecoder, usbstd::cdc::Ntb16, usbstd::cdc::Ntb32
+#include "usbstd_test.hpp" //< USBSTD_CHECK
+
+namespace {
+
+    /** Ethernet frame of `length` bytes whose every byte identifies the frame and its position
+    */
+    std::vector<uint8_t> makeFrame(uint8_t id, size_t length)
+    {
+        std::vector<uint8_t> frame(length);
+        for (size_t i = 0; i < length; ++i)
+            frame[i] = static_cast<uint8_t>(id * 31 + i);
+        return frame;
+    }
+
+    /** Unpack an NTB
+     * @return The datagrams in NTB order, empty when the NTH is not valid
+    */
+    template<typename Format_t>
+    std::vector<std::vector<uint8_t>> unpack(usbstd::Span<const uint8_t> ntb)
+    {
+        std::vector<std::vector<uint8_t>> frames;
+        const usbstd::cdc::NtbDecoder<Format_t> decoder{ ntb };
+        const size_t count = decoder.forEach([&](usbstd::Span<const uint8_t> frame) {
+            frames.emplace_back(frame.begin(), frame.end());
+        });
+        USBSTD_CHECK(count == frames.size());
+        return frames;
+    }
+
+    /** Frames of mixed sizes, from minimum to full-size Ethernet, packed into as many NTBs as needed
+    */
+    template<typename Format_t>
+    void roundTrip(const char* format)
+    {
+        const size_t lengths[] = { 60, 1514, 98, 342, 1514, 64, 1, 1514, 590, 1514, 1514, 60 };
+        std::vector<std::vector<uint8_t>> sent;
+        for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i)
+            sent.push_back(makeFrame(static_cast<uint8_t>(i), lengths[i]));
+
+        // Datagrams aligned for the IP header after the 14-byte Ethernet header: offset % 4 == 2
+        static uint8_t buffer[4096];
+        usbstd::cdc::NtbEncoder<Format_t, 8> encoder{ buffer, 4, 2 };
+        std::vector<std::vector<uint8_t>> received;
+        uint16_t sequence = 0;
+        size_t ntbs = 0;
+        auto flush = [&]() {
+            const auto ntb = encoder.finish(sequence);
+            if (!USBSTD_CHECK(!ntb.empty() && (ntb.size() <= sizeof(buffer))))
+                return;
+            typename Format_t::Nth nth;
+            std::memcpy(&nth, ntb.data(), sizeof(nth));
+            USBSTD_CHECK((nth.dwSignature == Format_t::NthSignature) && (nth.wSequence == sequence));
+            USBSTD_CHECK((Format_t::blockLength(nth) == ntb.size()) && (Format_t::ndpIndex(nth) % Format_t::NdpAlignment == 0));
+
+            const usbstd::cdc::NtbDecoder<Format_t> decoder{ ntb };
+            decoder.forEach([](usbstd::Span<const uint8_t> frame) {
+                USBSTD_CHECK(reinterpret_cast<uintptr_t>(frame.data()) % 4 == (reinterpret_cast<uintptr_t>(buffer) + 2) % 4);
+            });
+            for (auto& frame : unpack<Format_t>(ntb))
+                received.push_back(std::move(frame));
+            ++sequence;
+            ++ntbs;
+        };
+        for (const auto& frame : sent)
+        {
+            if (encoder.append(usbstd::Span<const uint8_t>{ frame.data(), frame.size() }))
+                continue;
+            USBSTD_CHECK(!encoder.empty());
+            flush();
+            USBSTD_CHECK(encoder.empty() && encoder.append(usbstd::Span<const uint8_t>{ frame.data(), frame.size() }));
+        }
+        flush();
+        USBSTD_CHECK(encoder.finish(sequence).empty());
+
+        if (!USBSTD_CHECK(received == sent))
+            std::fprintf(stderr, "%s: sent %zu frames, received %zu in %zu NTBs\n", format, sent.size(), received.size(), ntbs);
+        USBSTD_CHECK(ntbs >= 3); //< 4096-byte NTBs hold at most two full-size frames
+    }
+
+    /** Frames written in place, committed shorter than reserved, up to `MaxDatagrams`
+    */
+    template<typename Format_t>
+    void inPlace()
+    {
+        static uint8_t buffer[2048];
+        usbstd::cdc::NtbEncoder<Format_t, 4> encoder{ buffer };
+        std::vector<std::vector<uint8_t>> sent;
+        for (uint8_t id = 0; ; ++id)
+        {
+            const auto space = encoder.reserve(128);
+            if (space.empty())
+                break;
+            const auto frame = makeFrame(id, 60 + id);
+            std::memcpy(space.data(), frame.data(), frame.size());
+            encoder.commit(frame.size());
+            sent.push_back(frame);
+        }
+        USBSTD_CHECK(encoder.size() == 4);
+        const auto ntb = encoder.finish(7);
+        USBSTD_CHECK(unpack<Format_t>(ntb) == sent);
+
+        // An NTB shorter than its header or its wBlockLength is rejected
+        USBSTD_CHECK(unpack<Format_t>(ntb.first(sizeof(typename Format_t::Nth) - 1)).empty());
+        USBSTD_CHECK(unpack<Format_t>(ntb.first(ntb.size() - 1)).empty());
+    }
+
+} //END: anonymous
+
+int main()
+{
+    roundTrip<usbstd::cdc::Ntb16>("NTB-16");
+    roundTrip<usbstd::cdc::Ntb32>("NTB-32");
+    inPlace<usbstd::cdc::Ntb16>();
+    inPlace<usbstd::cdc::Ntb32>();
+    return usbstd::test::result();
+}
\ No newline at end of file
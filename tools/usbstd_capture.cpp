@@ -0,0 +1,493 @@
+/** usbstd_capture: decode Linux usbmon pcap/pcapng captures
+ * Prints one line per transfer event in the style of the usbmon text interface, followed by decoded descriptors and
+ * CDC line coding where a control transfer carries them.
+ *
+ *   usbstd_capture [-q] [-x bytes] capture.pcapng
+ *   usbstd_capture -s [-j threads] [-c MiB] [-w index] capture.pcapng
+ *   usbstd_capture -r index -d device [-b bus] [-e endpoint] [-R bRequest] [-x bytes] capture.pcapng
+ *
+ *   -q        Only print the summary (decode throughput)
+ *   -x bytes  Hex-dump at most `bytes` of each payload (default 32, at most 65536)
+ *   -s        Print per-device and per-endpoint statistics, decoding chunks of the capture on all cores
+ *   -j        Worker threads for `-s` (default: one per hardware thread)
+ *   -c        Chunk size in MiB for `-s` (default 32)
+ *   -w index  With `-s`, also write a sidecar index of the records of every bus/device/endpoint
+ *   -r index  Only decode the records of the selected device (and endpoint address, where 0 selects both directions of
+ *             the default pipe) using a sidecar index, optionally only control transfers with `bRequest`,
+ *             e.g. `-d 5 -e 0 -R 0x20` for CDC SET_LINE_CODING
+*/
+#include <chrono> //< std::chrono::steady_clock
+#include <cinttypes> //< PRIu64
+#include <cstdint> //< uint8_t, uint64_t
+#include <cstdio> //< std::fwrite, std::snprintf
+#include <cstdlib> //< std::atoi, std::strtol
+#include <cstring> //< std::strcmp
+#include <vector> //< std::vector
+
+#include "usb_capture.hpp" //< usbstd::capture::CaptureReader, usbstd::capture::decode
+#include "usb_capture_analysis.hpp" //< usbstd::capture::analyseCapture, usbstd::capture::CaptureIndex
+#include "usb_cdc.hpp" //< usbstd::cdc::*Descriptor, usbstd::usb_cdc_line_coding_t
+#include "usb_helper_descriptorwalker.hpp" //< usbstd::helper::DescriptorRange
+#include "usb_host_mappedfile.hpp" //< usbstd::host::MappedFile
+
+namespace {
+
+    /** Buffered stdout writer, formats into a fixed buffer and writes it in large blocks
+    */
+    class Output
+    {
+    public:
+        ~Output() { flush(); }
+
+        template<typename... Args_t>
+        void print(const char* format, Args_t... args)
+        {
+            if (sizeof(buffer_) - used_ < MaxLine)
+                flush();
+            const int length = std::snprintf(buffer_ + used_, sizeof(buffer_) - used_, format, argument(args)...);
+            if (length > 0)
+                used_ += (static_cast<size_t>(length) < sizeof(buffer_) - used_) ? static_cast<size_t>(length) : (sizeof(buffer_) - used_ - 1);
+        }
+
+        /// @{ Appenders for the per-transfer line, which skip `snprintf` as it dominates decode time; call `reserve()` first
+
+        void reserve(size_t length)
+        {
+            if (sizeof(buffer_) - used_ < length)
+                flush();
+        }
+
+        void put(char c) { buffer_[used_++] = c; }
+
+        void text(const char* string)
+        {
+            while (*string != '\0')
+                buffer_[used_++] = *string++;
+        }
+
+        void decimal(uint64_t value, unsigned width = 1)
+        {
+            char digits[20];
+            unsigned count = 0;
+            do
+            {
+                digits[count++] = static_cast<char>('0' + (value % 10));
+                value /= 10;
+            } while (value != 0);
+            for (; width > count; --width)
+                buffer_[used_++] = '0';
+            while (count != 0)
+                buffer_[used_++] = digits[--count];
+        }
+
+        void integer(int64_t value)
+        {
+            if (value < 0)
+                put('-');
+            decimal((value < 0) ? (0 - static_cast<uint64_t>(value)) : static_cast<uint64_t>(value));
+        }
+
+        void hexNumber(uint64_t value, unsigned digits)
+        {
+            while (digits != 0)
+                buffer_[used_++] = Digits[(value >> (4 * --digits)) & 0x0f];
+        }
+
+        /** ` xxxxxxxx xxxxxxxx ...`, hex digits grouped by four bytes
+        */
+        void hex(const uint8_t* data, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                if ((i % 4) == 0)
+                    buffer_[used_++] = ' ';
+                buffer_[used_++] = Digits[data[i] >> 4];
+                buffer_[used_++] = Digits[data[i] & 0x0f];
+            }
+        }
+        ///@}
+
+        void flush()
+        {
+            std::fwrite(buffer_, 1, used_, stdout);
+            used_ = 0;
+        }
+
+    private:
+        static constexpr size_t MaxLine = 512;
+        static constexpr char Digits[] = "0123456789abcdef";
+
+        /// Wire fields are `LittleEndian` wrappers, which cannot pass through `...`
+        template<typename Value_t>
+        static Value_t argument(usbstd::LittleEndian<Value_t> value) { return value; }
+        template<typename Value_t>
+        static Value_t argument(Value_t value) { return value; }
+
+        char buffer_[1 << 20];
+        size_t used_ = 0;
+    };
+
+    char transferCode(const usbstd::capture::Transfer& transfer)
+    {
+        switch (transfer.xfer)
+        {
+        case usbstd::USB_CONTROL_ENDPOINT: return 'C';
+        case usbstd::USB_ISOCHRONOUS_ENDPOINT: return 'Z';
+        case usbstd::USB_BULK_ENDPOINT: return 'B';
+        default: return 'I';
+        }
+    }
+
+    void printDescriptors(Output& out, usbstd::Span<const uint8_t> payload)
+    {
+        using namespace usbstd;
+        for (auto descriptor : helper::DescriptorRange{ payload })
+        {
+            if (const auto* device = descriptor.as<DeviceDescriptor>())
+            {
+                const auto& d = device->data;
+                out.print("    DEVICE bcdUSB=%04x class=%u/%u/%u ep0=%u idVendor=%04x idProduct=%04x bcdDevice=%04x configurations=%u\n"
+                    , d.bcdUSB, d.bDeviceClass, d.bDeviceSubClass, d.bDeviceProtocol, d.bMaxPacketSize0, d.idVendor, d.idProduct, d.bcdDevice, d.bNumConfigurations);
+            }
+            else if (const auto* configuration = descriptor.as<ConfigurationDescriptor>())
+            {
+                const auto& d = configuration->data;
+                out.print("    CONFIGURATION wTotalLength=%u interfaces=%u value=%u attributes=%02x maxPower=%umA\n"
+                    , d.wTotalLength, d.bNumInterfaces, d.bConfigurationValue, d.bmAttributes, d.bMaxPower * 2u);
+            }
+            else if (const auto* association = descriptor.as<InterfaceAssociationDescriptor>())
+            {
+                const auto& d = association->data;
+                out.print("    INTERFACE_ASSOCIATION first=%u count=%u class=%u/%u/%u\n"
+                    , d.bFirstInterface, d.bInterfaceCount, d.bFunctionClass, d.bFunctionSubClass, d.bFunctionProtocol);
+            }
+            else if (const auto* interface = descriptor.as<InterfaceDescriptor>())
+            {
+                const auto& d = interface->data;
+                out.print("    INTERFACE %u alt=%u endpoints=%u class=%u/%u/%u\n"
+                    , d.bInterfaceNumber, d.bAlternateSetting, d.bNumEndpoints, d.bInterfaceClass, d.bInterfaceSubClass, d.bInterfaceProtocol);
+            }
+            else if (const auto* endpoint = descriptor.as<EndpointDescriptor>())
+            {
+                static const char* const xferNames[4] = { "control", "isochronous", "bulk", "interrupt" };
+                const auto& d = endpoint->data;
+                out.print("    ENDPOINT %02x %s wMaxPacketSize=%u bInterval=%u\n"
+                    , d.bEndpointAddress, xferNames[d.bmAttributes.xfer()], unsigned(d.wMaxPacketSize.size()), d.bInterval);
+            }
+            else if (const auto* companion = descriptor.as<SuperSpeedEndpointCompanionDescriptor>())
+            {
+                const auto& d = companion->data;
+                out.print("    SS_ENDPOINT_COMPANION bMaxBurst=%u attributes=%02x wBytesPerInterval=%u\n"
+                    , d.bMaxBurst, d.bmAttributes, d.wBytesPerInterval);
+            }
+            else if (const auto* header = descriptor.as<cdc::HeaderDescriptor>())
+                out.print("    CDC_HEADER bcdCDC=%04x\n", header->data.bcdCDC);
+            else if (const auto* call = descriptor.as<cdc::CallDescriptor>())
+                out.print("    CDC_CALL_MANAGEMENT capabilities=%02x dataInterface=%u\n", call->data.bmCapabilities, call->data.bDataInterface);
+            else if (const auto* acm = descriptor.as<cdc::AcmDescriptor>())
+                out.print("    CDC_ACM capabilities=%02x\n", acm->data.bmCapabilities);
+            else if (const auto* cdcUnion = descriptor.as<cdc::UnionDescriptor>())
+                out.print("    CDC_UNION master=%u slave=%u\n", cdcUnion->data.bMasterInterface, cdcUnion->data.bSlaveInterface0);
+            else if (const auto* ethernet = descriptor.as<cdc::EthernetDescriptor>())
+                out.print("    CDC_ETHERNET iMACAddress=%u wMaxSegmentSize=%u\n", ethernet->data.iMACAddress, ethernet->data.wMaxSegmentSize);
+            else if (const auto* ncm = descriptor.as<cdc::NcmDescriptor>())
+                out.print("    CDC_NCM bcdNcmVersion=%04x capabilities=%02x\n", ncm->data.bcdNcmVersion, ncm->data.bmNetworkCapabilities);
+            else if (descriptor.type() == DescriptorType::String)
+                out.print("    STRING length=%u\n", descriptor.length());
+            else
+                out.print("    %s length=%u subtype=%u\n", capture::descriptorName(descriptor.type()), descriptor.length(), descriptor.subType());
+        }
+    }
+
+    void printTransfer(Output& out, const usbstd::capture::Transfer& transfer, const usbstd::Request* setup, size_t hexBytes)
+    {
+        using namespace usbstd;
+        const size_t count = (transfer.data.size() < hexBytes) ? transfer.data.size() : hexBytes;
+        out.reserve(256 + count * 3);
+
+        out.decimal(transfer.timestamp / 1000000000u);
+        out.put('.');
+        out.decimal(transfer.timestamp % 1000000000u, 9);
+        out.put(' ');
+        out.hexNumber(transfer.id, 16);
+        out.put(' ');
+        out.put(transfer.event);
+        out.put(' ');
+        out.put(transferCode(transfer));
+        out.put((transfer.endpoint & USB_IN_ENDPOINT) ? 'i' : 'o');
+        out.put(':');
+        out.decimal(transfer.bus);
+        out.put(':');
+        out.decimal(transfer.device, 3);
+        out.put(':');
+        out.decimal(transfer.endpoint & 0x0f);
+        out.put(' ');
+        out.integer(transfer.status);
+        out.put(' ');
+        out.decimal(transfer.length);
+
+        if (transfer.hasSetup)
+        {
+            const auto& s = transfer.setup;
+            const char* name = capture::requestName(s);
+            out.text(" s ");
+            out.hexNumber(s.bmRequestType, 2);
+            out.put(' ');
+            out.hexNumber(s.bRequest, 2);
+            out.put(' ');
+            out.hexNumber(s.wValue, 4);
+            out.put(' ');
+            out.hexNumber(s.wIndex, 4);
+            out.put(' ');
+            out.hexNumber(s.wLength, 4);
+            if (name != nullptr)
+            {
+                out.put(' ');
+                out.text(name);
+            }
+        }
+
+        if (!transfer.data.empty())
+        {
+            out.text(" =");
+            out.hex(transfer.data.data(), count);
+            if (count < transfer.data.size())
+                out.text(" ...");
+        }
+        out.put('\n');
+
+        if (setup == nullptr)
+            return;
+
+        // Data stages: OUT data is captured on submission, IN data on completion
+        const bool dataStage = (setup->direction() == USB_IN_TRANSFER) ? transfer.completion() : transfer.submission();
+        if (!dataStage || transfer.data.empty())
+            return;
+
+        if (capture::isGetDescriptor(*setup))
+            printDescriptors(out, transfer.data);
+        else if ((setup->type() == USB_CLASS_REQUEST) && ((setup->bRequest == USB_CDC_SET_LINE_CODING) || (setup->bRequest == USB_CDC_GET_LINE_CODING)))
+        {
+            if (const auto* coding = transfer.payloadAs<usb_cdc_line_coding_t>())
+                out.print("    LINE_CODING %u baud, %u data bits, parity %u, stop bits %u\n", coding->dwDTERate, coding->bDataBits, coding->bParityType, coding->bCharFormat);
+        }
+    }
+
+    void printStatistics(const usbstd::capture::CaptureStatistics& statistics)
+    {
+        static const char* const xferNames[4] = { "ctrl", "iso", "bulk", "intr" };
+        auto latency = [](const usbstd::capture::TransferStatistics& t, uint64_t value) { return (t.controlTransfers != 0) ? (value / 1e3) : 0.0; };
+
+        std::printf("%-9s %-8s %-4s %12s %12s %16s %8s %8s %10s %10s %10s\n"
+            , "bus:dev", "endpoint", "type", "submitted", "completed", "bytes", "stalls", "errors", "ctrl avg", "ctrl min", "ctrl max");
+        for (const auto& device : statistics.devices)
+        {
+            std::printf("%3u:%03u   %-8s %-4s %12" PRIu64 " %12" PRIu64 " %16" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8.1fus %8.1fus %8.1fus\n"
+                , device.bus, device.device, "all", "", device.submissions, device.completions, device.bytes, device.stalls, device.errors
+                , latency(device, device.latencyAverage()), latency(device, device.latencyMin), latency(device, device.latencyMax));
+            for (const auto& endpoint : statistics.endpoints)
+            {
+                if ((endpoint.bus != device.bus) || (endpoint.device != device.device))
+                    continue;
+                std::printf("          %02x %-5s %-4s %12" PRIu64 " %12" PRIu64 " %16" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8.1fus %8.1fus %8.1fus\n"
+                    , endpoint.endpoint, (endpoint.endpoint & usbstd::USB_IN_ENDPOINT) ? "in" : "out", xferNames[endpoint.xfer & 0x03]
+                    , endpoint.submissions, endpoint.completions, endpoint.bytes, endpoint.stalls, endpoint.errors
+                    , latency(endpoint, endpoint.latencyAverage()), latency(endpoint, endpoint.latencyMin), latency(endpoint, endpoint.latencyMax));
+            }
+        }
+    }
+
+    struct Arguments
+    {
+        const char* path = nullptr;
+        const char* writeIndex = nullptr;
+        const char* readIndex = nullptr;
+        bool quiet = false;
+        bool statistics = false;
+        size_t hexBytes = 32;
+        size_t threads = 0;
+        size_t chunkMiB = 32;
+        int bus = -1;
+        int device = -1;
+        int endpoint = -1;
+        int request = -1;
+    };
+
+    /** Decode only the records of the selected streams, merged in capture order
+    */
+    int query(const Arguments& arguments, const usbstd::host::MappedFile& file, usbstd::capture::CaptureReader& reader)
+    {
+        usbstd::host::MappedFile indexFile{ arguments.readIndex, false };
+        const usbstd::capture::CaptureIndex index{ indexFile.bytes() };
+        if (!indexFile || !index.valid(file.size()))
+        {
+            std::fprintf(stderr, "%s: missing or stale index, rebuild it with -s -w\n", arguments.readIndex);
+            return 1;
+        }
+
+        using Offsets = usbstd::capture::CaptureIndex::Offsets;
+        struct Cursor { Offsets::iterator position; Offsets::iterator end; };
+        std::vector<Cursor> cursors;
+        for (const auto& stream : index.streams())
+        {
+            if (((arguments.bus < 0) || (stream.bus == arguments.bus))
+                && (stream.device == arguments.device)
+                && ((arguments.endpoint < 0) || (stream.endpoint == arguments.endpoint)
+                    || ((stream.xfer == usbstd::USB_CONTROL_ENDPOINT) && ((stream.endpoint & usbstd::USB_INDEX_MASK) == arguments.endpoint))))
+            {
+                const auto offsets = index.offsets(stream);
+                cursors.push_back({ offsets.begin(), offsets.end() });
+            }
+        }
+
+        static Output out;
+        static usbstd::capture::ControlTracker<> tracker;
+        usbstd::capture::Packet packet;
+        usbstd::capture::Transfer transfer;
+        for (;;)
+        {
+            Cursor* earliest = nullptr;
+            for (auto& cursor : cursors)
+            {
+                if ((cursor.position != cursor.end) && ((earliest == nullptr) || (*cursor.position < *earliest->position)))
+                    earliest = &cursor;
+            }
+            if (earliest == nullptr)
+                break;
+
+            reader.seek(*earliest->position);
+            ++earliest->position;
+            if (!reader.next(packet) || !usbstd::capture::decode(packet, transfer))
+                continue;
+
+            const usbstd::Request* setup = tracker.track(transfer);
+            if ((arguments.request >= 0) && ((setup == nullptr) || (setup->bRequest != arguments.request)))
+                continue;
+            printTransfer(out, transfer, setup, arguments.hexBytes);
+        }
+        return 0;
+    }
+
+} //END: anonymous
+
+int main(int argc, char* argv[])
+{
+    Arguments arguments;
+    constexpr size_t MaxHexBytes = 65536;
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = (i + 1 < argc);
+        if (std::strcmp(argv[i], "-q") == 0)
+            arguments.quiet = true;
+        else if (std::strcmp(argv[i], "-s") == 0)
+            arguments.statistics = true;
+        else if ((std::strcmp(argv[i], "-x") == 0) && hasValue)
+        {
+            arguments.hexBytes = static_cast<size_t>(std::atoi(argv[++i]));
+            arguments.hexBytes = (arguments.hexBytes < MaxHexBytes) ? arguments.hexBytes : MaxHexBytes;
+        }
+        else if ((std::strcmp(argv[i], "-j") == 0) && hasValue)
+            arguments.threads = static_cast<size_t>(std::atoi(argv[++i]));
+        else if ((std::strcmp(argv[i], "-c") == 0) && hasValue)
+            arguments.chunkMiB = static_cast<size_t>(std::atoi(argv[++i]));
+        else if ((std::strcmp(argv[i], "-w") == 0) && hasValue)
+            arguments.writeIndex = argv[++i];
+        else if ((std::strcmp(argv[i], "-r") == 0) && hasValue)
+            arguments.readIndex = argv[++i];
+        else if ((std::strcmp(argv[i], "-b") == 0) && hasValue)
+            arguments.bus = static_cast<int>(std::strtol(argv[++i], nullptr, 0));
+        else if ((std::strcmp(argv[i], "-d") == 0) && hasValue)
+            arguments.device = static_cast<int>(std::strtol(argv[++i], nullptr, 0));
+        else if ((std::strcmp(argv[i], "-e") == 0) && hasValue)
+            arguments.endpoint = static_cast<int>(std::strtol(argv[++i], nullptr, 0));
+        else if ((std::strcmp(argv[i], "-R") == 0) && hasValue)
+            arguments.request = static_cast<int>(std::strtol(argv[++i], nullptr, 0));
+        else
+            arguments.path = argv[i];
+    }
+    if ((arguments.path == nullptr) || ((arguments.readIndex != nullptr) && (arguments.device < 0)))
+    {
+        std::fprintf(stderr, "usage: %s [-q] [-x bytes] capture\n"
+            "       %s -s [-j threads] [-c MiB] [-w index] capture\n"
+            "       %s -r index -d device [-b bus] [-e endpoint] [-R bRequest] [-x bytes] capture\n", argv[0], argv[0], argv[0]);
+        return 2;
+    }
+    const char* path = arguments.path;
+
+    usbstd::host::MappedFile file{ path, arguments.readIndex == nullptr };
+    if (!file)
+    {
+        std::fprintf(stderr, "%s: cannot map file\n", path);
+        return 1;
+    }
+
+    usbstd::capture::CaptureReader reader{ file.bytes() };
+    if (!reader.valid())
+    {
+        std::fprintf(stderr, "%s: not a pcap or pcapng capture of this host's byte order\n", path);
+        return 1;
+    }
+
+    if (arguments.readIndex != nullptr)
+        return query(arguments, file, reader);
+
+    const auto start = std::chrono::steady_clock::now();
+    auto throughput = [&](uint64_t packets, uint64_t transfers, bool truncated)
+    {
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::fprintf(stderr, "%" PRIu64 " packets, %" PRIu64 " usbmon transfers, %.1f MB in %.3f s (%.0f MB/s)%s\n"
+            , packets, transfers, file.size() / 1e6, seconds, (seconds > 0) ? (file.size() / 1e6 / seconds) : 0.0
+            , truncated ? ", capture truncated" : "");
+    };
+
+    if (arguments.statistics)
+    {
+        usbstd::capture::AnalysisOptions options;
+        options.threads = arguments.threads;
+        options.chunkSize = ((arguments.chunkMiB != 0) ? arguments.chunkMiB : 1) << 20;
+
+        std::vector<uint8_t> index;
+        const auto statistics = usbstd::capture::analyseCapture(file.bytes(), options, (arguments.writeIndex != nullptr) ? &index : nullptr);
+        throughput(statistics.packets, statistics.transfers, statistics.truncated);
+        printStatistics(statistics);
+
+        if (arguments.writeIndex != nullptr)
+        {
+            std::FILE* output = std::fopen(arguments.writeIndex, "wb");
+            if ((output == nullptr) || (std::fwrite(index.data(), 1, index.size(), output) != index.size()))
+            {
+                std::fprintf(stderr, "%s: cannot write index\n", arguments.writeIndex);
+                if (output != nullptr)
+                    std::fclose(output);
+                return 1;
+            }
+            std::fclose(output);
+            std::fprintf(stderr, "%s: %zu bytes\n", arguments.writeIndex, index.size());
+        }
+        return 0;
+    }
+
+    static Output out; //< Large buffer, kept off the stack
+    static usbstd::capture::ControlTracker<> tracker;
+    uint64_t packets = 0;
+    uint64_t transfers = 0;
+
+    usbstd::capture::Packet packet;
+    usbstd::capture::Transfer transfer;
+    while (reader.next(packet))
+    {
+        ++packets;
+        if (!usbstd::capture::decode(packet, transfer))
+            continue;
+        ++transfers;
+
+        const usbstd::Request* setup = tracker.track(transfer);
+        if (!arguments.quiet)
+            printTransfer(out, transfer, setup, arguments.hexBytes);
+    }
+    out.flush();
+    throughput(packets, transfers, reader.truncated());
+    if (tracker.overwritten() != 0)
+        std::fprintf(stderr, "%" PRIu64 " control SETUPs lost, more than %zu transfers outstanding\n", tracker.overwritten(), tracker.CapacityCount);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+/** usbstd_feedback: simulate the UAC2 asynchronous feedback loop against a drifting device clock
+ * Drives `usbstd::audio::FeedbackEstimator` with the clock model of `usbstd::host::simulateFeedback` and reports how fast
+ * the feedback converges, how much it jitters once converged, and whether the sink buffer ever under- or overruns.
+ *
+ *   usbstd_feedback [-H] [-r rate] [-p ppm] [-w ppm] [-W seconds] [-J ns] [-k shift] [-P log2] [-f log2] [-g log2]
+ *                   [-b samples] [-t seconds] [-T ppm] [-v]
+ *
+ *   -H          High speed: 125 µs microframes and 16.16 feedback (default full speed, 10.14)
+ *   -r rate     Nominal sample rate in Hz (default 48000)
+ *   -p ppm      Static device clock error (default 150)
+ *   -w ppm      Device clock wander amplitude (default 20), -W its period in seconds (default 30)
+ *   -J ns       SOF capture jitter, standard deviation (default 200)
+ *   -k shift    log2 of sample clock counter ticks per sample (default 8, a 256 fs MCLK)
+ *   -P log2     (Micro)frames per rate measurement (default 3 at full speed, 6 at high speed)
+ *   -f log2     IIR filter time constant in measurements (default 4)
+ *   -g log2     Milliseconds over which a fill level error is corrected (default 10)
+ *   -b samples  Sink buffer capacity, the fill target is half of it (default 192)
+ *   -t seconds  Simulated time (default 60)
+ *   -T ppm      Convergence tolerance (default 50)
+ *   -v          Print a CSV trace of every (micro)frame: frame, feedback ppm from nominal, error ppm, fill
+*/
+#include <cinttypes> //< PRIu64, PRId64
+#include <cstdint> //< uint64_t, int64_t
+#include <cstdio> //< std::printf, std::fprintf
+#include <cstdlib> //< std::atoi, std::atof
+#include <cstring> //< std::strcmp
+
+#include "usb_host_audiosim.hpp" //< usbstd::host::simulateFeedback
+
+int main(int argc, char* argv[])
+{
+    usbstd::host::FeedbackSimulationConfig config;
+    int periodLog2 = -1;
+    bool trace = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = (i + 1 < argc);
+        if (std::strcmp(argv[i], "-H") == 0)
+            config.speed = usbstd::BusSpeed::High;
+        else if (std::strcmp(argv[i], "-v") == 0)
+            trace = true;
+        else if ((std::strcmp(argv[i], "-r") == 0) && hasValue)
+            config.sampleRate = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if ((std::strcmp(argv[i], "-p") == 0) && hasValue)
+            config.offsetPpm = std::atof(argv[++i]);
+        else if ((std::strcmp(argv[i], "-w") == 0) && hasValue)
+            config.wanderPpm = std::atof(argv[++i]);
+        else if ((std::strcmp(argv[i], "-W") == 0) && hasValue)
+            config.wanderSeconds = std::atof(argv[++i]);
+        else if ((std::strcmp(argv[i], "-J") == 0) && hasValue)
+            config.sofJitterNs = std::atof(argv[++i]);
+        else if ((std::strcmp(argv[i], "-k") == 0) && hasValue)
+            config.tickShift = static_cast<uint8_t>(std::atoi(argv[++i]));
+        else if ((std::strcmp(argv[i], "-P") == 0) && hasValue)
+            periodLog2 = std::atoi(argv[++i]);
+        else if ((std::strcmp(argv[i], "-f") == 0) && hasValue)
+            config.filterShift = static_cast<uint8_t>(std::atoi(argv[++i]));
+        else if ((std::strcmp(argv[i], "-g") == 0) && hasValue)
+            config.gainShift = static_cast<uint8_t>(std::atoi(argv[++i]));
+        else if ((std::strcmp(argv[i], "-b") == 0) && hasValue)
+            config.bufferSamples = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if ((std::strcmp(argv[i], "-t") == 0) && hasValue)
+            config.seconds = std::atof(argv[++i]);
+        else if ((std::strcmp(argv[i], "-T") == 0) && hasValue)
+            config.tolerancePpm = std::atof(argv[++i]);
+        else
+        {
+            std::fprintf(stderr, "usage: %s [-H] [-r rate] [-p ppm] [-w ppm] [-W seconds] [-J ns] [-k shift] [-P log2] [-f log2] [-g log2]\n"
+                "       [-b samples] [-t seconds] [-T ppm] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    const bool highSpeed = config.speed >= usbstd::BusSpeed::High;
+    config.periodLog2 = static_cast<uint8_t>((periodLog2 >= 0) ? periodLog2 : (highSpeed ? 6 : 3));
+    if ((config.sampleRate == 0) || (config.bufferSamples < 2) || (config.tickShift + config.periodLog2 > 24))
+    {
+        std::fprintf(stderr, "%s: invalid configuration\n", argv[0]);
+        return 2;
+    }
+
+    usbstd::host::FeedbackSimulationResult result;
+    if (trace)
+    {
+        std::printf("frame,feedback_ppm,error_ppm,fill\n");
+        result = usbstd::host::simulateFeedback(config, [](uint64_t frame, double feedbackPpm, double errorPpm, int64_t fill)
+        {
+            std::printf("%" PRIu64 ",%.3f,%.3f,%" PRId64 "\n", frame, feedbackPpm, errorPpm, fill);
+        });
+    }
+    else
+        result = usbstd::host::simulateFeedback(config);
+
+    const double framePeriod = highSpeed ? 125e-6 : 1e-3;
+    std::fprintf(trace ? stderr : stdout,
+        "%s speed, %u Hz, device clock %+.1f ppm (wander %.1f ppm), SOF jitter %.0f ns\n"
+        "converged:  %s after %" PRIu64 " (micro)frames (%.3f s) within %.0f ppm\n"
+        "jitter:     %.2f ppm rms, %.2f ppm max\n"
+        "fill:       %" PRId64 "..%" PRId64 " of %u samples, %" PRIu64 " underrun, %" PRIu64 " overrun\n",
+        highSpeed ? "high" : "full", config.sampleRate, config.offsetPpm, config.wanderPpm, config.sofJitterNs,
+        result.converged() ? "yes" : "no", result.convergenceFrames, result.convergenceFrames * framePeriod, config.tolerancePpm,
+        result.rmsPpm, result.maxPpm,
+        result.fillMin, result.fillMax, config.bufferSamples, result.underruns, result.overruns);
+    return (result.converged() && (result.underruns == 0) && (result.overruns == 0)) ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,426 @@
+#pragma once
+
+#include <atomic> //< std::atomic
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t, uint32_t, int32_t, int64_t, uint64_t
+
+#include "usb_descriptor.hpp" //< usbstd::SubTypeDescriptor, usbstd::BusSpeed
+#include "usb_endian.hpp" //< usbstd::Le16, usbstd::Le32
+
+namespace usbstd {
+
+    /** Audio class requests, with `wValue` holding the control selector and channel
+     * @see USB Audio Class 2.0 specification A.14
+    */
+    enum
+    {
+        USB_AUDIO_CUR = 0x01,
+        USB_AUDIO_RANGE = 0x02,
+        USB_AUDIO_MEM = 0x03,
+    };
+
+    enum class AudioSubClass : uint8_t
+    {
+        Undefined = 0x00,
+        AudioControl = 0x01,
+        AudioStreaming = 0x02,
+        MidiStreaming = 0x03,
+    };
+
+    enum class AudioProtocol : uint8_t
+    {
+        Undefined = 0x00, ///< Audio Class 1.0
+        Ip20 = 0x20, ///< Audio Class 2.0, also the IAD `bFunctionProtocol`
+    };
+
+    /** `bCategory` of the audio control header, the primary use of the function
+    */
+    enum class AudioFunctionCategory : uint8_t
+    {
+        DesktopSpeaker = 0x01,
+        HomeTheater = 0x02,
+        Microphone = 0x03,
+        Headset = 0x04,
+        Telephone = 0x05,
+        Converter = 0x06,
+        VoiceSoundRecorder = 0x07,
+        IoBox = 0x08,
+        MusicalInstrument = 0x09,
+        ProAudio = 0x0a,
+        AudioVideo = 0x0b,
+        ControlPanel = 0x0c,
+        Other = 0xff,
+    };
+
+    enum class AudioControlSubType : uint8_t
+    {
+        Header = 0x01,
+        InputTerminal = 0x02,
+        OutputTerminal = 0x03,
+        MixerUnit = 0x04,
+        SelectorUnit = 0x05,
+        FeatureUnit = 0x06,
+        EffectUnit = 0x07,
+        ProcessingUnit = 0x08,
+        ExtensionUnit = 0x09,
+        ClockSource = 0x0a,
+        ClockSelector = 0x0b,
+        ClockMultiplier = 0x0c,
+        SampleRateConverter = 0x0d,
+    };
+
+    enum class AudioStreamingSubType : uint8_t
+    {
+        General = 0x01,
+        FormatType = 0x02,
+        Encoder = 0x03,
+        Decoder = 0x04,
+    };
+
+    enum class AudioEndpointSubType : uint8_t
+    {
+        General = 0x01,
+    };
+
+    /** `wTerminalType`
+     * @see USB Audio Terminal Types 2.0
+    */
+    enum class AudioTerminalType : uint16_t
+    {
+        UsbStreaming = 0x0101,
+        Microphone = 0x0201,
+        Speaker = 0x0301,
+        Headphones = 0x0302,
+        Headset = 0x0402,
+        LineConnector = 0x0603,
+        SpdifInterface = 0x0605,
+    };
+
+    /** Control selectors (high byte of `wValue`)
+    */
+    enum
+    {
+        USB_AUDIO_CS_SAM_FREQ_CONTROL = 0x01, ///< Clock source sampling frequency, 4 byte CUR and RANGE
+        USB_AUDIO_CS_CLOCK_VALID_CONTROL = 0x02,
+        USB_AUDIO_FU_MUTE_CONTROL = 0x01,
+        USB_AUDIO_FU_VOLUME_CONTROL = 0x02, ///< 1/256 dB steps, 2 byte CUR and RANGE
+        USB_AUDIO_AS_ACT_ALT_SETTING_CONTROL = 0x01,
+        USB_AUDIO_AS_VAL_ALT_SETTINGS_CONTROL = 0x02,
+    };
+
+    /** Clock source `bmAttributes`
+    */
+    enum AudioClockAttributes
+    {
+        ExternalClock = 0x00,
+        InternalFixedClock = 0x01,
+        InternalVariableClock = 0x02,
+        InternalProgrammableClock = 0x03,
+        SyncToSof = 0x04,
+    };
+
+    /** `bmControls` pairs: none, read-only or host programmable
+    */
+    enum AudioControlAccess
+    {
+        ControlReadOnly = 0x1,
+        ControlProgrammable = 0x3,
+    };
+
+    constexpr uint32_t audioControl(AudioControlAccess access, unsigned control) { return uint32_t(access) << (2 * (control - 1)); }
+
+    enum class AudioFormatType : uint8_t
+    {
+        TypeI = 0x01,
+        TypeII = 0x02,
+        TypeIII = 0x03,
+    };
+
+    /** Type I `bmFormats`
+    */
+    enum AudioFormats : uint32_t
+    {
+        Pcm = (1u << 0),
+        Pcm8 = (1u << 1),
+        IeeeFloat = (1u << 2),
+        Alaw = (1u << 3),
+        Mulaw = (1u << 4),
+        Raw = (1u << 31),
+    };
+
+#pragma pack(push, 1)
+
+    template<>
+    struct SubTypeDescriptorData<DescriptorType::CsInterface, AudioControlSubType::Header>
+    {
+        Le16 bcdADC; ///< 0x0200
+        AudioFunctionCategory bCategory;
+        Le16 wTotalLength; ///< Total length of the class-specific audio control descriptors, including this header
+        uint8_t  bmControls; ///< Latency control
+    };
+
+    template<>
+    struct SubTypeDescriptorData<DescriptorType::CsInterface, AudioControlSubType::ClockSource>
+    {
+        uint8_t  bClockID;
+        uint8_t  bmAttributes; ///< `AudioClockAttributes`
+        uint8_t  bmControls; ///< Frequency and validity controls, see `audioControl()`
+        uint8_t  bAssocTerminal;
+        uint8_t  iClockSource;
+    };
+
+    template<>
+    struct SubTypeDescriptorData<DescriptorType::CsInterface, AudioControlSubType::InputTerminal>
+    {
+        uint8_t  bTerminalID;
+        Le16 wTerminalType; ///< `AudioTerminalType`, see `terminalType()`
+        uint8_t  bAssocTerminal;
+        uint8_t  bCSourceID; ///< Clock entity of the terminal
+        uint8_t  bNrChannels;
+        Le32 bmChannelConfig; ///< Spatial location of the channels, 0x3 for front left and right
+        uint8_t  iChannelNames;
+        Le16 bmControls;
+        uint8_t  iTerminal;
+
+        constexpr AudioTerminalType terminalType() const { return static_cast<AudioTerminalType>(wTerminalType.value()); }
+        constexpr void terminalType(AudioTerminalType type) { wTerminalType = static_cast<uint16_t>(type); }
+    };
+
+    template<>
+    struct SubTypeDescriptorData<DescriptorType::CsInterface, AudioControlSubType::OutputTerminal>
+    {
+        uint8_t  bTerminalID;
+        Le16 wTerminalType; ///< `AudioTerminalType`, see `terminalType()`
+        uint8_t  bAssocTerminal;
+        uint8_t  bSourceID; ///< Unit or terminal the output is connected to
+        uint8_t  bCSourceID;
+        Le16 bmControls;
+        uint8_t  iTerminal;
+
+        constexpr AudioTerminalType terminalType() const { return static_cast<AudioTerminalType>(wTerminalType.value()); }
+        constexpr void terminalType(AudioTerminalType type) { wTerminalType = static_cast<uint16_t>(type); }
+    };
+
+    /** Feature unit with controls for the master channel and `Channels` logical channels
+    */
+    template<uint8_t Channels>
+    struct AudioFeatureUnitData
+    {
+        uint8_t  bUnitID;
+        uint8_t  bSourceID;
+        Le32 bmaControls[Channels + 1]; ///< Master channel first, see `audioControl()`
+        uint8_t  iFeature;
+    };
+
+    template<>
+    struct SubTypeDescriptorData<DescriptorType::CsInterface, AudioStreamingSubType::General>
+    {
+        uint8_t  bTerminalLink; ///< Terminal connected to the streaming endpoint
+        uint8_t  bmControls;
+        AudioFormatType bFormatType;
+        Le32 bmFormats; ///< `AudioFormats`
+        uint8_t  bNrChannels;
+        Le32 bmChannelConfig;
+        uint8_t  iChannelNames;
+    };
+
+    template<>
+    struct SubTypeDescriptorData<DescriptorType::CsInterface, AudioStreamingSubType::FormatType>
+    {
+        AudioFormatType bFormatType;
+        uint8_t  bSubslotSize; ///< Bytes per sample in the stream: 1, 2, 3 or 4
+        uint8_t  bBitResolution;
+    };
+
+    template<>
+    struct SubTypeDescriptorData<DescriptorType::CsEndpoint, AudioEndpointSubType::General>
+    {
+        uint8_t  bmAttributes; ///< D7: only full-size packets
+        uint8_t  bmControls;
+        uint8_t  bLockDelayUnits; ///< 1: milliseconds, 2: decoded PCM samples
+        Le16 wLockDelay;
+    };
+
+#pragma pack(pop)
+
+namespace audio {
+
+    using HeaderDescriptor = CsInterfaceDescriptor<AudioControlSubType::Header>;
+    using ClockSourceDescriptor = CsInterfaceDescriptor<AudioControlSubType::ClockSource>;
+    using InputTerminalDescriptor = CsInterfaceDescriptor<AudioControlSubType::InputTerminal>;
+    using OutputTerminalDescriptor = CsInterfaceDescriptor<AudioControlSubType::OutputTerminal>;
+    template<uint8_t Channels>
+    using FeatureUnitDescriptor = SubTypeDescriptor<DescriptorType::CsInterface, AudioControlSubType::FeatureUnit, AudioFeatureUnitData<Channels> >;
+    using StreamingGeneralDescriptor = CsInterfaceDescriptor<AudioStreamingSubType::General>;
+    using FormatTypeIDescriptor = CsInterfaceDescriptor<AudioStreamingSubType::FormatType>;
+    using IsoEndpointDescriptor = CsEndpointDescriptor<AudioEndpointSubType::General>;
+
+    static_assert(sizeof(HeaderDescriptor) == 9, "size is not correct");
+    static_assert(sizeof(ClockSourceDescriptor) == 8, "size is not correct");
+    static_assert(sizeof(InputTerminalDescriptor) == 17, "size is not correct");
+    static_assert(sizeof(OutputTerminalDescriptor) == 12, "size is not correct");
+    static_assert(sizeof(FeatureUnitDescriptor<2>) == 18, "size is not correct");
+    static_assert(sizeof(StreamingGeneralDescriptor) == 16, "size is not correct");
+    static_assert(sizeof(FormatTypeIDescriptor) == 6, "size is not correct");
+    static_assert(sizeof(IsoEndpointDescriptor) == 8, "size is not correct");
+
+    /** Rate feedback for an asynchronous isochronous OUT (sink) endpoint
+     * The host sends as many samples per (micro)frame as the feedback endpoint reports. The estimator measures the
+     * device sample clock against SOF: the caller captures a free-running sample clock counter (e.g. a timer clocked by
+     * MCLK) at every SOF, and the counter difference over 2^`periodLog2` (micro)frames gives the rate with sub-sample
+     * resolution. Measurements are smoothed by a first order IIR filter, and a proportional term steers the buffer fill
+     * level towards its target so quantisation and start-up errors do not accumulate.
+     *
+     * Internally rates are Q16.16 samples per (micro)frame. The feedback value is 10.14 samples per frame at full speed
+     * (3 bytes) and 16.16 samples per microframe at high speed (4 bytes).
+     * All arithmetic is integer shifts and adds: no division, no allocation, safe to run in the SOF interrupt.
+     * `level()` may be called from another interrupt, e.g. the audio DMA.
+     * @code
+     *   static usbstd::audio::FeedbackEstimator feedback{ 48000, usbstd::BusSpeed::Full, 8 }; // MCLK = 256 fs
+     *   feedback.target(96);
+     *
+     *   void onSof()          { feedback.sof(MCLK_TIMER->CNT); }
+     *   void onAudioDma()     { feedback.level(samplesBuffered()); }
+     *   void onFeedbackIn()   { uint8_t value[4]; startIn(FEEDBACK_EP, value, feedback.encode(value)); }
+     * @endcode
+    */
+    class FeedbackEstimator
+    {
+    public:
+        /**
+         * @param sampleRate  Nominal sample rate in Hz
+         * @param speed  `BusSpeed::Full` for 1 ms frames, `BusSpeed::High` for 125 µs microframes
+         * @param tickShift  log2 of sample clock counter ticks per sample, 0 when the counter counts samples
+         * @param periodLog2  log2 of (micro)frames per rate measurement
+         * @param filterShift  log2 of the IIR filter time constant, in measurements
+         * @param gainShift  log2 of the milliseconds over which a fill level error is corrected
+        */
+        explicit FeedbackEstimator(uint32_t sampleRate, BusSpeed speed = BusSpeed::Full, uint8_t tickShift = 0, uint8_t periodLog2 = 3, uint8_t filterShift = 4, uint8_t gainShift = 10)
+            : nominal_(nominalRate(sampleRate, speed)), highSpeed_(speed >= BusSpeed::High)
+            , measureShift_(16 - int(tickShift) - int(periodLog2)), periodLog2_(periodLog2), filterShift_(filterShift), gainShift_(static_cast<uint8_t>(gainShift + (highSpeed_ ? 3 : 0)))
+        {
+            reset();
+        }
+
+        /** Q16.16 samples per (micro)frame at `sampleRate`
+        */
+        static constexpr uint32_t nominalRate(uint32_t sampleRate, BusSpeed speed)
+        {
+            return static_cast<uint32_t>((uint64_t(sampleRate) << 16) / ((speed >= BusSpeed::High) ? 8000 : 1000));
+        }
+
+        /** Restart measuring, e.g. when the streaming interface is selected or the sample rate changes
+        */
+        void reset()
+        {
+            frames_ = 0;
+            measured_ = false;
+            filter_ = int64_t(nominal_) << filterShift_;
+            rate_ = nominal_;
+            feedback_.store(nominal_, std::memory_order_relaxed);
+        }
+
+        /** Target buffer fill level in samples, the level `level()` is steered towards
+        */
+        void target(int32_t samples) { target_.store(samples, std::memory_order_relaxed); fill_.store(samples, std::memory_order_relaxed); }
+
+        /** Current buffer fill level in samples
+        */
+        void level(int32_t samples) { fill_.store(samples, std::memory_order_relaxed); }
+
+        /** Start of (micro)frame with the sample clock counter captured at SOF
+        */
+        void sof(uint32_t ticks)
+        {
+            if (!measured_)
+            {
+                measured_ = true;
+                reference_ = ticks;
+                frames_ = 0;
+                return;
+            }
+            if (++frames_ < (1u << periodLog2_))
+                return;
+
+            const uint32_t elapsed = ticks - reference_;
+            reference_ = ticks;
+            frames_ = 0;
+
+            const uint32_t measured = (measureShift_ >= 0) ? (elapsed << measureShift_) : (elapsed >> -measureShift_);
+            filter_ += int64_t(measured) - (filter_ >> filterShift_);
+            rate_ = static_cast<uint32_t>(filter_ >> filterShift_);
+            publish();
+        }
+
+        /** Filtered sample clock rate, Q16.16 samples per (micro)frame
+        */
+        uint32_t rate() const { return rate_; }
+
+        /** Rate reported to the host, Q16.16 samples per (micro)frame
+        */
+        uint32_t feedback() const { return feedback_.load(std::memory_order_relaxed); }
+
+        uint32_t nominal() const { return nominal_; }
+
+        /** Feedback endpoint payload, 3 bytes of 10.14 at full speed or 4 bytes of 16.16 at high speed
+         * @return Bytes written
+        */
+        size_t encode(uint8_t* data) const
+        {
+            const uint32_t value = highSpeed_ ? feedback() : (feedback() >> 2);
+            const size_t size = highSpeed_ ? 4 : 3;
+            for (size_t i = 0; i < size; ++i)
+                data[i] = static_cast<uint8_t>(value >> (8 * i));
+            return size;
+        }
+
+        /** Host side interpretation of a feedback payload, Q16.16 samples per (micro)frame
+        */
+        static constexpr uint32_t decode(const uint8_t* data, size_t size)
+        {
+            uint32_t value = 0;
+            for (size_t i = 0; i < size; ++i)
+                value |= uint32_t(data[i]) << (8 * i);
+            return (size == 3) ? (value << 2) : value;
+        }
+
+    private:
+        void publish()
+        {
+            // A fuller buffer asks the host for fewer samples. Packet boundaries make the fill level itself jitter by a
+            // sample, which is not worth chasing
+            int64_t error = int64_t(target_.load(std::memory_order_relaxed)) - fill_.load(std::memory_order_relaxed);
+            error = (error > 1) ? (error - 1) : ((error < -1) ? (error + 1) : 0);
+            const int64_t limit = nominal_ >> 7; //< Correct by at most 1/128 of the nominal rate
+            int64_t correction = (error * 65536) >> gainShift_;
+            correction = (correction > limit) ? limit : ((correction < -limit) ? -limit : correction);
+
+            // Hosts reject feedback too far from nominal, stay within 1/8
+            int64_t value = int64_t(rate_) + correction;
+            const int64_t low = nominal_ - (nominal_ >> 3);
+            const int64_t high = nominal_ + (nominal_ >> 3);
+            value = (value < low) ? low : ((value > high) ? high : value);
+            feedback_.store(static_cast<uint32_t>(value), std::memory_order_relaxed);
+        }
+
+        uint32_t nominal_;
+        bool highSpeed_;
+        int8_t measureShift_; ///< Converts elapsed ticks over a measurement to Q16.16 samples per (micro)frame
+        uint8_t periodLog2_;
+        uint8_t filterShift_;
+        uint8_t gainShift_; ///< In (micro)frames
+
+        // SOF interrupt
+        bool measured_ = false;
+        uint32_t frames_ = 0;
+        uint32_t reference_ = 0;
+        int64_t filter_ = 0; ///< Q16.16 rate scaled by 2^filterShift
+        uint32_t rate_ = 0;
+
+        std::atomic<int32_t> target_ = { 0 };
+        std::atomic<int32_t> fill_ = { 0 };
+        std::atomic<uint32_t> feedback_ = { 0 };
+    };
+
+} //END: audio
+} //END: usbstd
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 
+#include "usb_descriptor.hpp"
+#include "usb_endian.hpp"
+
 namespace usbstd
 {
 #pragma pack(push, 1)
@@ -18,6 +22,90 @@ namespace usbstd
         MS_OS_20_FEATURE_VENDOR_REVISION = 0x08
     } microsoft_os_20_type_t;
 
+    /// `wIndex` of the vendor request (`bRequest` = `bMS_VendorCode`) retrieving the MS OS 2.0 descriptor set
+    enum
+    {
+        MS_OS_20_DESCRIPTOR_INDEX = 0x07,
+        MS_OS_20_SET_ALT_ENUMERATION = 0x08,
+    };
+
+    /// `wPropertyDataType` of a registry property descriptor
+    typedef enum
+    {
+        MS_OS_20_REG_SZ = 0x01, ///< NULL-terminated UTF-16LE string
+        MS_OS_20_REG_EXPAND_SZ = 0x02, ///< NULL-terminated UTF-16LE string with environment variables
+        MS_OS_20_REG_BINARY = 0x03,
+        MS_OS_20_REG_DWORD_LITTLE_ENDIAN = 0x04,
+        MS_OS_20_REG_DWORD_BIG_ENDIAN = 0x05,
+        MS_OS_20_REG_LINK = 0x06,
+        MS_OS_20_REG_MULTI_SZ = 0x07, ///< NULL-terminated UTF-16LE strings, ended by an empty string
+    } microsoft_os_20_property_data_type_t;
+
+    /** `bDevCapabilityType` of a `DescriptorType::DeviceCapability` descriptor
+     * @see USB 3.2 specification Table 9-14
+    */
+    enum class DeviceCapabilityType : uint8_t
+    {
+        WirelessUsb = 0x01,
+        Usb20Extension = 0x02,
+        SuperSpeedUsb = 0x03,
+        ContainerId = 0x04,
+        Platform = 0x05,
+        SuperSpeedPlus = 0x0a,
+    };
+
+    /// USB 2.0 extension `bmAttributes`
+    enum Usb20ExtensionAttributes : uint32_t
+    {
+        Lpm = (1u << 1), ///< Link Power Management supported
+        Besl = (1u << 2), ///< BESL and alternate HIRD definitions supported (LPM errata)
+        BaselineBeslValid = (1u << 3), ///< Bits 11..8 hold the recommended baseline BESL
+        DeepBeslValid = (1u << 4), ///< Bits 15..12 hold the recommended deep BESL
+    };
+
+    /// SuperSpeed USB `wSpeedsSupported`
+    enum SuperSpeedSupport : uint16_t
+    {
+        SupportsLowSpeed = (1u << 0),
+        SupportsFullSpeed = (1u << 1),
+        SupportsHighSpeed = (1u << 2),
+        SupportsSuperSpeed = (1u << 3), ///< 5 Gbps
+    };
+
+    template<>
+    struct SubTypeDescriptorData<DescriptorType::DeviceCapability, DeviceCapabilityType::Usb20Extension>
+    {
+        Le32 bmAttributes; ///< `Usb20ExtensionAttributes`, LPM must be set by SuperSpeed devices operating at high speed
+    };
+
+    template<>
+    struct SubTypeDescriptorData<DescriptorType::DeviceCapability, DeviceCapabilityType::SuperSpeedUsb>
+    {
+        uint8_t  bmAttributes; ///< Bit 1: Latency Tolerance Messages supported
+        Le16 wSpeedsSupported; ///< `SuperSpeedSupport` speeds the device operates at
+        uint8_t  bFunctionalitySupport; ///< Lowest speed at which all functionality is available, 0 (low) to 3 (SuperSpeed)
+        uint8_t  bU1DevExitLat; ///< U1 exit latency in µs, at most 10
+        Le16 wU2DevExitLat; ///< U2 exit latency in µs, at most 2047
+    };
+
+    template<>
+    struct SubTypeDescriptorData<DescriptorType::DeviceCapability, DeviceCapabilityType::ContainerId>
+    {
+        uint8_t  bReserved;
+        uint8_t  containerID[16]; ///< UUID of the device instance, the same across all speeds
+    };
+
+    namespace bos
+    {
+        using Usb20ExtensionDescriptor = SubTypeDescriptor<DescriptorType::DeviceCapability, DeviceCapabilityType::Usb20Extension>;
+        using SuperSpeedUsbDescriptor = SubTypeDescriptor<DescriptorType::DeviceCapability, DeviceCapabilityType::SuperSpeedUsb>;
+        using ContainerIdDescriptor = SubTypeDescriptor<DescriptorType::DeviceCapability, DeviceCapabilityType::ContainerId>;
+
+        static_assert(sizeof(Usb20ExtensionDescriptor) == 7, "size is not correct");
+        static_assert(sizeof(SuperSpeedUsbDescriptor) == 10, "size is not correct");
+        static_assert(sizeof(ContainerIdDescriptor) == 20, "size is not correct");
+    } //END: bos
+
     // USB Binary Device Object Store (BOS)
     // https://developers.google.com/web/fundamentals/native-hardware/build-for-webusb/
     struct usb_desc_bos_platform_t
@@ -34,14 +122,14 @@ namespace usbstd
     {
         uint8_t bLength;
         uint8_t bDescriptorType;
-        uint16_t wTotalLength;
+        Le16 wTotalLength;
         uint8_t bNumDeviceCaps;
     };
 
     struct usb_bos_ms_os_20_capability_t
     {
-        uint32_t dwWindowsVersion; ///< = 0x06030000 Windows version - Minimum Windows version (8.1) (0x06030000)
-        uint16_t wMSOSDescriptorSetTotalLength; ///< The length, in bytes of the MS OS 2.0 descriptor set
+        Le32 dwWindowsVersion; ///< = 0x06030000 Windows version - Minimum Windows version (8.1) (0x06030000)
+        Le16 wMSOSDescriptorSetTotalLength; ///< The length, in bytes of the MS OS 2.0 descriptor set
         uint8_t bMS_VendorCode; ///< Vendor defined code to use to retrieve this version of the MS OS 2.0 descriptor and also to set alternate enumeration behavior on the device.
         uint8_t bAltEnumCode; ///< = 0x00 A non-zero value to send to the device to indicate that the device may return non-default USB descriptors for enumeration.  If the device does not support alternate enumeration, this value shall be 0.
     };
@@ -55,56 +143,77 @@ namespace usbstd
     ///Microsoft OS 2.0 descriptor set header
     struct usb_ms_os_20_descriptor_set_header_t
     {
-        uint16_t wLength; ///< The length, in bytes, of this header. Shall be set to 10.
-        uint16_t wDescriptorType; ///< MSOS20_SET_HEADER_DESCRIPTOR
-        uint32_t dwWindowsVersion; ///< Windows version.
-        uint16_t wTotalLength; ////< The size of entire MS OS 2.0 descriptor set. The value shall match the value in the descriptor set information structure.  
+        Le16 wLength; ///< The length, in bytes, of this header. Shall be set to 10.
+        Le16 wDescriptorType; ///< MSOS20_SET_HEADER_DESCRIPTOR
+        Le32 dwWindowsVersion; ///< Windows version.
+        Le16 wTotalLength; ////< The size of entire MS OS 2.0 descriptor set. The value shall match the value in the descriptor set information structure.  
     };
 
     ///Microsoft OS 2.0 configuration subset header
     struct usb_ms_os_20_configuration_subset_header_t
     {
-        uint16_t wLength; ///< The length, in bytes, of this subset header. Shall be set to 8.
-        uint16_t wDescriptorType; ///< MS_OS_20_SUBSET_HEADER_CONFIGURATION
+        Le16 wLength; ///< The length, in bytes, of this subset header. Shall be set to 8.
+        Le16 wDescriptorType; ///< MS_OS_20_SUBSET_HEADER_CONFIGURATION
         uint8_t bConfigurationValue; ///< The configuration value for the USB configuration to which this subset applies
         uint8_t bReserved; ///< Shall be set to 0.
-        uint16_t wTotalLength; ////< The size of entire MS OS 2.0 descriptor set. The value shall match the value in the descriptor set information structure.  
-    } usb_ms_os_20_configuration_subset_header_t;
+        Le16 wTotalLength; ////< The size of entire MS OS 2.0 descriptor set. The value shall match the value in the descriptor set information structure.  
+    };
 
     /// Microsoft OS 2.0 function subset header
     struct usb_ms_os_20_function_subset_header_t
     {
-        uint16_t wLength; ///< The length, in bytes, of this subset header. Shall be set to 8.
-        uint16_t wDescriptorType; ///< MS_OS_20_SUBSET_HEADER_FUNCTION
+        Le16 wLength; ///< The length, in bytes, of this subset header. Shall be set to 8.
+        Le16 wDescriptorType; ///< MS_OS_20_SUBSET_HEADER_FUNCTION
         uint8_t bFirstInterface; ///< The interface number for the first interface of the function to which this subset applies.
         uint8_t bReserved; ///< Shall be set to 0.
-        uint16_t wSubsetLength; ////< The size of entire function subset including this header.
+        Le16 wSubsetLength; ////< The size of entire function subset including this header.
     };
 
     /// Microsoft OS 2.0 compatible ID descriptor
     struct usb_ms_os_20_compatible_id_descriptor_t
     {
-        uint16_t wLength; ///< The length, bytes, of the compatible ID descriptor including value descriptors. Shall be set to 20.
-        uint16_t wDescriptorType; ///< MS_OS_FEATURE_COMPATIBLE_ID
+        Le16 wLength; ///< The length, bytes, of the compatible ID descriptor including value descriptors. Shall be set to 20.
+        Le16 wDescriptorType; ///< MS_OS_FEATURE_COMPATIBLE_ID
         uint8_t compatibleID[8]; ///< Compatible ID String
         uint8_t subCompatibleID[8]; ///< Sub-compatible ID String
     };
 
+    /// MS OS 2.0 Registry property descriptor with a property name of `NameLength` UTF-16 characters (including the NULL) and `DataLength` bytes of data
+    template<size_t NameLength, size_t DataLength>
+    struct usb_ms_os_20_registry_property_t
+    {
+        Le16 wLength; ///< The length, in bytes, of this descriptor.
+        Le16 wDescriptorType; ///< MS_OS_20_FEATURE_REG_PROPERTY
+        Le16 wPropertyDataType; ///< `microsoft_os_20_property_data_type_t`
+        Le16 wPropertyNameLength; ///< The length of the property name, in bytes.
+        Le16 PropertyName[NameLength]; ///< UTF-16LE, including the NULL
+        Le16 wPropertyDataLength; ///< The length of property data, in bytes.
+        uint8_t  PropertyData[DataLength];
+    };
+
+    /// Microsoft OS 2.0 CCGP device descriptor: treat the device as composite even when it has a single interface
+    struct usb_ms_os_20_ccgp_device_descriptor_t
+    {
+        Le16 wLength; ///< Shall be set to 4.
+        Le16 wDescriptorType; ///< MS_OS_20_FEATURE_CCGP_DEVICE
+    };
+
     /// MS OS 2.0 Registry property descriptor: length, type
+    /// @note Fixed to the 20 character "DeviceInterfaceGUID" name and a 38 character GUID, see `usb_ms_os_20_registry_property_t`
     struct usb_ms_os_20_device_interface_guid_section_t
     {
-        uint16_t wLength; ///< The length, in bytes, of this descriptor.
-        uint16_t wDescriptorType; ///< MS_OS_20_FEATURE_REG_PROPERTY
-        uint16_t  wPropertyDataType; ///< The type of registry property. See Table 15.
-        uint16_t  wPropertyNameLength; ///< The length of the property name.
-        uint16_t  bPropertyName[20];
-        uint16_t dwPropertyDataLength; ///< The length of property data.
-        uint16_t  bPropertyData[38];
+        Le16 wLength; ///< The length, in bytes, of this descriptor.
+        Le16 wDescriptorType; ///< MS_OS_20_FEATURE_REG_PROPERTY
+        Le16      wPropertyDataType; ///< The type of registry property. See Table 15.
+        Le16      wPropertyNameLength; ///< The length of the property name.
+        Le16      bPropertyName[20];
+        Le16 dwPropertyDataLength; ///< The length of property data.
+        Le16      bPropertyData[38];
     };
 
     struct usb_bos_webusb_capability_t
     {
-        uint16_t bcdVersion;/// = 0x0100 WebUSB descriptor version 1.0
+        Le16 bcdVersion;/// = 0x0100 WebUSB descriptor version 1.0
         uint8_t bVendorCode;///	= 0x01 bRequest value for WebUSB
         uint8_t iLandingPage;/// = 0x01 URL for landing page
     };
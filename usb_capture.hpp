@@ -0,0 +1,763 @@
+#pragma once
+
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t, uint32_t, uint64_t
+#include <cstring> //< std::memcpy
+
+#include "usb_cdc.hpp" //< USB_CDC_*
+#include "usb_descriptor.hpp" //< usbstd::DescriptorType
+#include "usb_request.hpp" //< usbstd::Request
+#include "usb_span.hpp" //< usbstd::Span
+#include "usbstd.hpp" //< USB_GET_DESCRIPTOR, USB_*_ENDPOINT, USB_*_REQUEST
+
+namespace usbstd {
+namespace capture {
+
+    /** pcap link-layer types carrying Linux usbmon packets
+    */
+    enum LinkType : uint32_t
+    {
+        LINKTYPE_USB_LINUX = 189, ///< 48-byte `UsbmonPacket` header
+        LINKTYPE_USB_LINUX_MMAPPED = 220, ///< 64-byte `UsbmonPacketMmapped` header, isochronous descriptors precede the data
+    };
+
+#pragma pack(push, 1)
+
+    struct PcapHeader
+    {
+        uint32_t magic; ///< `PcapMicroseconds` or `PcapNanoseconds`
+        uint16_t versionMajor;
+        uint16_t versionMinor;
+        int32_t  thisZone;
+        uint32_t sigFigs;
+        uint32_t snapLength;
+        uint32_t linkType;
+    };
+    static_assert(sizeof(PcapHeader) == 24, "size is not correct");
+
+    struct PcapRecordHeader
+    {
+        uint32_t seconds;
+        uint32_t fraction; ///< Microseconds or nanoseconds, depending on `PcapHeader::magic`
+        uint32_t capturedLength;
+        uint32_t originalLength;
+    };
+    static_assert(sizeof(PcapRecordHeader) == 16, "size is not correct");
+
+    struct PcapngBlockHeader
+    {
+        uint32_t type;
+        uint32_t totalLength; ///< Whole block including this header and the trailing length copy, multiple of 4
+    };
+    static_assert(sizeof(PcapngBlockHeader) == 8, "size is not correct");
+
+    /** Linux usbmon packet header (`struct usbmon_packet`), in the byte order of the capturing host
+     * @see Linux Documentation/usb/usbmon.rst
+    */
+    struct UsbmonPacket
+    {
+        uint64_t id; ///< URB identifier, equal in the submission and the completion of one transfer
+        uint8_t  type; ///< 'S' submission, 'C' completion or 'E' submission error
+        uint8_t  xferType; ///< 0 isochronous, 1 interrupt, 2 control, 3 bulk
+        uint8_t  epnum; ///< Endpoint address, including the direction bit
+        uint8_t  devnum;
+        uint16_t busnum;
+        char     flagSetup; ///< 0 when `setup` is valid
+        char     flagData; ///< 0 when data follows the header
+        int64_t  tsSec;
+        int32_t  tsUsec;
+        int32_t  status; ///< 0 or negative errno, e.g. -EPIPE for a stall
+        uint32_t length; ///< URB transfer length
+        uint32_t lenCap; ///< Captured data length following the header
+        union
+        {
+            uint8_t setup[8];
+            struct { int32_t errorCount; int32_t numDesc; } iso;
+        } s;
+    };
+    static_assert(sizeof(UsbmonPacket) == 48, "size is not correct");
+
+    struct UsbmonPacketMmapped : UsbmonPacket
+    {
+        int32_t  interval;
+        int32_t  startFrame;
+        uint32_t xferFlags;
+        uint32_t ndesc; ///< Number of `UsbmonIsoDescriptor` preceding the data of an isochronous transfer
+    };
+    static_assert(sizeof(UsbmonPacketMmapped) == 64, "size is not correct");
+
+    struct UsbmonIsoDescriptor
+    {
+        int32_t  status;
+        uint32_t offset;
+        uint32_t length;
+        uint32_t padding;
+    };
+    static_assert(sizeof(UsbmonIsoDescriptor) == 16, "size is not correct");
+
+#pragma pack(pop)
+
+    /** One link-layer packet of a capture file, pointing into the capture
+    */
+    struct Packet
+    {
+        uint64_t timestamp; ///< Nanoseconds since the epoch
+        uint32_t linkType;
+        uint32_t originalLength;
+        size_t offset; ///< Offset of the record (pcapng block) in the capture, for `CaptureReader::seek()`
+        Span<const uint8_t> data; ///< Captured bytes
+    };
+
+    /** Zero-copy reader of pcap and pcapng captures held in memory (e.g. a `host::MappedFile`)
+     * Captures written with the byte order of the reading host are supported, which covers usbmon captures analysed on
+     * the (little-endian) machine class they were taken on.
+     * @code
+     *   usbstd::capture::CaptureReader reader{ file.bytes() };
+     *   usbstd::capture::Packet packet;
+     *   while (reader.next(packet))
+     *       ...
+     * @endcode
+    */
+    class CaptureReader
+    {
+    public:
+        enum class Format : uint8_t { Unknown, Pcap, Pcapng };
+
+        static constexpr uint32_t PcapMicroseconds = 0xa1b2c3d4;
+        static constexpr uint32_t PcapNanoseconds = 0xa1b23c4d;
+        static constexpr uint32_t PcapngSectionHeader = 0x0a0d0d0a;
+        static constexpr uint32_t PcapngInterfaceDescription = 1;
+        static constexpr uint32_t PcapngSimplePacket = 3;
+        static constexpr uint32_t PcapngEnhancedPacket = 6;
+        static constexpr uint32_t PcapngByteOrder = 0x1a2b3c4d;
+        static constexpr size_t MaxInterfaces = 16; ///< pcapng interfaces tracked per section, packets of further interfaces are skipped
+
+        CaptureReader() = default;
+        explicit CaptureReader(Span<const uint8_t> file) : file_(file)
+        {
+            const uint32_t magic = load<uint32_t>(0);
+            if ((file_.size() >= sizeof(PcapHeader)) && ((magic == PcapMicroseconds) || (magic == PcapNanoseconds)))
+            {
+                const auto header = load<PcapHeader>(0);
+                format_ = Format::Pcap;
+                nanoseconds_ = (magic == PcapNanoseconds);
+                snapLength_ = header.snapLength;
+                interfaces_[0] = { header.linkType, 0, 0 };
+                interfaceCount_ = 1;
+                offset_ = sizeof(PcapHeader);
+            }
+            else if ((file_.size() >= 12) && (magic == PcapngSectionHeader) && (load<uint32_t>(8) == PcapngByteOrder))
+            {
+                format_ = Format::Pcapng;
+
+                // Read the section and interface descriptions up to the first packet, so readers seeking into the capture know them
+                while (file_.size() - offset_ >= sizeof(PcapngBlockHeader))
+                {
+                    const auto block = load<PcapngBlockHeader>(offset_);
+                    if ((block.type == PcapngEnhancedPacket) || (block.type == PcapngSimplePacket) || !isBlock(offset_))
+                        break;
+                    describe(block, offset_);
+                    offset_ += block.totalLength;
+                }
+            }
+        }
+
+        Format format() const { return format_; }
+        bool valid() const { return format_ != Format::Unknown; }
+
+        /** Byte offset of the next record, equal to the file size once all records were read
+        */
+        size_t offset() const { return offset_; }
+
+        /** `true` when reading stopped at a record that is cut short or malformed rather than at the end of the file
+        */
+        bool truncated() const { return truncated_; }
+
+        /** Link type of a pcap file, or of the first pcapng interface seen so far
+        */
+        uint32_t linkType() const { return (interfaceCount_ != 0) ? interfaces_[0].linkType : 0; }
+
+        /** Continue reading at `offset`, which must be a record boundary, e.g. from `boundary()` or a `CaptureIndex`
+         * @note pcapng interfaces described after the first packet are only known to a reader that read past them
+        */
+        void seek(size_t offset)
+        {
+            offset_ = (offset < file_.size()) ? offset : file_.size();
+            truncated_ = false;
+        }
+
+        /** Find the first record boundary at or after `offset`, to split a capture into chunks read in parallel
+         * A candidate is accepted when it and the `ChainLength - 1` records following it (or those up to the end of file) are all plausible.
+         * @return Offset of the record, or the file size when there is none
+        */
+        size_t boundary(size_t offset) const
+        {
+            constexpr size_t ChainLength = 8;
+            const size_t first = (format_ == Format::Pcap) ? sizeof(PcapHeader) : 0;
+            const size_t step = (format_ == Format::Pcapng) ? 4 : 1;
+            if (offset < first)
+                offset = first;
+            offset = (offset + step - 1) & ~(step - 1);
+
+            for (; offset < file_.size(); offset += step)
+            {
+                size_t position = offset;
+                size_t chained = 0;
+                while ((chained < ChainLength) && (position < file_.size()))
+                {
+                    const size_t length = (format_ == Format::Pcap) ? isRecord(position) : isBlock(position);
+                    if (length == 0)
+                        break;
+                    position += length;
+                    ++chained;
+                }
+                if ((chained == ChainLength) || ((chained != 0) && (position == file_.size())))
+                    return offset;
+            }
+            return file_.size();
+        }
+
+        /** Advance to the next packet
+         * @return `false` at the end of the capture or at a malformed record
+        */
+        bool next(Packet& packet)
+        {
+            return (format_ == Format::Pcap) ? nextPcap(packet)
+                : (format_ == Format::Pcapng) ? nextPcapng(packet)
+                : false;
+        }
+
+    private:
+        struct Interface
+        {
+            uint32_t linkType;
+            uint8_t  resolution; ///< pcapng `if_tsresol`, 0 for the default of microseconds
+            uint8_t  reserved;
+        };
+
+        template<typename T>
+        T load(size_t offset) const
+        {
+            T value = {};
+            if (offset + sizeof(T) <= file_.size())
+                std::memcpy(&value, file_.data() + offset, sizeof(T));
+            return value;
+        }
+
+        bool stop()
+        {
+            truncated_ = (offset_ != file_.size());
+            offset_ = file_.size();
+            return false;
+        }
+
+        bool nextPcap(Packet& packet)
+        {
+            if (file_.size() - offset_ < sizeof(PcapRecordHeader))
+                return stop();
+
+            const auto record = load<PcapRecordHeader>(offset_);
+            const size_t dataOffset = offset_ + sizeof(PcapRecordHeader);
+            if (record.capturedLength > file_.size() - dataOffset)
+                return stop();
+
+            packet.timestamp = uint64_t(record.seconds) * 1000000000u + (nanoseconds_ ? record.fraction : uint64_t(record.fraction) * 1000u);
+            packet.linkType = interfaces_[0].linkType;
+            packet.originalLength = record.originalLength;
+            packet.offset = offset_;
+            packet.data = file_.subspan(dataOffset, record.capturedLength);
+            offset_ = dataOffset + record.capturedLength;
+            return true;
+        }
+
+        bool nextPcapng(Packet& packet)
+        {
+            for (;;)
+            {
+                if (file_.size() - offset_ < sizeof(PcapngBlockHeader))
+                    return stop();
+
+                const auto block = load<PcapngBlockHeader>(offset_);
+                if ((block.totalLength < 12) || ((block.totalLength & 3) != 0) || (block.totalLength > file_.size() - offset_))
+                    return stop();
+
+                const auto body = file_.subspan(offset_ + sizeof(PcapngBlockHeader), block.totalLength - 12);
+                const size_t blockOffset = offset_;
+                offset_ += block.totalLength;
+
+                switch (block.type)
+                {
+                case PcapngSectionHeader:
+                case PcapngInterfaceDescription:
+                    if (!describe(block, blockOffset))
+                        return stop(); //< Section of foreign byte order
+                    break;
+
+                case PcapngEnhancedPacket:
+                {
+                    if (body.size() < 20)
+                        return stop();
+                    uint32_t fields[5]; //< interface, timestamp high, timestamp low, captured length, original length
+                    std::memcpy(fields, body.data(), sizeof(fields));
+                    if ((fields[0] >= interfaceCount_) || (fields[3] > body.size() - 20))
+                        break;
+                    const auto& interface = interfaces_[fields[0]];
+                    packet.timestamp = toNanoseconds((uint64_t(fields[1]) << 32) | fields[2], interface.resolution);
+                    packet.linkType = interface.linkType;
+                    packet.originalLength = fields[4];
+                    packet.offset = blockOffset;
+                    packet.data = body.subspan(20, fields[3]);
+                    return true;
+                }
+
+                case PcapngSimplePacket:
+                {
+                    if ((body.size() < 4) || (interfaceCount_ == 0))
+                        break;
+                    uint32_t originalLength;
+                    std::memcpy(&originalLength, body.data(), sizeof(originalLength));
+                    const size_t captured = (originalLength < body.size() - 4) ? originalLength : (body.size() - 4);
+                    packet.timestamp = 0; //< Simple packets carry no timestamp
+                    packet.linkType = interfaces_[0].linkType;
+                    packet.originalLength = originalLength;
+                    packet.offset = blockOffset;
+                    packet.data = body.subspan(4, captured);
+                    return true;
+                }
+
+                default:
+                    break; //< Statistics, name resolution, custom blocks...
+                }
+            }
+        }
+
+        /** Apply a section header or interface description block
+         * @return `false` for a section of foreign byte order
+        */
+        bool describe(const PcapngBlockHeader& block, size_t blockOffset)
+        {
+            if (block.type == PcapngSectionHeader)
+            {
+                interfaceCount_ = 0;
+                return load<uint32_t>(blockOffset + 8) == PcapngByteOrder;
+            }
+            if ((block.type == PcapngInterfaceDescription) && (block.totalLength >= 20) && (interfaceCount_ < MaxInterfaces))
+            {
+                const auto body = file_.subspan(blockOffset + sizeof(PcapngBlockHeader), block.totalLength - 12);
+                interfaces_[interfaceCount_++] = { load<uint16_t>(blockOffset + 8), findResolution(body.subspan(8)), 0 };
+            }
+            return true;
+        }
+
+        /** Length of a plausible pcap record at `offset`, or 0
+        */
+        size_t isRecord(size_t offset) const
+        {
+            if (file_.size() - offset < sizeof(PcapRecordHeader))
+                return 0;
+            const auto record = load<PcapRecordHeader>(offset);
+            if ((record.capturedLength > record.originalLength)
+                || ((snapLength_ != 0) && (record.capturedLength > snapLength_))
+                || (record.fraction >= (nanoseconds_ ? 1000000000u : 1000000u))
+                || (record.capturedLength > file_.size() - offset - sizeof(PcapRecordHeader)))
+                return 0;
+
+            const uint32_t linkType = interfaces_[0].linkType;
+            if ((linkType == LINKTYPE_USB_LINUX) || (linkType == LINKTYPE_USB_LINUX_MMAPPED))
+            {
+                if (record.capturedLength < sizeof(UsbmonPacket))
+                    return 0;
+                const auto usbmon = load<UsbmonPacket>(offset + sizeof(PcapRecordHeader));
+                if (((usbmon.type != 'S') && (usbmon.type != 'C') && (usbmon.type != 'E'))
+                    || (usbmon.xferType > 3)
+                    || (usbmon.lenCap > record.capturedLength - sizeof(UsbmonPacket)))
+                    return 0;
+            }
+            return sizeof(PcapRecordHeader) + record.capturedLength;
+        }
+
+        /** Length of a plausible pcapng block at `offset`, or 0
+        */
+        size_t isBlock(size_t offset) const
+        {
+            if (file_.size() - offset < 12)
+                return 0;
+            const auto block = load<PcapngBlockHeader>(offset);
+            const bool known = (block.type == PcapngSectionHeader) || ((block.type >= PcapngInterfaceDescription) && (block.type <= PcapngEnhancedPacket))
+                || (block.type == 0x00000bad) || (block.type == 0x40000bad);
+            if (!known || (block.totalLength < 12) || ((block.totalLength & 3) != 0) || (block.totalLength > file_.size() - offset)
+                || (load<uint32_t>(offset + block.totalLength - 4) != block.totalLength))
+                return 0;
+            return block.totalLength;
+        }
+
+        /** Find `if_tsresol` in the options of an interface description block
+        */
+        static uint8_t findResolution(Span<const uint8_t> options)
+        {
+            constexpr uint16_t OptionEnd = 0;
+            constexpr uint16_t OptionResolution = 9;
+            while (options.size() >= 4)
+            {
+                uint16_t option[2]; //< code, length
+                std::memcpy(option, options.data(), sizeof(option));
+                if (option[0] == OptionEnd)
+                    break;
+                if ((option[0] == OptionResolution) && (option[1] >= 1) && (options.size() > 4))
+                    return options[4];
+                const size_t padded = 4 + ((option[1] + 3u) & ~3u);
+                if (padded > options.size())
+                    break;
+                options = options.subspan(padded);
+            }
+            return 0;
+        }
+
+        /** Convert a pcapng timestamp in units of `if_tsresol` to nanoseconds
+        */
+        static uint64_t toNanoseconds(uint64_t timestamp, uint8_t resolution)
+        {
+            if (resolution == 0)
+                return timestamp * 1000u; //< Default resolution is 10^-6
+            if ((resolution & 0x80) == 0)
+            {
+                uint64_t value = timestamp;
+                for (uint8_t exponent = resolution & 0x7f; exponent < 9; ++exponent)
+                    value *= 10u;
+                for (uint8_t exponent = resolution & 0x7f; exponent > 9; --exponent)
+                    value /= 10u;
+                return value;
+            }
+            uint8_t shift = resolution & 0x7f;
+            if (shift > 32)
+            {
+                timestamp >>= (shift - 32);
+                shift = 32;
+            }
+            const uint64_t mask = (uint64_t(1) << shift) - 1;
+            return (timestamp >> shift) * 1000000000u + (((timestamp & mask) * 1000000000u) >> shift);
+        }
+
+        Span<const uint8_t> file_;
+        size_t offset_ = 0;
+        Format format_ = Format::Unknown;
+        uint32_t snapLength_ = 0;
+        bool nanoseconds_ = false;
+        bool truncated_ = false;
+        uint8_t interfaceCount_ = 0;
+        Interface interfaces_[MaxInterfaces] = {};
+    };
+
+    /** One decoded usbmon event: the submission or completion of a USB transfer
+     * `data` points into the capture, so a `Transfer` is only valid while the capture stays mapped.
+    */
+    struct Transfer
+    {
+        uint64_t id; ///< URB identifier, matches submission to completion
+        uint64_t timestamp; ///< Nanoseconds since the epoch
+        char     event; ///< 'S' submission, 'C' completion or 'E' submission error
+        uint8_t  xfer; ///< `USB_CONTROL_ENDPOINT`, `USB_ISOCHRONOUS_ENDPOINT`, `USB_BULK_ENDPOINT` or `USB_INTERRUPT_ENDPOINT`
+        uint8_t  endpoint; ///< Endpoint address, including `USB_IN_ENDPOINT`
+        uint8_t  device;
+        uint16_t bus;
+        bool     hasSetup; ///< `setup` holds the SETUP packet of a control submission
+        int32_t  status; ///< 0 or negative errno
+        uint32_t length; ///< URB transfer length, requested on submission and actual on completion
+        Request  setup;
+        Span<const uint8_t> data; ///< Captured payload, possibly shorter than `length` when the capture was snapped
+
+        bool submission() const { return event == 'S'; }
+        bool completion() const { return event == 'C'; }
+        bool stalled() const { return status == -32; } //< -EPIPE
+
+        /** Payload as a packed wire struct
+         * @return `nullptr` when fewer than `sizeof(T)` bytes were captured
+        */
+        template<typename T>
+        const T* payloadAs() const { return (data.size() >= sizeof(T)) ? reinterpret_cast<const T*>(data.data()) : nullptr; }
+    };
+
+    /** Decode a usbmon packet
+     * @return `false` when the packet is not a usbmon packet or is too short
+    */
+    inline bool decode(const Packet& packet, Transfer& transfer)
+    {
+        size_t headerSize;
+        if (packet.linkType == LINKTYPE_USB_LINUX)
+            headerSize = sizeof(UsbmonPacket);
+        else if (packet.linkType == LINKTYPE_USB_LINUX_MMAPPED)
+            headerSize = sizeof(UsbmonPacketMmapped);
+        else
+            return false;
+        if (packet.data.size() < headerSize)
+            return false;
+
+        UsbmonPacket header;
+        std::memcpy(&header, packet.data.data(), sizeof(header));
+
+        static constexpr uint8_t xferTypes[4] = { USB_ISOCHRONOUS_ENDPOINT, USB_INTERRUPT_ENDPOINT, USB_CONTROL_ENDPOINT, USB_BULK_ENDPOINT };
+
+        transfer.id = header.id;
+        transfer.timestamp = (packet.timestamp != 0)
+            ? packet.timestamp
+            : (uint64_t(header.tsSec) * 1000000000u + uint64_t(header.tsUsec) * 1000u);
+        transfer.event = static_cast<char>(header.type);
+        transfer.xfer = xferTypes[header.xferType & 0x03];
+        transfer.endpoint = header.epnum;
+        transfer.device = header.devnum;
+        transfer.bus = header.busnum;
+        transfer.status = header.status;
+        transfer.length = header.length;
+        transfer.hasSetup = (header.flagSetup == 0) && (transfer.xfer == USB_CONTROL_ENDPOINT);
+        if (transfer.hasSetup)
+            std::memcpy(&transfer.setup, header.s.setup, sizeof(Request));
+        else
+            transfer.setup = {};
+
+        size_t dataOffset = headerSize;
+        if ((packet.linkType == LINKTYPE_USB_LINUX_MMAPPED) && (transfer.xfer == USB_ISOCHRONOUS_ENDPOINT))
+        {
+            uint32_t ndesc;
+            std::memcpy(&ndesc, packet.data.data() + sizeof(UsbmonPacketMmapped) - sizeof(ndesc), sizeof(ndesc));
+            dataOffset += size_t(ndesc) * sizeof(UsbmonIsoDescriptor);
+        }
+        const size_t captured = (dataOffset < packet.data.size()) ? (packet.data.size() - dataOffset) : 0;
+        transfer.data = (header.flagData == 0)
+            ? packet.data.subspan(dataOffset < packet.data.size() ? dataOffset : packet.data.size(), (header.lenCap < captured) ? header.lenCap : captured)
+            : Span<const uint8_t>{};
+        return true;
+    }
+
+    /** Fixed-size table pairing control completions with the SETUP of their submission
+     * Entries are hashed by URB id with linear probing, so transfers sharing a slot are all kept. A submission is only
+     * lost when more than `Capacity` control transfers are outstanding; it then replaces an older one, counted by `overwritten()`.
+     * @tparam  Capacity  Number of outstanding control transfers tracked (power of two)
+    */
+    template<size_t Capacity = 256>
+    class ControlTracker
+    {
+        static_assert((Capacity != 0) && ((Capacity & (Capacity - 1)) == 0), "Capacity must be a power of two");
+
+    public:
+        static constexpr size_t CapacityCount = Capacity;
+
+        /** Record a control submission, or find the SETUP of a completion
+         * @return SETUP packet the transfer belongs to, valid until the next call, or `nullptr` for non-control transfers and unmatched completions
+        */
+        const Request* track(const Transfer& transfer)
+        {
+            if (transfer.xfer != USB_CONTROL_ENDPOINT)
+                return nullptr;
+
+            size_t index = find(transfer);
+            if (transfer.submission())
+            {
+                if (!transfer.hasSetup)
+                    return nullptr;
+                if (index == Capacity)
+                {
+                    index = free(transfer);
+                    if (index == Capacity)
+                    {
+                        // Full: the submission replaces the one in its home slot
+                        index = slot(transfer.id, transfer.bus, transfer.device);
+                        ++overwritten_;
+                    }
+                    else
+                        ++outstanding_;
+                }
+                entries_[index] = { transfer.id, transfer.timestamp, transfer.bus, transfer.device, true, transfer.setup };
+                return &entries_[index].setup;
+            }
+
+            if (index == Capacity)
+                return nullptr;
+            submitted_ = entries_[index].timestamp;
+            matched_ = entries_[index].setup;
+            erase(index);
+            --outstanding_;
+            return &matched_;
+        }
+
+        /** Submission timestamp of the transfer last matched by `track()`
+        */
+        uint64_t submitted() const { return submitted_; }
+
+        /** Number of tracked submissions still waiting for their completion
+        */
+        size_t outstanding() const { return outstanding_; }
+
+        /** Submissions dropped because `Capacity` transfers were outstanding
+        */
+        uint64_t overwritten() const { return overwritten_; }
+
+    private:
+        static constexpr size_t Mask = Capacity - 1;
+
+        struct Entry
+        {
+            uint64_t id;
+            uint64_t timestamp;
+            uint16_t bus;
+            uint8_t  device;
+            bool     used;
+            Request  setup;
+        };
+
+        static size_t slot(uint64_t id, uint16_t bus, uint8_t device)
+        {
+            const uint64_t key = id ^ (uint64_t(bus) << 48) ^ (uint64_t(device) << 40);
+            return static_cast<size_t>((key * 0x9e3779b97f4a7c15ull) >> 32) & Mask;
+        }
+
+        /** Slot of the outstanding submission of `transfer`, or `Capacity`
+        */
+        size_t find(const Transfer& transfer) const
+        {
+            size_t index = slot(transfer.id, transfer.bus, transfer.device);
+            for (size_t probe = 0; (probe < Capacity) && entries_[index].used; ++probe, index = (index + 1) & Mask)
+            {
+                const Entry& entry = entries_[index];
+                if ((entry.id == transfer.id) && (entry.bus == transfer.bus) && (entry.device == transfer.device))
+                    return index;
+            }
+            return Capacity;
+        }
+
+        /** First unused slot of the probe sequence of `transfer`, or `Capacity` when the table is full
+        */
+        size_t free(const Transfer& transfer) const
+        {
+            size_t index = slot(transfer.id, transfer.bus, transfer.device);
+            for (size_t probe = 0; probe < Capacity; ++probe, index = (index + 1) & Mask)
+            {
+                if (!entries_[index].used)
+                    return index;
+            }
+            return Capacity;
+        }
+
+        /** Remove an entry, shifting later entries of its cluster back so no probe sequence has a gap
+        */
+        void erase(size_t index)
+        {
+            size_t next = (index + 1) & Mask;
+            for (size_t probe = 1; (probe < Capacity) && entries_[next].used; ++probe, next = (next + 1) & Mask)
+            {
+                const Entry& entry = entries_[next];
+                const size_t home = slot(entry.id, entry.bus, entry.device);
+                // Move the entry into the gap unless its home slot lies cyclically in (index, next]
+                if (((next - home) & Mask) >= ((next - index) & Mask))
+                {
+                    entries_[index] = entry;
+                    index = next;
+                }
+            }
+            entries_[index].used = false;
+        }
+
+        Entry entries_[Capacity] = {};
+        Request matched_ = {};
+        uint64_t submitted_ = 0;
+        uint64_t overwritten_ = 0;
+        size_t outstanding_ = 0;
+    };
+
+    /** `true` when `setup` reads descriptors, so its IN data stage can be walked with `helper::DescriptorRange`
+    */
+    constexpr bool isGetDescriptor(const Request& setup)
+    {
+        return (setup.bRequest == USB_GET_DESCRIPTOR) && (setup.direction() == USB_IN_TRANSFER)
+            && ((setup.type() == USB_STANDARD_REQUEST) || ((setup.type() == USB_CLASS_REQUEST) && (setup.recipient() == USB_RECIPIENT_INTERFACE)));
+    }
+
+    /** Name of a standard request, or of a CDC class request
+     * @return `nullptr` for vendor requests and unknown codes
+    */
+    inline const char* requestName(const Request& setup)
+    {
+        if (setup.type() == USB_STANDARD_REQUEST)
+        {
+            switch (setup.bRequest)
+            {
+            case USB_GET_STATUS: return "GET_STATUS";
+            case USB_CLEAR_FEATURE: return "CLEAR_FEATURE";
+            case USB_SET_FEATURE: return "SET_FEATURE";
+            case USB_SET_ADDRESS: return "SET_ADDRESS";
+            case USB_GET_DESCRIPTOR: return "GET_DESCRIPTOR";
+            case USB_SET_DESCRIPTOR: return "SET_DESCRIPTOR";
+            case USB_GET_CONFIGURATION: return "GET_CONFIGURATION";
+            case USB_SET_CONFIGURATION: return "SET_CONFIGURATION";
+            case USB_GET_INTERFACE: return "GET_INTERFACE";
+            case USB_SET_INTERFACE: return "SET_INTERFACE";
+            case USB_SYNCH_FRAME: return "SYNCH_FRAME";
+            default: return nullptr;
+            }
+        }
+        if (setup.type() == USB_CLASS_REQUEST)
+        {
+            switch (setup.bRequest)
+            {
+            case USB_CDC_SEND_ENCAPSULATED_COMMAND: return "CDC_SEND_ENCAPSULATED_COMMAND";
+            case USB_CDC_GET_ENCAPSULATED_RESPONSE: return "CDC_GET_ENCAPSULATED_RESPONSE";
+            case USB_CDC_SET_COMM_FEATURE: return "CDC_SET_COMM_FEATURE";
+            case USB_CDC_GET_COMM_FEATURE: return "CDC_GET_COMM_FEATURE";
+            case USB_CDC_CLEAR_COMM_FEATURE: return "CDC_CLEAR_COMM_FEATURE";
+            case USB_CDC_SET_LINE_CODING: return "CDC_SET_LINE_CODING";
+            case USB_CDC_GET_LINE_CODING: return "CDC_GET_LINE_CODING";
+            case USB_CDC_SET_CONTROL_LINE_STATE: return "CDC_SET_CONTROL_LINE_STATE";
+            case USB_CDC_SEND_BREAK: return "CDC_SEND_BREAK";
+            case USB_CDC_SET_ETHERNET_MULTICAST_FILTERS: return "CDC_SET_ETHERNET_MULTICAST_FILTERS";
+            case USB_CDC_SET_ETHERNET_PM_PATTERN_FILTER: return "CDC_SET_ETHERNET_PM_PATTERN_FILTER";
+            case USB_CDC_GET_ETHERNET_PM_PATTERN_FILTER: return "CDC_GET_ETHERNET_PM_PATTERN_FILTER";
+            case USB_CDC_SET_ETHERNET_PACKET_FILTER: return "CDC_SET_ETHERNET_PACKET_FILTER";
+            case USB_CDC_GET_ETHERNET_STATISTIC: return "CDC_GET_ETHERNET_STATISTIC";
+            case USB_CDC_GET_NTB_PARAMETERS: return "CDC_GET_NTB_PARAMETERS";
+            case USB_CDC_GET_NET_ADDRESS: return "CDC_GET_NET_ADDRESS";
+            case USB_CDC_SET_NET_ADDRESS: return "CDC_SET_NET_ADDRESS";
+            case USB_CDC_GET_NTB_FORMAT: return "CDC_GET_NTB_FORMAT";
+            case USB_CDC_SET_NTB_FORMAT: return "CDC_SET_NTB_FORMAT";
+            case USB_CDC_GET_NTB_INPUT_SIZE: return "CDC_GET_NTB_INPUT_SIZE";
+            case USB_CDC_SET_NTB_INPUT_SIZE: return "CDC_SET_NTB_INPUT_SIZE";
+            case USB_CDC_GET_MAX_DATAGRAM_SIZE: return "CDC_GET_MAX_DATAGRAM_SIZE";
+            case USB_CDC_SET_MAX_DATAGRAM_SIZE: return "CDC_SET_MAX_DATAGRAM_SIZE";
+            case USB_CDC_GET_CRC_MODE: return "CDC_GET_CRC_MODE";
+            case USB_CDC_SET_CRC_MODE: return "CDC_SET_CRC_MODE";
+            default: return nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    /** Name of a descriptor type
+    */
+    inline const char* descriptorName(DescriptorType type)
+    {
+        switch (type)
+        {
+        case DescriptorType::Device: return "DEVICE";
+        case DescriptorType::Configuration: return "CONFIGURATION";
+        case DescriptorType::String: return "STRING";
+        case DescriptorType::Interface: return "INTERFACE";
+        case DescriptorType::Endpoint: return "ENDPOINT";
+        case DescriptorType::DeviceQualifier: return "DEVICE_QUALIFIER";
+        case DescriptorType::OtherSpeedConfiguration: return "OTHER_SPEED_CONFIGURATION";
+        case DescriptorType::InterfacePower: return "INTERFACE_POWER";
+        case DescriptorType::Otg: return "OTG";
+        case DescriptorType::Debug: return "DEBUG";
+        case DescriptorType::InterfaceAssociation: return "INTERFACE_ASSOCIATION";
+        case DescriptorType::BinaryObjectStore: return "BOS";
+        case DescriptorType::DeviceCapability: return "DEVICE_CAPABILITY";
+        case DescriptorType::SuperSpeedEndpointCompanion: return "SS_ENDPOINT_COMPANION";
+        case DescriptorType::SuperSpeedPlusIsochronousEndpointCompanion: return "SSP_ISOCH_ENDPOINT_COMPANION";
+        case DescriptorType::CsDevice: return "CS_DEVICE";
+        case DescriptorType::CsConfiguration: return "CS_CONFIGURATION";
+        case DescriptorType::CsString: return "CS_STRING";
+        case DescriptorType::CsInterface: return "CS_INTERFACE";
+        case DescriptorType::CsEndpoint: return "CS_ENDPOINT";
+        default: return "UNKNOWN";
+        }
+    }
+
+} //END: capture
+} //END: usbstd
\ No newline at end of file
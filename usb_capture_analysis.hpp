@@ -0,0 +1,475 @@
+#pragma once
+
+#include <algorithm> //< std::sort
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t, uint32_t, uint64_t
+#include <cstring> //< std::memcpy, std::memcmp
+#include <thread> //< std::thread::hardware_concurrency
+#include <unordered_map> //< std::unordered_map
+#include <vector> //< std::vector
+
+#include "usb_capture.hpp" //< usbstd::capture::CaptureReader, usbstd::capture::ControlTracker
+#include "usb_host_workpool.hpp" //< usbstd::host::WorkStealingPool
+
+namespace usbstd {
+namespace capture {
+
+    /** Transfer counters and control latency shared by endpoint and device statistics
+    */
+    struct TransferStatistics
+    {
+        uint64_t submissions = 0;
+        uint64_t completions = 0;
+        uint64_t bytes = 0; ///< Actual length of all completions
+        uint64_t stalls = 0; ///< Completions with -EPIPE
+        uint64_t errors = 0; ///< Other failed completions and submission errors
+        uint64_t controlTransfers = 0; ///< Control transfers whose SETUP and completion were both seen
+        uint64_t latencySum = 0; ///< Nanoseconds from SETUP submission to completion, over `controlTransfers`
+        uint64_t latencyMin = ~uint64_t(0);
+        uint64_t latencyMax = 0;
+
+        uint64_t latencyAverage() const { return (controlTransfers != 0) ? (latencySum / controlTransfers) : 0; }
+
+        void addLatency(uint64_t latency)
+        {
+            ++controlTransfers;
+            latencySum += latency;
+            latencyMin = (latency < latencyMin) ? latency : latencyMin;
+            latencyMax = (latency > latencyMax) ? latency : latencyMax;
+        }
+
+        void merge(const TransferStatistics& other)
+        {
+            submissions += other.submissions;
+            completions += other.completions;
+            bytes += other.bytes;
+            stalls += other.stalls;
+            errors += other.errors;
+            controlTransfers += other.controlTransfers;
+            latencySum += other.latencySum;
+            latencyMin = (other.latencyMin < latencyMin) ? other.latencyMin : latencyMin;
+            latencyMax = (other.latencyMax > latencyMax) ? other.latencyMax : latencyMax;
+        }
+    };
+
+    struct EndpointStatistics : TransferStatistics
+    {
+        uint16_t bus = 0;
+        uint8_t  device = 0;
+        uint8_t  endpoint = 0; ///< Endpoint address, including `USB_IN_ENDPOINT`
+        uint8_t  xfer = 0;
+    };
+
+    struct DeviceStatistics : TransferStatistics
+    {
+        uint16_t bus = 0;
+        uint8_t  device = 0;
+    };
+
+    struct CaptureStatistics
+    {
+        uint64_t packets = 0;
+        uint64_t transfers = 0; ///< usbmon events decoded
+        bool truncated = false; ///< A chunk of the capture ends in a cut-short or malformed record
+        std::vector<EndpointStatistics> endpoints; ///< Ordered by bus, device and endpoint address
+        std::vector<DeviceStatistics> devices; ///< Ordered by bus and device
+    };
+
+    /** Key ordering streams by bus, device and endpoint address
+    */
+    constexpr uint32_t endpointKey(uint16_t bus, uint8_t device, uint8_t endpoint)
+    {
+        return (uint32_t(bus) << 16) | (uint32_t(device) << 8) | endpoint;
+    }
+
+#pragma pack(push, 1)
+
+    /** Sidecar index file header
+     * The header is followed by `streamCount` `IndexStream` entries, ordered by `endpointKey()`, then by the record offsets
+     * of every stream: LEB128 varints, each the distance from the previous record of the stream (the first from 0).
+    */
+    struct IndexHeader
+    {
+        char     magic[8]; ///< `IndexMagic`
+        uint32_t version;
+        uint32_t streamCount;
+        uint64_t captureSize; ///< Size of the indexed capture, a mismatch means the index is stale
+        uint64_t recordCount;
+    };
+    static_assert(sizeof(IndexHeader) == 32, "size is not correct");
+
+    /** Records of one bus/device/endpoint in the sidecar index
+    */
+    struct IndexStream
+    {
+        uint16_t bus;
+        uint8_t  device;
+        uint8_t  endpoint;
+        uint8_t  xfer;
+        uint8_t  reserved[3];
+        uint64_t recordCount;
+        uint64_t dataOffset; ///< Offset of the varint offsets, from the end of the stream table
+        uint64_t dataLength;
+    };
+    static_assert(sizeof(IndexStream) == 32, "size is not correct");
+
+#pragma pack(pop)
+
+    constexpr char IndexMagic[8] = { 'U', 'S', 'B', 'S', 'T', 'D', 'I', 'X' };
+    constexpr uint32_t IndexVersion = 1;
+
+    /** Read-only view of a sidecar index, e.g. from a `host::MappedFile`
+     * @code
+     *   usbstd::capture::CaptureIndex index{ indexFile.bytes() };
+     *   if (index.valid(capture.size()))
+     *       if (const auto* stream = index.find(1, 5, 0x00))
+     *           for (size_t offset : index.offsets(*stream))
+     *           {
+     *               reader.seek(offset);
+     *               reader.next(packet);
+     *               ...
+     *           }
+     * @endcode
+    */
+    class CaptureIndex
+    {
+    public:
+        /** Record offsets of one stream, decoded while iterating
+        */
+        class Offsets
+        {
+        public:
+            class iterator
+            {
+            public:
+                iterator(const uint8_t* position, const uint8_t* end) : position_(position), end_(end) { decode(); }
+
+                size_t operator*() const { return static_cast<size_t>(offset_); }
+                iterator& operator++() { decode(); return *this; }
+                bool operator!=(const iterator& other) const { return (position_ != other.position_) || (done_ != other.done_); }
+                bool operator==(const iterator& other) const { return !(*this != other); }
+
+            private:
+                void decode()
+                {
+                    if (position_ == end_)
+                    {
+                        done_ = true;
+                        return;
+                    }
+                    uint64_t delta = 0;
+                    for (unsigned shift = 0; (position_ != end_) && (shift < 64); shift += 7)
+                    {
+                        const uint8_t byte = *position_++;
+                        delta |= uint64_t(byte & 0x7f) << shift;
+                        if ((byte & 0x80) == 0)
+                            break;
+                    }
+                    offset_ += delta;
+                }
+
+                const uint8_t* position_;
+                const uint8_t* end_;
+                uint64_t offset_ = 0;
+                bool done_ = false;
+            };
+
+            Offsets(Span<const uint8_t> data) : data_(data) {}
+            iterator begin() const { return { data_.begin(), data_.end() }; }
+            iterator end() const { return { data_.end(), data_.end() }; }
+
+        private:
+            Span<const uint8_t> data_;
+        };
+
+        CaptureIndex() = default;
+        explicit CaptureIndex(Span<const uint8_t> bytes) : bytes_(bytes) {}
+
+        /** Check the index is well-formed and was built for a capture of `captureSize` bytes
+        */
+        bool valid(size_t captureSize) const
+        {
+            if (bytes_.size() < sizeof(IndexHeader))
+                return false;
+            const auto header = this->header();
+            if ((std::memcmp(header.magic, IndexMagic, sizeof(IndexMagic)) != 0) || (header.version != IndexVersion)
+                || (header.captureSize != captureSize) || (header.streamCount > (bytes_.size() - sizeof(IndexHeader)) / sizeof(IndexStream)))
+                return false;
+            const size_t blobSize = bytes_.size() - dataStart();
+            for (const auto& stream : streams())
+            {
+                if ((stream.dataOffset > blobSize) || (stream.dataLength > blobSize - stream.dataOffset))
+                    return false;
+            }
+            return true;
+        }
+
+        IndexHeader header() const
+        {
+            IndexHeader header;
+            std::memcpy(&header, bytes_.data(), sizeof(header));
+            return header;
+        }
+
+        Span<const IndexStream> streams() const
+        {
+            return { reinterpret_cast<const IndexStream*>(bytes_.data() + sizeof(IndexHeader)), header().streamCount };
+        }
+
+        /** Binary search the stream of a bus/device/endpoint
+         * @return `nullptr` when the endpoint has no records
+        */
+        const IndexStream* find(uint16_t bus, uint8_t device, uint8_t endpoint) const
+        {
+            const auto all = streams();
+            const uint32_t key = endpointKey(bus, device, endpoint);
+            const auto* stream = std::lower_bound(all.begin(), all.end(), key, [](const IndexStream& entry, uint32_t value)
+            {
+                return endpointKey(entry.bus, entry.device, entry.endpoint) < value;
+            });
+            return ((stream != all.end()) && (endpointKey(stream->bus, stream->device, stream->endpoint) == key)) ? stream : nullptr;
+        }
+
+        Offsets offsets(const IndexStream& stream) const
+        {
+            return bytes_.subspan(dataStart() + static_cast<size_t>(stream.dataOffset), static_cast<size_t>(stream.dataLength));
+        }
+
+    private:
+        size_t dataStart() const { return sizeof(IndexHeader) + header().streamCount * sizeof(IndexStream); }
+
+        Span<const uint8_t> bytes_;
+    };
+
+    struct AnalysisOptions
+    {
+        size_t threads = 0; ///< Worker threads, 0 for one per hardware thread
+        size_t chunkSize = size_t(32) << 20; ///< Bytes of capture decoded per task
+        size_t lookahead = size_t(4) << 20; ///< Bytes read past a chunk to find completions of control transfers submitted in it
+    };
+
+    /** Decode a usbmon capture on all cores and gather per-device and per-endpoint statistics
+     * The capture is split into chunks at record boundaries (`CaptureReader::boundary()`), which are decoded in parallel on
+     * a `host::WorkStealingPool` and merged in capture order. A control transfer is attributed to the chunk holding its
+     * SETUP; that chunk's worker reads up to `AnalysisOptions::lookahead` bytes beyond its end to find the completion.
+     * @param[out]  index  [optional] Serialised sidecar index (see `IndexHeader`) of all records by bus/device/endpoint
+    */
+    inline CaptureStatistics analyseCapture(Span<const uint8_t> file, const AnalysisOptions& options = {}, std::vector<uint8_t>* index = nullptr)
+    {
+        CaptureStatistics statistics;
+        const CaptureReader base{ file };
+        if (!base.valid())
+            return statistics;
+
+        /// Record offsets of one stream within one chunk, the first absolute and the rest as varint deltas
+        struct StreamChunk
+        {
+            uint8_t xfer = 0;
+            uint64_t first = 0;
+            uint64_t last = 0;
+            uint64_t count = 0;
+            std::vector<uint8_t> deltas;
+        };
+
+        struct Chunk
+        {
+            size_t begin = 0;
+            size_t end = 0;
+            uint64_t packets = 0;
+            uint64_t transfers = 0;
+            bool truncated = false;
+            std::unordered_map<uint32_t, EndpointStatistics> endpoints;
+            std::unordered_map<uint32_t, StreamChunk> streams;
+        };
+
+        auto appendVarint = [](std::vector<uint8_t>& bytes, uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                bytes.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            bytes.push_back(static_cast<uint8_t>(value));
+        };
+
+        // Split at record boundaries
+        const size_t chunkSize = (options.chunkSize != 0) ? options.chunkSize : file.size();
+        std::vector<Chunk> chunks;
+        for (size_t begin = base.offset(); begin < file.size(); )
+        {
+            const size_t end = (file.size() - begin > chunkSize) ? base.boundary(begin + chunkSize) : file.size();
+            chunks.emplace_back();
+            chunks.back().begin = begin;
+            chunks.back().end = end;
+            begin = end;
+        }
+
+        const bool buildIndex = (index != nullptr);
+        host::WorkStealingPool pool{ (options.threads != 0) ? options.threads : std::thread::hardware_concurrency() };
+        pool.run(chunks.size(), [&](size_t chunkIndex, size_t)
+        {
+            Chunk& chunk = chunks[chunkIndex];
+            CaptureReader reader = base;
+            reader.seek(chunk.begin);
+            ControlTracker<> tracker;
+            Packet packet;
+            Transfer transfer;
+
+            auto statisticsOf = [&](const Transfer& t) -> EndpointStatistics&
+            {
+                auto& entry = chunk.endpoints[endpointKey(t.bus, t.device, t.endpoint)];
+                entry.bus = t.bus;
+                entry.device = t.device;
+                entry.endpoint = t.endpoint;
+                entry.xfer = t.xfer;
+                return entry;
+            };
+
+            while ((reader.offset() < chunk.end) && reader.next(packet))
+            {
+                if (packet.offset >= chunk.end)
+                    break; //< Non-packet blocks skipped across the boundary
+                ++chunk.packets;
+                if (!decode(packet, transfer))
+                    continue;
+                ++chunk.transfers;
+
+                auto& endpoint = statisticsOf(transfer);
+                if (transfer.submission())
+                    ++endpoint.submissions;
+                else if (transfer.completion())
+                {
+                    ++endpoint.completions;
+                    endpoint.bytes += transfer.length;
+                    if (transfer.stalled())
+                        ++endpoint.stalls;
+                    else if (transfer.status < 0)
+                        ++endpoint.errors;
+                }
+                else
+                    ++endpoint.errors;
+
+                if (tracker.track(transfer) && transfer.completion())
+                    endpoint.addLatency(transfer.timestamp - tracker.submitted());
+
+                if (buildIndex)
+                {
+                    auto& stream = chunk.streams[endpointKey(transfer.bus, transfer.device, transfer.endpoint)];
+                    if (stream.count == 0)
+                    {
+                        stream.xfer = transfer.xfer;
+                        stream.first = packet.offset;
+                    }
+                    else
+                        appendVarint(stream.deltas, packet.offset - stream.last);
+                    stream.last = packet.offset;
+                    ++stream.count;
+                }
+            }
+            chunk.truncated = reader.truncated();
+
+            // Completions of control transfers submitted in this chunk
+            const size_t lookaheadEnd = (file.size() - chunk.end > options.lookahead) ? (chunk.end + options.lookahead) : file.size();
+            while ((tracker.outstanding() != 0) && (reader.offset() < lookaheadEnd) && reader.next(packet))
+            {
+                if (decode(packet, transfer) && transfer.completion() && tracker.track(transfer))
+                    statisticsOf(transfer).addLatency(transfer.timestamp - tracker.submitted());
+            }
+        });
+
+        // Merge in capture order
+        std::unordered_map<uint32_t, EndpointStatistics> endpoints;
+        std::unordered_map<uint32_t, StreamChunk> streams;
+        for (auto& chunk : chunks)
+        {
+            statistics.packets += chunk.packets;
+            statistics.transfers += chunk.transfers;
+            statistics.truncated |= chunk.truncated;
+            for (const auto& entry : chunk.endpoints)
+            {
+                auto& endpoint = endpoints[entry.first];
+                endpoint.merge(entry.second);
+                endpoint.bus = entry.second.bus;
+                endpoint.device = entry.second.device;
+                endpoint.endpoint = entry.second.endpoint;
+                endpoint.xfer = entry.second.xfer;
+            }
+            for (auto& entry : chunk.streams)
+            {
+                auto& stream = streams[entry.first];
+                appendVarint(stream.deltas, entry.second.first - stream.last); //< From the previous chunk, or from 0
+                stream.deltas.insert(stream.deltas.end(), entry.second.deltas.begin(), entry.second.deltas.end());
+                stream.xfer = entry.second.xfer;
+                stream.last = entry.second.last;
+                stream.count += entry.second.count;
+            }
+            chunk = Chunk{}; //< Release as we go, index data may be large
+        }
+
+        for (const auto& entry : endpoints)
+            statistics.endpoints.push_back(entry.second);
+        std::sort(statistics.endpoints.begin(), statistics.endpoints.end(), [](const EndpointStatistics& lhs, const EndpointStatistics& rhs)
+        {
+            return endpointKey(lhs.bus, lhs.device, lhs.endpoint) < endpointKey(rhs.bus, rhs.device, rhs.endpoint);
+        });
+        for (const auto& endpoint : statistics.endpoints)
+        {
+            if (statistics.devices.empty() || (statistics.devices.back().bus != endpoint.bus) || (statistics.devices.back().device != endpoint.device))
+            {
+                statistics.devices.emplace_back();
+                statistics.devices.back().bus = endpoint.bus;
+                statistics.devices.back().device = endpoint.device;
+            }
+            statistics.devices.back().merge(endpoint);
+        }
+
+        if (buildIndex)
+        {
+            std::vector<uint32_t> keys;
+            keys.reserve(streams.size());
+            for (const auto& entry : streams)
+                keys.push_back(entry.first);
+            std::sort(keys.begin(), keys.end());
+
+            IndexHeader header = {};
+            std::memcpy(header.magic, IndexMagic, sizeof(IndexMagic));
+            header.version = IndexVersion;
+            header.streamCount = static_cast<uint32_t>(keys.size());
+            header.captureSize = file.size();
+            header.recordCount = 0;
+
+            std::vector<IndexStream> table;
+            uint64_t dataOffset = 0;
+            for (const uint32_t key : keys)
+            {
+                const auto& stream = streams[key];
+                IndexStream entry = {};
+                entry.bus = static_cast<uint16_t>(key >> 16);
+                entry.device = static_cast<uint8_t>(key >> 8);
+                entry.endpoint = static_cast<uint8_t>(key);
+                entry.xfer = stream.xfer;
+                entry.recordCount = stream.count;
+                entry.dataOffset = dataOffset;
+                entry.dataLength = stream.deltas.size();
+                dataOffset += stream.deltas.size();
+                header.recordCount += stream.count;
+                table.push_back(entry);
+            }
+
+            index->clear();
+            index->reserve(sizeof(header) + table.size() * sizeof(IndexStream) + static_cast<size_t>(dataOffset));
+            const auto* headerBytes = reinterpret_cast<const uint8_t*>(&header);
+            index->insert(index->end(), headerBytes, headerBytes + sizeof(header));
+            const auto* tableBytes = reinterpret_cast<const uint8_t*>(table.data());
+            index->insert(index->end(), tableBytes, tableBytes + table.size() * sizeof(IndexStream));
+            for (const uint32_t key : keys)
+            {
+                const auto& deltas = streams[key].deltas;
+                index->insert(index->end(), deltas.begin(), deltas.end());
+            }
+        }
+        return statistics;
+    }
+
+} //END: capture
+} //END: usbstd
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "usb_class.hpp"
 #include "usb_request.hpp"
 #include "usb_descriptor.hpp"
+#include "usb_endian.hpp"
 
 namespace usbstd
 {
@@ -38,11 +39,30 @@ namespace usbstd
 		USB_CDC_GET_UNIT_PARAMETER = 0x38,
 		USB_CDC_CLEAR_UNIT_PARAMETER = 0x39,
 		USB_CDC_GET_PROFILE = 0x3a,
+		USB_CDC_SET_ETHERNET_MULTICAST_FILTERS = 0x40,
+		USB_CDC_SET_ETHERNET_PM_PATTERN_FILTER = 0x41,
+		USB_CDC_GET_ETHERNET_PM_PATTERN_FILTER = 0x42,
+		USB_CDC_SET_ETHERNET_PACKET_FILTER = 0x43,
+		USB_CDC_GET_ETHERNET_STATISTIC = 0x44,
+		USB_CDC_GET_NTB_PARAMETERS = 0x80,
+		USB_CDC_GET_NET_ADDRESS = 0x81,
+		USB_CDC_SET_NET_ADDRESS = 0x82,
+		USB_CDC_GET_NTB_FORMAT = 0x83,
+		USB_CDC_SET_NTB_FORMAT = 0x84,
+		USB_CDC_GET_NTB_INPUT_SIZE = 0x85,
+		USB_CDC_SET_NTB_INPUT_SIZE = 0x86,
+		USB_CDC_GET_MAX_DATAGRAM_SIZE = 0x87,
+		USB_CDC_SET_MAX_DATAGRAM_SIZE = 0x88,
+		USB_CDC_GET_CRC_MODE = 0x89,
+		USB_CDC_SET_CRC_MODE = 0x8a,
 
+		USB_CDC_NOTIFY_NETWORK_CONNECTION = 0x00,
+		USB_CDC_NOTIFY_RESPONSE_AVAILABLE = 0x01,
 		USB_CDC_NOTIFY_RING_DETECT = 0x09,
 		USB_CDC_NOTIFY_SERIAL_STATE = 0x20,
 		USB_CDC_NOTIFY_CALL_STATE_CHANGE = 0x28,
 		USB_CDC_NOTIFY_LINE_STATE_CHANGE = 0x29,
+		USB_CDC_NOTIFY_CONNECTION_SPEED_CHANGE = 0x2a,
 	};
 
 	enum
@@ -87,6 +107,19 @@ namespace usbstd
 		Ccm = 5, // CAPI Control Model
 		Eth = 6, // Ethernet Networking Control Model
 		Atm = 7, // ATM Networking Control Model
+		Wmc = 8, // Wireless Handset Control Model
+		Dmm = 9, // Device Management
+		Mdlm = 10, // Mobile Direct Line Model
+		Obex = 11, // OBEX
+		Eem = 12, // Ethernet Emulation Model
+		Ncm = 13, // Network Control Model
+	};
+
+	enum class CdcDataProtocol
+	{
+		None = 0x00, ///< No class specific protocol required
+		Ntb = 0x01, ///< Network Transfer Block (NCM data interface)
+		Vendor = 0xFF ///< Vendor-specific
 	};
 	
 	enum class CdcProtocol
@@ -142,6 +175,8 @@ namespace usbstd
 		CallManagement = 1, // Call Management
 		Acm = 2, // Abstract Control Management
 		Union = 6, // Union Functional Descriptor
+		Ethernet = 15, // Ethernet Networking Functional Descriptor
+		Ncm = 26, // NCM Functional Descriptor
 
 		/// @todo TinyUsb cdc_func_desc_type_t for full list?
 	};
@@ -149,7 +184,7 @@ namespace usbstd
 	template<>
 	struct SubTypeDescriptorData<DescriptorType::CsInterface, CdcDescriptorSubType::Header>
 	{
-		uint16_t  bcdCDC;
+		Le16      bcdCDC;
 	};
 
 	template<>
@@ -172,17 +207,47 @@ namespace usbstd
 		uint8_t   bSlaveInterface0;
 	};
 
+	template<>
+	struct SubTypeDescriptorData<DescriptorType::CsInterface, CdcDescriptorSubType::Ethernet>
+	{
+		uint8_t   iMACAddress; ///< Index of string descriptor holding the 48bit Ethernet MAC address as 12 hex digits
+		Le32      bmEthernetStatistics; ///< Ethernet statistics supported by the device, see USB ECM 1.2 Table 4
+		Le16      wMaxSegmentSize; ///< Maximum segment size the Ethernet device is capable of supporting, typically 1514 bytes
+		Le16      wNumberMCFilters; ///< Number of multicast filters that can be configured by the host, D15 set if filters are imperfect
+		uint8_t   bNumberPowerFilters; ///< Number of pattern filters available for causing wake-up of the host
+	};
+
+	template<>
+	struct SubTypeDescriptorData<DescriptorType::CsInterface, CdcDescriptorSubType::Ncm>
+	{
+		Le16      bcdNcmVersion; ///< Release number of the NCM specification, 0x0100
+		uint8_t   bmNetworkCapabilities; ///< `CdcNcmNetworkCapabilities` supported by the function
+	};
+
+	// USB CDC NCM Network Capabilities
+	enum CdcNcmNetworkCapabilities
+	{
+		PacketFilter = (1 << 0), // Device supports SetEthernetPacketFilter.
+		NetAddress = (1 << 1), // Device supports GetNetAddress and SetNetAddress.
+		EncapsulatedCommand = (1 << 2), // Device supports SendEncapsulatedCommand and GetEncapsulatedResponse.
+		MaxDatagramSize = (1 << 3), // Device supports GetMaxDatagramSize and SetMaxDatagramSize.
+		CrcMode = (1 << 4), // Device supports GetCrcMode and SetCrcMode.
+		NtbInputSize8Byte = (1 << 5), // Device supports 8-byte GetNtbInputSize and SetNtbInputSize.
+	};
+
 	namespace cdc
 	{
 		using HeaderDescriptor = CsInterfaceDescriptor<CdcDescriptorSubType::Header>;
 		using CallDescriptor = CsInterfaceDescriptor<CdcDescriptorSubType::CallManagement>;
 		using AcmDescriptor = CsInterfaceDescriptor<CdcDescriptorSubType::Acm>;
 		using UnionDescriptor = CsInterfaceDescriptor<CdcDescriptorSubType::Union>;
+		using EthernetDescriptor = CsInterfaceDescriptor<CdcDescriptorSubType::Ethernet>;
+		using NcmDescriptor = CsInterfaceDescriptor<CdcDescriptorSubType::Ncm>;
 	} //< END: cdc
 
 	struct usb_cdc_line_coding_t
 	{
-		uint32_t  dwDTERate;
+		Le32      dwDTERate;
 		uint8_t   bCharFormat;
 		uint8_t   bParityType;
 		uint8_t   bDataBits;
@@ -191,7 +256,7 @@ namespace usbstd
 	struct usb_cdc_notify_serial_state_t
 	{
 		Request request;
-		uint16_t value;
+		Le16 value;
 	} ;
 
 #pragma pack(pop)
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t
+#include <cstring> //< std::memcpy
+
+#include "usb_cdc.hpp" //< usbstd::usb_cdc_line_coding_t, usbstd::CdcCtrlSignal
+#include "usb_helper_ringbuffer.hpp" //< usbstd::helper::SpscRingBuffer
+
+namespace usbstd {
+namespace cdc {
+
+    /** CDC-ACM data channel between the USB ISR and application code
+     * Bulk OUT packets are received directly into the RX ring and bulk IN transfers are sent directly from the TX ring.
+     * Only when the free RX space wraps with less than one packet before the end of storage is a packet received into a
+     * bounce buffer and copied, so DMA always targets contiguous memory.
+     * @tparam  RxCapacity  RX ring size in bytes (power of two)
+     * @tparam  TxCapacity  TX ring size in bytes (power of two)
+     * @tparam  MaxPacketSize  Bulk endpoint `wMaxPacketSize`
+     * @code
+     *   static usbstd::cdc::AcmDataChannel<2048, 2048, 64> acm;
+     *
+     *   // ISR: arm the next OUT transfer, and complete it
+     *   auto rx = acm.rxBuffer();
+     *   if (!rx.empty()) startOut(rx.data(), rx.size());
+     *   ...
+     *   acm.rxComplete(received);
+     *
+     *   // ISR: start an IN transfer, and complete it
+     *   auto tx = acm.txBuffer();
+     *   if (!tx.empty()) startIn(tx.data(), tx.size());
+     *   ...
+     *   acm.txComplete(sent);
+     * @endcode
+    */
+    template<size_t RxCapacity, size_t TxCapacity, size_t MaxPacketSize = 64>
+    class AcmDataChannel
+    {
+        static_assert(RxCapacity >= MaxPacketSize, "RX ring must hold at least one packet");
+
+    public:
+        /// @{ USB (ISR) side
+
+        /** Buffer for the next bulk OUT packet
+         * @return `MaxPacketSize` bytes of contiguous space, or an empty span when the RX ring is full and the endpoint should NAK
+        */
+        Span<uint8_t> rxBuffer()
+        {
+            const auto space = rx_.reserve();
+            if (space.size() >= MaxPacketSize)
+            {
+                rxBounced_ = false;
+                return space.first(MaxPacketSize);
+            }
+            if (rx_.available() >= MaxPacketSize)
+            {
+                rxBounced_ = true;
+                return bounce_;
+            }
+            return {};
+        }
+
+        /** Bulk OUT packet of `length` bytes was received into the last `rxBuffer()`
+        */
+        void rxComplete(size_t length)
+        {
+            if (rxBounced_)
+                rx_.write(bounce_, length);
+            else
+                rx_.commit(length);
+        }
+
+        /** Data for the next bulk IN transfer
+         * @param  maxLength  Largest transfer the controller accepts, data beyond the end of the ring storage is sent in the next transfer
+         * @return Contiguous data from the TX ring, or an empty span when there is nothing to send
+        */
+        Span<const uint8_t> txBuffer(size_t maxLength = TxCapacity)
+        {
+            const auto filled = tx_.peek().first;
+            return filled.first((filled.size() < maxLength) ? filled.size() : maxLength);
+        }
+
+        /** Bulk IN transfer of `length` bytes from the last `txBuffer()` completed
+        */
+        void txComplete(size_t length)
+        {
+            tx_.consume(length);
+        }
+        ///@}
+
+        /// @{ Application side
+
+        /** Received data, in place; release it with `consume()`
+        */
+        helper::SplitSpan<const uint8_t> readable() { return rx_.peek(); }
+        void consume(size_t length) { rx_.consume(length); }
+        size_t read(uint8_t* data, size_t length) { return rx_.read(data, length); }
+
+        /** Free TX space, in place; publish it with `commit()`
+        */
+        helper::SplitSpan<uint8_t> writable() { return tx_.reserveAll(); }
+        void commit(size_t length) { tx_.commit(length); }
+        size_t write(const uint8_t* data, size_t length) { return tx_.write(data, length); }
+        ///@}
+
+        /// @{ Control interface state, updated by SET_LINE_CODING and SET_CONTROL_LINE_STATE
+        usb_cdc_line_coding_t lineCoding = { 115200, USB_CDC_1_STOP_BIT, USB_CDC_NO_PARITY, USB_CDC_8_DATA_BITS };
+        uint16_t controlLineState = 0; ///< `CdcCtrlSignal` bits
+
+        bool dtePresent() const { return (controlLineState & static_cast<uint16_t>(CdcCtrlSignal::DtePresent)) != 0; }
+        ///@}
+
+    private:
+        helper::SpscRingBuffer<RxCapacity> rx_;
+        helper::SpscRingBuffer<TxCapacity> tx_;
+        uint8_t bounce_[MaxPacketSize] = {}; ///< OUT packet buffer used only when free RX space wraps mid-packet
+        bool rxBounced_ = false;
+    };
+
+} //END: cdc
+} //END: usbstd
\ No newline at end of file
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <array> //< std::array
+#include <atomic> //< std::atomic
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t, uint32_t
+#include <utility> //< std::index_sequence, std::make_index_sequence
+
+#include "usb_cdc.hpp" //< usbstd::usb_cdc_notify_serial_state_t, usbstd::CdcState, usbstd::USB_CDC_NOTIFY_SERIAL_STATE
+#include "usb_cdc_acm.hpp" //< usbstd::cdc::AcmDataChannel
+#include "usb_helper_composite.hpp" //< usbstd::helper::Composite, usbstd::helper::CdcAcmFunction
+#include "usbstd.hpp" //< usbstd::USB_IN_TRANSFER, usbstd::USB_CLASS_REQUEST, usbstd::USB_RECIPIENT_INTERFACE
+
+namespace usbstd {
+namespace cdc {
+
+    /** Several CDC-ACM ports of one device, with shared bulk IN scheduling and batched serial state notifications
+     * `Composite<Controller_t>` declares one `helper::CdcAcmFunction`, with its IAD, per port as functions 0 to `Ports - 1`,
+     * followed by any other functions; port `p` owns interfaces `2p` and `2p + 1` and the endpoints of `handle<p>`.
+     *
+     * Bulk IN: whenever the controller can start an IN transfer the USB side asks `nextTransmit()` for one. Ports with data
+     * are served round-robin, at most `Quantum` bytes per turn, so a port streaming data cannot starve a quiet one: once a
+     * port has data, at most `Ports - 1` transfers of other ports start before its own, and ports with a backlog share the
+     * IN bandwidth equally. `MaxInFlight` bounds the IN transfers running together, for controllers sharing packet memory
+     * or a DMA channel between endpoints.
+     *
+     * Serial state: the application reports `CdcState` bits with `serialState()`. Updates made while a notification of the
+     * port is pending or in flight are merged, so a burst costs one SERIAL_STATE interrupt transfer per port. DCD and DSR
+     * carry the latest level; the Break, Ring, Framing, Parity and Overrun events are accumulated and sent once, as PSTN 6.5.4
+     * requires. Notifications that would repeat the last levels without new events are dropped.
+     * @note The USB side functions must be called from one context, e.g. the USB ISR; `serialState()` from any context
+     * @tparam  Ports  Number of ports, 1 to 32
+     * @tparam  Quantum  Largest IN transfer of one turn, a multiple of `MaxPacketSize`
+     * @tparam  MaxInFlight  IN transfers started and not yet completed, across all ports
+     * @code
+     *   using Serial = usbstd::cdc::MultiPortAcm<4, 1024, 1024>;
+     *   using Device = Serial::Composite<usbstd::helper::ControllerTraits<16, 2048>>;
+     *   static constexpr auto notifyEndpoints = Serial::endpoints<Device>(0);
+     *   static constexpr auto inEndpoints = Serial::endpoints<Device>(2);
+     *   static Serial serial;
+     *
+     *   // ISR: start IN transfers while the scheduler has some, complete them on the endpoint interrupt
+     *   for (auto tx = serial.nextTransmit(); tx.port != Serial::NoPort; tx = serial.nextTransmit())
+     *       startIn(inEndpoints[tx.port], tx.data.data(), tx.data.size());
+     *   ...
+     *   serial.transmitComplete(Device::functionOfEndpoint(address), sent);
+     *
+     *   // ISR: send notifications on idle interrupt endpoints
+     *   for (size_t port = 0; port < Serial::PortCount; ++port)
+     *       if (auto notification = serial.nextNotification(port); !notification.empty())
+     *           startIn(notifyEndpoints[port], notification.data(), notification.size());
+     *
+     *   // Application
+     *   serial.port(2).write(data, length);
+     *   serial.serialState(2, uint16_t(usbstd::CdcState::Dcd) | uint16_t(usbstd::CdcState::Dsr));
+     * @endcode
+    */
+    template<size_t Ports, size_t RxCapacity, size_t TxCapacity, size_t MaxPacketSize = 64, size_t Quantum = 4 * MaxPacketSize, size_t MaxInFlight = Ports>
+    class MultiPortAcm
+    {
+        static_assert((Ports != 0) && (Ports <= 32), "Ports must be 1 to 32");
+        static_assert((Quantum != 0) && ((Quantum % MaxPacketSize) == 0), "Quantum must be a multiple of MaxPacketSize");
+        static_assert((MaxInFlight != 0) && (MaxInFlight <= Ports), "MaxInFlight must be 1 to Ports");
+
+        template<size_t>
+        struct PortFunction { using type = helper::CdcAcmFunction<MaxPacketSize>; };
+
+        template<typename Indices_t, typename Controller_t, typename... Others_t>
+        struct CompositeOf;
+
+        template<size_t... Index, typename Controller_t, typename... Others_t>
+        struct CompositeOf<std::index_sequence<Index...>, Controller_t, Others_t...>
+        {
+            using type = helper::Composite<Controller_t, typename PortFunction<Index>::type..., Others_t...>;
+        };
+
+    public:
+        static constexpr size_t PortCount = Ports;
+        static constexpr uint8_t NoPort = 0xff;
+
+        using Channel = AcmDataChannel<RxCapacity, TxCapacity, MaxPacketSize>;
+        using Function = helper::CdcAcmFunction<MaxPacketSize>;
+
+        /** Composite device of the ports, as functions 0 to `Ports - 1`, and `Others_t`
+        */
+        template<typename Controller_t, typename... Others_t>
+        using Composite = typename CompositeOf<std::make_index_sequence<Ports>, Controller_t, Others_t...>::type;
+
+        /** Communication interface of a port, the target of its class requests and notifications
+        */
+        static constexpr uint8_t communicationInterface(size_t port) { return static_cast<uint8_t>(2 * port); }
+
+        /** Address of endpoint `endpoint` of every port of `Composite_t`: 0 notification IN, 1 data OUT, 2 data IN
+        */
+        template<typename Composite_t>
+        static constexpr std::array<uint8_t, Ports> endpoints(size_t endpoint)
+        {
+            return endpoints_<Composite_t>(endpoint, std::make_index_sequence<Ports>{});
+        }
+
+        /** Port owning an interface, for routing SET_LINE_CODING and SET_CONTROL_LINE_STATE
+         * @return Port index or `NoPort`
+        */
+        static constexpr uint8_t portOfInterface(uint8_t interface) { return ((interface / 2) < Ports) ? static_cast<uint8_t>(interface / 2) : NoPort; }
+
+        Channel& port(size_t index) { return ports_[index]; }
+        const Channel& port(size_t index) const { return ports_[index]; }
+
+        /** IN transfer of a port
+        */
+        struct Transfer
+        {
+            uint8_t port; ///< `NoPort` when there is nothing to start
+            Span<const uint8_t> data;
+        };
+
+        /// @{ USB (ISR) side
+
+        /** Next bulk IN transfer, from the next port round-robin with data and no transfer in flight
+         * @return Up to `Quantum` bytes of the port's TX ring, or `NoPort` when no port has data or `MaxInFlight` transfers are running
+        */
+        Transfer nextTransmit()
+        {
+            if (inFlight_ >= MaxInFlight)
+                return { NoPort, {} };
+            size_t port = next_;
+            for (size_t i = 0; i < Ports; ++i, port = (port + 1 < Ports) ? (port + 1) : 0)
+            {
+                const uint32_t bit = uint32_t(1) << port;
+                if ((transmitting_ & bit) != 0)
+                    continue;
+                const auto data = ports_[port].txBuffer(Quantum);
+                if (data.empty())
+                    continue;
+                transmitting_ |= bit;
+                ++inFlight_;
+                next_ = (port + 1 < Ports) ? (port + 1) : 0;
+                return { static_cast<uint8_t>(port), data };
+            }
+            return { NoPort, {} };
+        }
+
+        /** Bulk IN transfer of `length` bytes from the last `nextTransmit()` of `port` completed
+        */
+        void transmitComplete(size_t port, size_t length)
+        {
+            ports_[port].txComplete(length);
+            transmitting_ &= ~(uint32_t(1) << port);
+            --inFlight_;
+        }
+
+        /** SERIAL_STATE notification of `port`, when its state changed since the last one and no notification is in flight
+         * @return The notification to send on the port's interrupt IN endpoint, valid until `notificationComplete()`, or an empty span
+        */
+        Span<const uint8_t> nextNotification(size_t port)
+        {
+            const uint32_t bit = uint32_t(1) << port;
+            if (((notifying_ & bit) != 0) || ((pending_.load(std::memory_order_relaxed) & bit) == 0))
+                return {};
+
+            pending_.fetch_and(~bit, std::memory_order_acquire);
+            const uint16_t events = events_[port].exchange(0, std::memory_order_relaxed);
+            const uint16_t levels = levels_[port].load(std::memory_order_relaxed);
+            if ((events == 0) && (levels == sent_[port]))
+                return {};
+
+            sent_[port] = levels;
+            notifications_[port].request = { (USB_IN_TRANSFER << 7) | (USB_CLASS_REQUEST << 5) | USB_RECIPIENT_INTERFACE
+                , USB_CDC_NOTIFY_SERIAL_STATE, 0, communicationInterface(port), 2 };
+            notifications_[port].value = static_cast<uint16_t>(levels | events);
+            notifying_ |= bit;
+            return { reinterpret_cast<const uint8_t*>(&notifications_[port]), sizeof(usb_cdc_notify_serial_state_t) };
+        }
+
+        /** Notification of `port` was sent
+        */
+        void notificationComplete(size_t port)
+        {
+            notifying_ &= ~(uint32_t(1) << port);
+        }
+
+        /** Bus reset or deconfiguration: transfers in flight are abandoned, their data is sent again
+        */
+        void reset()
+        {
+            transmitting_ = 0;
+            notifying_ = 0;
+            inFlight_ = 0;
+            next_ = 0;
+            for (auto& sent : sent_)
+                sent = 0;
+            pending_.fetch_or(AllPorts, std::memory_order_relaxed);
+        }
+        ///@}
+
+        /// @{ Application side
+
+        /** Report the `CdcState` bits of a port, queueing a notification
+        */
+        void serialState(size_t port, uint16_t state)
+        {
+            levels_[port].store(static_cast<uint16_t>(state & LevelMask), std::memory_order_relaxed);
+            if ((state & EventMask) != 0)
+                events_[port].fetch_or(static_cast<uint16_t>(state & EventMask), std::memory_order_relaxed);
+            pending_.fetch_or(uint32_t(1) << port, std::memory_order_release);
+        }
+        ///@}
+
+    private:
+        template<typename Composite_t, size_t... Index>
+        static constexpr std::array<uint8_t, Ports> endpoints_(size_t endpoint, std::index_sequence<Index...>)
+        {
+            return { { Composite_t::template handle<Index>.endpoint(endpoint)... } };
+        }
+
+        static constexpr uint16_t LevelMask = static_cast<uint16_t>(CdcState::Dcd) | static_cast<uint16_t>(CdcState::Dsr);
+        static constexpr uint16_t EventMask = static_cast<uint16_t>(CdcState::Break) | static_cast<uint16_t>(CdcState::Ring)
+            | static_cast<uint16_t>(CdcState::Framing) | static_cast<uint16_t>(CdcState::Parity) | static_cast<uint16_t>(CdcState::Overrun);
+        static constexpr uint32_t AllPorts = (Ports == 32) ? ~uint32_t(0) : ((uint32_t(1) << Ports) - 1);
+
+        Channel ports_[Ports];
+
+        // USB side
+        uint32_t transmitting_ = 0; ///< Ports with an IN transfer in flight
+        uint32_t notifying_ = 0; ///< Ports with a notification in flight
+        size_t inFlight_ = 0;
+        size_t next_ = 0; ///< Port the next round-robin scan starts at
+        uint16_t sent_[Ports] = {}; ///< Levels of the last notification
+        usb_cdc_notify_serial_state_t notifications_[Ports] = {};
+
+        // Application to USB side
+        std::atomic<uint32_t> pending_ = { 0 }; ///< Ports with an unsent `serialState()`
+        std::atomic<uint16_t> levels_[Ports] = {};
+        std::atomic<uint16_t> events_[Ports] = {};
+    };
+
+} //END: cdc
+} //END: usbstd
\ No newline at end of file
@@ -0,0 +1,354 @@
+#pragma once
+
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t, uint32_t
+#include <cstring> //< std::memcpy, std::memset
+
+#include "usb_cdc.hpp" //< usbstd::CdcSubClass::Ncm, usbstd::cdc::NcmDescriptor
+#include "usb_endian.hpp" //< usbstd::Le16, usbstd::Le32
+#include "usb_span.hpp" //< usbstd::Span
+
+namespace usbstd {
+namespace cdc {
+#pragma pack(push, 1)
+
+    /// NTB Parameter Structure, response to GET_NTB_PARAMETERS (NCM 1.0 Table 6-3)
+    struct NtbParameters
+    {
+        Le16 wLength; ///< Size of this structure, 0x1C
+        Le16 bmNtbFormatsSupported; ///< D0: NTB-16 (shall be set), D1: NTB-32
+        Le32 dwNtbInMaxSize; ///< IN NTB maximum size in bytes
+        Le16 wNdpInDivisor; ///< Modulus used to align IN datagrams
+        Le16 wNdpInPayloadRemainder; ///< Remainder used to align IN datagrams (offset % divisor == remainder)
+        Le16 wNdpInAlignment; ///< Alignment of IN NDPs, power of two >= 4
+        Le16 wReserved;
+        Le32 dwNtbOutMaxSize; ///< OUT NTB maximum size in bytes
+        Le16 wNdpOutDivisor; ///< Modulus used to align OUT datagrams
+        Le16 wNdpOutPayloadRemainder; ///< Remainder used to align OUT datagrams
+        Le16 wNdpOutAlignment; ///< Alignment of OUT NDPs
+        Le16 wNtbOutMaxDatagrams; ///< Maximum number of datagrams per OUT NTB, 0 for no limit
+    };
+    static_assert(sizeof(NtbParameters) == 28, "size is not correct");
+
+    /// 16-bit NCM Transfer Header (NCM 1.0 Table 3-1)
+    struct Nth16
+    {
+        Le32 dwSignature; ///< "NCMH"
+        Le16 wHeaderLength; ///< Size of this header, 12
+        Le16 wSequence; ///< Sequence number, incremented for each NTB
+        Le16 wBlockLength; ///< Size of the whole NTB in bytes
+        Le16 wNdpIndex; ///< Offset of the first NDP
+    };
+
+    /// 32-bit NCM Transfer Header (NCM 1.0 Table 3-2)
+    struct Nth32
+    {
+        Le32 dwSignature; ///< "ncmh"
+        Le16 wHeaderLength; ///< Size of this header, 16
+        Le16 wSequence; ///< Sequence number, incremented for each NTB
+        Le32 dwBlockLength; ///< Size of the whole NTB in bytes
+        Le32 dwNdpIndex; ///< Offset of the first NDP
+    };
+
+    /// 16-bit NCM Datagram Pointer header (NCM 1.0 Table 3-3), followed by `NdpEntry16` terminated by a zero entry
+    struct Ndp16
+    {
+        Le32 dwSignature; ///< "NCM0" (no CRC) or "NCM1" (CRC appended)
+        Le16 wLength; ///< Size of this NDP including entries, multiple of 4 and >= 16
+        Le16 wNextNdpIndex; ///< Offset of the next NDP, or 0
+    };
+
+    struct NdpEntry16
+    {
+        Le16 wDatagramIndex; ///< Offset of the datagram from the start of the NTB
+        Le16 wDatagramLength; ///< Length of the datagram in bytes
+    };
+
+    /// 32-bit NCM Datagram Pointer header (NCM 1.0 Table 3-4), followed by `NdpEntry32` terminated by a zero entry
+    struct Ndp32
+    {
+        Le32 dwSignature; ///< "ncm0" (no CRC) or "ncm1" (CRC appended)
+        Le16 wLength; ///< Size of this NDP including entries, multiple of 8 and >= 32
+        Le16 wReserved6;
+        Le32 dwNextNdpIndex; ///< Offset of the next NDP, or 0
+        Le32 dwReserved12;
+    };
+
+    struct NdpEntry32
+    {
+        Le32 dwDatagramIndex; ///< Offset of the datagram from the start of the NTB
+        Le32 dwDatagramLength; ///< Length of the datagram in bytes
+    };
+
+#pragma pack(pop)
+
+    /** NTB-16 format traits
+    */
+    struct Ntb16
+    {
+        using Nth = Nth16;
+        using Ndp = Ndp16;
+        using NdpEntry = NdpEntry16;
+
+        static constexpr uint32_t NthSignature = 0x484D434E; ///< "NCMH"
+        static constexpr uint32_t NdpSignature = 0x304D434E; ///< "NCM0"
+        static constexpr size_t NdpAlignment = 4;
+        static constexpr size_t MaxBlockLength = UINT16_MAX;
+
+        static size_t blockLength(const Nth& nth) { return nth.wBlockLength; }
+        static size_t ndpIndex(const Nth& nth) { return nth.wNdpIndex; }
+        static size_t nextNdpIndex(const Ndp& ndp) { return ndp.wNextNdpIndex; }
+        static size_t datagramIndex(const NdpEntry& entry) { return entry.wDatagramIndex; }
+        static size_t datagramLength(const NdpEntry& entry) { return entry.wDatagramLength; }
+
+        static Nth makeNth(uint16_t sequence, size_t blockLength, size_t ndpIndex)
+        {
+            return { NthSignature, sizeof(Nth), sequence, static_cast<uint16_t>(blockLength), static_cast<uint16_t>(ndpIndex) };
+        }
+        static Ndp makeNdp(size_t length) { return { NdpSignature, static_cast<uint16_t>(length), 0 }; }
+        static NdpEntry makeEntry(size_t index, size_t length) { return { static_cast<uint16_t>(index), static_cast<uint16_t>(length) }; }
+    };
+
+    /** NTB-32 format traits
+    */
+    struct Ntb32
+    {
+        using Nth = Nth32;
+        using Ndp = Ndp32;
+        using NdpEntry = NdpEntry32;
+
+        static constexpr uint32_t NthSignature = 0x686D636E; ///< "ncmh"
+        static constexpr uint32_t NdpSignature = 0x306D636E; ///< "ncm0"
+        static constexpr size_t NdpAlignment = 8;
+        static constexpr size_t MaxBlockLength = UINT32_MAX;
+
+        static size_t blockLength(const Nth& nth) { return nth.dwBlockLength; }
+        static size_t ndpIndex(const Nth& nth) { return nth.dwNdpIndex; }
+        static size_t nextNdpIndex(const Ndp& ndp) { return ndp.dwNextNdpIndex; }
+        static size_t datagramIndex(const NdpEntry& entry) { return entry.dwDatagramIndex; }
+        static size_t datagramLength(const NdpEntry& entry) { return entry.dwDatagramLength; }
+
+        static Nth makeNth(uint16_t sequence, size_t blockLength, size_t ndpIndex)
+        {
+            return { NthSignature, sizeof(Nth), sequence, static_cast<uint32_t>(blockLength), static_cast<uint32_t>(ndpIndex) };
+        }
+        static Ndp makeNdp(size_t length) { return { NdpSignature, static_cast<uint16_t>(length), 0, 0, 0 }; }
+        static NdpEntry makeEntry(size_t index, size_t length) { return { static_cast<uint32_t>(index), static_cast<uint32_t>(length) }; }
+    };
+
+    /** Aggregates Ethernet frames into a single NTB transfer buffer
+     * Frames are written in place (`reserve()`/`commit()`), so a network stack or DMA can fill the NTB without an extra copy.
+     * The NTH is written at the start of the buffer and a single NDP after the last datagram when the NTB is finished.
+     * @tparam  Format_t  `Ntb16` or `Ntb32`
+     * @tparam  MaxDatagrams  Maximum datagrams per NTB
+     * @code
+     *   static uint8_t ntbBuffer[8192];
+     *   usbstd::cdc::NtbEncoder<usbstd::cdc::Ntb16> encoder{ ntbBuffer };
+     *
+     *   for (auto frame = encoder.reserve(nextFrameLength()); !frame.empty(); frame = encoder.reserve(nextFrameLength()))
+     *       encoder.commit(receiveFrame(frame.data(), frame.size()));
+     *   const auto ntb = encoder.finish(sequence++); //< Send as one bulk IN transfer
+     * @endcode
+    */
+    template<typename Format_t, size_t MaxDatagrams = 32>
+    class NtbEncoder
+    {
+        using Nth = typename Format_t::Nth;
+        using Ndp = typename Format_t::Ndp;
+        using NdpEntry = typename Format_t::NdpEntry;
+
+    public:
+        /** @param buffer  NTB transfer buffer, at most `dwNtbInMaxSize`
+         * @param divisor  `wNdpInDivisor` datagram alignment modulus
+         * @param remainder  `wNdpInPayloadRemainder` datagram alignment remainder
+        */
+        NtbEncoder(Span<uint8_t> buffer, size_t divisor = 4, size_t remainder = 0)
+            : buffer_(buffer.first((buffer.size() < Format_t::MaxBlockLength) ? buffer.size() : Format_t::MaxBlockLength))
+            , divisor_(divisor ? divisor : 1), remainder_(remainder % (divisor ? divisor : 1))
+        {
+        }
+
+        /** Discard all datagrams and start a new NTB
+        */
+        void reset()
+        {
+            position_ = sizeof(Nth);
+            count_ = 0;
+        }
+
+        /** Space for the next datagram, aligned as negotiated
+         * @return Span of `length` bytes, or an empty span when the datagram does not fit into this NTB
+        */
+        Span<uint8_t> reserve(size_t length)
+        {
+            if (count_ == MaxDatagrams)
+                return {};
+            const auto offset = datagramOffset(position_);
+            if ((length == 0) || (align(offset + length, Format_t::NdpAlignment) + ndpLength(count_ + 1) > buffer_.size()))
+                return {};
+            pending_ = offset;
+            return buffer_.subspan(offset, length);
+        }
+
+        /** Add the datagram written into the last `reserve()` of (at most the reserved) `length` bytes
+        */
+        void commit(size_t length)
+        {
+            entries_[count_++] = { pending_, length };
+            position_ = pending_ + length;
+        }
+
+        /** Copy a datagram into the NTB
+         * @return `false` when the datagram does not fit and a new NTB must be started
+        */
+        bool append(Span<const uint8_t> datagram)
+        {
+            auto space = reserve(datagram.size());
+            if (space.empty())
+                return false;
+            std::memcpy(space.data(), datagram.data(), datagram.size());
+            commit(datagram.size());
+            return true;
+        }
+
+        size_t size() const { return count_; }
+        bool empty() const { return count_ == 0; }
+
+        /** Write the NTH and NDP for the aggregated datagrams
+         * @return The complete NTB, or an empty span when no datagram was added
+         * @note The encoder is reset; the returned span remains valid until the buffer is reused
+        */
+        Span<const uint8_t> finish(uint16_t sequence)
+        {
+            if (count_ == 0)
+                return {};
+
+            const auto ndpIndex = align(position_, Format_t::NdpAlignment);
+            const auto length = ndpIndex + ndpLength(count_);
+            std::memset(buffer_.data() + position_, 0, ndpIndex - position_);
+
+            const Nth nth = Format_t::makeNth(sequence, length, ndpIndex);
+            std::memcpy(buffer_.data(), &nth, sizeof(nth));
+            const Ndp ndp = Format_t::makeNdp(ndpLength(count_));
+            std::memcpy(buffer_.data() + ndpIndex, &ndp, sizeof(ndp));
+
+            auto* entry = buffer_.data() + ndpIndex + sizeof(Ndp);
+            for (size_t i = 0; i <= count_; ++i, entry += sizeof(NdpEntry))
+            {
+                const NdpEntry value = (i < count_) ? Format_t::makeEntry(entries_[i].offset, entries_[i].length) : NdpEntry{}; //< Zero terminated
+                std::memcpy(entry, &value, sizeof(value));
+            }
+
+            reset();
+            return { buffer_.data(), length };
+        }
+
+    private:
+        static constexpr size_t align(size_t value, size_t alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+        /** NDP length for `count` datagrams plus the terminating entry, padded to the NDP alignment
+        */
+        static constexpr size_t ndpLength(size_t count) { return align(sizeof(Ndp) + ((count + 1) * sizeof(NdpEntry)), Format_t::NdpAlignment); }
+
+        size_t datagramOffset(size_t position) const
+        {
+            const auto misalignment = (position + divisor_ - remainder_) % divisor_;
+            return misalignment ? (position + divisor_ - misalignment) : position;
+        }
+
+        struct Entry
+        {
+            size_t offset;
+            size_t length;
+        };
+
+        Span<uint8_t> buffer_;
+        size_t divisor_;
+        size_t remainder_;
+        size_t position_ = sizeof(Nth);
+        size_t pending_ = 0;
+        size_t count_ = 0;
+        Entry entries_[MaxDatagrams] = {};
+    };
+
+    /** Validating, zero-copy decoder of a received NTB
+     * Datagrams are returned as spans into the NTB buffer; every NDP in the chain is followed.
+     * @tparam  Format_t  `Ntb16` or `Ntb32`
+     * @code
+     *   usbstd::cdc::NtbDecoder<usbstd::cdc::Ntb16> decoder{ received };
+     *   decoder.forEach([](usbstd::Span<const uint8_t> frame) { forwardToEthernet(frame); });
+     * @endcode
+    */
+    template<typename Format_t>
+    class NtbDecoder
+    {
+        using Nth = typename Format_t::Nth;
+        using Ndp = typename Format_t::Ndp;
+        using NdpEntry = typename Format_t::NdpEntry;
+
+    public:
+        explicit NtbDecoder(Span<const uint8_t> ntb)
+        {
+            if (ntb.size() < sizeof(Nth))
+                return;
+            Nth nth;
+            std::memcpy(&nth, ntb.data(), sizeof(nth));
+            const auto blockLength = Format_t::blockLength(nth);
+            if ((nth.dwSignature != Format_t::NthSignature) || (nth.wHeaderLength != sizeof(Nth))
+                || (blockLength > ntb.size()) || (blockLength < sizeof(Nth)))
+                return;
+            ntb_ = ntb.first(blockLength);
+            firstNdp_ = Format_t::ndpIndex(nth);
+        }
+
+        /** `true` when the NTH is well-formed
+        */
+        bool valid() const { return !ntb_.empty(); }
+
+        /** Invoke `fn(Span<const uint8_t>)` for each datagram in NTB order
+         * @return Number of datagrams visited; iteration stops at the first malformed NDP or entry
+        */
+        template<typename Fn>
+        size_t forEach(Fn&& fn) const
+        {
+            size_t count = 0;
+            size_t ndpIndex = firstNdp_;
+            for (size_t hops = 0; valid() && (ndpIndex != 0) && (hops < MaxNdpChain); ++hops)
+            {
+                if ((ndpIndex % sizeof(uint32_t)) || (ndpIndex + sizeof(Ndp) > ntb_.size()))
+                    break;
+                Ndp ndp;
+                std::memcpy(&ndp, ntb_.data() + ndpIndex, sizeof(ndp));
+                if (((ndp.dwSignature & 0x00FFFFFF) != (Format_t::NdpSignature & 0x00FFFFFF))
+                    || (ndp.wLength < sizeof(Ndp) + (2 * sizeof(NdpEntry))) || (ndpIndex + ndp.wLength > ntb_.size()))
+                    break;
+
+                const size_t entries = (ndp.wLength - sizeof(Ndp)) / sizeof(NdpEntry);
+                const uint8_t* entry = ntb_.data() + ndpIndex + sizeof(Ndp);
+                for (size_t i = 0; i < entries; ++i, entry += sizeof(NdpEntry))
+                {
+                    NdpEntry value;
+                    std::memcpy(&value, entry, sizeof(value));
+                    const auto index = Format_t::datagramIndex(value);
+                    const auto length = Format_t::datagramLength(value);
+                    if ((index == 0) || (length == 0))
+                        break;
+                    if ((index > ntb_.size()) || (length > ntb_.size() - index))
+                        return count;
+                    fn(ntb_.subspan(index, length));
+                    ++count;
+                }
+                ndpIndex = Format_t::nextNdpIndex(ndp);
+            }
+            return count;
+        }
+
+    private:
+        static constexpr size_t MaxNdpChain = 64; ///< Bound on NDP chain length, protects against loops in malformed NTBs
+
+        Span<const uint8_t> ntb_;
+        size_t firstNdp_ = 0;
+    };
+
+} //END: cdc
+} //END: usbstd
\ No newline at end of file
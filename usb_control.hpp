@@ -0,0 +1,374 @@
+#pragma once
+
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t
+#include <cstring> //< std::memcpy
+#include <initializer_list> //< std::initializer_list
+
+#include "usb_request.hpp" //< usbstd::Request
+#include "usb_span.hpp" //< usbstd::Span
+#include "usbstd.hpp" //< usbstd::USB_IN_TRANSFER
+
+namespace usbstd {
+
+    enum class ControlStage : uint8_t
+    {
+        Idle, ///< No transfer, or stalled until the next SETUP
+        Setup, ///< SETUP received, waiting for the application
+        DataIn,
+        DataOut,
+        DataReceived, ///< OUT data stage complete, waiting for the application to `acknowledge()` or `stall()`
+        StatusIn, ///< Device sends the status ZLP
+        StatusOut, ///< Host sends the status ZLP
+    };
+
+    enum class ControlEvent : uint8_t
+    {
+        None,
+        DataReceived, ///< OUT data stage complete, `received()` bytes are in the `receive()` buffer
+        Complete, ///< Status stage done, e.g. apply SET_ADDRESS now
+    };
+
+    /** Device side control transfer state machine for endpoint 0
+     * Data stages are streamed straight from (or into) the caller's memory in `bMaxPacketSize0` packets: an IN data stage
+     * is described by up to `MaxSegments` spans, e.g. a header in RAM followed by a descriptor in ROM, and each packet
+     * is handed to the controller as a pointer into those spans. Only a packet straddling two spans is gathered into an
+     * internal packet buffer. The data stage is clamped to `wLength`, and ends with a zero-length packet when it is
+     * shorter than `wLength` and a multiple of `bMaxPacketSize0`.
+     *
+     * The controller driver reports `setup()`, `inComplete()` and `outComplete()`; the application answers a SETUP with
+     * exactly one of `send()`, `receive()`, `acknowledge()` or `stall()`, immediately or later.
+     * @tparam  Backend_t  Controller driver providing:
+     *  - `void ep0Transmit(const uint8_t* data, size_t length)`: send one IN packet, `length` 0 for a ZLP
+     *  - `void ep0Receive(uint8_t* data, size_t length)`: accept one OUT packet of at most `length` bytes, 0 for a status ZLP
+     *  - `void ep0Stall()`: stall both directions until the next SETUP
+     * @tparam  MaxSegments  Most spans in one IN data stage
+     * @tparam  MaxPacketSize0  Largest `bMaxPacketSize0` used, the size of the packet buffer
+     * @code
+     *   usbstd::ControlPipe<Controller> ep0{ controller, 64 };
+     *
+     *   void onSetup(const usbstd::Request& request)
+     *   {
+     *       ep0.setup(request);
+     *       if (isGetConfiguration(request))
+     *           ep0.send({ usbConfiguration.data(), usbConfiguration.size() });
+     *       else
+     *           ep0.stall();
+     *   }
+     *   void onEp0In()                { if (ep0.inComplete() == usbstd::ControlEvent::Complete) applyAddress(); }
+     *   void onEp0Out(size_t length)  { if (ep0.outComplete(length) == usbstd::ControlEvent::DataReceived) handleData(); }
+     * @endcode
+    */
+    template<typename Backend_t, size_t MaxSegments = 4, size_t MaxPacketSize0 = 64>
+    class ControlPipe
+    {
+    public:
+        explicit ControlPipe(Backend_t& backend, uint8_t maxPacketSize0 = static_cast<uint8_t>(MaxPacketSize0 < 255 ? MaxPacketSize0 : 64))
+            : backend_(backend), maxPacketSize_((maxPacketSize0 <= MaxPacketSize0) ? maxPacketSize0 : static_cast<uint8_t>(MaxPacketSize0))
+        {}
+
+        /** `bMaxPacketSize0` after enumeration or a speed change, at most `MaxPacketSize0`
+        */
+        uint8_t maxPacketSize() const { return maxPacketSize_; }
+        void maxPacketSize(uint8_t size) { maxPacketSize_ = (size <= MaxPacketSize0) ? size : static_cast<uint8_t>(MaxPacketSize0); }
+
+        ControlStage stage() const { return stage_; }
+        const Request& request() const { return request_; }
+        size_t received() const { return offset_; }
+
+        /// @{ Controller side
+
+        /** SETUP packet received, abandoning any transfer in progress
+        */
+        void setup(const Request& request)
+        {
+            request_ = request;
+            segmentCount_ = 0;
+            segment_ = 0;
+            offset_ = 0;
+            remaining_ = 0;
+            zlp_ = false;
+            stage_ = ControlStage::Setup;
+        }
+
+        /** The last IN packet was sent
+        */
+        ControlEvent inComplete()
+        {
+            if (stage_ == ControlStage::DataIn)
+            {
+                if ((remaining_ != 0) || zlp_)
+                    transmitNext();
+                else
+                {
+                    stage_ = ControlStage::StatusOut;
+                    backend_.ep0Receive(nullptr, 0);
+                }
+            }
+            else if (stage_ == ControlStage::StatusIn)
+            {
+                stage_ = ControlStage::Idle;
+                return ControlEvent::Complete;
+            }
+            return ControlEvent::None;
+        }
+
+        /** An OUT packet of `length` bytes was received
+        */
+        ControlEvent outComplete(size_t length)
+        {
+            if (stage_ == ControlStage::DataOut)
+            {
+                offset_ += length;
+                remaining_ = (length < remaining_) ? (remaining_ - length) : 0;
+                if ((remaining_ == 0) || (length < maxPacketSize_))
+                {
+                    stage_ = ControlStage::DataReceived;
+                    return ControlEvent::DataReceived;
+                }
+                receiveNext();
+            }
+            else if ((stage_ == ControlStage::StatusOut) || (stage_ == ControlStage::DataIn))
+            {
+                // The host may end an IN data stage early and start the status stage
+                stage_ = ControlStage::Idle;
+                return ControlEvent::Complete;
+            }
+            return ControlEvent::None;
+        }
+        ///@}
+
+        /// @{ Application side
+
+        /** Answer an IN request with the concatenation of `segments`, clamped to `wLength`
+         * A request with a `wLength` of 0 has no data stage and is acknowledged.
+         * @note The segments must stay valid until the transfer completes
+         * @return `false` (and stall) when the request is not an IN request or has too many segments
+        */
+        bool send(const Span<const uint8_t>* segments, size_t count)
+        {
+            if ((stage_ != ControlStage::Setup) || (request_.direction() != USB_IN_TRANSFER) || (count > MaxSegments))
+            {
+                stall();
+                return false;
+            }
+            if (request_.wLength == 0)
+            {
+                // No data stage: the status stage is the device's ZLP
+                acknowledge();
+                return true;
+            }
+
+            size_t total = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                segments_[i] = segments[i];
+                total += segments[i].size();
+            }
+            segmentCount_ = count;
+            remaining_ = (total < request_.wLength) ? total : static_cast<size_t>(request_.wLength);
+            zlp_ = (remaining_ < request_.wLength) && ((remaining_ % maxPacketSize_) == 0);
+            stage_ = ControlStage::DataIn;
+            transmitNext();
+            return true;
+        }
+
+        bool send(std::initializer_list<Span<const uint8_t>> segments) { return send(segments.begin(), segments.size()); }
+        bool send(Span<const uint8_t> data) { return send(&data, 1); }
+
+        /** Answer an OUT request by receiving its data stage into `buffer`
+         * @return `false` (and stall) when the request is not an OUT request with data or `buffer` is smaller than `wLength`
+        */
+        bool receive(Span<uint8_t> buffer)
+        {
+            if ((stage_ != ControlStage::Setup) || (request_.direction() == USB_IN_TRANSFER) || (request_.wLength == 0) || (buffer.size() < request_.wLength))
+            {
+                stall();
+                return false;
+            }
+            buffer_ = buffer.data();
+            offset_ = 0;
+            remaining_ = request_.wLength;
+            stage_ = ControlStage::DataOut;
+            receiveNext();
+            return true;
+        }
+
+        /** Complete a request without data stage, or an OUT request after its data was received, with a status ZLP
+        */
+        void acknowledge()
+        {
+            if ((stage_ == ControlStage::DataReceived) || ((stage_ == ControlStage::Setup) && (request_.direction() != USB_IN_TRANSFER || request_.wLength == 0)))
+            {
+                stage_ = ControlStage::StatusIn;
+                backend_.ep0Transmit(nullptr, 0);
+            }
+            else
+                stall();
+        }
+
+        /** Reject the request, the host sees a STALL handshake
+        */
+        void stall()
+        {
+            stage_ = ControlStage::Idle;
+            backend_.ep0Stall();
+        }
+        ///@}
+
+    private:
+        void transmitNext()
+        {
+            const size_t length = (remaining_ < maxPacketSize_) ? remaining_ : maxPacketSize_;
+            if (length == 0)
+            {
+                zlp_ = false;
+                backend_.ep0Transmit(nullptr, 0);
+                return;
+            }
+
+            // Skip exhausted (and empty) segments
+            while ((segment_ < segmentCount_) && (offset_ == segments_[segment_].size()))
+            {
+                ++segment_;
+                offset_ = 0;
+            }
+
+            const auto& segment = segments_[segment_];
+            const uint8_t* packet = segment.data() + offset_;
+            if (segment.size() - offset_ >= length)
+                offset_ += length;
+            else
+            {
+                // Packet straddles segments, gather it
+                size_t gathered = 0;
+                while (gathered < length)
+                {
+                    const auto& part = segments_[segment_];
+                    const size_t available = part.size() - offset_;
+                    const size_t count = (available < length - gathered) ? available : (length - gathered);
+                    std::memcpy(packet_ + gathered, part.data() + offset_, count);
+                    gathered += count;
+                    offset_ += count;
+                    if (offset_ == part.size())
+                    {
+                        ++segment_;
+                        offset_ = 0;
+                    }
+                }
+                packet = packet_;
+            }
+            remaining_ -= length;
+            backend_.ep0Transmit(packet, length);
+        }
+
+        void receiveNext()
+        {
+            backend_.ep0Receive(buffer_ + offset_, (remaining_ < maxPacketSize_) ? remaining_ : maxPacketSize_);
+        }
+
+        Backend_t& backend_;
+        uint8_t maxPacketSize_;
+        ControlStage stage_ = ControlStage::Idle;
+        Request request_ = {};
+        bool zlp_ = false; ///< IN data stage ends with a ZLP
+
+        Span<const uint8_t> segments_[MaxSegments];
+        size_t segmentCount_ = 0;
+        size_t segment_ = 0;
+        size_t offset_ = 0; ///< IN: offset in the current segment, OUT: bytes received
+        size_t remaining_ = 0; ///< Data stage bytes not yet sent or received
+        uint8_t* buffer_ = nullptr;
+        uint8_t packet_[MaxPacketSize0];
+    };
+
+    /** In-memory endpoint 0 for `ControlPipe`, standing in for a controller in tests and benchmarks
+     * `transfer()` plays the host: it runs a complete control transfer and collects the IN data.
+    */
+    class ControlLoopback
+    {
+    public:
+        /// @{ Backend interface
+        void ep0Transmit(const uint8_t* data, size_t length) { in_ = data; inLength_ = length; inPending_ = true; }
+        void ep0Receive(uint8_t* data, size_t length) { out_ = data; outLength_ = length; outPending_ = true; }
+        void ep0Stall() { stalled_ = true; }
+        ///@}
+
+        bool stalled() const { return stalled_; }
+        size_t packets() const { return packets_; }
+
+        /** Run a control transfer as the host
+         * @param data  IN: receives up to `wLength` bytes; OUT: the `wLength` bytes to send
+         * @param answer  `answer(pipe)` responds to the SETUP, as the application would
+         * @return Data stage bytes transferred, or -1 when the device stalled or did not complete the status stage
+        */
+        template<typename Pipe_t, typename Answer_t>
+        long transfer(Pipe_t& pipe, const Request& request, Span<uint8_t> data, Answer_t&& answer)
+        {
+            inPending_ = outPending_ = stalled_ = false;
+            packets_ = 0;
+            pipe.setup(request);
+            answer(pipe);
+
+            size_t transferred = 0;
+            if ((request.direction() == USB_IN_TRANSFER) && (request.wLength != 0))
+            {
+                // Every packet completes, including the last full-size one and a terminating ZLP
+                while (!stalled_ && inPending_)
+                {
+                    inPending_ = false;
+                    ++packets_;
+                    if (inLength_ > request.wLength - transferred)
+                        return -1; //< Data stage longer than `wLength`
+                    if ((inLength_ != 0) && (data.data() != nullptr))
+                        std::memcpy(data.data() + transferred, in_, inLength_);
+                    transferred += inLength_;
+                    const bool last = (inLength_ < maxPacketSize(pipe)) || (transferred == request.wLength);
+                    pipe.inComplete();
+                    if (last)
+                        break;
+                }
+                // Status stage: the device must have armed it, and the host sends a ZLP
+                if (stalled_ || inPending_ || !outPending_ || (outLength_ != 0))
+                    return -1;
+                outPending_ = false;
+                if (pipe.outComplete(0) != ControlEvent::Complete)
+                    return -1;
+            }
+            else
+            {
+                while (!stalled_ && outPending_ && (transferred < request.wLength))
+                {
+                    outPending_ = false;
+                    ++packets_;
+                    const size_t left = request.wLength - transferred;
+                    const size_t length = (outLength_ < left) ? outLength_ : left;
+                    std::memcpy(out_, data.data() + transferred, length);
+                    transferred += length;
+                    if (pipe.outComplete(length) == ControlEvent::DataReceived)
+                        answer(pipe);
+                }
+                if (stalled_ || !inPending_ || (inLength_ != 0))
+                    return -1;
+                inPending_ = false;
+                if (pipe.inComplete() != ControlEvent::Complete)
+                    return -1;
+            }
+            return stalled_ ? -1 : static_cast<long>(transferred);
+        }
+
+    private:
+        template<typename Pipe_t>
+        static size_t maxPacketSize(const Pipe_t& pipe) { return pipe.maxPacketSize(); }
+
+        const uint8_t* in_ = nullptr;
+        size_t inLength_ = 0;
+        uint8_t* out_ = nullptr;
+        size_t outLength_ = 0;
+        size_t packets_ = 0;
+        bool inPending_ = false;
+        bool outPending_ = false;
+        bool stalled_ = false;
+    };
+
+} //END: usbstd
\ No newline at end of file
@@ -0,0 +1,348 @@
+#pragma once
+
+#include <atomic> //< std::atomic
+#include <cstddef> //< size_t, std::max_align_t
+#include <cstdint> //< uint8_t, uint32_t
+#include <exception> //< std::terminate
+
+#include "usb_control.hpp" //< usbstd::ControlPipe, usbstd::ControlEvent
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine> //< std::coroutine_handle, std::suspend_always, std::suspend_never
+#define USBSTD_HAS_COROUTINES 1
+
+namespace usbstd {
+
+    /** Fixed block allocator for coroutine frames, avoiding the heap
+     * @see StaticFramePool
+    */
+    class FramePool
+    {
+    public:
+        /** Header in front of every frame, so `ControlTask` can return it to its pool
+        */
+        struct alignas(std::max_align_t) Header
+        {
+            FramePool* pool;
+        };
+
+        void* allocate(size_t size)
+        {
+            if (size + sizeof(Header) <= blockSize_)
+            {
+                for (size_t i = 0; i < blockCount_; ++i)
+                {
+                    if ((used_ & (1u << i)) == 0)
+                    {
+                        used_ |= (1u << i);
+                        ++inUse_;
+                        peak_ = (inUse_ > peak_) ? inUse_ : peak_;
+                        Header* header = reinterpret_cast<Header*>(storage_ + i * blockSize_);
+                        header->pool = this;
+                        return header + 1;
+                    }
+                }
+            }
+            ++failures_;
+            return nullptr;
+        }
+
+        static inline FramePool* active = nullptr; ///< Pool `ControlTask` frames are allocated from, set while a handler starts
+
+        static void deallocate(void* frame)
+        {
+            Header* header = static_cast<Header*>(frame) - 1;
+            FramePool& pool = *header->pool;
+            const size_t index = static_cast<size_t>(reinterpret_cast<unsigned char*>(header) - pool.storage_) / pool.blockSize_;
+            pool.used_ &= ~(1u << index);
+            --pool.inUse_;
+        }
+
+        size_t blockSize() const { return blockSize_ - sizeof(Header); } ///< Largest frame
+        size_t inUse() const { return inUse_; }
+        size_t peak() const { return peak_; }
+        size_t failures() const { return failures_; } ///< Coroutines that could not start
+
+    protected:
+        FramePool(unsigned char* storage, size_t blockSize, size_t blockCount)
+            : storage_(storage), blockSize_(blockSize), blockCount_(blockCount)
+        {}
+
+    private:
+        unsigned char* storage_;
+        size_t blockSize_;
+        size_t blockCount_;
+        uint32_t used_ = 0;
+        size_t inUse_ = 0;
+        size_t peak_ = 0;
+        size_t failures_ = 0;
+    };
+
+    /** `FramePool` owning `Frames` blocks of `FrameSize` bytes
+     * @tparam  FrameSize  Largest coroutine frame; compilers do not expose frame sizes, so size it from `peak()` and `failures()` in testing
+     * @tparam  Frames  Concurrent coroutines, at most 32
+    */
+    template<size_t FrameSize, size_t Frames = 1>
+    class StaticFramePool : public FramePool
+    {
+        static_assert(Frames > 0 && Frames <= 32, "1 to 32 frames supported");
+        static constexpr size_t BlockSize = (sizeof(Header) + FrameSize + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+    public:
+        StaticFramePool() : FramePool(storage_, BlockSize, Frames) {}
+
+    private:
+        alignas(std::max_align_t) unsigned char storage_[BlockSize * Frames];
+    };
+
+    /** Coroutine type of an asynchronous control request handler
+     * The frame is allocated from the `FramePool` of the `AsyncControl` starting the handler; there is no heap fallback.
+     * When the pool is exhausted, or the coroutine is called outside `AsyncControl::poll()`, the task is invalid and the
+     * request is stalled.
+    */
+    class ControlTask
+    {
+    public:
+        struct promise_type
+        {
+            static void* operator new(size_t size) noexcept { return (FramePool::active != nullptr) ? FramePool::active->allocate(size) : nullptr; }
+            static void operator delete(void* frame, size_t) { FramePool::deallocate(frame); }
+
+            static ControlTask get_return_object_on_allocation_failure() { return ControlTask{}; }
+            ControlTask get_return_object() { return ControlTask{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+
+        ControlTask() = default;
+        ControlTask(ControlTask&& other) noexcept : handle_(other.handle_) { other.handle_ = nullptr; }
+        ControlTask& operator=(ControlTask&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                handle_ = other.handle_;
+                other.handle_ = nullptr;
+            }
+            return *this;
+        }
+        ~ControlTask() { reset(); }
+
+        bool valid() const { return static_cast<bool>(handle_); }
+        bool done() const { return !handle_ || handle_.done(); }
+        void resume() { handle_.resume(); }
+
+        /** Destroy the coroutine, running the destructors of its locals
+        */
+        void reset()
+        {
+            if (handle_)
+                handle_.destroy();
+            handle_ = nullptr;
+        }
+
+    private:
+        explicit ControlTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    /** Runs control request handlers written as coroutines on top of `ControlPipe`
+     * The USB interrupt only forwards SETUP and EP0 completions, each a bounded amount of work. Handlers start and resume
+     * in `poll()`, from the main loop or a low priority task, and `co_await` the data stage or any readiness condition
+     * (flash, sensor, encapsulated response) instead of blocking the interrupt or keeping a hand-written state machine.
+     * A new SETUP destroys the running handler.
+     * @note `poll()` shares the `ControlPipe` with the interrupt: run it where the EP0 interrupt cannot preempt it,
+     *  e.g. a lower priority software interrupt, or mask the USB interrupt around it.
+     * @code
+     *   usbstd::ControlTask sendCommand(Control& control, const usbstd::Request& request)
+     *   {
+     *       uint8_t command[64];
+     *       if (co_await control.receive(command) == 0)
+     *           co_return;
+     *       co_await control.until([] { return modem.idle(); });
+     *       modem.write(command, control.received());
+     *       control.acknowledge();
+     *   }
+     *
+     *   usbstd::StaticFramePool<256> pool;
+     *   Control control{ ep0, pool };
+     *   ...
+     *   control.poll([](Control& control, const usbstd::Request& request) {
+     *       return (request.bRequest == USB_CDC_SEND_ENCAPSULATED_COMMAND) ? sendCommand(control, request) : usbstd::ControlTask{};
+     *   });
+     * @endcode
+     * @tparam  Pipe_t  `ControlPipe` specialisation
+    */
+    template<typename Pipe_t>
+    class AsyncControl
+    {
+    public:
+        AsyncControl(Pipe_t& pipe, FramePool& pool) : pipe_(pipe), pool_(pool) {}
+
+        Pipe_t& pipe() { return pipe_; }
+        const Request& request() const { return pipe_.request(); }
+        size_t received() const { return pipe_.received(); }
+
+        /// @{ USB side (interrupt)
+
+        void setup(const Request& request)
+        {
+            pipe_.setup(request);
+            event_.store(ControlEvent::None, std::memory_order_relaxed);
+            setups_.fetch_add(1, std::memory_order_release);
+        }
+
+        ControlEvent inComplete() { return notify(pipe_.inComplete()); }
+        ControlEvent outComplete(size_t length) { return notify(pipe_.outComplete(length)); }
+        ///@}
+
+        /** Start handlers for new requests and resume waiting handlers
+         * @param handler  `ControlTask handler(AsyncControl&, const Request&)`, returning an invalid `ControlTask` stalls
+         *  the request; a handler that completes without answering also stalls it
+         * @return `true` while a handler is running
+        */
+        template<typename Handler_t>
+        bool poll(Handler_t&& handler)
+        {
+            const uint32_t setups = setups_.load(std::memory_order_acquire);
+            if (setups != started_)
+            {
+                started_ = setups;
+                task_.reset();
+                wait_ = Wait::None;
+                FramePool::active = &pool_;
+                task_ = handler(*this, pipe_.request());
+                FramePool::active = nullptr;
+                if (!task_.valid())
+                    pipe_.stall();
+            }
+            else if (!task_.done() && ready())
+            {
+                wait_ = Wait::None;
+                task_.resume();
+            }
+
+            if (task_.valid() && task_.done())
+            {
+                task_.reset();
+                if (pipe_.stage() == ControlStage::Setup)
+                    pipe_.stall();
+            }
+            return task_.valid();
+        }
+
+        /// @{ Handler side, awaitables
+
+        /** Send the IN data stage and resume once the status stage completed
+         * @return `co_await` result: `false` when the data could not be sent and the request was stalled
+        */
+        auto send(std::initializer_list<Span<const uint8_t>> segments) { return Awaiter{ *this, pipe_.send(segments), Wait::Complete }; }
+        auto send(Span<const uint8_t> data) { return Awaiter{ *this, pipe_.send(data), Wait::Complete }; }
+
+        /** Receive the OUT data stage into `buffer`, which must stay valid, and resume once it arrived
+         * @return `co_await` result: the bytes received, 0 when the request was stalled; answer with `acknowledge()` or `stall()`
+        */
+        auto receive(Span<uint8_t> buffer) { return Awaiter{ *this, pipe_.receive(buffer), Wait::DataReceived }; }
+
+        /** Acknowledge and resume once the status stage completed, e.g. to apply a new address
+        */
+        auto acknowledge()
+        {
+            pipe_.acknowledge();
+            return Awaiter{ *this, pipe_.stage() == ControlStage::StatusIn, Wait::Complete };
+        }
+
+        void stall() { pipe_.stall(); }
+
+        /** Resume once `predicate()` is `true`, checked on every `poll()`
+         * @note `predicate` is stored in the coroutine frame while waiting
+        */
+        template<typename Predicate_t>
+        auto until(Predicate_t predicate) { return PredicateAwaiter<Predicate_t>{ *this, predicate }; }
+        ///@}
+
+    private:
+        enum class Wait : uint8_t
+        {
+            None,
+            DataReceived,
+            Complete,
+            Predicate,
+        };
+
+        struct Awaiter
+        {
+            AsyncControl& control;
+            bool started;
+            Wait wait;
+
+            bool await_ready() const { return !started; }
+            void await_suspend(std::coroutine_handle<>) { control.wait_ = wait; }
+            size_t await_resume() const
+            {
+                if (!started)
+                    return 0;
+                return (wait == Wait::DataReceived) ? control.pipe_.received() : 1;
+            }
+        };
+
+        template<typename Predicate_t>
+        struct PredicateAwaiter
+        {
+            AsyncControl& control;
+            Predicate_t predicate;
+
+            bool await_ready() { return predicate(); }
+            void await_suspend(std::coroutine_handle<>)
+            {
+                control.wait_ = Wait::Predicate;
+                control.predicate_ = [](void* context) { return static_cast<PredicateAwaiter*>(context)->predicate(); };
+                control.predicateContext_ = this;
+            }
+            void await_resume() const {}
+        };
+
+        ControlEvent notify(ControlEvent event)
+        {
+            if (event != ControlEvent::None)
+                event_.store(event, std::memory_order_release);
+            return event;
+        }
+
+        bool ready()
+        {
+            switch (wait_)
+            {
+            case Wait::DataReceived:
+            case Wait::Complete:
+                if (event_.load(std::memory_order_acquire) != static_cast<ControlEvent>(wait_))
+                    return false;
+                event_.store(ControlEvent::None, std::memory_order_relaxed);
+                return true;
+            case Wait::Predicate:
+                return predicate_(predicateContext_);
+            default:
+                return false;
+            }
+        }
+
+        static_assert(static_cast<uint8_t>(Wait::DataReceived) == static_cast<uint8_t>(ControlEvent::DataReceived), "Wait mirrors ControlEvent");
+        static_assert(static_cast<uint8_t>(Wait::Complete) == static_cast<uint8_t>(ControlEvent::Complete), "Wait mirrors ControlEvent");
+
+        Pipe_t& pipe_;
+        FramePool& pool_;
+        ControlTask task_;
+        std::atomic<uint32_t> setups_{ 0 }; ///< SETUPs received
+        uint32_t started_ = 0; ///< SETUPs handled
+        std::atomic<ControlEvent> event_{ ControlEvent::None };
+        Wait wait_ = Wait::None;
+        bool (*predicate_)(void*) = nullptr;
+        void* predicateContext_ = nullptr;
+    };
+
+} //END: usbstd
+
+#endif // __cpp_impl_coroutine
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <cstdint>
 
 #include "usb_class.hpp"
+#include "usb_endian.hpp"
 
 namespace usbstd
 {
@@ -23,6 +24,8 @@ namespace usbstd
 		InterfaceAssociation = 11, ///< USB Interface Association Descriptor (IAD ECN)
 		BinaryObjectStore = 15,
 		DeviceCapability = 16,
+		SuperSpeedEndpointCompanion = 48, ///< Follows each endpoint descriptor at SuperSpeed (USB 3.2 9.6.7)
+		SuperSpeedPlusIsochronousEndpointCompanion = 49, ///< Follows the companion of isochronous endpoints above 48 KiB per interval
 
 		// Class Specific Descriptor
 		CsDevice = 33,
@@ -31,13 +34,23 @@ namespace usbstd
 		CsInterface = 36,
 		CsEndpoint = 37,
 
-#if 0//< @todo?
-		Functional = 33,
-
+		// HID Class Descriptors (HID 1.11 7.1)
 		Hid = CsDevice,
 		HidReport = CsConfiguration,
 		HidPhysical = CsString,
-#endif
+
+		// DFU Class Descriptors (DFU 1.1 4.1.3)
+		DfuFunctional = CsDevice,
+	};
+
+	/** Bus speed a descriptor set is interpreted for, e.g. `bInterval` units and `wMaxPacketSize` limits
+	*/
+	enum class BusSpeed : uint8_t
+	{
+		Low = 0,
+		Full = 1,
+		High = 2,
+		Super = 3,
 	};
 
 	struct DescriptorHeader
@@ -52,7 +65,7 @@ namespace usbstd
 	template<DescriptorType Type, typename DescriptorData_t = DescriptorData<Type> >
 	struct Descriptor
 	{
-		DescriptorHeader header = { sizeof(Descriptor<Type>), Type };
+		DescriptorHeader header = { sizeof(Descriptor), Type };
 		DescriptorData_t data;
 	};
 
@@ -89,14 +102,14 @@ namespace usbstd
 	template<>
 	struct DescriptorData<DescriptorType::Device>
 	{
-		uint16_t  bcdUSB;
+		Le16      bcdUSB;
 		uint8_t   bDeviceClass;
 		uint8_t   bDeviceSubClass;
 		uint8_t   bDeviceProtocol;
 		uint8_t   bMaxPacketSize0;
-		uint16_t  idVendor;
-		uint16_t  idProduct;
-		uint16_t  bcdDevice;
+		Le16      idVendor;
+		Le16      idProduct;
+		Le16      bcdDevice;
 		uint8_t   iManufacturer;
 		uint8_t   iProduct;
 		uint8_t   iSerialNumber;
@@ -108,7 +121,7 @@ namespace usbstd
 	template<>
 	struct DescriptorData<DescriptorType::Configuration>
 	{
-		uint16_t wTotalLength; ///< Total length of data returned for this configuration. Includes the combined length of all descriptors (configuration, interface, endpoint, and class- or vendor-specific) returned for this configuration.
+		Le16 wTotalLength; ///< Total length of data returned for this configuration. Includes the combined length of all descriptors (configuration, interface, endpoint, and class- or vendor-specific) returned for this configuration.
 
 		uint8_t  bNumInterfaces; ///< Number of interfaces supported by this configuration
 		uint8_t  bConfigurationValue; ///< Value to use as an argument to the SetConfiguration() request to select this configuration.
@@ -164,46 +177,61 @@ namespace usbstd
 		uint8_t  bEndpointAddress; ///< The address of the endpoint on the USB device described by this descriptor. The address is encoded as follows: \n Bit 3...0: The endpoint number \n Bit 6...4: Reserved, reset to zero \n Bit 7: Direction, ignored for control endpoints 0 = OUT endpoint 1 = IN endpoint.
 
 		struct Attributes {
-			uint8_t xfer : 2; /**<Bits 1..0: Transfer Type 
-								*  - 00 = Control 
-								*  - 01 = Isochronous 
-								*  - 10 = Bulk 
-								*  - 11 = Interrupt 
-								*/
-			uint8_t sync : 2; /**< If isochronous, they are defined as follows: 
-								* Bits 3..2: Synchronization Type 
-								*  - 00 = No Synchronization 
-								*  - 01 = Asynchronous 
-								*  - 10 = Adaptive 
-								*  - 11 = Synchronous 
-							    * @warning If not an isochronous endpoint, bits 5..2 are reserved and must be set to zero.
-							    */
-			uint8_t usage : 2;/**< If isochronous, they are defined as follows: 
-								* Bits 5..4: Usage Type 
-								*  - 00 = Data endpoint 
-								*  - 01 = Feedback endpoint 
-								*  - 10 = Implicit feedback Data endpoint 
-								*  - 11 = Reserved 
-							    * @warning If not an isochronous endpoint, bits 5..2 are reserved and must be set to zero.
-							    */
-			uint8_t : 2; //< All other bits are reserved and must be reset to zero. Reserved bits must be ignored by the host.
+			uint8_t value; ///< Raw `bmAttributes`, bits 7..6 are reserved and must be reset to zero. Reserved bits must be ignored by the host.
+
+			/** Bits 1..0: Transfer Type 
+			*  - 00 = Control 
+			*  - 01 = Isochronous 
+			*  - 10 = Bulk 
+			*  - 11 = Interrupt 
+			*/
+			constexpr uint8_t xfer() const { return BitField<0, 2>::get(value); }
+			constexpr void xfer(uint8_t xfer) { value = BitField<0, 2>::set(value, xfer); }
+
+			/** If isochronous, they are defined as follows: 
+			* Bits 3..2: Synchronization Type 
+			*  - 00 = No Synchronization 
+			*  - 01 = Asynchronous 
+			*  - 10 = Adaptive 
+			*  - 11 = Synchronous 
+			* @warning If not an isochronous endpoint, bits 5..2 are reserved and must be set to zero.
+			*/
+			constexpr uint8_t sync() const { return BitField<2, 2>::get(value); }
+			constexpr void sync(uint8_t sync) { value = BitField<2, 2>::set(value, sync); }
+
+			/** If isochronous, they are defined as follows: 
+			* Bits 5..4: Usage Type 
+			*  - 00 = Data endpoint 
+			*  - 01 = Feedback endpoint 
+			*  - 10 = Implicit feedback Data endpoint 
+			*  - 11 = Reserved 
+			* @warning If not an isochronous endpoint, bits 5..2 are reserved and must be set to zero.
+			*/
+			constexpr uint8_t usage() const { return BitField<4, 2>::get(value); }
+			constexpr void usage(uint8_t usage) { value = BitField<4, 2>::set(value, usage); }
 		} bmAttributes; ///< This field describes the endpoint's attributes when it is configured using the bConfigurationValue. 
 		
 		struct MaxPacketSize {
-			uint16_t size : 11; /**< Maximum packet size this endpoint is capable of sending or receiving when this configuration is selected. 
-								* For isochronous endpoints, this value is used to reserve the bus time in the schedule, required for the per-(micro)frame data payloads.
-								* The pipe may, on an ongoing basis, actually use less bandwidth than that reserved. 
-								* The device reports, if necessary, the actual bandwidth used via its normal, non-USB defined mechanisms. 
-								* For all endpoints, bits 10..0 specify the maximum packet size (in bytes).
-								*/
-			uint16_t hs_period_mult : 2;/**< For high-speed isochronous and interrupt endpoints: \
-								*   Bits 12..11 specify the number of additional transaction opportunities per microframe: 
-								*  - 00 = None (1 transaction per microframe) 
-								* - 01 = 1 additional (2 per microframe) 
-								* - 10 = 2 additional (3 per microframe) 
-								* - 11 = Reserved 
-								*/
-			uint16_t : 3; ///< Bits 15..13 are reserved and must be set to zero
+			Le16 value; ///< Raw `wMaxPacketSize`, bits 15..13 are reserved and must be set to zero
+
+			/** Maximum packet size this endpoint is capable of sending or receiving when this configuration is selected. 
+			* For isochronous endpoints, this value is used to reserve the bus time in the schedule, required for the per-(micro)frame data payloads.
+			* The pipe may, on an ongoing basis, actually use less bandwidth than that reserved. 
+			* The device reports, if necessary, the actual bandwidth used via its normal, non-USB defined mechanisms. 
+			* For all endpoints, bits 10..0 specify the maximum packet size (in bytes).
+			*/
+			constexpr uint16_t size() const { return BitField<0, 11>::get(value.value()); }
+			constexpr void size(uint16_t size) { value = BitField<0, 11>::set(value.value(), size); }
+
+			/** For high-speed isochronous and interrupt endpoints: \
+			*   Bits 12..11 specify the number of additional transaction opportunities per microframe: 
+			*  - 00 = None (1 transaction per microframe) 
+			* - 01 = 1 additional (2 per microframe) 
+			* - 10 = 2 additional (3 per microframe) 
+			* - 11 = Reserved 
+			*/
+			constexpr uint8_t hsPeriodMult() const { return static_cast<uint8_t>(BitField<11, 2>::get(value.value())); }
+			constexpr void hsPeriodMult(uint8_t mult) { value = BitField<11, 2>::set(value.value(), mult); }
 		} wMaxPacketSize;
 
 		uint8_t  bInterval; /**< Interval for polling endpoint for data transfers.Expressed in frames or microframes depending on the device operating speed (i.e., either 1 millisecond or 125 us units).
@@ -218,6 +246,7 @@ namespace usbstd
 							*/
 	};
 	using EndpointDescriptor = Descriptor<DescriptorType::Endpoint>;
+	static_assert(sizeof(EndpointDescriptor) == 7, "size is not correct");
 
 	template<>
 	struct DescriptorData<DescriptorType::InterfaceAssociation>
@@ -233,18 +262,50 @@ namespace usbstd
 	};
 	using InterfaceAssociationDescriptor = Descriptor<DescriptorType::InterfaceAssociation>;
 
-#if 0
+	/**
+	 * @see USB 3.2 specification 9.6.7
+	*/
+	template<>
+	struct DescriptorData<DescriptorType::SuperSpeedEndpointCompanion>
+	{
+		uint8_t  bMaxBurst; ///< Packets the endpoint can send or receive in a burst, less one (0 to 15). Zero for control endpoints.
+		uint8_t  bmAttributes; /**< Transfer type dependent:
+								* - Bulk: bits 4..0 are the log2 of the number of streams supported (0 = no streams, at most 16)
+								* - Isochronous: bits 1..0 are the number of bursts per service interval, less one (`Mult`); bit 7 selects a
+								*   `SuperSpeedPlusIsochronousEndpointCompanion` descriptor
+								* - Control and interrupt: reserved, zero
+								*/
+		Le16 wBytesPerInterval; ///< Total bytes per service interval of a periodic endpoint, zero for bulk and control
+	};
+	using SuperSpeedEndpointCompanionDescriptor = Descriptor<DescriptorType::SuperSpeedEndpointCompanion>;
+	static_assert(sizeof(SuperSpeedEndpointCompanionDescriptor) == 6, "size is not correct");
+
+	/**
+	 * @see USB 3.2 specification 9.6.8
+	*/
+	template<>
+	struct DescriptorData<DescriptorType::SuperSpeedPlusIsochronousEndpointCompanion>
+	{
+		Le16 wReserved;
+		Le32 dwBytesPerInterval; ///< Total bytes per service interval, replaces `wBytesPerInterval` of the companion
+	};
+	using SuperSpeedPlusIsochronousEndpointCompanionDescriptor = Descriptor<DescriptorType::SuperSpeedPlusIsochronousEndpointCompanion>;
+	static_assert(sizeof(SuperSpeedPlusIsochronousEndpointCompanionDescriptor) == 8, "size is not correct");
+
+	/**
+	 * @see HID 1.11 specification 6.2.1
+	*/
 	template<>
 	struct DescriptorData<DescriptorType::Hid>
 	{
-		uint16_t  bcdHID;
-		uint8_t   bCountryCode;
-		uint8_t   bNumDescriptors;
-		uint8_t   bDescriptorType1;
-		uint16_t  wDescriptorLength;
+		Le16      bcdHID; ///< HID specification release, 0x0111
+		uint8_t   bCountryCode; ///< Country code of localized hardware, 0 if not localized
+		uint8_t   bNumDescriptors; ///< Number of class descriptors, at least one report descriptor
+		DescriptorType bDescriptorType1; ///< Type of the first class descriptor, `DescriptorType::HidReport`
+		Le16      wDescriptorLength; ///< Length of the first class descriptor, e.g. `hid::ReportDescriptor<items>::Size`
 	};
 	using HidDescriptor = Descriptor<DescriptorType::Hid>;
-#endif
+	static_assert(sizeof(HidDescriptor) == 9, "size is not correct");
 
 
 #pragma pack(pop)
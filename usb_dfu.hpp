@@ -0,0 +1,623 @@
+#pragma once
+
+#include <atomic> //< std::atomic
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t, uint32_t
+#include <cstring> //< std::memcpy, std::memset
+
+#include "usb_class.hpp" //< usbstd::ClassCode
+#include "usb_descriptor.hpp" //< usbstd::Descriptor, usbstd::DescriptorType
+#include "usb_endian.hpp" //< usbstd::Le16
+#include "usb_helper_ringbuffer.hpp" //< USBSTD_CACHE_LINE_SIZE
+#include "usb_request.hpp" //< usbstd::Request
+#include "usb_span.hpp" //< usbstd::Span
+
+namespace usbstd {
+
+    /** Device Firmware Upgrade class requests
+     * @see USB Device Firmware Upgrade 1.1, 3
+    */
+    enum
+    {
+        USB_DFU_DETACH = 0x00,
+        USB_DFU_DNLOAD = 0x01,
+        USB_DFU_UPLOAD = 0x02,
+        USB_DFU_GETSTATUS = 0x03,
+        USB_DFU_CLRSTATUS = 0x04,
+        USB_DFU_GETSTATE = 0x05,
+        USB_DFU_ABORT = 0x06,
+    };
+
+    /// `bInterfaceSubClass` of a DFU interface, with `ClassCode::ApplicationSpecific`
+    enum class DfuSubClass : uint8_t
+    {
+        Dfu = 0x01,
+    };
+
+    enum class DfuProtocol : uint8_t
+    {
+        Runtime = 0x01, ///< DFU interface of the application firmware, only DETACH
+        Dfu = 0x02, ///< DFU mode, the only interface of the device
+    };
+
+    /// DFU functional descriptor `bmAttributes`
+    enum DfuAttributes : uint8_t
+    {
+        CanDownload = (1u << 0),
+        CanUpload = (1u << 1),
+        ManifestationTolerant = (1u << 2), ///< The device still answers after manifestation, otherwise it waits for a reset
+        WillDetach = (1u << 3), ///< The device detaches itself on DETACH instead of waiting for a bus reset
+    };
+
+#pragma pack(push, 1)
+
+    /** DFU functional descriptor, following the DFU interface descriptor
+     * @note Shares `bDescriptorType` 0x21 with the HID descriptor, so it has its own data type
+    */
+    struct DfuFunctionalData
+    {
+        uint8_t  bmAttributes; ///< `DfuAttributes`
+        Le16 wDetachTimeOut; ///< Milliseconds the device waits for a reset after DETACH
+        Le16 wTransferSize; ///< Largest DNLOAD/UPLOAD block, at most the device's buffer size
+        Le16 bcdDFUVersion; ///< 0x0110
+    };
+    using DfuFunctionalDescriptor = Descriptor<DescriptorType::DfuFunctional, DfuFunctionalData>;
+    static_assert(sizeof(DfuFunctionalDescriptor) == 9, "size is not correct");
+
+namespace dfu {
+
+    /** Answer to DFU_GETSTATUS
+    */
+    struct StatusResponse
+    {
+        uint8_t bStatus; ///< `Status`
+        uint8_t bwPollTimeout[3]; ///< Milliseconds the host waits before the next GETSTATUS, little-endian
+        uint8_t bState; ///< `State` after this request
+        uint8_t iString;
+    };
+    static_assert(sizeof(StatusResponse) == 6, "size is not correct");
+
+#pragma pack(pop)
+
+    /// @see USB Device Firmware Upgrade 1.1, 6.1.2
+    enum class State : uint8_t
+    {
+        AppIdle = 0,
+        AppDetach = 1,
+        DfuIdle = 2,
+        DnloadSync = 3,
+        DnBusy = 4,
+        DnloadIdle = 5,
+        ManifestSync = 6,
+        Manifest = 7,
+        ManifestWaitReset = 8,
+        UploadIdle = 9,
+        Error = 10,
+    };
+
+    enum class Status : uint8_t
+    {
+        Ok = 0x00,
+        ErrTarget = 0x01, ///< File is not targeted for this device
+        ErrFile = 0x02,
+        ErrWrite = 0x03,
+        ErrErase = 0x04,
+        ErrCheckErased = 0x05,
+        ErrProg = 0x06,
+        ErrVerify = 0x07,
+        ErrAddress = 0x08, ///< Firmware larger than the memory
+        ErrNotDone = 0x09,
+        ErrFirmware = 0x0a,
+        ErrVendor = 0x0b,
+        ErrUsbReset = 0x0c,
+        ErrPowerOnReset = 0x0d,
+        ErrUnknown = 0x0e,
+        ErrStalledPacket = 0x0f, ///< Unexpected request
+    };
+
+    constexpr DfuFunctionalDescriptor functionalDescriptor(uint8_t attributes, uint16_t transferSize, uint16_t detachTimeOut = 1000)
+    {
+        DfuFunctionalDescriptor descriptor = {};
+        descriptor.data = { attributes, detachTimeOut, transferSize, 0x0110 };
+        return descriptor;
+    }
+
+    /** Flash held in RAM with NOR semantics, e.g. for tests
+     * Also documents the flash interface `FirmwareUpdate` expects: erase sets a sector to 0xff, programming only
+     * clears bits, and either may block for as long as the hardware takes.
+    */
+    template<uint32_t Size, uint32_t SectorSize = 4096>
+    class RamFlash
+    {
+        static_assert((Size % SectorSize) == 0, "Size must be a multiple of SectorSize");
+
+    public:
+        uint32_t size() const { return Size; }
+        uint32_t sectorSize() const { return SectorSize; }
+
+        /** Erase the sector starting at `address`
+        */
+        bool erase(uint32_t address)
+        {
+            if (((address % SectorSize) != 0) || (address >= Size))
+                return false;
+            std::memset(storage_ + address, 0xff, SectorSize);
+            return true;
+        }
+
+        /** Program erased memory
+         * @return `false` when out of range or when the data needs bits set that are not erased
+        */
+        bool program(uint32_t address, const uint8_t* data, size_t length)
+        {
+            if ((address > Size) || (length > Size - address))
+                return false;
+            bool programmed = true;
+            for (size_t i = 0; i < length; ++i)
+            {
+                storage_[address + i] &= data[i];
+                programmed &= (storage_[address + i] == data[i]);
+            }
+            return programmed;
+        }
+
+        /** @return Bytes read, fewer than `length` at the end of the memory
+        */
+        size_t read(uint32_t address, uint8_t* data, size_t length)
+        {
+            if (address >= Size)
+                return 0;
+            length = (length < Size - address) ? length : (Size - address);
+            std::memcpy(data, storage_ + address, length);
+            return length;
+        }
+
+        /** Finish the download, e.g. verify and mark the image valid
+        */
+        bool manifest() { return true; }
+
+        uint8_t* data() { return storage_; }
+
+    private:
+        uint8_t storage_[Size] = {};
+    };
+
+    /** DFU mode state machine with a pipelined download
+     * DNLOAD blocks are received straight into one of `Buffers` buffers. `process()` erases and programs the oldest
+     * buffer while the host already sends the next block into another one, so the download only waits on the flash when
+     * every buffer is queued. GETSTATUS then answers `DnBusy` with a `bwPollTimeout` predicted from the measured erase
+     * and program times of earlier blocks, rather than a fixed worst case.
+     *
+     * `setup()` and `dataReceived()` run where control requests are handled (the USB interrupt) and never touch the
+     * flash except for UPLOAD reads; `process()` runs in a task that may block on the flash.
+     *
+     * ABORT and CLRSTATUS drop the queued blocks. A block the task is already writing cannot be dropped, so a new download
+     * only starts once the task finished it: until then GETSTATUS in `DfuIdle` answers with the time left as `bwPollTimeout`
+     * and DNLOAD stalls.
+     *
+     * @tparam  Flash_t  Flash, with the interface of `RamFlash`
+     * @tparam  TransferSize  `wTransferSize`, the largest block
+     * @tparam  Buffers  Download buffers, 2 or more
+     * @code
+     *   static usbstd::dfu::FirmwareUpdate<Flash, 1024> dfu{ flash, micros };
+     *
+     *   // Control requests for the DFU interface, after ep0.setup(request)
+     *   dfu.setup(ep0);
+     *   ... if (ep0.outComplete(length) == usbstd::ControlEvent::DataReceived) dfu.dataReceived(ep0);
+     *
+     *   // Task
+     *   for (;;) dfu.process();
+     * @endcode
+    */
+    template<typename Flash_t, size_t TransferSize = 1024, size_t Buffers = 2>
+    class FirmwareUpdate
+    {
+        static_assert(Buffers >= 2, "The download pipeline needs at least two buffers");
+        static_assert(TransferSize <= 0xffff, "wTransferSize is 16 bits");
+
+    public:
+        /**
+         * @param micros  Free-running microsecond clock, used to measure the flash and predict `bwPollTimeout`
+         * @param attributes  `DfuAttributes`, as announced in the functional descriptor
+         * @param runtime  Start in `State::AppIdle`, for the runtime DFU interface of the application
+        */
+        FirmwareUpdate(Flash_t& flash, uint32_t (*micros)(), uint8_t attributes = CanDownload | CanUpload | ManifestationTolerant, bool runtime = false)
+            : flash_(flash), micros_(micros), attributes_(attributes), state_(runtime ? State::AppIdle : State::DfuIdle), busyUntil_(micros())
+        {}
+
+        State state() const { return state_.load(std::memory_order_relaxed); }
+        Status status() const { return status_; }
+
+        /** Functional descriptor matching this state machine
+        */
+        DfuFunctionalDescriptor descriptor(uint16_t detachTimeOut = 1000) const { return functionalDescriptor(attributes_, TransferSize, detachTimeOut); }
+
+        /// @{ Measured flash timing
+        uint32_t eraseMicros() const { return eraseUs_.load(std::memory_order_relaxed); } ///< Per sector
+        uint32_t programNanosPerByte() const { return programNsPerByte_.load(std::memory_order_relaxed); }
+        ///@}
+
+        /// @{ Control requests (USB side)
+
+        /** Answer the DFU class request `ep0.request()`
+         * @tparam  Pipe_t  `ControlPipe` in the `ControlStage::Setup` stage
+        */
+        template<typename Pipe_t>
+        void setup(Pipe_t& ep0)
+        {
+            const Request& request = ep0.request();
+            const State state = this->state();
+            switch (request.bRequest)
+            {
+            case USB_DFU_DETACH:
+                if (state != State::AppIdle)
+                    return fail(ep0);
+                state_.store(State::AppDetach, std::memory_order_relaxed);
+                return ep0.acknowledge();
+
+            case USB_DFU_DNLOAD:
+                if (((attributes_ & CanDownload) == 0) || ((state != State::DfuIdle) && (state != State::DnloadIdle)))
+                    return fail(ep0);
+                if (request.wLength == 0)
+                {
+                    if (state != State::DnloadIdle)
+                        return fail(ep0);
+                    manifestRequested_.store(true, std::memory_order_release);
+                    state_.store(State::ManifestSync, std::memory_order_relaxed);
+                    return ep0.acknowledge();
+                }
+                if (request.wLength > TransferSize)
+                    return fail(ep0);
+                if (state == State::DfuIdle) //< New download
+                {
+                    if (!resync())
+                        return fail(ep0); //< The task still writes a block of the previous download
+                    ++generation_;
+                    nextAddress_ = 0;
+                    flashStatus_.store(Status::Ok, std::memory_order_relaxed);
+                    manifestRequested_.store(false, std::memory_order_relaxed);
+                    manifestDone_.store(false, std::memory_order_relaxed);
+                }
+                if (buffers_[usbIndex_].state.load(std::memory_order_acquire) != Free)
+                    return fail(ep0);
+                buffers_[usbIndex_].state.store(Receiving, std::memory_order_relaxed);
+                ep0.receive(Span<uint8_t>{ buffers_[usbIndex_].data, request.wLength });
+                return;
+
+            case USB_DFU_UPLOAD:
+            {
+                if (((attributes_ & CanUpload) == 0) || ((state != State::DfuIdle) && (state != State::UploadIdle)) || !idle())
+                    return fail(ep0);
+                if (state == State::DfuIdle)
+                    uploadAddress_ = 0;
+                const size_t length = (request.wLength < TransferSize) ? static_cast<size_t>(request.wLength) : TransferSize;
+                const size_t read = flash_.read(uploadAddress_, buffers_[usbIndex_].data, length);
+                uploadAddress_ += static_cast<uint32_t>(read);
+                // A short block ends the upload
+                state_.store((read < length) ? State::DfuIdle : State::UploadIdle, std::memory_order_relaxed);
+                ep0.send(Span<const uint8_t>{ buffers_[usbIndex_].data, read });
+                return;
+            }
+
+            case USB_DFU_GETSTATUS:
+            {
+                const uint32_t pollTimeout = refresh();
+                const uint32_t milliseconds = (pollTimeout / 1000 + ((pollTimeout % 1000) != 0)) & 0xffffff;
+                response_.bStatus = static_cast<uint8_t>(status_);
+                response_.bwPollTimeout[0] = static_cast<uint8_t>(milliseconds);
+                response_.bwPollTimeout[1] = static_cast<uint8_t>(milliseconds >> 8);
+                response_.bwPollTimeout[2] = static_cast<uint8_t>(milliseconds >> 16);
+                response_.bState = static_cast<uint8_t>(this->state());
+                response_.iString = 0;
+                ep0.send(Span<const uint8_t>{ reinterpret_cast<const uint8_t*>(&response_), sizeof(response_) });
+                return;
+            }
+
+            case USB_DFU_CLRSTATUS:
+                if (state != State::Error)
+                    return fail(ep0);
+                static_cast<void>(resync());
+                status_ = Status::Ok;
+                flashStatus_.store(Status::Ok, std::memory_order_relaxed);
+                state_.store(State::DfuIdle, std::memory_order_relaxed);
+                return ep0.acknowledge();
+
+            case USB_DFU_GETSTATE:
+                stateByte_ = static_cast<uint8_t>(state);
+                ep0.send(Span<const uint8_t>{ &stateByte_, 1 });
+                return;
+
+            case USB_DFU_ABORT:
+                if ((state != State::DfuIdle) && (state != State::DnloadSync) && (state != State::DnloadIdle)
+                    && (state != State::ManifestSync) && (state != State::UploadIdle))
+                {
+                    return fail(ep0);
+                }
+                static_cast<void>(resync());
+                manifestRequested_.store(false, std::memory_order_relaxed);
+                state_.store(State::DfuIdle, std::memory_order_relaxed);
+                return ep0.acknowledge();
+
+            default:
+                return fail(ep0);
+            }
+        }
+
+        /** DNLOAD data stage complete, queue the block for `process()`
+        */
+        template<typename Pipe_t>
+        void dataReceived(Pipe_t& ep0)
+        {
+            auto& buffer = buffers_[usbIndex_];
+            buffer.address = nextAddress_;
+            buffer.length = static_cast<uint32_t>(ep0.received());
+            buffer.generation = generation_;
+            nextAddress_ += buffer.length;
+            buffer.state.store(Filled, std::memory_order_release);
+            usbIndex_ = (usbIndex_ + 1) % Buffers;
+            state_.store(State::DnloadSync, std::memory_order_relaxed);
+            ep0.acknowledge();
+        }
+
+        /** USB bus reset
+         * @return `true` when the device should restart: into DFU mode after DETACH, or into the new firmware after a
+         *  manifestation that needs a reset
+        */
+        bool usbReset()
+        {
+            const State state = this->state();
+            if (state == State::AppDetach)
+            {
+                state_.store(State::DfuIdle, std::memory_order_relaxed);
+                return true;
+            }
+            return state == State::ManifestWaitReset;
+        }
+        ///@}
+
+        /** Erase and program the oldest queued block, or manifest once the download ended and all blocks are written
+         * @return `true` when flash work was done
+        */
+        bool process()
+        {
+            const size_t index = taskIndex_.load(std::memory_order_relaxed);
+            auto& buffer = buffers_[index];
+            busyUntil_.store(micros_(), std::memory_order_relaxed); //< Never older than a block claimed below
+            uint8_t filled = Filled;
+            if (!buffer.state.compare_exchange_strong(filled, Busy, std::memory_order_acq_rel))
+            {
+                if ((filled != Free) || !manifestRequested_.load(std::memory_order_acquire) || manifestDone_.load(std::memory_order_relaxed))
+                    return false;
+                const uint32_t start = micros_();
+                if (!flash_.manifest())
+                    flashStatus_.store(Status::ErrFirmware, std::memory_order_relaxed);
+                manifestUs_.store(micros_() - start, std::memory_order_relaxed);
+                manifestDone_.store(true, std::memory_order_release);
+                return true;
+            }
+
+            const uint32_t address = buffer.address;
+            const uint32_t length = buffer.length;
+            if (buffer.generation != erasedGeneration_) //< New download
+            {
+                erasedGeneration_ = buffer.generation;
+                erasedEnd_ = 0;
+            }
+            if ((address > flash_.size()) || (length > flash_.size() - address))
+                flashStatus_.store(Status::ErrAddress, std::memory_order_relaxed);
+            else if (flashStatus_.load(std::memory_order_relaxed) == Status::Ok)
+            {
+                uint32_t now = micros_();
+                const uint32_t sector = flash_.sectorSize();
+                const uint32_t sectors = (erasedEnd_ < address + length) ? ((address + length - erasedEnd_ + sector - 1) / sector) : 0;
+                busyUntil_.store(now + estimate(length, sectors), std::memory_order_relaxed);
+                while ((erasedEnd_ < address + length) && (flashStatus_.load(std::memory_order_relaxed) == Status::Ok))
+                {
+                    if (!flash_.erase(erasedEnd_))
+                        flashStatus_.store(Status::ErrErase, std::memory_order_relaxed);
+                    const uint32_t end = micros_();
+                    eraseUs_.store(filter(eraseUs_.load(std::memory_order_relaxed), end - now), std::memory_order_relaxed);
+                    erasedEnd_ += flash_.sectorSize();
+                    now = end;
+                }
+                if ((flashStatus_.load(std::memory_order_relaxed) == Status::Ok) && (length != 0))
+                {
+                    if (!flash_.program(address, buffer.data, length))
+                        flashStatus_.store(Status::ErrProg, std::memory_order_relaxed);
+                    const uint32_t nsPerByte = static_cast<uint32_t>((uint64_t(micros_() - now) * 1000) / length);
+                    programNsPerByte_.store(filter(programNsPerByte_.load(std::memory_order_relaxed), nsPerByte), std::memory_order_relaxed);
+                }
+            }
+            busyUntil_.store(micros_(), std::memory_order_relaxed);
+            taskIndex_.store((index + 1) % Buffers, std::memory_order_relaxed); //< Before the release, for `resync()`
+            buffer.state.store(Free, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        enum : uint8_t
+        {
+            Free,
+            Receiving,
+            Filled, ///< Queued for `process()`
+            Busy, ///< Being erased and programmed
+        };
+
+        struct Buffer
+        {
+            alignas(USBSTD_CACHE_LINE_SIZE) uint8_t data[TransferSize];
+            uint32_t address = 0;
+            uint32_t length = 0;
+            uint32_t generation = 0; ///< Download the block belongs to
+            std::atomic<uint8_t> state = { Free };
+        };
+
+        template<typename Pipe_t>
+        void fail(Pipe_t& ep0)
+        {
+            ep0.stall();
+            const State state = this->state();
+            if ((state != State::AppIdle) && (state != State::AppDetach))
+            {
+                status_ = Status::ErrStalledPacket;
+                state_.store(State::Error, std::memory_order_relaxed);
+            }
+        }
+
+        bool idle() const
+        {
+            for (const auto& buffer : buffers_)
+                if (buffer.state.load(std::memory_order_acquire) != Free)
+                    return false;
+            return true;
+        }
+
+        /** Drop the queued blocks the task has not started, and a block whose data stage a new SETUP abandoned, then, once
+         * the task has no block left, receive into the buffer it writes next so both sides step through the buffers together
+         * @return `false` while the task still writes a block
+        */
+        bool resync()
+        {
+            for (auto& buffer : buffers_)
+            {
+                uint8_t state = Filled;
+                if (!buffer.state.compare_exchange_strong(state, Free, std::memory_order_acq_rel) && (state == Receiving))
+                    buffer.state.store(Free, std::memory_order_relaxed);
+            }
+            if (!idle())
+                return false;
+            usbIndex_ = taskIndex_.load(std::memory_order_relaxed);
+            return true;
+        }
+
+        /** Exponential moving average over 4 samples, starting from the first measurement
+        */
+        static uint32_t filter(uint32_t average, uint32_t sample)
+        {
+            return (average == 0) ? sample : static_cast<uint32_t>(int64_t(average) + ((int64_t(sample) - int64_t(average)) / 4));
+        }
+
+        /** Predicted µs to erase `sectors` and program `length` bytes
+        */
+        uint32_t estimate(uint32_t length, uint32_t sectors) const
+        {
+            return eraseUs_.load(std::memory_order_relaxed) * sectors
+                + static_cast<uint32_t>((uint64_t(programNsPerByte_.load(std::memory_order_relaxed)) * length) / 1000);
+        }
+
+        /** Predicted µs to write a queued block, with the erases spread over the sector as the USB side does not know
+         * which sectors are erased already
+        */
+        uint32_t estimate(uint32_t length) const
+        {
+            return estimate(length, 0) + static_cast<uint32_t>(uint64_t(eraseUs_.load(std::memory_order_relaxed)) * length / flash_.sectorSize());
+        }
+
+        /** µs until the block being written is done
+         * @note `busyUntil_` is only meaningful while a buffer is `Busy`, see `wait()`
+        */
+        uint32_t remaining() const
+        {
+            const int32_t left = static_cast<int32_t>(busyUntil_.load(std::memory_order_relaxed) - micros_());
+            return (left > 0) ? static_cast<uint32_t>(left) : 0;
+        }
+
+        /** µs until `buffer` is free again: the time left when it is being written, the prediction when it is queued
+        */
+        uint32_t wait(const Buffer& buffer) const
+        {
+            const uint8_t state = buffer.state.load(std::memory_order_acquire);
+            return (state == Busy) ? remaining() : ((state == Filled) ? estimate(buffer.length) : 0);
+        }
+
+        /** µs until every buffer is free
+        */
+        uint64_t wait() const
+        {
+            uint64_t pending = 0;
+            for (const auto& buffer : buffers_)
+                pending += wait(buffer);
+            return pending;
+        }
+
+        /** `bwPollTimeout` in µs, at least 1 ms so the host does not poll a busy device back to back
+        */
+        static uint32_t pollTimeout(uint64_t micros)
+        {
+            return (micros > 1000) ? static_cast<uint32_t>((micros < 0xffffffffu) ? micros : 0xffffffffu) : 1000;
+        }
+
+        /** Advance the GETSTATUS state transitions
+         * @return Poll timeout in µs
+        */
+        uint32_t refresh()
+        {
+            const Status flashStatus = flashStatus_.load(std::memory_order_relaxed);
+            if ((flashStatus != Status::Ok) && (state() != State::Error) && (state() != State::DfuIdle))
+            {
+                status_ = flashStatus;
+                state_.store(State::Error, std::memory_order_relaxed);
+                return 0;
+            }
+
+            switch (state())
+            {
+            case State::DfuIdle:
+                return idle() ? 0 : pollTimeout(wait()); //< A block of an aborted download
+
+            case State::DnloadSync:
+            case State::DnBusy:
+                if (buffers_[usbIndex_].state.load(std::memory_order_acquire) == Free)
+                {
+                    state_.store(State::DnloadIdle, std::memory_order_relaxed);
+                    return 0;
+                }
+                state_.store(State::DnBusy, std::memory_order_relaxed);
+                return pollTimeout(wait(buffers_[usbIndex_])); //< The oldest block, the next one the task finishes
+
+            case State::ManifestSync:
+            case State::Manifest:
+                if (manifestDone_.load(std::memory_order_acquire))
+                {
+                    state_.store(((attributes_ & ManifestationTolerant) != 0) ? State::DfuIdle : State::ManifestWaitReset, std::memory_order_relaxed);
+                    return 0;
+                }
+                state_.store(State::Manifest, std::memory_order_relaxed);
+                // The block being written, the queued blocks, then the manifestation
+                return pollTimeout(wait() + manifestUs_.load(std::memory_order_relaxed));
+
+            default:
+                return 0;
+            }
+        }
+
+        Flash_t& flash_;
+        uint32_t (*micros_)();
+        const uint8_t attributes_;
+
+        Buffer buffers_[Buffers];
+        size_t usbIndex_ = 0; ///< Next buffer to receive into
+        std::atomic<size_t> taskIndex_ = { 0 }; ///< Next buffer to write, read by `resync()`
+        uint32_t generation_ = 0; ///< Downloads started, tags their blocks
+        uint32_t nextAddress_ = 0;
+        uint32_t uploadAddress_ = 0;
+        uint32_t erasedEnd_ = 0; ///< Task side: flash is erased from the download start up to here
+        uint32_t erasedGeneration_ = 0; ///< Task side: download `erasedEnd_` belongs to
+
+        std::atomic<State> state_;
+        Status status_ = Status::Ok; ///< Reported by GETSTATUS
+        std::atomic<Status> flashStatus_ = { Status::Ok }; ///< Set by `process()` on flash errors
+        std::atomic<bool> manifestRequested_ = { false };
+        std::atomic<bool> manifestDone_ = { false };
+
+        std::atomic<uint32_t> busyUntil_; ///< Predicted end of the `Busy` block
+        std::atomic<uint32_t> eraseUs_ = { 0 };
+        std::atomic<uint32_t> programNsPerByte_ = { 0 };
+        std::atomic<uint32_t> manifestUs_ = { 0 };
+
+        StatusResponse response_ = {};
+        uint8_t stateByte_ = 0;
+    };
+
+} //END: dfu
+} //END: usbstd
\ No newline at end of file
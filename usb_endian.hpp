@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t, uint32_t
+#include <type_traits> //< std::is_unsigned_v, std::is_trivial_v
+#include <utility> //< std::index_sequence, std::make_index_sequence
+
+namespace usbstd {
+
+    /** Unsigned integer stored little-endian in `sizeof(Value_t)` bytes, with an alignment of 1
+     * USB wire fields keep their layout whatever the target byte order, packing pragmas or bitfield ABI. Values are
+     * assembled with shifts, which compilers fold into one (unaligned) load or store where the target allows it, and a
+     * load and byte swap on big-endian targets; everything is usable in constant expressions.
+     * Converts implicitly to and from `Value_t`, so a field reads and is assigned as the plain integer it replaces.
+     * @code
+     *   usbstd::Le16 wTotalLength = 0x0123; //< Bytes 0x23, 0x01
+     *   const uint16_t length = wTotalLength;
+     * @endcode
+    */
+    template<typename Value_t>
+    class LittleEndian
+    {
+        static_assert(std::is_unsigned_v<Value_t> && ((sizeof(Value_t) == 2) || (sizeof(Value_t) == 4)), "Value_t must be a 16 or 32-bit unsigned integer");
+
+    public:
+        using value_type = Value_t;
+
+        LittleEndian() = default; //< Trivial, `= {}` zero-initialises
+        constexpr LittleEndian(Value_t value) : LittleEndian(value, std::make_index_sequence<sizeof(Value_t)>{}) {}
+
+        constexpr operator Value_t() const { return value(); }
+
+        constexpr Value_t value() const
+        {
+            // Spelled out rather than looped, the form the load merging passes of GCC and Clang recognise
+            if constexpr (sizeof(Value_t) == 2)
+                return static_cast<Value_t>(bytes_[0] | (bytes_[1] << 8));
+            else
+                return static_cast<Value_t>(uint32_t(bytes_[0]) | (uint32_t(bytes_[1]) << 8) | (uint32_t(bytes_[2]) << 16) | (uint32_t(bytes_[3]) << 24));
+        }
+
+        constexpr LittleEndian& operator=(Value_t value)
+        {
+            store(value);
+            return *this;
+        }
+
+        /// @{ Read-modify-write
+        constexpr LittleEndian& operator+=(Value_t value) { return *this = static_cast<Value_t>(this->value() + value); }
+        constexpr LittleEndian& operator-=(Value_t value) { return *this = static_cast<Value_t>(this->value() - value); }
+        constexpr LittleEndian& operator|=(Value_t value) { return *this = static_cast<Value_t>(this->value() | value); }
+        constexpr LittleEndian& operator&=(Value_t value) { return *this = static_cast<Value_t>(this->value() & value); }
+        constexpr LittleEndian& operator++() { return *this += 1; }
+        constexpr Value_t operator++(int)
+        {
+            const Value_t previous = value();
+            *this += 1;
+            return previous;
+        }
+        ///@}
+
+    private:
+        /// Every byte in the initialiser list: GCC rejects later writes to a const object under construction in constant expressions
+        template<size_t... Index>
+        constexpr LittleEndian(Value_t value, std::index_sequence<Index...>) : bytes_{ static_cast<uint8_t>(value >> (8 * Index))... } {}
+
+        constexpr void store(Value_t value)
+        {
+            bytes_[0] = static_cast<uint8_t>(value);
+            bytes_[1] = static_cast<uint8_t>(value >> 8);
+            if constexpr (sizeof(Value_t) == 4)
+            {
+                bytes_[2] = static_cast<uint8_t>(value >> 16);
+                bytes_[3] = static_cast<uint8_t>(value >> 24);
+            }
+        }
+
+        uint8_t bytes_[sizeof(Value_t)];
+    };
+
+    using Le16 = LittleEndian<uint16_t>;
+    using Le32 = LittleEndian<uint32_t>;
+
+    static_assert((sizeof(Le16) == 2) && (alignof(Le16) == 1), "size is not correct");
+    static_assert((sizeof(Le32) == 4) && (alignof(Le32) == 1), "size is not correct");
+    static_assert(std::is_trivial_v<Le16> && std::is_trivial_v<Le32>, "Wire fields must stay trivial");
+
+    /** `Width` bits at bit `Offset` of an integer, replacing C bitfields whose layout is implementation-defined
+     * @code
+     *   using TransferType = usbstd::BitField<0, 2>;
+     *   const uint8_t xfer = TransferType::get(bmAttributes);
+     *   bmAttributes = TransferType::set(bmAttributes, USB_BULK_ENDPOINT);
+     * @endcode
+    */
+    template<unsigned Offset, unsigned Width>
+    struct BitField
+    {
+        static_assert((Width != 0) && (Offset + Width <= 32), "Field exceeds 32 bits");
+
+        static constexpr uint32_t Mask = ((Width == 32) ? ~uint32_t(0) : ((uint32_t(1) << Width) - 1)) << Offset;
+
+        template<typename Value_t>
+        static constexpr Value_t get(Value_t value) { return static_cast<Value_t>((uint32_t(value) & Mask) >> Offset); }
+
+        /** `value` with the field replaced by `field`, truncated to `Width` bits
+        */
+        template<typename Value_t>
+        static constexpr Value_t set(Value_t value, uint32_t field)
+        {
+            return static_cast<Value_t>((uint32_t(value) & ~Mask) | ((field << Offset) & Mask));
+        }
+    };
+
+} //END: usbstd
\ No newline at end of file
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint32_t
+#include <type_traits> //< std::decay_t, std::is_same_v
+
+#include "usb_descriptor.hpp" //< usbstd::BusSpeed, usbstd::EndpointDescriptor, usbstd::InterfaceDescriptor
+#include "usb_helper_descriptorlist.hpp" //< usbstd::helper::DescriptorList, usbstd::helper::DescriptorCount
+#include "usbstd.hpp" //< USB_ISOCHRONOUS_ENDPOINT, USB_INTERRUPT_ENDPOINT
+
+namespace usbstd {
+namespace helper {
+
+    /** USB 2.0 bus-time constants used by `PeriodicBudget`, in full-speed (FS/LS) or high-speed (HS) byte-times
+     * @see USB 2.0 specification 5.6.5, 5.7.4 (protocol overhead) and 5.6.4, 5.7.4 (periodic limits)
+    */
+    struct BusTiming
+    {
+        static constexpr uint32_t FrameBytes(BusSpeed speed) { return (speed == BusSpeed::High) ? 7500 : 1500; } ///< 125us at 480Mb/s, 1ms at 12Mb/s
+
+        /** Periodic transfers may use at most 90% of a full-speed frame and 80% of a high-speed microframe
+        */
+        static constexpr uint32_t PeriodicLimit(BusSpeed speed) { return (speed == BusSpeed::High) ? (FrameBytes(speed) * 80 / 100) : (FrameBytes(speed) * 90 / 100); }
+
+        static constexpr uint32_t FrameMicroseconds(BusSpeed speed) { return (speed == BusSpeed::High) ? 125 : 1000; }
+
+        /** Protocol overhead per transaction (token, handshake, inter-packet delays, CRC, SYNC/EOP)
+        */
+        static constexpr uint32_t Overhead(BusSpeed speed, uint8_t xfer)
+        {
+            if (speed == BusSpeed::High)
+                return (xfer == USB_ISOCHRONOUS_ENDPOINT) ? 38 : 55;
+            return (xfer == USB_ISOCHRONOUS_ENDPOINT) ? 9 : 13;
+        }
+
+        /** Worst-case bit-stuffed payload length (one stuffed bit per six data bits)
+        */
+        static constexpr uint32_t Stuffed(uint32_t bytes) { return (bytes * 7 + 5) / 6; }
+    };
+
+    /** Periodic bandwidth reservation and polling latency of one interrupt or isochronous endpoint
+    */
+    struct EndpointBudget
+    {
+        uint8_t bEndpointAddress;
+        uint8_t bInterfaceNumber;
+        uint8_t bAlternateSetting;
+        uint8_t xfer; ///< `USB_ISOCHRONOUS_ENDPOINT` or `USB_INTERRUPT_ENDPOINT`
+        uint32_t payloadBytes; ///< Payload per service (micro)frame, `wMaxPacketSize` x transactions
+        uint32_t busBytes; ///< Bus-time reserved in the service (micro)frame, including overhead and bit-stuffing, in byte-times of the bus speed
+        uint32_t period; ///< Service period in (micro)frames
+        uint32_t latencyMicroseconds; ///< Worst-case delay between data becoming ready and the next poll
+    };
+
+    /** Result of analysing the periodic endpoints of a configuration for one bus speed
+     * @note All endpoints are assumed to be scheduled in the same (micro)frame, the worst case a host or hub may choose;
+     * for each interface only its most demanding alternate setting is counted, as only one can be active.
+    */
+    template<size_t MaxEndpoints>
+    struct PeriodicBudget
+    {
+        BusSpeed speed;
+        size_t count; ///< Number of periodic endpoints in `endpoints`
+        EndpointBudget endpoints[MaxEndpoints ? MaxEndpoints : 1];
+        uint32_t reservedBytes; ///< Worst-case bus-time reserved in a single (micro)frame
+        uint32_t limitBytes; ///< Periodic limit of a (micro)frame
+        uint32_t worstLatencyMicroseconds; ///< Largest polling latency of any periodic endpoint
+
+        constexpr bool fits() const { return reservedBytes <= limitBytes; }
+
+        /** Percentage of the (micro)frame reserved for periodic transfers
+        */
+        constexpr uint32_t utilisation() const { return (reservedBytes * 100) / BusTiming::FrameBytes(speed); }
+    };
+
+    /** Analyse the periodic (interrupt and isochronous) bandwidth of a configuration at compile-time
+     * @code
+     *   static constexpr auto usbConfiguration = usbstd::helper::makeConfiguration(...);
+     *
+     *   constexpr auto hsBudget = usbstd::helper::periodicBudget<usbstd::BusSpeed::High>(usbConfiguration);
+     *   static_assert(hsBudget.fits(), "Periodic endpoints exceed the high-speed microframe budget");
+     * @endcode
+     * @tparam  Speed  Bus speed the configuration is used at, `bInterval` and `hsPeriodMult()` are interpreted accordingly
+    */
+    template<BusSpeed Speed, typename... Descriptors_t>
+    constexpr auto periodicBudget(const DescriptorList<Descriptors_t...>& configuration)
+    {
+        static_assert(Speed != BusSpeed::Super, "SuperSpeed periodic scheduling is not covered by the USB 2.0 budget");
+
+        constexpr size_t MaxEndpoints = DescriptorCount<EndpointDescriptor, DescriptorList<Descriptors_t...>>::value;
+        constexpr size_t MaxInterfaces = DescriptorCount<InterfaceDescriptor, DescriptorList<Descriptors_t...>>::value;
+
+        PeriodicBudget<MaxEndpoints> budget = {};
+        budget.speed = Speed;
+        budget.limitBytes = BusTiming::PeriodicLimit(Speed);
+
+        struct Setting { uint8_t bInterfaceNumber; uint8_t bAlternateSetting; uint32_t busBytes; };
+        Setting settings[MaxInterfaces ? MaxInterfaces : 1] = {};
+        size_t settingCount = 0;
+
+        configuration.forEach([&](const auto& descriptor)
+        {
+            using Type = std::decay_t<decltype(descriptor)>;
+            if constexpr (std::is_same_v<Type, InterfaceDescriptor>)
+            {
+                settings[settingCount++] = { descriptor.data.bInterfaceNumber, descriptor.data.bAlternateSetting, 0 };
+            }
+            else if constexpr (std::is_same_v<Type, EndpointDescriptor>)
+            {
+                const auto& data = descriptor.data;
+                const uint8_t xfer = data.bmAttributes.xfer();
+                if ((settingCount == 0) || ((xfer != USB_ISOCHRONOUS_ENDPOINT) && (xfer != USB_INTERRUPT_ENDPOINT)))
+                    return;
+
+                const uint32_t transactions = (Speed == BusSpeed::High) ? (1u + data.wMaxPacketSize.hsPeriodMult()) : 1u;
+                const uint32_t transactionBytes = BusTiming::Stuffed(data.wMaxPacketSize.size()) + BusTiming::Overhead(Speed, xfer);
+                const uint32_t scale = (Speed == BusSpeed::Low) ? 8 : 1; //< Low-speed byte-times on a full-speed frame
+
+                const uint32_t exponent = (data.bInterval == 0) ? 0 : ((data.bInterval > 16) ? 15 : (data.bInterval - 1u));
+                const uint32_t period = ((Speed == BusSpeed::High) || (xfer == USB_ISOCHRONOUS_ENDPOINT))
+                    ? (1u << exponent)
+                    : ((data.bInterval == 0) ? 1u : data.bInterval);
+
+                auto& endpoint = budget.endpoints[budget.count++];
+                auto& setting = settings[settingCount - 1];
+                endpoint = { data.bEndpointAddress, setting.bInterfaceNumber, setting.bAlternateSetting, xfer
+                    , data.wMaxPacketSize.size() * transactions
+                    , transactionBytes * transactions * scale
+                    , period
+                    , period * BusTiming::FrameMicroseconds(Speed) };
+                setting.busBytes += endpoint.busBytes;
+                if (endpoint.latencyMicroseconds > budget.worstLatencyMicroseconds)
+                    budget.worstLatencyMicroseconds = endpoint.latencyMicroseconds;
+            }
+        });
+
+        // Alternate settings of an interface are mutually exclusive: reserve the largest
+        for (size_t i = 0; i < settingCount; ++i)
+        {
+            bool largest = true;
+            for (size_t j = 0; j < settingCount; ++j)
+            {
+                if ((i != j) && (settings[i].bInterfaceNumber == settings[j].bInterfaceNumber)
+                    && ((settings[j].busBytes > settings[i].busBytes) || ((settings[j].busBytes == settings[i].busBytes) && (j < i))))
+                    largest = false;
+            }
+            if (largest)
+                budget.reservedBytes += settings[i].busBytes;
+        }
+        return budget;
+    }
+
+} //END: helper
+} //END: usbstd
\ No newline at end of file
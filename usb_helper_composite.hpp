@@ -0,0 +1,387 @@
+#pragma once
+
+#include <array> //< std::array
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t
+#include <tuple> //< std::tuple, std::tuple_element_t
+#include <utility> //< std::index_sequence
+
+#include "usb_cdc.hpp" //< usbstd::cdc::*Descriptor, usbstd::CdcSubClass
+#include "usb_class.hpp" //< usbstd::ClassCode
+#include "usb_dfu.hpp" //< usbstd::dfu::functionalDescriptor, usbstd::DfuSubClass
+#include "usb_helper_descriptorlist.hpp" //< usbstd::helper::makeConfiguration, usbstd::helper::makeDescriptorList
+#include "usb_hid.hpp" //< usbstd::HidSubClass, usbstd::HidProtocol
+#include "usbstd.hpp" //< usbstd::USB_IN_ENDPOINT, usbstd::USB_BULK_ENDPOINT, usbstd::USB_INTERRUPT_ENDPOINT
+
+namespace usbstd {
+namespace helper {
+
+    /** Endpoint a function needs; the builder assigns its number
+    */
+    struct EndpointRequirement
+    {
+        uint8_t  direction; ///< `USB_IN_ENDPOINT` or `USB_OUT_ENDPOINT`
+        uint8_t  xfer; ///< `USB_BULK_ENDPOINT`, `USB_INTERRUPT_ENDPOINT` or `USB_ISOCHRONOUS_ENDPOINT`
+        uint16_t maxPacketSize;
+        uint8_t  interval; ///< `bInterval`
+    };
+
+    /** Resources of the target device controller the composite layout must fit in
+     * @tparam  EndpointCount  Endpoint numbers implemented, including EP0, e.g. 8 for EP0..EP7
+     * @tparam  FifoBytes  Packet memory available to endpoints other than EP0
+     * @tparam  BuffersPerEndpoint  Packet buffers allocated per endpoint, 2 for double-buffered controllers
+     * @tparam  SharedNumbers  Whether an IN and an OUT endpoint can use the same endpoint number
+    */
+    template<uint8_t EndpointCount, size_t FifoBytes, uint8_t BuffersPerEndpoint = 1, bool SharedNumbers = true>
+    struct ControllerTraits
+    {
+        static constexpr uint8_t endpointCount = EndpointCount;
+        static constexpr size_t fifoBytes = FifoBytes;
+        static constexpr uint8_t buffersPerEndpoint = BuffersPerEndpoint;
+        static constexpr bool sharedNumbers = SharedNumbers;
+    };
+
+    /** Interfaces and endpoints assigned to one function of a `Composite`
+     * Usable in constant expressions, e.g. as the `index` of a `Route`.
+    */
+    template<size_t EndpointCount>
+    struct FunctionHandle
+    {
+        uint8_t firstInterface;
+        uint8_t interfaceCount;
+        uint8_t endpoints[(EndpointCount != 0) ? EndpointCount : 1]; ///< Endpoint addresses, in the order the function declared them
+
+        constexpr uint8_t interface(uint8_t index = 0) const { return static_cast<uint8_t>(firstInterface + index); }
+        constexpr uint8_t endpoint(size_t index) const { return endpoints[index]; }
+    };
+
+    constexpr InterfaceDescriptor makeInterface(uint8_t number, ClassCode interfaceClass, uint8_t subClass = 0, uint8_t protocol = 0, uint8_t iInterface = 0)
+    {
+        InterfaceDescriptor descriptor = {};
+        descriptor.data = { number, 0, 0, static_cast<uint8_t>(interfaceClass), subClass, protocol, iInterface };
+        return descriptor;
+    }
+
+    constexpr EndpointDescriptor makeEndpoint(uint8_t address, const EndpointRequirement& requirement)
+    {
+        EndpointDescriptor descriptor = {};
+        descriptor.data.bEndpointAddress = address;
+        descriptor.data.bmAttributes.xfer(static_cast<uint8_t>(requirement.xfer));
+        descriptor.data.wMaxPacketSize.size(static_cast<uint16_t>(requirement.maxPacketSize));
+        descriptor.data.bInterval = requirement.interval;
+        return descriptor;
+    }
+
+    /** Compile-time interface and endpoint allocation of a `Composite`
+    */
+    template<typename Controller_t, typename... Functions_t>
+    struct CompositeLayout
+    {
+        static constexpr size_t FunctionCount = sizeof...(Functions_t);
+        static constexpr size_t EndpointTotal = (Functions_t::endpoints.size() + ... + 0);
+        static constexpr uint8_t InterfaceCounts[] = { Functions_t::InterfaceCount... };
+        static constexpr size_t EndpointCounts[] = { Functions_t::endpoints.size()... };
+
+        struct Allocation
+        {
+            uint8_t firstInterface[FunctionCount];
+            size_t  firstEndpoint[FunctionCount]; ///< Index into `addresses`
+            uint8_t addresses[(EndpointTotal != 0) ? EndpointTotal : 1];
+            uint8_t interfaceCount;
+            size_t  fifoBytes;
+            bool    endpointsFit;
+        };
+
+        static constexpr Allocation allocate()
+        {
+            Allocation allocation = {};
+            allocation.endpointsFit = true;
+
+            uint8_t nextIn = 1;
+            uint8_t nextOut = 1;
+            size_t endpoint = 0;
+            size_t function = 0;
+            const auto place = [&](const auto& endpoints, uint8_t interfaces)
+            {
+                allocation.firstInterface[function] = allocation.interfaceCount;
+                allocation.firstEndpoint[function] = endpoint;
+                allocation.interfaceCount = static_cast<uint8_t>(allocation.interfaceCount + interfaces);
+                for (const EndpointRequirement& requirement : endpoints)
+                {
+                    const bool in = (requirement.direction & USB_IN_ENDPOINT) != 0;
+                    uint8_t& next = (in || !Controller_t::sharedNumbers) ? nextIn : nextOut;
+                    const uint8_t number = next++;
+                    if (!Controller_t::sharedNumbers)
+                        nextOut = nextIn;
+                    if (number >= Controller_t::endpointCount)
+                        allocation.endpointsFit = false;
+                    allocation.addresses[endpoint++] = static_cast<uint8_t>(number | (in ? USB_IN_ENDPOINT : USB_OUT_ENDPOINT));
+                    allocation.fifoBytes += size_t(requirement.maxPacketSize) * Controller_t::buffersPerEndpoint;
+                }
+                ++function;
+            };
+            (place(Functions_t::endpoints, Functions_t::InterfaceCount), ...);
+            return allocation;
+        }
+
+        template<size_t Index>
+        static constexpr FunctionHandle<EndpointCounts[Index]> handle(const Allocation& allocation)
+        {
+            FunctionHandle<EndpointCounts[Index]> handle = {};
+            handle.firstInterface = allocation.firstInterface[Index];
+            handle.interfaceCount = InterfaceCounts[Index];
+            for (size_t i = 0; i < EndpointCounts[Index]; ++i)
+                handle.endpoints[i] = allocation.addresses[allocation.firstEndpoint[Index] + i];
+            return handle;
+        }
+
+        struct Owners
+        {
+            uint8_t interfaces[256]; ///< Function index by interface number
+            uint8_t endpoints[32]; ///< Function index by endpoint number, OUT then IN
+        };
+
+        static constexpr Owners owners(const Allocation& allocation)
+        {
+            Owners owners = {};
+            for (auto& owner : owners.interfaces)
+                owner = NoFunction;
+            for (auto& owner : owners.endpoints)
+                owner = NoFunction;
+            for (size_t function = 0; function < FunctionCount; ++function)
+            {
+                for (uint8_t i = 0; i < InterfaceCounts[function]; ++i)
+                    owners.interfaces[allocation.firstInterface[function] + i] = static_cast<uint8_t>(function);
+                for (size_t i = 0; i < EndpointCounts[function]; ++i)
+                    owners.endpoints[endpointSlot(allocation.addresses[allocation.firstEndpoint[function] + i])] = static_cast<uint8_t>(function);
+            }
+            return owners;
+        }
+
+        static constexpr uint8_t NoFunction = 0xff;
+
+        static constexpr size_t endpointSlot(uint8_t address)
+        {
+            return (address & 0x0f) | ((address & USB_IN_ENDPOINT) ? 16 : 0);
+        }
+    };
+
+    /** Compile-time composite device
+     * Each function declares the interfaces and endpoints it needs; the composite assigns interface numbers and endpoint
+     * addresses in declaration order, checks them against the controller, and builds the configuration descriptor with
+     * an IAD in front of every function of more than one interface.
+     *
+     * A function type provides:
+     *  - `static constexpr uint8_t InterfaceCount`
+     *  - `static constexpr std::array<EndpointRequirement, N> endpoints`
+     *  - `static constexpr uint8_t FunctionClass, FunctionSubClass, FunctionProtocol` for its IAD
+     *  - `template<typename Handle_t> static constexpr auto descriptors(const Handle_t& handle)`, its interface, class-specific
+     *    and endpoint descriptors using the numbers in `handle`
+     * @code
+     *   using Controller = usbstd::helper::ControllerTraits<8, 1024>;
+     *   using Device = usbstd::helper::Composite<Controller, CdcAcmFunction<>, HidFunction<MouseReport>, VendorFunction<>>;
+     *
+     *   static constexpr auto usbConfiguration = Device::configuration(configuration);
+     *
+     *   constexpr usbstd::helper::Route<Handler> usbRoutes[] = {
+     *       { usbstd::USB_CLASS_REQUEST, usbstd::USB_RECIPIENT_INTERFACE, usbstd::USB_CDC_SET_LINE_CODING, setLineCoding, Device::handle<0>.interface() } };
+     *   constexpr uint8_t mouseEndpoint = Device::handle<1>.endpoint(0);
+     * @endcode
+    */
+    template<typename Controller_t, typename... Functions_t>
+    class Composite
+    {
+        using Layout = CompositeLayout<Controller_t, Functions_t...>;
+
+        static constexpr typename Layout::Allocation allocation_ = Layout::allocate();
+        static_assert(allocation_.endpointsFit, "Functions need more endpoint numbers than the controller implements");
+        static_assert(allocation_.fifoBytes <= Controller_t::fifoBytes, "Functions need more packet memory than the controller has");
+
+        static constexpr typename Layout::Owners owners_ = Layout::owners(allocation_);
+
+    public:
+        static constexpr size_t FunctionCount = Layout::FunctionCount;
+        static constexpr uint8_t InterfaceCount = allocation_.interfaceCount;
+        static constexpr size_t FifoBytes = allocation_.fifoBytes; ///< Packet memory used by the function endpoints
+        static constexpr bool UsesIad = ((Functions_t::InterfaceCount > 1) || ...);
+        static constexpr uint8_t NoFunction = Layout::NoFunction;
+
+        template<size_t Index>
+        using Function = std::tuple_element_t<Index, std::tuple<Functions_t...>>;
+
+        /** Interface numbers and endpoint addresses of function `Index`
+        */
+        template<size_t Index>
+        static constexpr auto handle = Layout::template handle<Index>(allocation_);
+
+        /** Function owning an interface, for routing interface requests
+         * @return Function index or `NoFunction`
+        */
+        static constexpr uint8_t functionOfInterface(uint8_t interface) { return owners_.interfaces[interface]; }
+
+        /** Function owning an endpoint address, for routing endpoint requests and transfer completions
+         * @return Function index or `NoFunction`
+        */
+        static constexpr uint8_t functionOfEndpoint(uint8_t address) { return owners_.endpoints[Layout::endpointSlot(address)]; }
+
+        /** Device descriptor with the IAD class triple (Misc/Common/IAD) when a function has several interfaces
+        */
+        static constexpr DeviceDescriptor device(DeviceDescriptor device)
+        {
+            if (UsesIad)
+            {
+                device.data.bDeviceClass = static_cast<uint8_t>(ClassCode::Misc);
+                device.data.bDeviceSubClass = 0x02;
+                device.data.bDeviceProtocol = 0x01;
+            }
+            return device;
+        }
+
+        /** Complete configuration descriptor of all functions
+         * @see makeConfiguration
+        */
+        static constexpr auto configuration(ConfigurationDescriptor configuration)
+        {
+            return configuration_(configuration, std::index_sequence_for<Functions_t...>{});
+        }
+
+    private:
+        template<size_t... Indices>
+        static constexpr auto configuration_(ConfigurationDescriptor configuration, std::index_sequence<Indices...>)
+        {
+            return makeConfiguration(configuration, function_<Indices>()...);
+        }
+
+        template<size_t Index>
+        static constexpr auto function_()
+        {
+            using Function_t = Function<Index>;
+            constexpr auto functionHandle = handle<Index>;
+            if constexpr (Function_t::InterfaceCount > 1)
+            {
+                InterfaceAssociationDescriptor association = {};
+                association.data = { functionHandle.firstInterface, functionHandle.interfaceCount
+                    , Function_t::FunctionClass, Function_t::FunctionSubClass, Function_t::FunctionProtocol, 0 };
+                return makeDescriptorList(association, Function_t::descriptors(functionHandle));
+            }
+            else
+                return Function_t::descriptors(functionHandle);
+        }
+    };
+
+    /** CDC-ACM function: communication interface with a notification endpoint, and a data interface with bulk OUT and IN
+     * Endpoints: 0 notification IN, 1 data OUT, 2 data IN
+    */
+    template<uint16_t MaxPacketSize = 64, uint16_t NotifySize = 8, uint8_t NotifyInterval = 16>
+    struct CdcAcmFunction
+    {
+        static constexpr uint8_t InterfaceCount = 2;
+        static constexpr std::array<EndpointRequirement, 3> endpoints = { {
+             { USB_IN_ENDPOINT, USB_INTERRUPT_ENDPOINT, NotifySize, NotifyInterval }
+            ,{ USB_OUT_ENDPOINT, USB_BULK_ENDPOINT, MaxPacketSize, 0 }
+            ,{ USB_IN_ENDPOINT, USB_BULK_ENDPOINT, MaxPacketSize, 0 }
+        } };
+        static constexpr uint8_t FunctionClass = static_cast<uint8_t>(ClassCode::Cdc);
+        static constexpr uint8_t FunctionSubClass = static_cast<uint8_t>(CdcSubClass::Acm);
+        static constexpr uint8_t FunctionProtocol = static_cast<uint8_t>(CdcProtocol::None);
+
+        template<typename Handle_t>
+        static constexpr auto descriptors(const Handle_t& handle)
+        {
+            cdc::HeaderDescriptor header = {};
+            header.data.bcdCDC = 0x0120;
+            cdc::CallDescriptor call = {};
+            call.data = { 0, handle.interface(1) };
+            cdc::AcmDescriptor acm = {};
+            acm.data.bmCapabilities = CdcAcmRequestCapabilities::Line;
+            cdc::UnionDescriptor cdcUnion = {};
+            cdcUnion.data = { handle.interface(0), handle.interface(1) };
+
+            return makeDescriptorList(
+                  makeInterface(handle.interface(0), ClassCode::Cdc, FunctionSubClass, FunctionProtocol)
+                , header, call, acm, cdcUnion
+                , makeEndpoint(handle.endpoint(0), endpoints[0])
+                , makeInterface(handle.interface(1), ClassCode::CdcData)
+                , makeEndpoint(handle.endpoint(1), endpoints[1])
+                , makeEndpoint(handle.endpoint(2), endpoints[2]) );
+        }
+    };
+
+    /** HID function with an interrupt IN endpoint, and an interrupt OUT endpoint when `OutSize` is not zero
+     * @tparam  Report_t  `hid::ReportDescriptor` announced by the HID descriptor
+    */
+    template<typename Report_t, uint16_t InSize = 8, uint8_t Interval = 10, uint16_t OutSize = 0
+        , HidSubClass SubClass = HidSubClass::None, HidProtocol Protocol = HidProtocol::None>
+    struct HidFunction
+    {
+        static constexpr uint8_t InterfaceCount = 1;
+        static constexpr auto endpoints = []
+        {
+            if constexpr (OutSize != 0)
+                return std::array<EndpointRequirement, 2>{ { { USB_IN_ENDPOINT, USB_INTERRUPT_ENDPOINT, InSize, Interval }, { USB_OUT_ENDPOINT, USB_INTERRUPT_ENDPOINT, OutSize, Interval } } };
+            else
+                return std::array<EndpointRequirement, 1>{ { { USB_IN_ENDPOINT, USB_INTERRUPT_ENDPOINT, InSize, Interval } } };
+        }();
+        static constexpr uint8_t FunctionClass = static_cast<uint8_t>(ClassCode::Hid);
+        static constexpr uint8_t FunctionSubClass = static_cast<uint8_t>(SubClass);
+        static constexpr uint8_t FunctionProtocol = static_cast<uint8_t>(Protocol);
+
+        template<typename Handle_t>
+        static constexpr auto descriptors(const Handle_t& handle)
+        {
+            const auto interface = makeInterface(handle.interface(), ClassCode::Hid, FunctionSubClass, FunctionProtocol);
+            if constexpr (OutSize != 0)
+                return makeDescriptorList(interface, Report_t::descriptor(), makeEndpoint(handle.endpoint(0), endpoints[0]), makeEndpoint(handle.endpoint(1), endpoints[1]));
+            else
+                return makeDescriptorList(interface, Report_t::descriptor(), makeEndpoint(handle.endpoint(0), endpoints[0]));
+        }
+    };
+
+    /** Vendor-specific function with one bulk OUT and one bulk IN endpoint, e.g. for WinUSB or libusb
+     * Endpoints: 0 OUT, 1 IN
+    */
+    template<uint16_t MaxPacketSize = 64, uint8_t SubClass = 0, uint8_t Protocol = 0>
+    struct VendorFunction
+    {
+        static constexpr uint8_t InterfaceCount = 1;
+        static constexpr std::array<EndpointRequirement, 2> endpoints = { {
+             { USB_OUT_ENDPOINT, USB_BULK_ENDPOINT, MaxPacketSize, 0 }
+            ,{ USB_IN_ENDPOINT, USB_BULK_ENDPOINT, MaxPacketSize, 0 }
+        } };
+        static constexpr uint8_t FunctionClass = static_cast<uint8_t>(ClassCode::VendorSpecific);
+        static constexpr uint8_t FunctionSubClass = SubClass;
+        static constexpr uint8_t FunctionProtocol = Protocol;
+
+        template<typename Handle_t>
+        static constexpr auto descriptors(const Handle_t& handle)
+        {
+            return makeDescriptorList(
+                  makeInterface(handle.interface(), ClassCode::VendorSpecific, SubClass, Protocol)
+                , makeEndpoint(handle.endpoint(0), endpoints[0])
+                , makeEndpoint(handle.endpoint(1), endpoints[1]) );
+        }
+    };
+
+    /** DFU runtime function: an interface without endpoints, announcing DETACH to switch to DFU mode
+     * @tparam  Attributes  `DfuAttributes` of the DFU mode firmware
+    */
+    template<uint8_t Attributes = CanDownload | WillDetach, uint16_t TransferSize = 1024, uint16_t DetachTimeOut = 1000>
+    struct DfuRuntimeFunction
+    {
+        static constexpr uint8_t InterfaceCount = 1;
+        static constexpr std::array<EndpointRequirement, 0> endpoints = {};
+        static constexpr uint8_t FunctionClass = static_cast<uint8_t>(ClassCode::ApplicationSpecific);
+        static constexpr uint8_t FunctionSubClass = static_cast<uint8_t>(DfuSubClass::Dfu);
+        static constexpr uint8_t FunctionProtocol = static_cast<uint8_t>(DfuProtocol::Runtime);
+
+        template<typename Handle_t>
+        static constexpr auto descriptors(const Handle_t& handle)
+        {
+            return makeDescriptorList(
+                  makeInterface(handle.interface(), ClassCode::ApplicationSpecific, FunctionSubClass, FunctionProtocol)
+                , dfu::functionalDescriptor(Attributes, TransferSize, DetachTimeOut) );
+        }
+    };
+
+} //END: helper
+} //END: usbstd
\ No newline at end of file
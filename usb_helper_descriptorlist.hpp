@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t
+#include <type_traits> //< std::decay_t, std::is_same_v, std::void_t
+#include <utility> //< std::declval
+
+#include "usb_bos.hpp" //< usbstd::usb_bos_descriptor_header_t, usbstd::usb_desc_bos_platform_t
+#include "usb_descriptor.hpp" //< usbstd::ConfigurationDescriptor, usbstd::InterfaceDescriptor, usbstd::EndpointDescriptor
+#include "usbstd.hpp" //< usbstd::USB_ISOCHRONOUS_ENDPOINT, usbstd::USB_INTERRUPT_ENDPOINT
+
+namespace usbstd {
+namespace helper {
+
+    template<typename Element_t, typename Fn>
+    constexpr void visitDescriptor(Element_t& element, Fn& fn);
+
+#pragma pack(push, 1)
+
+    /** Contiguous, packed sequence of descriptors laid out exactly as they are sent on the wire
+     * @note Each element must itself be packed (`alignof == 1`) so the list has no padding and `sizeof` equals the wire length
+     * @note A `DescriptorList` may itself contain `DescriptorList` elements; `forEach()` visits them flattened
+     * @tparam  Descriptors_t  Descriptor types, in wire order
+    */
+    template<typename... Descriptors_t>
+    struct DescriptorList;
+
+    template<typename Descriptor_t>
+    struct DescriptorList<Descriptor_t>
+    {
+        static_assert(alignof(Descriptor_t) == 1, "Descriptor type must be packed");
+
+        Descriptor_t head;
+
+        /** Visit every descriptor in wire order, flattening nested lists
+        */
+        template<typename Fn>
+        constexpr void forEach(Fn&& fn) const { visitDescriptor(head, fn); }
+
+        template<typename Fn>
+        constexpr void forEach(Fn&& fn) { visitDescriptor(head, fn); }
+
+        /** Raw bytes of the list, suitable to return directly from a GET_DESCRIPTOR request
+        */
+        const uint8_t* data() const { return reinterpret_cast<const uint8_t*>(this); }
+        static constexpr size_t size() { return sizeof(DescriptorList); }
+    };
+
+    template<typename Descriptor_t, typename... Tail_t>
+    struct DescriptorList<Descriptor_t, Tail_t...>
+    {
+        static_assert(alignof(Descriptor_t) == 1, "Descriptor type must be packed");
+
+        Descriptor_t head;
+        DescriptorList<Tail_t...> tail;
+
+        template<typename Fn>
+        constexpr void forEach(Fn&& fn) const { visitDescriptor(head, fn); tail.forEach(fn); }
+
+        template<typename Fn>
+        constexpr void forEach(Fn&& fn) { visitDescriptor(head, fn); tail.forEach(fn); }
+
+        const uint8_t* data() const { return reinterpret_cast<const uint8_t*>(this); }
+        static constexpr size_t size() { return sizeof(DescriptorList); }
+    };
+
+#pragma pack(pop)
+
+    template<typename T>
+    struct IsDescriptorList : std::false_type {};
+
+    template<typename... Descriptors_t>
+    struct IsDescriptorList<DescriptorList<Descriptors_t...>> : std::true_type {};
+
+    /** Number of `Descriptor_t` elements in a descriptor (list) type, counting nested lists
+    */
+    template<typename Descriptor_t, typename Element_t>
+    struct DescriptorCount : std::integral_constant<size_t, std::is_same_v<Descriptor_t, Element_t> ? 1 : 0> {};
+
+    template<typename Descriptor_t, typename... Elements_t>
+    struct DescriptorCount<Descriptor_t, DescriptorList<Elements_t...>>
+        : std::integral_constant<size_t, (DescriptorCount<Descriptor_t, Elements_t>::value + ... + 0)> {};
+
+    /** Invoke `fn` on `element`, or on each of its descriptors when `element` is a nested `DescriptorList`
+    */
+    template<typename Element_t, typename Fn>
+    constexpr void visitDescriptor(Element_t& element, Fn& fn)
+    {
+        if constexpr (IsDescriptorList<std::remove_const_t<Element_t>>::value)
+            element.forEach(fn);
+        else
+            fn(element);
+    }
+
+    /** Build a packed `DescriptorList` from descriptor values
+     * @code
+     *   constexpr auto descriptors = usbstd::helper::makeDescriptorList(interface0, endpoint1, endpoint2);
+     * @endcode
+    */
+    template<typename Descriptor_t, typename... Tail_t>
+    constexpr DescriptorList<Descriptor_t, Tail_t...> makeDescriptorList(const Descriptor_t& head, const Tail_t&... tail)
+    {
+        if constexpr (sizeof...(Tail_t) == 0)
+            return { head };
+        else
+            return { head, makeDescriptorList(tail...) };
+    }
+
+    /** Compile-time Configuration-descriptor builder
+     * Produces the complete GET_DESCRIPTOR(Configuration) response as one packed object, filling in:
+     *  - `wTotalLength` from the size of the whole list
+     *  - `bNumInterfaces` from the number of interfaces with `bAlternateSetting == 0`
+     *  - `bNumEndpoints` of each interface from the endpoint descriptors that follow it
+     *  - `wBytesPerInterval` of SuperSpeed companions of periodic endpoints, when left zero, from `wMaxPacketSize`, the burst
+     *    size and `Mult`; bulk companions get zero
+     * @code
+     *   static constexpr auto usbConfiguration = usbstd::helper::makeConfiguration(
+     *       configuration, vendorInterface, bulkInEndpoint, bulkOutEndpoint );
+     *
+     *   // GET_DESCRIPTOR(Configuration) is answered straight from flash:
+     *   return usbConfiguration.data(); //< usbConfiguration.size() bytes
+     * @endcode
+     * @param configuration  Configuration descriptor, `wTotalLength` and `bNumInterfaces` are overwritten
+     * @param descriptors  Interface, endpoint, class-specific descriptors (or nested `DescriptorList`s) in wire order
+    */
+    template<typename... Descriptors_t>
+    constexpr auto makeConfiguration(ConfigurationDescriptor configuration, const Descriptors_t&... descriptors)
+    {
+        static_assert(sizeof...(Descriptors_t) > 0, "A configuration requires at least one interface");
+
+        auto list = makeDescriptorList(configuration, descriptors...);
+        static_assert(decltype(list)::size() <= UINT16_MAX, "Configuration exceeds wTotalLength range");
+
+        uint8_t interfaceCount = 0;
+        DescriptorData<DescriptorType::Interface>* currentInterface = nullptr;
+        DescriptorData<DescriptorType::Endpoint>* currentEndpoint = nullptr;
+        list.tail.forEach([&](auto& descriptor)
+        {
+            using Type = std::decay_t<decltype(descriptor)>;
+            if constexpr (std::is_same_v<Type, InterfaceDescriptor>)
+            {
+                currentInterface = &descriptor.data;
+                currentInterface->bNumEndpoints = 0;
+                if (descriptor.data.bAlternateSetting == 0)
+                    ++interfaceCount;
+            }
+            else if constexpr (std::is_same_v<Type, EndpointDescriptor>)
+            {
+                currentEndpoint = &descriptor.data;
+                if (currentInterface != nullptr)
+                    ++currentInterface->bNumEndpoints;
+            }
+            else if constexpr (std::is_same_v<Type, SuperSpeedEndpointCompanionDescriptor>)
+            {
+                if (currentEndpoint != nullptr)
+                {
+                    const uint8_t xfer = currentEndpoint->bmAttributes.xfer();
+                    if ((xfer == USB_ISOCHRONOUS_ENDPOINT) || (xfer == USB_INTERRUPT_ENDPOINT))
+                    {
+                        if (descriptor.data.wBytesPerInterval == 0)
+                        {
+                            const uint32_t mult = (xfer == USB_ISOCHRONOUS_ENDPOINT) ? (descriptor.data.bmAttributes & 0x03u) + 1 : 1;
+                            const uint32_t bytes = uint32_t(currentEndpoint->wMaxPacketSize.size()) * (descriptor.data.bMaxBurst + 1u) * mult;
+                            descriptor.data.wBytesPerInterval = static_cast<uint16_t>((bytes < UINT16_MAX) ? bytes : UINT16_MAX);
+                        }
+                    }
+                    else
+                        descriptor.data.wBytesPerInterval = 0;
+                }
+            }
+        });
+
+        list.head.data.wTotalLength = static_cast<uint16_t>(list.size());
+        list.head.data.bNumInterfaces = interfaceCount;
+        return list;
+    }
+
+    /** SuperSpeed companion of a bulk endpoint
+     * @param burst  Packets per burst, 1 to 16
+     * @param streamsLog2  log2 of the bulk streams supported, 0 for none, at most 16 (65536 streams)
+    */
+    constexpr SuperSpeedEndpointCompanionDescriptor makeBulkCompanion(uint8_t burst, uint8_t streamsLog2 = 0)
+    {
+        SuperSpeedEndpointCompanionDescriptor companion = {};
+        companion.data.bMaxBurst = static_cast<uint8_t>((burst - 1) & 0x0f);
+        companion.data.bmAttributes = static_cast<uint8_t>(streamsLog2 & 0x1f);
+        return companion;
+    }
+
+    /** SuperSpeed companion of an isochronous or interrupt endpoint
+     * @param burst  Packets per burst, 1 to 16 (interrupt: 1 to 3 with `wMaxPacketSize` 1024)
+     * @param mult  Bursts per service interval for isochronous endpoints, 1 to 3
+     * @param bytesPerInterval  Bytes per service interval, 0 for the maximum, as filled in by `makeConfiguration()`
+    */
+    constexpr SuperSpeedEndpointCompanionDescriptor makePeriodicCompanion(uint8_t burst, uint8_t mult = 1, uint16_t bytesPerInterval = 0)
+    {
+        SuperSpeedEndpointCompanionDescriptor companion = {};
+        companion.data.bMaxBurst = static_cast<uint8_t>((burst - 1) & 0x0f);
+        companion.data.bmAttributes = static_cast<uint8_t>((mult - 1) & 0x03);
+        companion.data.wBytesPerInterval = bytesPerInterval;
+        return companion;
+    }
+
+    template<typename T, typename = void>
+    struct HasPlatformHeader : std::false_type {};
+
+    template<typename T>
+    struct HasPlatformHeader<T, std::void_t<decltype(std::declval<T&>().platform)>> : std::is_same<decltype(std::declval<T&>().platform), usb_desc_bos_platform_t> {};
+
+    /** Compile-time BOS builder
+     * Produces the complete GET_DESCRIPTOR(BOS) response as one packed object, filling in the header `wTotalLength` and
+     * `bNumDeviceCaps`, and the header of platform capabilities (WebUSB, MS OS 2.0)
+     * @code
+     *   static constexpr auto usbBos = usbstd::helper::makeBos(usb20Extension, superSpeedUsb, webUsb);
+     * @endcode
+     * @param capabilities  Device capability descriptors, e.g. `bos::Usb20ExtensionDescriptor`, `usb_bos_webusb_descriptor_t`
+    */
+    template<typename... Capabilities_t>
+    constexpr auto makeBos(const Capabilities_t&... capabilities)
+    {
+        static_assert(sizeof...(Capabilities_t) > 0, "A BOS requires at least one device capability");
+
+        const usb_bos_descriptor_header_t header = { sizeof(usb_bos_descriptor_header_t), static_cast<uint8_t>(DescriptorType::BinaryObjectStore), 0, 0 };
+        auto list = makeDescriptorList(header, capabilities...);
+        static_assert(decltype(list)::size() <= UINT16_MAX, "BOS exceeds wTotalLength range");
+
+        uint8_t capabilityCount = 0;
+        list.tail.forEach([&](auto& capability)
+        {
+            using Type = std::decay_t<decltype(capability)>;
+            if constexpr (HasPlatformHeader<Type>::value)
+            {
+                capability.platform.bLength = static_cast<uint8_t>(sizeof(Type));
+                capability.platform.bDescriptorType = static_cast<uint8_t>(DescriptorType::DeviceCapability);
+                capability.platform.bDevCapabilityType = static_cast<uint8_t>(DeviceCapabilityType::Platform);
+            }
+            ++capabilityCount;
+        });
+
+        list.head.wTotalLength = static_cast<uint16_t>(list.size());
+        list.head.bNumDeviceCaps = capabilityCount;
+        return list;
+    }
+
+} //END: helper
+} //END: usbstd
\ No newline at end of file
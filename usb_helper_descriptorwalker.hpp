@@ -0,0 +1,398 @@
+#pragma once
+
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t
+
+#include "usb_descriptor.hpp" //< usbstd::DescriptorHeader, usbstd::Descriptor, usbstd::SubTypeDescriptor
+#include "usb_span.hpp" //< usbstd::Span
+
+namespace usbstd {
+namespace helper {
+
+    /** Maps a descriptor struct to the `bDescriptorType` (and `bDescriptorSubType`) that identifies it on the wire
+    */
+    template<typename Descriptor_t>
+    struct DescriptorTraits;
+
+    template<DescriptorType Type, typename DescriptorData_t>
+    struct DescriptorTraits< Descriptor<Type, DescriptorData_t> >
+    {
+        static constexpr DescriptorType type = Type;
+        static constexpr bool hasSubType = false;
+        static constexpr uint8_t subType = 0;
+    };
+
+    template<DescriptorType Type, auto ClassSubType, typename DescriptorData_t>
+    struct DescriptorTraits< SubTypeDescriptor<Type, ClassSubType, DescriptorData_t> >
+    {
+        static constexpr DescriptorType type = Type;
+        static constexpr bool hasSubType = true;
+        static constexpr uint8_t subType = static_cast<uint8_t>(ClassSubType);
+    };
+
+    /** Typed, zero-copy view of a single descriptor inside a raw buffer
+     * @note A view is only created by `DescriptorIterator` after `bLength` was checked against the buffer bounds
+    */
+    class DescriptorView
+    {
+    public:
+        constexpr DescriptorView() = default;
+        explicit constexpr DescriptorView(const uint8_t* data) : data_(data) {}
+
+        DescriptorType type() const { return static_cast<DescriptorType>(data_[1]); }
+        uint8_t length() const { return data_[0]; }
+
+        /** Class-specific `bDescriptorSubType`, only meaningful for class-specific descriptors
+        */
+        uint8_t subType() const { return length() > sizeof(DescriptorHeader) ? data_[2] : 0; }
+
+        const DescriptorHeader* header() const { return reinterpret_cast<const DescriptorHeader*>(data_); }
+        Span<const uint8_t> bytes() const { return { data_, length() }; }
+
+        /** Check whether this descriptor is a `Descriptor_t`
+         * @return `true` when type (and subtype) match and `bLength` covers the whole struct
+        */
+        template<typename Descriptor_t>
+        bool is() const
+        {
+            using Traits = DescriptorTraits<Descriptor_t>;
+            return (type() == Traits::type)
+                && (length() >= sizeof(Descriptor_t))
+                && (!Traits::hasSubType || (data_[2] == Traits::subType));
+        }
+
+        /** Typed access to the descriptor in place
+         * @return Pointer into the walked buffer, or `nullptr` when this descriptor is not a `Descriptor_t`
+         * @code
+         *   if (const auto* endpoint = view.as<usbstd::EndpointDescriptor>())
+         *       handleEndpoint(endpoint->data.bEndpointAddress);
+         * @endcode
+        */
+        template<typename Descriptor_t>
+        const Descriptor_t* as() const
+        {
+            return is<Descriptor_t>() ? reinterpret_cast<const Descriptor_t*>(data_) : nullptr;
+        }
+
+    private:
+        const uint8_t* data_ = nullptr;
+    };
+
+    /** Forward iterator over the descriptors of a raw buffer
+     * Each element's `bLength` is validated exactly once, when the iterator reaches it.
+     * A malformed element (`bLength < 2`, or extending beyond the buffer) terminates the iteration.
+    */
+    class DescriptorIterator
+    {
+    public:
+        constexpr DescriptorIterator() = default;
+        DescriptorIterator(const uint8_t* position, const uint8_t* end)
+            : position_(position), end_(end)
+        {
+            validate();
+        }
+
+        DescriptorView operator*() const { return DescriptorView{ position_ }; }
+
+        DescriptorIterator& operator++()
+        {
+            position_ += position_[0];
+            validate();
+            return *this;
+        }
+
+        DescriptorIterator operator++(int)
+        {
+            auto previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const DescriptorIterator& other) const { return position_ == other.position_; }
+        bool operator!=(const DescriptorIterator& other) const { return position_ != other.position_; }
+
+        /** Current byte position, equal to the range end once iteration is complete or stopped at a malformed element
+        */
+        const uint8_t* position() const { return position_; }
+
+        /** `true` when iteration stopped early at an element whose `bLength` is invalid
+        */
+        bool malformed() const { return malformed_; }
+
+    private:
+        void validate()
+        {
+            const auto remaining = static_cast<size_t>(end_ - position_);
+            if ((remaining < sizeof(DescriptorHeader))
+                || (position_[0] < sizeof(DescriptorHeader))
+                || (position_[0] > remaining))
+            {
+                malformed_ = (remaining != 0);
+                position_ = end_;
+            }
+        }
+
+        const uint8_t* position_ = nullptr;
+        const uint8_t* end_ = nullptr;
+        bool malformed_ = false;
+    };
+
+    /** Allocation-free range of descriptors in a raw buffer, e.g. a captured GET_DESCRIPTOR(Configuration) response
+     * @code
+     *   for (auto descriptor : usbstd::helper::DescriptorRange{ buffer })
+     *   {
+     *       if (const auto* interface = descriptor.as<usbstd::InterfaceDescriptor>())
+     *           ...
+     *       else if (const auto* acm = descriptor.as<usbstd::cdc::AcmDescriptor>())
+     *           ...
+     *   }
+     * @endcode
+    */
+    class DescriptorRange
+    {
+    public:
+        constexpr DescriptorRange() = default;
+        constexpr DescriptorRange(Span<const uint8_t> bytes) : bytes_(bytes) {}
+
+        DescriptorIterator begin() const { return { bytes_.begin(), bytes_.end() }; }
+        DescriptorIterator end() const { return { bytes_.end(), bytes_.end() }; }
+
+        Span<const uint8_t> bytes() const { return bytes_; }
+
+        /** Walk the range and check every element is well-formed
+        */
+        bool valid() const
+        {
+            auto it = begin();
+            while (it != end())
+                ++it;
+            return !it.malformed();
+        }
+
+    private:
+        Span<const uint8_t> bytes_;
+    };
+
+    /** Hierarchical index of a Configuration-descriptor blob, built in a single pass
+     * Groups endpoints and class-specific descriptors under their interface and alternate setting so repeated lookups do not re-scan the blob.
+     * All entries are byte offsets into the indexed buffer, which must outlive the index.
+     * @tparam  MaxInterfaces  Capacity for interface descriptors (counting every alternate setting)
+     * @tparam  MaxEndpoints  Capacity for endpoint descriptors across all interfaces
+     * @code
+     *   usbstd::helper::ConfigurationIndex<> index;
+     *   if (index.build(buffer))
+     *   {
+     *       const auto* dataInterface = index.find(1, 0);
+     *       for (auto endpoint : index.endpoints(*dataInterface))
+     *           ...
+     *   }
+     * @endcode
+    */
+    template<size_t MaxInterfaces = 32, size_t MaxEndpoints = 32>
+    class ConfigurationIndex
+    {
+    public:
+        static constexpr uint8_t NoAssociation = 0xff;
+
+        struct Interface
+        {
+            uint16_t offset; ///< Offset of the interface descriptor
+            uint16_t extraOffset; ///< Offset of the first class-specific descriptor following the interface
+            uint16_t extraLength; ///< Length of class-specific descriptors preceding the first endpoint or next interface
+            uint8_t firstEndpoint; ///< Index into the endpoint table
+            uint8_t endpointCount; ///< Number of endpoint descriptors following the interface
+            uint8_t association; ///< Index of the enclosing interface association, or `NoAssociation`
+        };
+
+        /** Index the given buffer, replacing any previous content
+         * @return `false` when the buffer is malformed, is not a configuration, or exceeds the index capacity
+        */
+        bool build(Span<const uint8_t> bytes)
+        {
+            bytes_ = bytes;
+            interfaceCount_ = endpointCount_ = associationCount_ = 0;
+
+            const DescriptorRange range{ bytes };
+            auto it = range.begin();
+            if ((it == range.end()) || !(*it).is<ConfigurationDescriptor>())
+                return false;
+
+            Interface* current = nullptr;
+            uint8_t association = NoAssociation;
+            uint8_t associationEnd = 0;
+            for (++it; it != range.end(); ++it)
+            {
+                const auto descriptor = *it;
+                const auto offset = static_cast<uint16_t>(descriptor.bytes().data() - bytes.data());
+
+                if (const auto* iad = descriptor.as<InterfaceAssociationDescriptor>())
+                {
+                    if (associationCount_ == MaxAssociations)
+                        return false;
+                    association = static_cast<uint8_t>(associationCount_);
+                    associationEnd = iad->data.bFirstInterface + iad->data.bInterfaceCount;
+                    associations_[associationCount_++] = offset;
+                    current = nullptr;
+                }
+                else if (const auto* interface = descriptor.as<InterfaceDescriptor>())
+                {
+                    if (interfaceCount_ == MaxInterfaces)
+                        return false;
+                    if ((association != NoAssociation) && (interface->data.bInterfaceNumber >= associationEnd))
+                        association = NoAssociation;
+                    current = &interfaces_[interfaceCount_++];
+                    *current = { offset, static_cast<uint16_t>(offset + descriptor.length()), 0
+                        , static_cast<uint8_t>(endpointCount_), 0, association };
+                }
+                else if (descriptor.is<EndpointDescriptor>())
+                {
+                    if ((current == nullptr) || (endpointCount_ == MaxEndpoints))
+                        return false;
+                    endpoints_[endpointCount_++] = offset;
+                    ++current->endpointCount;
+                }
+                else if ((current != nullptr) && (current->endpointCount == 0))
+                {
+                    current->extraLength = static_cast<uint16_t>(current->extraLength + descriptor.length());
+                }
+            }
+            return !it.malformed();
+        }
+
+        /** Point the index at an identical copy of the indexed buffer, without re-walking it
+         * Entries are offsets and the index is trivially copyable, so it can be persisted and rebound, see `host::DescriptorCache`.
+         * Counts and offsets are bounds-checked against `bytes`, so an index image corrupted in storage cannot make the
+         * accessors read outside `bytes`.
+         * @return `false` when an entry does not fit `bytes`; the index must then be rebuilt with `build()` before use
+        */
+        bool rebind(Span<const uint8_t> bytes)
+        {
+            bytes_ = bytes;
+            if ((interfaceCount_ > MaxInterfaces) || (endpointCount_ > MaxEndpoints) || (associationCount_ > MaxAssociations))
+                return false;
+
+            // Maxima without early exits, the check runs on every cache hit
+            size_t end = sizeof(ConfigurationDescriptor);
+            size_t endpointEnd = 0;
+            bool associated = true;
+            for (size_t i = 0; i < interfaceCount_; ++i)
+            {
+                const Interface& entry = interfaces_[i];
+                end = max(end, size_t(entry.offset) + sizeof(InterfaceDescriptor));
+                end = max(end, size_t(entry.extraOffset) + entry.extraLength);
+                endpointEnd = max(endpointEnd, size_t(entry.firstEndpoint) + entry.endpointCount);
+                associated &= (entry.association == NoAssociation) | (entry.association < associationCount_);
+            }
+            for (size_t i = 0; i < endpointCount_; ++i)
+                end = max(end, size_t(endpoints_[i]) + sizeof(EndpointDescriptor));
+            for (size_t i = 0; i < associationCount_; ++i)
+                end = max(end, size_t(associations_[i]) + sizeof(InterfaceAssociationDescriptor));
+            return (end <= bytes.size()) && (endpointEnd <= endpointCount_) && associated;
+        }
+
+        Span<const uint8_t> bytes() const { return bytes_; }
+
+        const ConfigurationDescriptor* configuration() const { return reinterpret_cast<const ConfigurationDescriptor*>(bytes_.data()); }
+
+        Span<const Interface> interfaces() const { return { interfaces_, interfaceCount_ }; }
+
+        /** Find an interface by number and alternate setting
+         * @return Interface entry, or `nullptr` if not present
+        */
+        const Interface* find(uint8_t interfaceNumber, uint8_t alternateSetting = 0) const
+        {
+            for (const auto& entry : interfaces())
+            {
+                const auto& data = descriptor(entry)->data;
+                if ((data.bInterfaceNumber == interfaceNumber) && (data.bAlternateSetting == alternateSetting))
+                    return &entry;
+            }
+            return nullptr;
+        }
+
+        /** Find the endpoint descriptor with the given `bEndpointAddress` in any interface
+        */
+        const EndpointDescriptor* findEndpoint(uint8_t endpointAddress) const
+        {
+            for (size_t i = 0; i < endpointCount_; ++i)
+            {
+                const auto* endpoint = endpointAt(i);
+                if (endpoint->data.bEndpointAddress == endpointAddress)
+                    return endpoint;
+            }
+            return nullptr;
+        }
+
+        const InterfaceDescriptor* descriptor(const Interface& entry) const
+        {
+            return reinterpret_cast<const InterfaceDescriptor*>(bytes_.data() + entry.offset);
+        }
+
+        const InterfaceAssociationDescriptor* association(const Interface& entry) const
+        {
+            return (entry.association == NoAssociation) ? nullptr
+                : reinterpret_cast<const InterfaceAssociationDescriptor*>(bytes_.data() + associations_[entry.association]);
+        }
+
+        /** Class-specific descriptors between the interface and its first endpoint, e.g. CDC functional descriptors
+        */
+        DescriptorRange classSpecific(const Interface& entry) const
+        {
+            return Span<const uint8_t>{ bytes_.data() + entry.extraOffset, entry.extraLength };
+        }
+
+        /** Endpoint descriptors of the interface, in descriptor order
+        */
+        class Endpoints
+        {
+        public:
+            class iterator
+            {
+            public:
+                iterator(const ConfigurationIndex* index, size_t position) : index_(index), position_(position) {}
+                const EndpointDescriptor* operator*() const { return index_->endpointAt(position_); }
+                iterator& operator++() { ++position_; return *this; }
+                bool operator!=(const iterator& other) const { return position_ != other.position_; }
+                bool operator==(const iterator& other) const { return position_ == other.position_; }
+            private:
+                const ConfigurationIndex* index_;
+                size_t position_;
+            };
+
+            iterator begin() const { return { index_, first_ }; }
+            iterator end() const { return { index_, first_ + count_ }; }
+            size_t size() const { return count_; }
+            const EndpointDescriptor* operator[](size_t i) const { return index_->endpointAt(first_ + i); }
+
+        private:
+            friend class ConfigurationIndex;
+            Endpoints(const ConfigurationIndex* index, size_t first, size_t count) : index_(index), first_(first), count_(count) {}
+            const ConfigurationIndex* index_;
+            size_t first_;
+            size_t count_;
+        };
+
+        Endpoints endpoints(const Interface& entry) const { return { this, entry.firstEndpoint, entry.endpointCount }; }
+
+    private:
+        static constexpr size_t MaxAssociations = MaxInterfaces;
+        static_assert(MaxEndpoints <= 0xff, "Endpoint index is stored in uint8_t");
+
+        static constexpr size_t max(size_t a, size_t b) { return (a < b) ? b : a; }
+
+        const EndpointDescriptor* endpointAt(size_t i) const
+        {
+            return reinterpret_cast<const EndpointDescriptor*>(bytes_.data() + endpoints_[i]);
+        }
+
+        Span<const uint8_t> bytes_;
+        Interface interfaces_[MaxInterfaces] = {};
+        uint16_t endpoints_[MaxEndpoints] = {};
+        uint16_t associations_[MaxAssociations] = {};
+        size_t interfaceCount_ = 0;
+        size_t endpointCount_ = 0;
+        size_t associationCount_ = 0;
+    };
+
+} //END: helper
+} //END: usbstd
\ No newline at end of file
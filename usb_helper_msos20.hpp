@@ -0,0 +1,228 @@
+#pragma once
+
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t, uint32_t
+#include <type_traits> //< std::false_type, std::true_type, std::decay_t
+
+#include "usb_bos.hpp" //< usbstd::usb_ms_os_20_*, usbstd::usb_bos_ms_os_20_descriptor_t
+#include "usb_helper_descriptorlist.hpp" //< usbstd::helper::DescriptorList, usbstd::helper::makeDescriptorList
+
+namespace usbstd {
+namespace helper {
+
+    /** Compile-time assembler for Microsoft OS 2.0 descriptor sets
+     * A set is described by nesting typed elements; every `wLength`, `wSubsetLength` and `wTotalLength` is computed from
+     * the packed size of what it contains, so the set is one ROM blob answered without runtime work:
+     * @code
+     *   using namespace usbstd::helper;
+     *   static constexpr auto msOs20Set = msos20::descriptorSet(
+     *       msos20::configuration(0,
+     *           msos20::function(2, msos20::compatibleId("WINUSB"), msos20::deviceInterfaceGuids(u"{975F44D9-0D08-43FD-8B3E-127CA8AFFF9D}")) ));
+     *
+     *   static constexpr auto usbBos = makeBos(msos20::capability(msOs20Set, VendorCode));
+     *
+     *   // Vendor request bRequest == VendorCode, wIndex == MS_OS_20_DESCRIPTOR_INDEX:
+     *   return { msOs20Set.data(), msOs20Set.size() };
+     * @endcode
+    */
+namespace msos20 {
+
+    constexpr uint32_t Windows81 = 0x06030000; ///< Minimum `dwWindowsVersion` supporting MS OS 2.0 descriptors
+
+    /// `platformCapabilityUUID` of the MS OS 2.0 platform capability, {D8DD60DF-4589-4CC7-9CD2-659D9E648A9F} in little-endian format
+    inline constexpr uint8_t PlatformUuid[16] = { 0xdf, 0x60, 0xdd, 0xd8, 0x89, 0x45, 0xc7, 0x4c, 0x9c, 0xd2, 0x65, 0x9d, 0x9e, 0x64, 0x8a, 0x9f };
+
+    /// @{ Element classification, to reject misplaced elements at compile time
+    template<typename T>
+    struct IsFeature : std::false_type {};
+
+    template<>
+    struct IsFeature<usb_ms_os_20_compatible_id_descriptor_t> : std::true_type {};
+
+    template<>
+    struct IsFeature<usb_ms_os_20_ccgp_device_descriptor_t> : std::true_type {};
+
+    template<size_t NameLength, size_t DataLength>
+    struct IsFeature<usb_ms_os_20_registry_property_t<NameLength, DataLength>> : std::true_type {};
+
+    template<typename List_t, typename Header_t>
+    struct IsSubset : std::false_type {};
+
+    template<typename... Elements_t, typename Header_t>
+    struct IsSubset<DescriptorList<Elements_t...>, Header_t> : std::is_same<decltype(DescriptorList<Elements_t...>::head), Header_t> {};
+
+    template<typename T>
+    using IsFunction = IsSubset<T, usb_ms_os_20_function_subset_header_t>;
+
+    template<typename T>
+    using IsConfiguration = IsSubset<T, usb_ms_os_20_configuration_subset_header_t>;
+    ///@}
+
+    /** Compatible ID feature, e.g. "WINUSB"
+     * @param compatibleId  Up to 8 ASCII characters
+     * @param subCompatibleId  Up to 8 ASCII characters
+    */
+    template<size_t IdLength, size_t SubIdLength = 1>
+    constexpr usb_ms_os_20_compatible_id_descriptor_t compatibleId(const char(&compatibleId)[IdLength], const char(&subCompatibleId)[SubIdLength] = "")
+    {
+        static_assert((IdLength <= 9) && (SubIdLength <= 9), "Compatible IDs are at most 8 characters");
+
+        usb_ms_os_20_compatible_id_descriptor_t descriptor = {};
+        descriptor.wLength = sizeof(descriptor);
+        descriptor.wDescriptorType = MS_OS_20_FEATURE_COMPATBLE_ID;
+        for (size_t i = 0; i + 1 < IdLength; ++i)
+            descriptor.compatibleID[i] = static_cast<uint8_t>(compatibleId[i]);
+        for (size_t i = 0; i + 1 < SubIdLength; ++i)
+            descriptor.subCompatibleID[i] = static_cast<uint8_t>(subCompatibleId[i]);
+        return descriptor;
+    }
+
+    /** Registry property feature with raw data
+     * @param name  UTF-16 property name, e.g. u"SelectiveSuspendEnabled"
+    */
+    template<size_t NameLength, size_t DataLength>
+    constexpr usb_ms_os_20_registry_property_t<NameLength, DataLength> registryProperty(uint16_t dataType, const char16_t(&name)[NameLength], const uint8_t(&data)[DataLength])
+    {
+        usb_ms_os_20_registry_property_t<NameLength, DataLength> descriptor = {};
+        descriptor.wLength = sizeof(descriptor);
+        descriptor.wDescriptorType = MS_OS_20_FEATURE_REG_PROPERTY;
+        descriptor.wPropertyDataType = dataType;
+        descriptor.wPropertyNameLength = static_cast<uint16_t>(NameLength * sizeof(char16_t));
+        for (size_t i = 0; i < NameLength; ++i)
+            descriptor.PropertyName[i] = static_cast<uint16_t>(name[i]);
+        descriptor.wPropertyDataLength = static_cast<uint16_t>(DataLength);
+        for (size_t i = 0; i < DataLength; ++i)
+            descriptor.PropertyData[i] = data[i];
+        return descriptor;
+    }
+
+    /** REG_SZ (or `dataType`) string registry property, stored as UTF-16LE including the NULL
+    */
+    template<size_t NameLength, size_t ValueLength>
+    constexpr usb_ms_os_20_registry_property_t<NameLength, ValueLength * 2> registryString(const char16_t(&name)[NameLength], const char16_t(&value)[ValueLength], uint16_t dataType = MS_OS_20_REG_SZ)
+    {
+        uint8_t data[ValueLength * 2] = {};
+        for (size_t i = 0; i < ValueLength; ++i)
+        {
+            data[2 * i] = static_cast<uint8_t>(value[i]);
+            data[2 * i + 1] = static_cast<uint8_t>(value[i] >> 8);
+        }
+        return registryProperty(dataType, name, data);
+    }
+
+    /** REG_MULTI_SZ registry property holding a single string, followed by the terminating empty string
+    */
+    template<size_t NameLength, size_t ValueLength>
+    constexpr usb_ms_os_20_registry_property_t<NameLength, (ValueLength + 1) * 2> registryMultiString(const char16_t(&name)[NameLength], const char16_t(&value)[ValueLength])
+    {
+        uint8_t data[(ValueLength + 1) * 2] = {};
+        for (size_t i = 0; i < ValueLength; ++i)
+        {
+            data[2 * i] = static_cast<uint8_t>(value[i]);
+            data[2 * i + 1] = static_cast<uint8_t>(value[i] >> 8);
+        }
+        return registryProperty(MS_OS_20_REG_MULTI_SZ, name, data);
+    }
+
+    /** REG_DWORD_LITTLE_ENDIAN registry property
+    */
+    template<size_t NameLength>
+    constexpr usb_ms_os_20_registry_property_t<NameLength, 4> registryDword(const char16_t(&name)[NameLength], uint32_t value)
+    {
+        const uint8_t data[4] = { static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24) };
+        return registryProperty(MS_OS_20_REG_DWORD_LITTLE_ENDIAN, name, data);
+    }
+
+    /** "DeviceInterfaceGUIDs" property, giving WinUSB interfaces a GUID applications can open them by
+     * @param guid  Braced GUID, e.g. u"{975F44D9-0D08-43FD-8B3E-127CA8AFFF9D}"
+    */
+    template<size_t GuidLength>
+    constexpr auto deviceInterfaceGuids(const char16_t(&guid)[GuidLength])
+    {
+        static_assert(GuidLength == 39, "Expected a braced GUID of 38 characters");
+        return registryMultiString(u"DeviceInterfaceGUIDs", guid);
+    }
+
+    constexpr usb_ms_os_20_ccgp_device_descriptor_t ccgpDevice()
+    {
+        return { sizeof(usb_ms_os_20_ccgp_device_descriptor_t), MS_OS_20_FEATURE_CCGP_DEVICE };
+    }
+
+    /** Function subset: features applying to the function starting at interface `firstInterface`
+    */
+    template<typename... Features_t>
+    constexpr auto function(uint8_t firstInterface, const Features_t&... features)
+    {
+        static_assert(sizeof...(Features_t) > 0, "A function subset requires at least one feature");
+        static_assert((IsFeature<Features_t>::value && ...), "A function subset only contains feature descriptors");
+
+        const usb_ms_os_20_function_subset_header_t header = { sizeof(usb_ms_os_20_function_subset_header_t), MS_OS_20_SUBSET_HEADER_FUNCTION, firstInterface, 0, 0 };
+        auto list = makeDescriptorList(header, features...);
+        static_assert(decltype(list)::size() <= UINT16_MAX, "Function subset exceeds wSubsetLength range");
+        list.head.wSubsetLength = static_cast<uint16_t>(list.size());
+        return list;
+    }
+
+    /** Configuration subset: features and function subsets applying to one configuration
+     * @param configurationIndex  Zero-based index of the configuration, not its `bConfigurationValue`
+    */
+    template<typename... Elements_t>
+    constexpr auto configuration(uint8_t configurationIndex, const Elements_t&... elements)
+    {
+        static_assert(sizeof...(Elements_t) > 0, "A configuration subset requires at least one feature or function");
+        static_assert(((IsFeature<Elements_t>::value || IsFunction<Elements_t>::value) && ...), "A configuration subset only contains features and function subsets");
+
+        const usb_ms_os_20_configuration_subset_header_t header = { sizeof(usb_ms_os_20_configuration_subset_header_t), MS_OS_20_SUBSET_HEADER_CONFIGURATION, configurationIndex, 0, 0 };
+        auto list = makeDescriptorList(header, elements...);
+        static_assert(decltype(list)::size() <= UINT16_MAX, "Configuration subset exceeds wTotalLength range");
+        list.head.wTotalLength = static_cast<uint16_t>(list.size());
+        return list;
+    }
+
+    /** Complete descriptor set: device-wide features followed by configuration subsets
+     * @note Function subsets must be placed in a configuration subset
+    */
+    template<typename... Elements_t>
+    constexpr auto descriptorSetFor(uint32_t windowsVersion, const Elements_t&... elements)
+    {
+        static_assert(sizeof...(Elements_t) > 0, "A descriptor set requires at least one feature or configuration");
+        static_assert(((IsFeature<Elements_t>::value || IsConfiguration<Elements_t>::value) && ...), "A descriptor set only contains features and configuration subsets");
+
+        const usb_ms_os_20_descriptor_set_header_t header = { sizeof(usb_ms_os_20_descriptor_set_header_t), MS_OS_20_SET_HEADER_DESCRIPTOR, windowsVersion, 0 };
+        auto list = makeDescriptorList(header, elements...);
+        static_assert(decltype(list)::size() <= UINT16_MAX, "Descriptor set exceeds wTotalLength range");
+        list.head.wTotalLength = static_cast<uint16_t>(list.size());
+        return list;
+    }
+
+    template<typename... Elements_t>
+    constexpr auto descriptorSet(const Elements_t&... elements)
+    {
+        return descriptorSetFor(Windows81, elements...);
+    }
+
+    /** BOS platform capability announcing `set`, for `makeBos()`
+     * @param vendorCode  `bRequest` of the vendor request the host retrieves the set with
+     * @param altEnumCode  Non-zero when the device supports alternate enumeration
+    */
+    template<typename Set_t>
+    constexpr usb_bos_ms_os_20_descriptor_t capability(const Set_t& set, uint8_t vendorCode, uint8_t altEnumCode = 0)
+    {
+        static_assert(IsSubset<Set_t, usb_ms_os_20_descriptor_set_header_t>::value, "Expected a descriptor set");
+
+        usb_bos_ms_os_20_descriptor_t descriptor = {};
+        descriptor.platform.bLength = sizeof(descriptor);
+        descriptor.platform.bDescriptorType = static_cast<uint8_t>(DescriptorType::DeviceCapability);
+        descriptor.platform.bDevCapabilityType = static_cast<uint8_t>(DeviceCapabilityType::Platform);
+        for (size_t i = 0; i < sizeof(PlatformUuid); ++i)
+            descriptor.platform.platformCapabilityUUID[i] = PlatformUuid[i];
+        descriptor.capability.dwWindowsVersion = set.head.dwWindowsVersion;
+        descriptor.capability.wMSOSDescriptorSetTotalLength = set.head.wTotalLength;
+        descriptor.capability.bMS_VendorCode = vendorCode;
+        descriptor.capability.bAltEnumCode = altEnumCode;
+        return descriptor;
+    }
+
+} //END: msos20
+} //END: helper
+} //END: usbstd
\ No newline at end of file
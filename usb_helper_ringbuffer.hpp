@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic> //< std::atomic
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t
+#include <cstring> //< std::memcpy
+
+#include "usb_span.hpp" //< usbstd::Span
+
+/** Cache-line size used to keep producer and consumer state apart, override for the target if required
+*/
+#ifndef USBSTD_CACHE_LINE_SIZE
+#define USBSTD_CACHE_LINE_SIZE 64
+#endif
+
+namespace usbstd {
+namespace helper {
+
+    /** Region of a ring buffer that may wrap around the end of the storage
+     * `second` is empty unless the region wraps.
+    */
+    template<typename T>
+    struct SplitSpan
+    {
+        Span<T> first;
+        Span<T> second;
+
+        constexpr size_t size() const { return first.size() + second.size(); }
+        constexpr bool empty() const { return size() == 0; }
+    };
+
+    /** Wait-free single-producer/single-consumer ring buffer
+     * Producer and consumer work in place: the producer reserves free space, fills it (e.g. by DMA) and commits it;
+     * the consumer peeks at filled space, processes it and consumes it. Neither side blocks or copies.
+     * Indices are free-running, so the buffer holds up to `Capacity` elements, and only atomic loads/stores are used.
+     * @note Exactly one context may call producer functions and exactly one context consumer functions, e.g. ISR and main loop
+     * @tparam  Capacity  Storage size in elements, must be a power of two
+     * @tparam  T  Element type
+     * @code
+     *   static usbstd::helper::SpscRingBuffer<1024> rxRing;
+     *
+     *   // ISR: receive straight into the ring
+     *   auto space = rxRing.reserve();
+     *   const size_t received = readPacket(space.data(), space.size());
+     *   rxRing.commit(received);
+     *
+     *   // Application
+     *   auto data = rxRing.peek();
+     *   process(data.first); process(data.second);
+     *   rxRing.consume(data.size());
+     * @endcode
+    */
+    template<size_t Capacity, typename T = uint8_t>
+    class SpscRingBuffer
+    {
+        static_assert((Capacity != 0) && ((Capacity & (Capacity - 1)) == 0), "Capacity must be a power of two");
+
+    public:
+        /// @{ Producer
+
+        /** Contiguous free space starting at the write position, up to the end of storage
+        */
+        Span<T> reserve()
+        {
+            const auto free = available();
+            const auto offset = head_.load(std::memory_order_relaxed) & Mask;
+            return { &buffer_[offset], min(free, Capacity - offset) };
+        }
+
+        /** All free space, split in two when it wraps
+        */
+        SplitSpan<T> reserveAll()
+        {
+            const auto free = available();
+            const auto offset = head_.load(std::memory_order_relaxed) & Mask;
+            const auto first = min(free, Capacity - offset);
+            return { { &buffer_[offset], first }, { &buffer_[0], free - first } };
+        }
+
+        /** Publish `count` elements written into reserved space
+        */
+        void commit(size_t count)
+        {
+            head_.store(head_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        }
+
+        /** Copy up to `count` elements into the buffer
+         * @return Number of elements written
+        */
+        size_t write(const T* data, size_t count)
+        {
+            const auto space = reserveAll();
+            count = min(count, space.size());
+            const auto first = min(count, space.first.size());
+            std::memcpy(space.first.data(), data, first * sizeof(T));
+            std::memcpy(space.second.data(), data + first, (count - first) * sizeof(T));
+            commit(count);
+            return count;
+        }
+
+        /** Free space, as seen by the producer
+        */
+        size_t available() const
+        {
+            return Capacity - (head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_acquire));
+        }
+        ///@}
+
+        /// @{ Consumer
+
+        /** All filled space, split in two when it wraps
+        */
+        SplitSpan<const T> peek()
+        {
+            const auto filled = size();
+            const auto offset = tail_.load(std::memory_order_relaxed) & Mask;
+            const auto first = min(filled, Capacity - offset);
+            return { { &buffer_[offset], first }, { &buffer_[0], filled - first } };
+        }
+
+        /** Release `count` elements that have been processed
+        */
+        void consume(size_t count)
+        {
+            tail_.store(tail_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        }
+
+        /** Copy up to `count` elements out of the buffer
+         * @return Number of elements read
+        */
+        size_t read(T* data, size_t count)
+        {
+            const auto filled = peek();
+            count = min(count, filled.size());
+            const auto first = min(count, filled.first.size());
+            std::memcpy(data, filled.first.data(), first * sizeof(T));
+            std::memcpy(data + first, filled.second.data(), (count - first) * sizeof(T));
+            consume(count);
+            return count;
+        }
+
+        /** Filled space, as seen by the consumer
+        */
+        size_t size() const
+        {
+            return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed);
+        }
+        ///@}
+
+        static constexpr size_t capacity() { return Capacity; }
+
+    private:
+        static constexpr size_t Mask = Capacity - 1;
+        static constexpr size_t min(size_t lhs, size_t rhs) { return (lhs < rhs) ? lhs : rhs; }
+
+        /// @note Indices live on separate cache lines so producer and consumer never write to the same line
+        alignas(USBSTD_CACHE_LINE_SIZE) std::atomic<size_t> head_ = { 0 }; ///< Write index, owned by the producer
+        alignas(USBSTD_CACHE_LINE_SIZE) std::atomic<size_t> tail_ = { 0 }; ///< Read index, owned by the consumer
+
+        alignas(USBSTD_CACHE_LINE_SIZE) T buffer_[Capacity] = {};
+    };
+
+} //END: helper
+} //END: usbstd
\ No newline at end of file
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t, uint32_t
+#include <iterator> //< std::size
+#include <type_traits> //< std::remove_cv_t
+
+#include "usb_request.hpp" //< usbstd::Request
+#include "usbstd.hpp" //< USB_RECIPIENT_INTERFACE, USB_RECIPIENT_ENDPOINT
+
+namespace usbstd {
+namespace helper {
+
+    /** Control-request route: the handler for one (type, recipient, bRequest[, wIndex]) tuple
+     * @tparam  Handler_t  Handler type, typically a function pointer; a default constructed `Handler_t` means "no handler"
+    */
+    template<typename Handler_t>
+    struct Route
+    {
+        static constexpr int16_t AnyIndex = -1;
+
+        uint8_t type; ///< `USB_STANDARD_REQUEST`, `USB_CLASS_REQUEST` or `USB_VENDOR_REQUEST`
+        uint8_t recipient; ///< `USB_RECIPIENT_DEVICE`, `USB_RECIPIENT_INTERFACE`, `USB_RECIPIENT_ENDPOINT` or `USB_RECIPIENT_OTHER`
+        uint8_t bRequest; ///< Request code e.g. `USB_GET_DESCRIPTOR`, `USB_CDC_SET_LINE_CODING`
+        Handler_t handler;
+        int16_t index = AnyIndex; /**< [optional] Interface number (or endpoint address) matched against the low byte of `wIndex`
+                                   * Only used for interface and endpoint recipients, `AnyIndex` matches every interface/endpoint
+                                   */
+    };
+
+    /** Compile-time perfect hash of a route table
+     * Keys pack type, recipient, bRequest and optional index into 24 bits, hashed by multiply-shift into a power-of-two table.
+     * The multiplier and table size are searched at compile-time until no two routes collide.
+    */
+    template< auto& routes >
+    struct RouteTableLayout
+    {
+        using Route_t = std::remove_cv_t<std::remove_reference_t<decltype(routes[0])>>;
+
+        static constexpr size_t Count = std::size(routes);
+        static constexpr uint32_t EmptyKey = 0xffffffff;
+        static constexpr uint32_t IndexFlag = 1u << 23;
+
+        static constexpr uint32_t makeKey(uint8_t type, uint8_t recipient, uint8_t bRequest)
+        {
+            return (static_cast<uint32_t>(type & 0x03) << 21) | (static_cast<uint32_t>(recipient & 0x1f) << 16) | (static_cast<uint32_t>(bRequest) << 8);
+        }
+
+        static constexpr uint32_t makeKey(uint8_t type, uint8_t recipient, uint8_t bRequest, uint8_t index)
+        {
+            return makeKey(type, recipient, bRequest) | IndexFlag | index;
+        }
+
+        static constexpr uint32_t key(const Route_t& route)
+        {
+            return (route.index == Route_t::AnyIndex) ? makeKey(route.type, route.recipient, route.bRequest)
+                : makeKey(route.type, route.recipient, route.bRequest, static_cast<uint8_t>(route.index));
+        }
+
+        static constexpr uint32_t hash(uint32_t key, uint32_t multiplier, uint8_t bits)
+        {
+            return (bits == 0) ? 0 : static_cast<uint32_t>(key * multiplier) >> (32 - bits);
+        }
+
+        static constexpr bool unique()
+        {
+            for (size_t i = 0; i < Count; ++i)
+                for (size_t j = i + 1; j < Count; ++j)
+                    if (key(routes[i]) == key(routes[j]))
+                        return false;
+            return true;
+        }
+
+        struct Parameters
+        {
+            uint32_t multiplier;
+            uint8_t bits;
+        };
+
+        static constexpr bool collisionFree(uint32_t multiplier, uint8_t bits)
+        {
+            for (size_t i = 0; i < Count; ++i)
+                for (size_t j = i + 1; j < Count; ++j)
+                    if (hash(key(routes[i]), multiplier, bits) == hash(key(routes[j]), multiplier, bits))
+                        return false;
+            return true;
+        }
+
+        static constexpr Parameters search()
+        {
+            uint8_t bits = 0;
+            while ((size_t{ 1 } << bits) < Count)
+                ++bits;
+
+            for (; bits < 16; ++bits)
+            {
+                for (uint32_t attempt = 0; attempt < 256; ++attempt)
+                {
+                    const uint32_t multiplier = 0x9E3779B1u + (attempt * 0x6A09E668u); //< Odd multipliers from the golden ratio sequence
+                    if (collisionFree(multiplier | 1u, bits))
+                        return { multiplier | 1u, bits };
+                }
+            }
+            return { 0, 0 };
+        }
+
+        struct Entry
+        {
+            uint32_t key;
+            decltype(Route_t::handler) handler;
+        };
+
+        template<size_t Size>
+        struct Table
+        {
+            Entry entries[Size];
+        };
+
+        template<size_t Size>
+        static constexpr Table<Size> build(const Parameters& parameters)
+        {
+            Table<Size> table = {};
+            for (auto& entry : table.entries)
+                entry = { EmptyKey, {} };
+            for (const auto& route : routes)
+                table.entries[hash(key(route), parameters.multiplier, parameters.bits)] = { key(route), route.handler };
+            return table;
+        }
+    };
+
+    /** Constant-time dispatch of SETUP packets to handlers registered in a route table
+     * A request costs at most two table probes: the exact (interface/endpoint) key, then the `AnyIndex` key.
+     * @code
+     *   using Handler = bool(*)(const usbstd::Request&);
+     *   constexpr usbstd::helper::Route<Handler> usbRoutes[] = {
+     *        { usbstd::USB_STANDARD_REQUEST, usbstd::USB_RECIPIENT_DEVICE, usbstd::USB_GET_DESCRIPTOR, getDescriptor }
+     *       ,{ usbstd::USB_STANDARD_REQUEST, usbstd::USB_RECIPIENT_DEVICE, usbstd::USB_SET_CONFIGURATION, setConfiguration }
+     *       ,{ usbstd::USB_CLASS_REQUEST, usbstd::USB_RECIPIENT_INTERFACE, usbstd::USB_CDC_SET_LINE_CODING, setLineCoding, CdcInterface }
+     *   };
+     *   using UsbRouter = usbstd::helper::RequestRouter<usbRoutes>;
+     *
+     *   if (const auto handler = UsbRouter::find(request))
+     *       return handler(request);
+     *   return false; //< STALL
+     * @endcode
+    */
+    template< auto& routes >
+    class RequestRouter
+    {
+        using Layout = RouteTableLayout<routes>;
+        static_assert(Layout::unique(), "Duplicate route in route table");
+
+        static constexpr typename Layout::Parameters parameters_ = Layout::search();
+        static_assert(parameters_.multiplier != 0, "No collision-free hash found for route table");
+
+    public:
+        /** Number of slots in the dispatch table
+        */
+        static constexpr size_t Size = size_t{ 1 } << parameters_.bits;
+
+    private:
+        static constexpr typename Layout::template Table<Size> table_ = Layout::template build<Size>(parameters_);
+
+        static auto probe(uint32_t key)
+        {
+            const auto& entry = table_.entries[Layout::hash(key, parameters_.multiplier, parameters_.bits)];
+            return (entry.key == key) ? entry.handler : decltype(entry.handler){};
+        }
+
+    public:
+        using Handler_t = decltype(Layout::Route_t::handler);
+
+        /** Find the handler for a SETUP packet
+         * @return Handler for the request, or a default constructed `Handler_t` (e.g. `nullptr`) when none is registered
+         * @note `Handler_t` must be contextually convertible to `bool`, `false` meaning "no handler"
+        */
+        static Handler_t find(const Request& request)
+        {
+            const auto type = request.type();
+            const auto recipient = request.recipient();
+            if ((recipient == USB_RECIPIENT_INTERFACE) || (recipient == USB_RECIPIENT_ENDPOINT))
+            {
+                if (const auto handler = probe(Layout::makeKey(type, recipient, request.bRequest, static_cast<uint8_t>(request.wIndex))))
+                    return handler;
+            }
+            return probe(Layout::makeKey(type, recipient, request.bRequest));
+        }
+    };
+
+} //END: helper
+} //END: usbstd
\ No newline at end of file
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <cstddef> //< size_t
+#include <cstdint> //< uint16_t, uint32_t
+#include <iterator> //< std::size
+#include <string_view> //< std::string_view
+
+namespace usbstd {
+namespace helper {
+
+    /** Constexpr UTF-8 decoding to UTF-16 code units
+     * @note Malformed sequences decode to U+FFFD, code points above U+FFFF are emitted as surrogate pairs
+    */
+    struct Utf8
+    {
+        static constexpr char16_t Replacement = 0xFFFD;
+
+        /** Decode the code point starting at `position` and advance `position` past it
+        */
+        static constexpr uint32_t decode(std::string_view string, size_t& position)
+        {
+            const auto lead = static_cast<uint8_t>(string[position++]);
+            size_t trailing = 0;
+            uint32_t codePoint = 0;
+            if (lead < 0x80) { return lead; }
+            else if ((lead & 0xE0) == 0xC0) { trailing = 1; codePoint = lead & 0x1F; }
+            else if ((lead & 0xF0) == 0xE0) { trailing = 2; codePoint = lead & 0x0F; }
+            else if ((lead & 0xF8) == 0xF0) { trailing = 3; codePoint = lead & 0x07; }
+            else { return Replacement; }
+
+            for (; trailing != 0; --trailing)
+            {
+                if ((position == string.size()) || ((static_cast<uint8_t>(string[position]) & 0xC0) != 0x80))
+                    return Replacement;
+                codePoint = (codePoint << 6) | (static_cast<uint8_t>(string[position++]) & 0x3F);
+            }
+            return ((codePoint > 0x10FFFF) || ((codePoint >= 0xD800) && (codePoint <= 0xDFFF))) ? Replacement : codePoint;
+        }
+
+        /** Number of UTF-16 code units required to encode the UTF-8 `string`
+        */
+        static constexpr size_t utf16Length(std::string_view string)
+        {
+            size_t length = 0;
+            for (size_t position = 0; position < string.size(); )
+                length += (decode(string, position) > 0xFFFF) ? 2 : 1;
+            return length;
+        }
+
+        /** Convert the UTF-8 `string` into `destination`, which must hold `utf16Length(string)` code units
+        */
+        static constexpr size_t toUtf16(std::string_view string, char16_t* destination)
+        {
+            size_t length = 0;
+            for (size_t position = 0; position < string.size(); )
+            {
+                const auto codePoint = decode(string, position);
+                if (codePoint > 0xFFFF)
+                {
+                    destination[length++] = static_cast<char16_t>(0xD800 + ((codePoint - 0x10000) >> 10));
+                    destination[length++] = static_cast<char16_t>(0xDC00 + ((codePoint - 0x10000) & 0x3FF));
+                }
+                else
+                {
+                    destination[length++] = static_cast<char16_t>(codePoint);
+                }
+            }
+            return length;
+        }
+    };
+
+    /** Compile-time placement of the strings of a `StringPool`
+     * Strings are placed longest first; a string that already occurs anywhere in the pool (e.g. a repeated string, or a suffix
+     * of another) re-uses that storage, and a string whose prefix matches the end of the pool overlaps it.
+    */
+    template< auto& utf8Strings >
+    struct StringPoolLayout
+    {
+        static constexpr size_t Count = std::size(utf8Strings);
+
+        static constexpr size_t upperBound()
+        {
+            size_t length = 0;
+            for (const auto& string : utf8Strings)
+                length += Utf8::utf16Length(string);
+            return length;
+        }
+
+        static constexpr size_t longest()
+        {
+            size_t length = 0;
+            for (const auto& string : utf8Strings)
+                length = (Utf8::utf16Length(string) > length) ? Utf8::utf16Length(string) : length;
+            return length;
+        }
+
+        /** Pool content in worst-case sized storage, trimmed to `size` by `StringPool`
+        */
+        struct Placement
+        {
+            char16_t words[upperBound() ? upperBound() : 1] = {};
+            size_t size = 0;
+            uint16_t offsets[Count] = {};
+            uint16_t lengths[Count] = {};
+        };
+
+        static constexpr bool matches(const char16_t* lhs, const char16_t* rhs, size_t length)
+        {
+            for (size_t i = 0; i < length; ++i)
+                if (lhs[i] != rhs[i])
+                    return false;
+            return true;
+        }
+
+        static constexpr Placement place()
+        {
+            Placement placement = {};
+
+            size_t order[Count] = {}; //< String indices, longest first
+            for (size_t i = 0; i < Count; ++i)
+            {
+                size_t j = i;
+                for (; (j > 0) && (Utf8::utf16Length(utf8Strings[order[j - 1]]) < Utf8::utf16Length(utf8Strings[i])); --j)
+                    order[j] = order[j - 1];
+                order[j] = i;
+            }
+
+            for (size_t i = 0; i < Count; ++i)
+            {
+                const size_t index = order[i];
+                char16_t string[longest() ? longest() : 1] = {};
+                const size_t length = Utf8::toUtf16(utf8Strings[index], string);
+                placement.lengths[index] = static_cast<uint16_t>(length);
+
+                size_t offset = 0;
+                while ((offset + length <= placement.size) && !matches(&placement.words[offset], string, length))
+                    ++offset;
+
+                if (offset + length > placement.size) //< Not found, overlap with the pool tail where possible
+                {
+                    size_t overlap = (length < placement.size) ? length : placement.size;
+                    while ((overlap != 0) && !matches(&placement.words[placement.size - overlap], string, overlap))
+                        --overlap;
+                    offset = placement.size - overlap;
+                    for (size_t c = overlap; c < length; ++c)
+                        placement.words[placement.size++] = string[c];
+                }
+                placement.offsets[index] = static_cast<uint16_t>(offset);
+            }
+            return placement;
+        }
+
+        /** Pool content trimmed to its final size, plus the compact (offset, length) index
+        */
+        template<size_t Size>
+        struct Storage
+        {
+            char16_t words[Size ? Size : 1];
+            uint16_t offsets[Count];
+            uint16_t lengths[Count];
+        };
+
+        template<size_t Size>
+        static constexpr Storage<Size> trim(const Placement& placement)
+        {
+            Storage<Size> storage = {};
+            for (size_t i = 0; i < Size; ++i)
+                storage.words[i] = placement.words[i];
+            for (size_t i = 0; i < Count; ++i)
+            {
+                storage.offsets[i] = placement.offsets[i];
+                storage.lengths[i] = placement.lengths[i];
+            }
+            return storage;
+        }
+    };
+
+    /** Deduplicated UTF-16 storage for a set of UTF-8 strings, built at compile-time
+     * Each string is referenced through a 4-byte `String` (offset, length) instead of a separately stored literal.
+     * @note `StringDescriptorGenerator` copies from the pool, so the saving carries over; `StringDescriptorTable` builds
+     *  complete descriptors in ROM and shares only strings that are equal, not suffixes or overlaps
+     * @tparam   utf8Strings   Static array of `std::string_view` UTF-8 strings
+     * @code
+     *   constexpr std::string_view usbStrings[] = { "Acme", "Acme Widget", "Acme Widget Gerät", "Widget" };
+     *   using UsbStringPool = usbstd::helper::StringPool<usbStrings>;
+     *
+     *   constexpr usbstd::helper::MultiLanguageStringTable<2, 2, UsbStringPool::String> usbStringTable = {
+     *        { 0x0409, 0x0407 }
+     *       ,{
+     *          { UsbStringPool::at(0), UsbStringPool::at(1) }
+     *         ,{ UsbStringPool::at(0), UsbStringPool::at(2) }
+     *       }
+     *   };
+     * @endcode
+    */
+    template< auto& utf8Strings >
+    class StringPool
+    {
+        using Layout = StringPoolLayout<utf8Strings>;
+
+        static constexpr typename Layout::Placement placement_ = Layout::place();
+        static_assert(placement_.size <= UINT16_MAX, "String pool exceeds 16-bit offsets");
+
+    public:
+        static constexpr size_t Count = Layout::Count;
+
+        /** Number of UTF-16 code units stored after deduplication
+        */
+        static constexpr size_t Size = placement_.size;
+
+    private:
+        static constexpr typename Layout::template Storage<Size> storage_ = Layout::template trim<Size>(placement_);
+
+    public:
+        /** Compact reference to a pooled string, usable as `StringView_t` for `StringTable` and `MultiLanguageStringTable`
+        */
+        struct String
+        {
+            uint16_t offset;
+            uint16_t length_;
+
+            constexpr size_t length() const { return length_; }
+            constexpr size_t size() const { return length_; }
+            constexpr char16_t operator[](size_t i) const { return storage_.words[offset + i]; }
+            constexpr std::u16string_view view() const { return { &storage_.words[offset], length_ }; }
+
+            /** Copy as `std::u16string_view::copy()`
+            */
+            size_t copy(char16_t* destination, size_t count, size_t position = 0) const
+            {
+                return view().copy(destination, count, position);
+            }
+        };
+
+        /** Deduplicated UTF-16 code units
+        */
+        static constexpr const char16_t* words() { return storage_.words; }
+
+        /** Reference to the string at `index` in `utf8Strings`
+        */
+        static constexpr String at(size_t index) { return { storage_.offsets[index], storage_.lengths[index] }; }
+    };
+
+} //END: helper
+} //END: usbstd
\ No newline at end of file
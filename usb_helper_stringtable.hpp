@@ -1,8 +1,12 @@
 #pragma once
 
+#include <algorithm> //< std::max_element
+#include <iterator> //< std::begin, std::end, std::size
 #include <string_view> //< std::u16string_view
+#include <type_traits> //< std::remove_cv_t
 
 #include "usb_descriptor.hpp" //< usbstd::DescriptorHeader
+#include "usb_endian.hpp" //< usbstd::Le16
 
 namespace usbstd {
 namespace helper {
@@ -101,5 +105,250 @@ namespace helper {
         } descriptorBuffer_ = {};
     };
 
+    /** Represents table of default (const) String values for USB-Descriptors in several languages
+     * @note The string at a given index is shared by all languages for `updateFns`, a dynamic string has a single RAM slot
+     * @tparam   Languages      Number of supported languages
+     * @tparam   StringView_t   Type used to store default string values internally
+     * @code
+     *   constexpr usbstd::helper::MultiLanguageStringTable<2, 2> usbStringTable = {
+     *        { 0x0409, 0x0407 } //< English (US), German
+     *       ,{
+     *          { u"Manufacturer", u"Product" }
+     *         ,{ u"Hersteller", u"Produkt" }
+     *       }
+     *   };
+     * @endcode
+    */
+    template<size_t Languages, size_t Count, typename StringView_t = std::u16string_view>
+    struct MultiLanguageStringTable
+    {
+        uint16_t langIds[Languages];
+
+        /** User-provided string per language
+        */
+        StringView_t strings[Languages][Count];
+
+        /** [optional] User-provided string-update function used `StringDescriptorTable::generate()`
+        */
+        uint16_t(*updateFns[Count])(char16_t* const, const uint16_t) = {};
+    };
+
+    /** Uniform access to the languages of `StringTable` and `MultiLanguageStringTable`
+    */
+    template<typename StringTable_t>
+    struct StringTableTraits;
+
+    template<size_t Count_, typename StringView_t>
+    struct StringTableTraits< StringTable<Count_, StringView_t> >
+    {
+        static constexpr size_t Languages = 1;
+        static constexpr size_t Count = Count_;
+
+        static constexpr uint16_t langId(const StringTable<Count_, StringView_t>& table, size_t) { return table.langId; }
+        static constexpr const StringView_t& string(const StringTable<Count_, StringView_t>& table, size_t, size_t index) { return table.strings[index]; }
+    };
+
+    template<size_t Languages_, size_t Count_, typename StringView_t>
+    struct StringTableTraits< MultiLanguageStringTable<Languages_, Count_, StringView_t> >
+    {
+        static constexpr size_t Languages = Languages_;
+        static constexpr size_t Count = Count_;
+
+        static constexpr uint16_t langId(const MultiLanguageStringTable<Languages_, Count_, StringView_t>& table, size_t language) { return table.langIds[language]; }
+        static constexpr const StringView_t& string(const MultiLanguageStringTable<Languages_, Count_, StringView_t>& table, size_t language, size_t index) { return table.strings[language][index]; }
+    };
+
+    /** Compile-time sizes of the string-descriptors in a string table
+    */
+    template< auto& stringTable >
+    struct StringTableLayout
+    {
+        using Traits = StringTableTraits< std::remove_cv_t<std::remove_reference_t<decltype(stringTable)>> >;
+
+        static constexpr size_t maxLength()
+        {
+            size_t length = 0;
+            for (size_t language = 0; language < Traits::Languages; ++language)
+                for (size_t index = 0; index < Traits::Count; ++index)
+                    length = std::max<size_t>(length, Traits::string(stringTable, language, index).length());
+            return length;
+        }
+
+        /** Earlier string (as `language * Count + index`) with the same content, or `language * Count + index` when the first
+        */
+        static constexpr size_t firstOccurrence(size_t language, size_t index)
+        {
+            const auto& string = Traits::string(stringTable, language, index);
+            const size_t key = (language * Traits::Count) + index;
+            for (size_t other = 0; other < key; ++other)
+            {
+                const auto& candidate = Traits::string(stringTable, other / Traits::Count, other % Traits::Count);
+                if (candidate.length() != string.length())
+                    continue;
+                size_t i = 0;
+                while ((i < string.length()) && (candidate[i] == string[i]))
+                    ++i;
+                if (i == string.length())
+                    return other;
+            }
+            return key;
+        }
+
+        /** Words of the language-Id descriptor and of every distinct string-descriptor
+        */
+        static constexpr size_t wordCount()
+        {
+            size_t words = 1 + Traits::Languages; //< Language-Id descriptor
+            for (size_t language = 0; language < Traits::Languages; ++language)
+                for (size_t index = 0; index < Traits::Count; ++index)
+                    if (firstOccurrence(language, index) == (language * Traits::Count) + index)
+                        words += 1 + Traits::string(stringTable, language, index).length();
+            return words;
+        }
+
+        /** Number of strings with an `updateFn`
+        */
+        static constexpr size_t dynamicCount()
+        {
+            size_t count = 0;
+            for (size_t index = 0; index < Traits::Count; ++index)
+                count += (stringTable.updateFns[index] != nullptr) ? 1 : 0;
+            return count;
+        }
+
+        static constexpr uint16_t headerWord(size_t stringLength)
+        {
+            return static_cast<uint16_t>((sizeof(DescriptorHeader) + (stringLength * sizeof(char16_t)))
+                | (static_cast<uint16_t>(DescriptorType::String) << 8));
+        }
+    };
+
+    /** Compile-time image of every string-descriptor in a string table
+     * Descriptors are stored as little-endian 16-bit words: the header word (`bLength`, `bDescriptorType`) followed by the
+     * UTF-16LE string, the USB wire format whatever the target byte order.
+     * Strings with the same content, e.g. a serial number or a brand name shared by several languages, share one descriptor.
+     * @note Each descriptor needs its own header word, so the suffix and overlap sharing of `StringPool` does not carry over:
+     *  a pooled string costs its full length here, and the pool saving applies to `StringDescriptorGenerator` alone
+    */
+    template< auto& stringTable >
+    struct StringDescriptorRom
+    {
+        using Layout = StringTableLayout<stringTable>;
+        using Traits = typename Layout::Traits;
+
+        static constexpr uint8_t NoSlot = 0xff;
+
+        static_assert(sizeof(DescriptorHeader) + (Layout::maxLength() * sizeof(char16_t)) <= UINT8_MAX, "String exceeds maximum string-descriptor length");
+        static_assert(Layout::dynamicCount() < NoSlot, "Too many dynamic strings");
+
+        Le16 words[Layout::wordCount()] = {}; ///< All distinct descriptors back to back, starting with the language-Id descriptor (index 0)
+        uint16_t offsets[Traits::Languages][Traits::Count] = {}; ///< Word offset of each string-descriptor
+        uint8_t slots[Traits::Count] = {}; ///< RAM slot of each string with an `updateFn`, or `NoSlot`
+
+        static constexpr StringDescriptorRom build()
+        {
+            StringDescriptorRom rom = {};
+            size_t word = 0;
+            rom.words[word++] = Layout::headerWord(Traits::Languages);
+            for (size_t language = 0; language < Traits::Languages; ++language)
+                rom.words[word++] = Traits::langId(stringTable, language);
+
+            for (size_t language = 0; language < Traits::Languages; ++language)
+            {
+                for (size_t index = 0; index < Traits::Count; ++index)
+                {
+                    const size_t first = Layout::firstOccurrence(language, index);
+                    if (first != (language * Traits::Count) + index)
+                    {
+                        rom.offsets[language][index] = rom.offsets[first / Traits::Count][first % Traits::Count];
+                        continue;
+                    }
+
+                    const auto& string = Traits::string(stringTable, language, index);
+                    rom.offsets[language][index] = static_cast<uint16_t>(word);
+                    rom.words[word++] = Layout::headerWord(string.length());
+                    for (size_t i = 0; i < string.length(); ++i)
+                        rom.words[word++] = static_cast<uint16_t>(string[i]);
+                }
+            }
+
+            uint8_t slot = 0;
+            for (size_t index = 0; index < Traits::Count; ++index)
+                rom.slots[index] = (stringTable.updateFns[index] != nullptr) ? slot++ : NoSlot;
+            return rom;
+        }
+    };
+
+    /** Provides O(1) lookup of String-descriptors precomputed at compile-time for every supported language
+     * Static strings are returned directly from ROM, so results of back-to-back requests never overwrite each other.
+     * Only strings with an `updateFn` are generated at runtime, each into its own RAM slot.
+     * @code
+     *   static usbstd::helper::StringDescriptorTable<usbStringTable> usbStringDescriptors = {};
+     *
+     *   extern "C" uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid)
+     *   {
+     *       return usbStringDescriptors.generate(index, langid);
+     *   }
+     * @endcode
+    */
+    template< auto& stringTable >
+    class StringDescriptorTable
+    {
+        using Rom_t = StringDescriptorRom<stringTable>;
+        using Layout = typename Rom_t::Layout;
+        using Traits = typename Rom_t::Traits;
+
+        static constexpr Rom_t rom_ = Rom_t::build();
+
+    public:
+        /** Capacity of each dynamic string RAM slot, based on longest string in the `stringTable`
+        */
+        static constexpr size_t Capacity = Layout::maxLength();
+
+        /** Runtime call to retrieve a string-descriptor for the given index and langid
+         * @param index
+         * @param langid
+         * @return Pointer to String-descriptor for requested string, or `nullptr` when the Index of language is not supported
+         * @note Static strings point into ROM; dynamic strings point to a per-index RAM slot updated on each call for that index,
+         *  holding the `updateFn` output in native byte-order as `StringDescriptorGenerator` does
+        */
+        const uint16_t* generate(const uint8_t index, const uint16_t langid)
+        {
+            if (index == 0) //< Special case index==0 returns all supported `langIds`
+                return reinterpret_cast<const uint16_t*>(rom_.words);
+
+            if (index > Traits::Count)
+                return nullptr;
+
+            size_t language = 0;
+            while ((language < Traits::Languages) && (Traits::langId(stringTable, language) != langid))
+                ++language;
+            if (language == Traits::Languages)
+                return nullptr;
+
+            const uint16_t* const descriptor = reinterpret_cast<const uint16_t*>(&rom_.words[rom_.offsets[language][index - 1]]); //< @note Strings are 1-base indexed (0 reserved for language-Id)
+            const auto slot = rom_.slots[index - 1];
+            if (slot == Rom_t::NoSlot)
+                return descriptor;
+
+            auto& buffer = dynamic_[slot];
+            const auto defaultLength = static_cast<uint16_t>(Traits::string(stringTable, language, index - 1).copy(buffer.string, Capacity));
+            const auto updateLength = stringTable.updateFns[index - 1](buffer.string, defaultLength);
+            buffer.header.bLength = static_cast<uint8_t>(sizeof(usbstd::DescriptorHeader) + (updateLength * sizeof(char16_t)));
+            return reinterpret_cast<const uint16_t*>(&buffer);
+        }
+
+    private:
+        struct StringDescriptor
+        {
+            usbstd::DescriptorHeader header = { sizeof(usbstd::DescriptorHeader), usbstd::DescriptorType::String };
+            char16_t string[Capacity] = {};
+        };
+
+        /** RAM slot for each string with an `updateFn`
+        */
+        StringDescriptor dynamic_[Layout::dynamicCount() ? Layout::dynamicCount() : 1] = {};
+    };
+
 } //END: helper
 } //END: usbstd
\ No newline at end of file
@@ -0,0 +1,549 @@
+#pragma once
+
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t, uint32_t, int32_t, uint64_t, int64_t
+#include <cstring> //< std::memcpy
+
+#include "usb_descriptor.hpp" //< usbstd::HidDescriptor, usbstd::DescriptorType
+#include "usb_span.hpp" //< usbstd::Span
+
+namespace usbstd {
+
+    /** HID class requests
+     * @see HID 1.11 specification 7.2
+    */
+    enum
+    {
+        USB_HID_GET_REPORT = 0x01,
+        USB_HID_GET_IDLE = 0x02,
+        USB_HID_GET_PROTOCOL = 0x03,
+        USB_HID_SET_REPORT = 0x09,
+        USB_HID_SET_IDLE = 0x0a,
+        USB_HID_SET_PROTOCOL = 0x0b,
+    };
+
+    /** Report type, high byte of `wValue` of GET_REPORT and SET_REPORT
+    */
+    enum class HidReportType : uint8_t
+    {
+        Input = 1,
+        Output = 2,
+        Feature = 3,
+    };
+
+    enum class HidSubClass : uint8_t
+    {
+        None = 0,
+        Boot = 1, ///< Boot interface, usable by BIOS hosts without parsing the report descriptor
+    };
+
+    /** `bInterfaceProtocol` of a boot interface
+    */
+    enum class HidProtocol : uint8_t
+    {
+        None = 0,
+        Keyboard = 1,
+        Mouse = 2,
+    };
+
+    /** `wValue` of GET_PROTOCOL and SET_PROTOCOL
+    */
+    enum class HidProtocolMode : uint8_t
+    {
+        Boot = 0,
+        Report = 1,
+    };
+
+namespace hid {
+
+    /** Short item prefix with `bSize` cleared: `bTag` in bits 7..4, `bType` in bits 3..2
+     * @see HID 1.11 specification 6.2.2
+    */
+    enum class ItemTag : uint8_t
+    {
+        // Main
+        Input = 0x80,
+        Output = 0x90,
+        Collection = 0xa0,
+        Feature = 0xb0,
+        EndCollection = 0xc0,
+
+        // Global
+        UsagePage = 0x04,
+        LogicalMinimum = 0x14,
+        LogicalMaximum = 0x24,
+        PhysicalMinimum = 0x34,
+        PhysicalMaximum = 0x44,
+        UnitExponent = 0x54,
+        Unit = 0x64,
+        ReportSize = 0x74,
+        ReportId = 0x84,
+        ReportCount = 0x94,
+        Push = 0xa4,
+        Pop = 0xb4,
+
+        // Local
+        Usage = 0x08,
+        UsageMinimum = 0x18,
+        UsageMaximum = 0x28,
+        DesignatorIndex = 0x38,
+        DesignatorMinimum = 0x48,
+        DesignatorMaximum = 0x58,
+        StringIndex = 0x78,
+        StringMinimum = 0x88,
+        StringMaximum = 0x98,
+        Delimiter = 0xa8,
+    };
+
+    /** Input, Output and Feature item data
+     * @see HID 1.11 specification 6.2.2.5
+    */
+    enum MainFlags : uint16_t
+    {
+        Data = 0,
+        Constant = 1 << 0,
+        Array = 0,
+        Variable = 1 << 1,
+        Absolute = 0,
+        Relative = 1 << 2,
+        NoWrap = 0,
+        Wrap = 1 << 3,
+        Linear = 0,
+        NonLinear = 1 << 4,
+        PreferredState = 0,
+        NoPreferred = 1 << 5,
+        NoNullPosition = 0,
+        NullState = 1 << 6,
+        NonVolatile = 0,
+        Volatile = 1 << 7,
+        BitField = 0,
+        BufferedBytes = 1 << 8,
+    };
+
+    enum class CollectionType : uint8_t
+    {
+        Physical = 0,
+        Application = 1,
+        Logical = 2,
+        Report = 3,
+        NamedArray = 4,
+        UsageSwitch = 5,
+        UsageModifier = 6,
+    };
+
+    /** One short item of a report descriptor, encoded by `ReportDescriptor` with the smallest data size holding `value`
+    */
+    struct Item
+    {
+        ItemTag tag;
+        uint32_t value;
+        bool isSigned; ///< `value` is a two's complement `int32_t`, e.g. Logical Minimum
+
+        constexpr size_t dataSize() const
+        {
+            if ((tag == ItemTag::EndCollection) || (tag == ItemTag::Push) || (tag == ItemTag::Pop))
+                return 0;
+            if (isSigned)
+            {
+                const auto signedValue = static_cast<int32_t>(value);
+                return ((signedValue >= -128) && (signedValue <= 127)) ? 1
+                    : ((signedValue >= -32768) && (signedValue <= 32767)) ? 2
+                    : 4;
+            }
+            return (value <= 0xff) ? 1 : (value <= 0xffff) ? 2 : 4;
+        }
+
+        constexpr size_t size() const { return 1 + dataSize(); }
+    };
+
+    /// @{ Report descriptor items, e.g. for `ReportDescriptor`
+    constexpr Item usagePage(uint16_t page) { return { ItemTag::UsagePage, page, false }; }
+    constexpr Item usage(uint32_t usage) { return { ItemTag::Usage, usage, false }; } ///< 16-bit usage ID, or usage page and ID in 32 bits
+    constexpr Item usageMinimum(uint32_t usage) { return { ItemTag::UsageMinimum, usage, false }; }
+    constexpr Item usageMaximum(uint32_t usage) { return { ItemTag::UsageMaximum, usage, false }; }
+    constexpr Item collection(CollectionType type) { return { ItemTag::Collection, static_cast<uint32_t>(type), false }; }
+    constexpr Item endCollection() { return { ItemTag::EndCollection, 0, false }; }
+    constexpr Item logicalMinimum(int32_t value) { return { ItemTag::LogicalMinimum, static_cast<uint32_t>(value), true }; }
+    constexpr Item logicalMaximum(int32_t value) { return { ItemTag::LogicalMaximum, static_cast<uint32_t>(value), true }; }
+    constexpr Item physicalMinimum(int32_t value) { return { ItemTag::PhysicalMinimum, static_cast<uint32_t>(value), true }; }
+    constexpr Item physicalMaximum(int32_t value) { return { ItemTag::PhysicalMaximum, static_cast<uint32_t>(value), true }; }
+    constexpr Item unitExponent(int32_t exponent) { return { ItemTag::UnitExponent, static_cast<uint32_t>(exponent), true }; }
+    constexpr Item unit(uint32_t unit) { return { ItemTag::Unit, unit, false }; }
+    constexpr Item reportSize(uint32_t bits) { return { ItemTag::ReportSize, bits, false }; }
+    constexpr Item reportCount(uint32_t count) { return { ItemTag::ReportCount, count, false }; }
+    constexpr Item reportId(uint8_t id) { return { ItemTag::ReportId, id, false }; }
+    constexpr Item push() { return { ItemTag::Push, 0, false }; }
+    constexpr Item pop() { return { ItemTag::Pop, 0, false }; }
+    constexpr Item input(uint16_t flags) { return { ItemTag::Input, flags, false }; } ///< `MainFlags`
+    constexpr Item output(uint16_t flags) { return { ItemTag::Output, flags, false }; }
+    constexpr Item feature(uint16_t flags) { return { ItemTag::Feature, flags, false }; }
+    ///@}
+
+    /** Encoding of an `Item` array at compile-time, see `ReportDescriptor`
+    */
+    template< auto& items >
+    struct ReportDescriptorLayout
+    {
+        static constexpr size_t size()
+        {
+            size_t size = 0;
+            for (const auto& item : items)
+                size += item.size();
+            return size;
+        }
+
+        template<size_t Size>
+        struct Storage
+        {
+            uint8_t bytes[Size];
+        };
+
+        template<size_t Size>
+        static constexpr Storage<Size> encode()
+        {
+            Storage<Size> storage = {};
+            size_t position = 0;
+            for (const auto& item : items)
+            {
+                const size_t dataSize = item.dataSize();
+                storage.bytes[position++] = static_cast<uint8_t>(static_cast<uint8_t>(item.tag) | ((dataSize == 4) ? 3 : dataSize));
+                for (size_t i = 0; i < dataSize; ++i)
+                    storage.bytes[position++] = static_cast<uint8_t>(item.value >> (8 * i));
+            }
+            return storage;
+        }
+    };
+
+    /** HID report descriptor encoded at compile-time
+     * @code
+     *   static constexpr usbstd::hid::Item mouseItems[] = {
+     *       usagePage(0x01), usage(0x02), collection(CollectionType::Application),
+     *           ...
+     *       endCollection() };
+     *   using MouseReport = usbstd::hid::ReportDescriptor<mouseItems>;
+     *
+     *   static constexpr auto hidDescriptor = MouseReport::descriptor();
+     *   // GET_DESCRIPTOR(HidReport): send MouseReport::bytes()
+     * @endcode
+    */
+    template< auto& items >
+    class ReportDescriptor
+    {
+        using Layout = ReportDescriptorLayout<items>;
+
+    public:
+        static constexpr size_t Size = Layout::size();
+        static_assert(Size <= UINT16_MAX, "Report descriptor exceeds wDescriptorLength");
+
+    private:
+        static constexpr typename Layout::template Storage<Size> storage_ = Layout::template encode<Size>();
+
+    public:
+        static constexpr const uint8_t* data() { return storage_.bytes; }
+        static constexpr Span<const uint8_t> bytes() { return { storage_.bytes, Size }; }
+
+        /** HID class descriptor announcing this report descriptor, placed after the interface descriptor
+        */
+        static constexpr HidDescriptor descriptor(uint8_t bCountryCode = 0)
+        {
+            HidDescriptor descriptor = {};
+            descriptor.data = { 0x0111, bCountryCode, 1, DescriptorType::HidReport, static_cast<uint16_t>(Size) };
+            return descriptor;
+        }
+    };
+
+    /** One data field of a report, produced by `ReportLayout::parse()`
+    */
+    struct ReportField
+    {
+        uint32_t usage; ///< Usage page in the high word and usage ID in the low word; for array fields the first usage of the range
+        uint32_t bitOffset; ///< From the start of the report as transferred, i.e. including the report ID byte when report IDs are used
+        uint8_t  bitSize;
+        uint8_t  reportId;
+        HidReportType type;
+        uint16_t flags; ///< `MainFlags` of the main item
+        int32_t  logicalMinimum;
+        int32_t  logicalMaximum;
+
+        constexpr bool isSigned() const { return logicalMinimum < 0; }
+        constexpr bool isArray() const { return (flags & Variable) == 0; }
+    };
+
+    /** Flat table of the fields of all reports of a report descriptor
+     * Parsing happens once, at compile-time for a device's own descriptor or when a host first sees a device; reports are
+     * then decoded with a `ReportExtractor` instead of walking the items again.
+     * @note Constant (padding) fields and fields wider than 32 bits take up space in the report but are not listed
+     * @tparam  MaxFields  Capacity of the field table
+     * @tparam  MaxReports  Number of distinct (report ID, report type) pairs tracked
+    */
+    template<size_t MaxFields, size_t MaxReports = 16>
+    struct ReportLayout
+    {
+        struct Report
+        {
+            uint8_t  id;
+            HidReportType type;
+            uint32_t bits; ///< Report length in bits, including the report ID byte
+        };
+
+        ReportField fields[MaxFields] = {};
+        size_t count = 0;
+        Report reports[MaxReports] = {};
+        size_t reportCount = 0;
+        bool usesReportIds = false;
+        bool valid = false; ///< `false` when the descriptor is malformed or exceeds `MaxFields` or `MaxReports`
+
+        /** Length in bytes of a report as transferred, including the report ID byte
+         * @return 0 for an unknown report
+        */
+        constexpr size_t reportBytes(uint8_t reportId, HidReportType type = HidReportType::Input) const
+        {
+            for (size_t i = 0; i < reportCount; ++i)
+            {
+                if ((reports[i].id == reportId) && (reports[i].type == type))
+                    return (reports[i].bits + 7) / 8;
+            }
+            return 0;
+        }
+
+        static constexpr ReportLayout parse(Span<const uint8_t> descriptor)
+        {
+            constexpr size_t MaxUsages = 32;
+            constexpr size_t StackDepth = 4;
+
+            struct Globals
+            {
+                uint32_t usagePage = 0;
+                int32_t  logicalMinimum = 0;
+                int32_t  logicalMaximum = 0;
+                uint32_t logicalMaximumUnsigned = 0;
+                uint32_t reportSize = 0;
+                uint32_t reportCount = 0;
+                uint8_t  reportId = 0;
+            };
+
+            ReportLayout layout;
+            Globals globals;
+            Globals stack[StackDepth] = {};
+            size_t depth = 0;
+
+            uint32_t usages[MaxUsages] = {};
+            size_t usageCount = 0;
+            uint32_t usageMinimum = 0;
+            uint32_t usageMaximum = 0;
+            bool hasRange = false;
+
+            // Usages of up to 16 bits take the Usage Page current at the main item
+            auto fullUsage = [&](uint32_t value, size_t size) { return (size == 4) ? value : ((globals.usagePage << 16) | value); };
+
+            size_t position = 0;
+            while (position < descriptor.size())
+            {
+                const uint8_t prefix = descriptor[position];
+                if (prefix == 0xfe) //< Long item, no standard long items are defined
+                {
+                    if (position + 1 >= descriptor.size())
+                        return layout;
+                    position += 3 + descriptor[position + 1];
+                    continue;
+                }
+
+                const size_t size = ((prefix & 0x03) == 3) ? 4 : (prefix & 0x03);
+                if (position + 1 + size > descriptor.size())
+                    return layout;
+
+                uint32_t value = 0;
+                for (size_t i = 0; i < size; ++i)
+                    value |= uint32_t(descriptor[position + 1 + i]) << (8 * i);
+                const uint32_t signBit = (size == 0) ? 0 : (uint32_t(1) << (8 * size - 1));
+                const int32_t signedValue = (size == 4) ? static_cast<int32_t>(value) : (static_cast<int32_t>(value ^ signBit) - static_cast<int32_t>(signBit));
+                position += 1 + size;
+
+                const auto tag = static_cast<ItemTag>(prefix & 0xfc);
+                switch (tag)
+                {
+                case ItemTag::UsagePage: globals.usagePage = value & 0xffff; break;
+                case ItemTag::LogicalMinimum: globals.logicalMinimum = signedValue; break;
+                case ItemTag::LogicalMaximum: globals.logicalMaximum = signedValue; globals.logicalMaximumUnsigned = value; break;
+                case ItemTag::ReportSize: globals.reportSize = value; break;
+                case ItemTag::ReportCount: globals.reportCount = value; break;
+                case ItemTag::ReportId:
+                    globals.reportId = static_cast<uint8_t>(value);
+                    layout.usesReportIds = true;
+                    break;
+                case ItemTag::Push:
+                    if (depth == StackDepth)
+                        return layout;
+                    stack[depth++] = globals;
+                    break;
+                case ItemTag::Pop:
+                    if (depth == 0)
+                        return layout;
+                    globals = stack[--depth];
+                    break;
+
+                case ItemTag::Usage:
+                    if (usageCount < MaxUsages)
+                        usages[usageCount++] = fullUsage(value, size);
+                    break;
+                case ItemTag::UsageMinimum: usageMinimum = fullUsage(value, size); hasRange = true; break;
+                case ItemTag::UsageMaximum: usageMaximum = fullUsage(value, size); hasRange = true; break;
+
+                case ItemTag::Input:
+                case ItemTag::Output:
+                case ItemTag::Feature:
+                {
+                    const auto type = (tag == ItemTag::Input) ? HidReportType::Input
+                        : (tag == ItemTag::Output) ? HidReportType::Output
+                        : HidReportType::Feature;
+
+                    // Find (or start) the report this item extends
+                    size_t report = 0;
+                    while ((report < layout.reportCount) && ((layout.reports[report].id != globals.reportId) || (layout.reports[report].type != type)))
+                        ++report;
+                    if (report == layout.reportCount)
+                    {
+                        if (report == MaxReports)
+                            return layout;
+                        layout.reports[layout.reportCount++] = { globals.reportId, type, (globals.reportId != 0) ? 8u : 0u };
+                    }
+                    uint32_t& bits = layout.reports[report].bits;
+
+                    // Descriptors often encode e.g. a maximum of 255 in one byte, read it unsigned when the minimum is not negative
+                    const int32_t logicalMaximum = ((globals.logicalMinimum >= 0) && (globals.logicalMaximum < globals.logicalMinimum))
+                        ? static_cast<int32_t>(globals.logicalMaximumUnsigned)
+                        : globals.logicalMaximum;
+
+                    const bool variable = (value & Variable) != 0;
+                    if (((value & Constant) == 0) && (globals.reportSize != 0) && (globals.reportSize <= 32))
+                    {
+                        for (uint32_t i = 0; i < globals.reportCount; ++i)
+                        {
+                            if (layout.count == MaxFields)
+                                return layout;
+                            uint32_t fieldUsage = hasRange ? usageMinimum : ((usageCount != 0) ? usages[0] : 0);
+                            if (variable)
+                            {
+                                if (hasRange && (usageMinimum + i <= usageMaximum))
+                                    fieldUsage = usageMinimum + i;
+                                else if (usageCount != 0)
+                                    fieldUsage = usages[(i < usageCount) ? i : (usageCount - 1)];
+                            }
+                            layout.fields[layout.count++] = { fieldUsage, bits + i * globals.reportSize, static_cast<uint8_t>(globals.reportSize)
+                                , globals.reportId, type, static_cast<uint16_t>(value), globals.logicalMinimum, logicalMaximum };
+                        }
+                    }
+                    bits += globals.reportSize * globals.reportCount;
+                }
+                    [[fallthrough]];
+                case ItemTag::Collection:
+                case ItemTag::EndCollection:
+                    usageCount = 0; //< Local items only apply to the next main item
+                    usageMinimum = usageMaximum = 0;
+                    hasRange = false;
+                    break;
+
+                default:
+                    break; //< Physical range, units, designators and strings do not affect the layout
+                }
+            }
+            layout.valid = true;
+            return layout;
+        }
+    };
+
+    /** Readable bytes `ReportExtractor::extract()` requires after the last byte of a field
+     * Each field is read with one unaligned 64-bit load, so report buffers must be sized with `ReportExtractor::bufferSize()`.
+    */
+    constexpr size_t ReportPadding = 8;
+
+    /** Table-driven, branch-free extraction of the fields of one report
+     * The fields are kept as a structure of arrays, and every field costs one load, shift, mask and sign-extension with no
+     * data-dependent branches, so the loop vectorises (with gathers) where the target supports it.
+     * @code
+     *   static constexpr auto layout = usbstd::hid::ReportLayout<16>::parse(MouseReport::bytes());
+     *   static constexpr usbstd::hid::ReportExtractor<16> mouse{ layout, 0 };
+     *
+     *   alignas(8) uint8_t report[mouse.bufferSize()];
+     *   int64_t values[16];
+     *   mouse.extract(report, values);
+     * @endcode
+     * @tparam  MaxFields  Capacity, fields of the report beyond it are not extracted
+    */
+    template<size_t MaxFields>
+    class ReportExtractor
+    {
+    public:
+        constexpr ReportExtractor() = default;
+
+        /** Select the fields of report `reportId` of `type` from `layout`
+        */
+        template<size_t LayoutFields, size_t MaxReports>
+        constexpr ReportExtractor(const ReportLayout<LayoutFields, MaxReports>& layout, uint8_t reportId, HidReportType type = HidReportType::Input)
+        {
+            for (size_t i = 0; (i < layout.count) && (count_ < MaxFields); ++i)
+            {
+                const auto& field = layout.fields[i];
+                if ((field.reportId != reportId) || (field.type != type))
+                    continue;
+                fields_[count_] = field;
+                byteOffset_[count_] = field.bitOffset / 8;
+                shift_[count_] = static_cast<uint8_t>(field.bitOffset % 8);
+                mask_[count_] = (uint64_t(1) << field.bitSize) - 1;
+                signBit_[count_] = field.isSigned() ? (uint64_t(1) << (field.bitSize - 1)) : 0;
+                if (byteOffset_[count_] + ReportPadding > bufferSize_)
+                    bufferSize_ = byteOffset_[count_] + ReportPadding;
+                ++count_;
+            }
+        }
+
+        constexpr size_t size() const { return count_; }
+        constexpr const ReportField& field(size_t index) const { return fields_[index]; }
+
+        /** Smallest readable report buffer, the report followed by padding
+        */
+        constexpr size_t bufferSize() const { return bufferSize_; }
+
+        /** Extract every field of `report`
+         * @param  report  Report as transferred, including the report ID byte, in a buffer of at least `bufferSize()` bytes
+         * @param[out]  values  `size()` values, sign-extended for fields with a negative logical minimum
+        */
+        void extract(const uint8_t* report, int64_t* values) const
+        {
+            for (size_t i = 0; i < count_; ++i)
+            {
+                const uint64_t raw = (load(report + byteOffset_[i]) >> shift_[i]) & mask_[i];
+                values[i] = static_cast<int64_t>((raw ^ signBit_[i]) - signBit_[i]);
+            }
+        }
+
+        /** Extract a single field, as `extract()`
+        */
+        int64_t extract(const uint8_t* report, size_t index) const
+        {
+            const uint64_t raw = (load(report + byteOffset_[index]) >> shift_[index]) & mask_[index];
+            return static_cast<int64_t>((raw ^ signBit_[index]) - signBit_[index]);
+        }
+
+    private:
+        static uint64_t load(const uint8_t* data)
+        {
+            uint64_t word;
+            std::memcpy(&word, data, sizeof(word));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+            word = __builtin_bswap64(word);
+#endif
+            return word;
+        }
+
+        size_t count_ = 0;
+        size_t bufferSize_ = ReportPadding;
+        uint32_t byteOffset_[MaxFields] = {};
+        uint8_t shift_[MaxFields] = {};
+        uint64_t mask_[MaxFields] = {};
+        uint64_t signBit_[MaxFields] = {}; ///< Sign bit of signed fields, 0 for unsigned: `(raw ^ signBit) - signBit` sign-extends without a branch
+        ReportField fields_[MaxFields] = {};
+    };
+
+} //END: hid
+} //END: usbstd
\ No newline at end of file
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cmath> //< std::cos, std::floor, std::sqrt, std::fabs
+#include <cstdint> //< uint8_t, uint32_t, uint64_t, int64_t
+#include <random> //< std::mt19937, std::normal_distribution
+
+#include "usb_audio.hpp" //< usbstd::audio::FeedbackEstimator
+
+namespace usbstd {
+namespace host {
+
+    /** Drifting clock model for an asynchronous audio sink
+     * The host SOF is the time reference. The device sample clock runs `offsetPpm` fast (negative: slow) with a
+     * sinusoidal wander of `wanderPpm`, and the device captures its sample clock counter at SOF with Gaussian jitter.
+    */
+    struct FeedbackSimulationConfig
+    {
+        uint32_t sampleRate = 48000;
+        BusSpeed speed = BusSpeed::Full;
+        double offsetPpm = 150; ///< Static device clock error
+        double wanderPpm = 20; ///< Amplitude of slow device clock drift, e.g. temperature
+        double wanderSeconds = 30; ///< Period of the drift
+        double sofJitterNs = 200; ///< Standard deviation of the SOF to counter capture latency
+        uint8_t tickShift = 8; ///< Device counter ticks per sample, log2 (256 fs MCLK)
+        uint8_t periodLog2 = 3; ///< (Micro)frames per measurement, log2; 3 is 8 ms at full speed, use 6 at high speed
+        uint8_t filterShift = 4;
+        uint8_t gainShift = 10;
+        uint32_t bufferSamples = 192; ///< Sink buffer capacity, the fill target is half of it
+        double seconds = 60;
+        double tolerancePpm = 50; ///< Error bound for convergence
+        uint32_t seed = 1;
+    };
+
+    struct FeedbackSimulationResult
+    {
+        uint64_t frames = 0;
+        uint64_t convergenceFrames = 0; ///< (Micro)frames until the feedback error stays within `tolerancePpm`
+        double rmsPpm = 0; ///< Feedback error after convergence
+        double maxPpm = 0;
+        int64_t fillMin = 0;
+        int64_t fillMax = 0;
+        uint64_t underruns = 0; ///< Samples the sink had to invent
+        uint64_t overruns = 0; ///< Samples the sink had to drop
+
+        bool converged() const { return convergenceFrames < frames; }
+    };
+
+    /** Run `FeedbackEstimator` against the clock model, with the host sending samples as Linux does: the decoded
+     * feedback value is accumulated every (micro)frame and the integer part is sent.
+     * @param trace  Optional `trace(frame, feedbackPpm, errorPpm, fill)` called every (micro)frame
+    */
+    template<typename Trace_t>
+    FeedbackSimulationResult simulateFeedback(const FeedbackSimulationConfig& config, Trace_t&& trace)
+    {
+        constexpr double Pi = 3.14159265358979323846;
+        const bool highSpeed = config.speed >= BusSpeed::High;
+        const double framePeriod = highSpeed ? 125e-6 : 1e-3;
+        const double rate = config.sampleRate * (1 + config.offsetPpm * 1e-6);
+        const double wander = config.sampleRate * config.wanderPpm * 1e-6 * config.wanderSeconds / (2 * Pi);
+        const double ticksPerSample = double(1u << config.tickShift);
+
+        // Samples produced by the device clock by time `t`
+        const auto phase = [&](double t) { return rate * t + wander * (1 - std::cos(2 * Pi * t / config.wanderSeconds)); };
+
+        audio::FeedbackEstimator estimator{ config.sampleRate, config.speed, config.tickShift, config.periodLog2, config.filterShift, config.gainShift };
+        const int64_t target = config.bufferSamples / 2;
+        estimator.target(static_cast<int32_t>(target));
+
+        std::mt19937 random{ config.seed };
+        std::normal_distribution<double> jitter{ 0, config.sofJitterNs * 1e-9 };
+
+        FeedbackSimulationResult result;
+        result.frames = static_cast<uint64_t>(config.seconds / framePeriod);
+        result.fillMin = result.fillMax = target;
+
+        int64_t fill = target;
+        uint32_t accumulator = 0; //< Host fractional samples, Q16.16
+        double sumSquares = 0;
+        uint64_t settled = 0;
+        for (uint64_t frame = 0; frame < result.frames; ++frame)
+        {
+            const double start = frame * framePeriod;
+            const double capture = start + std::fabs(jitter(random));
+            estimator.sof(static_cast<uint32_t>(static_cast<uint64_t>(std::floor(phase(capture) * ticksPerSample))));
+
+            uint8_t payload[4];
+            accumulator += audio::FeedbackEstimator::decode(payload, estimator.encode(payload));
+            const int64_t sent = accumulator >> 16;
+            accumulator &= 0xffff;
+
+            const int64_t consumed = static_cast<int64_t>(std::floor(phase(start + framePeriod)) - std::floor(phase(start)));
+            fill += sent - consumed;
+            if (fill < 0)
+            {
+                result.underruns += static_cast<uint64_t>(-fill);
+                fill = 0;
+            }
+            else if (fill > int64_t(config.bufferSamples))
+            {
+                result.overruns += static_cast<uint64_t>(fill - config.bufferSamples);
+                fill = config.bufferSamples;
+            }
+            result.fillMin = (fill < result.fillMin) ? fill : result.fillMin;
+            result.fillMax = (fill > result.fillMax) ? fill : result.fillMax;
+            estimator.level(static_cast<int32_t>(fill));
+
+            const double actual = phase(start + framePeriod) - phase(start);
+            const double reported = estimator.feedback() / 65536.0;
+            const double errorPpm = (reported / actual - 1) * 1e6;
+            if (std::fabs(errorPpm) > config.tolerancePpm)
+            {
+                result.convergenceFrames = frame + 1;
+                sumSquares = 0;
+                settled = 0;
+                result.maxPpm = 0;
+            }
+            else
+            {
+                sumSquares += errorPpm * errorPpm;
+                ++settled;
+                result.maxPpm = (std::fabs(errorPpm) > result.maxPpm) ? std::fabs(errorPpm) : result.maxPpm;
+            }
+            trace(frame, (reported * 65536.0 / estimator.nominal() - 1) * 1e6, errorPpm, fill);
+        }
+        result.rmsPpm = (settled != 0) ? std::sqrt(sumSquares / settled) : 0;
+        return result;
+    }
+
+    inline FeedbackSimulationResult simulateFeedback(const FeedbackSimulationConfig& config)
+    {
+        return simulateFeedback(config, [](uint64_t, double, double, int64_t) {});
+    }
+
+} //END: host
+} //END: usbstd
\ No newline at end of file
@@ -0,0 +1,346 @@
+#pragma once
+
+#include <atomic> //< std::atomic
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t, uint32_t, uint64_t
+#include <cstring> //< std::memcpy, std::memcmp
+#include <mutex> //< std::mutex, std::lock_guard
+#include <type_traits> //< std::is_trivially_copyable_v
+
+#include <fcntl.h> //< open
+#include <sys/file.h> //< flock
+#include <sys/mman.h> //< mmap, munmap
+#include <sys/stat.h> //< fstat
+#include <unistd.h> //< ftruncate, close
+
+#include "usb_descriptor.hpp" //< usbstd::DeviceDescriptor
+#include "usb_helper_descriptorwalker.hpp" //< usbstd::helper::ConfigurationIndex
+#include "usb_span.hpp" //< usbstd::Span
+
+namespace usbstd {
+namespace host {
+
+    /** Persistent cache of parsed configuration descriptors, shared between processes through a memory-mapped file (POSIX)
+     * Entries are keyed by (`idVendor`, `idProduct`, `bcdDevice`, hash of the device and configuration descriptors) and
+     * hold the descriptors with their pre-walked `Index_t`, so a device seen before is served without walking them again.
+     * Lookups take no locks and may run in any number of processes at once. Inserts are serialised with `flock` and
+     * publish each entry with a release store, so readers see an entry completely or not at all. Entries are never
+     * removed; the file has a fixed size and inserts are skipped once it is full.
+     * @code
+     *   usbstd::host::DescriptorCache<> cache{ "/var/cache/usbstd/descriptors" };
+     *   usbstd::host::DescriptorCache<>::Entry entry;
+     *   if (cache.lookup(device, configuration, entry)) //< Walks and inserts the descriptors on first sight only
+     *       for (const auto& interface : entry.index.interfaces())
+     *           ...
+     * @endcode
+     * @tparam  Index_t  Pre-walked form stored with the descriptors, trivially copyable with `build()` and a `rebind()`
+     *  that checks the stored image against the descriptors; an image failing the check is rebuilt
+    */
+    template<typename Index_t = helper::ConfigurationIndex<>>
+    class DescriptorCache
+    {
+        static_assert(std::is_trivially_copyable_v<Index_t>, "Index_t is stored as a byte image");
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared mappings need address-free atomics");
+
+    public:
+        static constexpr uint32_t Version = 1; ///< Bump on any change of the file layout
+
+        struct Key
+        {
+            uint16_t idVendor;
+            uint16_t idProduct;
+            uint16_t bcdDevice;
+            uint64_t hash; ///< `hash()` of the device and configuration descriptors
+        };
+
+        struct Entry
+        {
+            DeviceDescriptor device;
+            Span<const uint8_t> configuration; ///< Into the mapping when cached, otherwise the bytes passed to `lookup()`
+            Index_t index; ///< Bound to `configuration`
+            bool cached = false; ///< Served from the cache, without walking the descriptors
+        };
+
+        /** Open or create the cache file, check `ready()` for success
+         * @param dataSize  Bytes for entries when creating the file, an existing file keeps its layout
+         * @param slotCount  Hash table size when creating the file, bounds the number of entries
+         * @param readOnly  Only look up, e.g. for processes without write access to the file
+         * @note An existing file with another `Version` or `Index_t` layout is rejected; delete it to start over.
+        */
+        explicit DescriptorCache(const char* path, size_t dataSize = 1024 * 1024, uint32_t slotCount = 4096, bool readOnly = false)
+            : readOnly_(readOnly)
+        {
+            fd_ = ::open(path, readOnly ? O_RDONLY : (O_RDWR | O_CREAT), 0644);
+            if ((fd_ < 0) || (::flock(fd_, readOnly ? LOCK_SH : LOCK_EX) != 0))
+            {
+                close();
+                return;
+            }
+
+            struct stat status = {};
+            bool valid = (::fstat(fd_, &status) == 0);
+            if (valid && (status.st_size == 0) && !readOnly && (slotCount != 0))
+            {
+                // New file, created under the lock so no other process sees it half initialised
+                const size_t size = dataOffset(slotCount) + align(dataSize);
+                valid = (::ftruncate(fd_, off_t(size)) == 0) && map(size);
+                if (valid)
+                {
+                    FileHeader& header = *reinterpret_cast<FileHeader*>(data_);
+                    header.version = Version;
+                    header.slotCount = slotCount;
+                    header.indexSize = sizeof(Index_t);
+                    header.dataSize = align(dataSize);
+                    std::memcpy(header.magic, Magic, sizeof(header.magic));
+                }
+            }
+            else if (valid && (static_cast<size_t>(status.st_size) >= sizeof(FileHeader)))
+            {
+                valid = map(static_cast<size_t>(status.st_size));
+                const FileHeader* header = reinterpret_cast<const FileHeader*>(data_);
+                valid = valid && (std::memcmp(header->magic, Magic, sizeof(header->magic)) == 0) && (header->version == Version)
+                    && (header->indexSize == sizeof(Index_t)) && (header->slotCount != 0)
+                    && (dataOffset(header->slotCount) + header->dataSize == size_);
+            }
+            else
+                valid = false;
+            valid = valid && (header().dataSize >= RecordSize + IndexSize);
+
+            ::flock(fd_, LOCK_UN);
+            if (!valid)
+                close();
+        }
+
+        DescriptorCache(const DescriptorCache&) = delete;
+        DescriptorCache& operator=(const DescriptorCache&) = delete;
+
+        ~DescriptorCache() { close(); }
+
+        bool ready() const { return data_ != nullptr; }
+
+        /// @{ Statistics
+        uint64_t entries() const { return ready() ? header().entries.load(std::memory_order_relaxed) : 0; }
+        uint64_t used() const { return ready() ? header().used.load(std::memory_order_relaxed) : 0; } ///< Entry bytes in use
+        uint64_t capacity() const { return ready() ? header().dataSize : 0; }
+        uint64_t hits() const { return hits_.load(std::memory_order_relaxed); } ///< `lookup()` served from the cache, by this object
+        uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+        ///@}
+
+        /** Hash of the device and configuration descriptors, eight bytes per step
+         * Stored in the file, so changing it needs a new `Version`.
+        */
+        static uint64_t hash(const DeviceDescriptor& device, Span<const uint8_t> configuration)
+        {
+            uint64_t value = 0xcbf29ce484222325ull ^ configuration.size();
+            const auto mix = [&](const uint8_t* bytes, size_t length) {
+                for (; length >= sizeof(uint64_t); bytes += sizeof(uint64_t), length -= sizeof(uint64_t))
+                {
+                    uint64_t word;
+                    std::memcpy(&word, bytes, sizeof(word));
+                    value = (value ^ word) * 0x9e3779b97f4a7c15ull;
+                    value ^= value >> 29;
+                }
+                uint64_t tail = 0;
+                std::memcpy(&tail, bytes, length);
+                value = (value ^ tail ^ (uint64_t(length) << 56)) * 0x9e3779b97f4a7c15ull;
+                value ^= value >> 29;
+            };
+            mix(reinterpret_cast<const uint8_t*>(&device), sizeof(device));
+            mix(configuration.data(), configuration.size());
+            return value;
+        }
+
+        static Key key(const DeviceDescriptor& device, Span<const uint8_t> configuration)
+        {
+            return { device.data.idVendor, device.data.idProduct, device.data.bcdDevice, hash(device, configuration) };
+        }
+
+        /** Find a cached entry, without locks
+         * @return `false` when `key` is not cached
+        */
+        bool find(const Key& key, Entry& entry) const
+        {
+            if (!ready())
+                return false;
+            const Record* record = probe(key, nullptr);
+            if (record == nullptr)
+                return false;
+            // The file is shared and writable: read the length once, and check the index image before trusting its offsets
+            const uint16_t configurationLength = record->configurationLength;
+            const size_t offset = static_cast<size_t>(reinterpret_cast<const uint8_t*>(record) - data_);
+            if (configurationLength > size_ - offset - RecordSize - IndexSize)
+                return false;
+            std::memcpy(&entry.device, &record->device, sizeof(entry.device));
+            std::memcpy(&entry.index, reinterpret_cast<const uint8_t*>(record) + RecordSize, sizeof(Index_t));
+            entry.configuration = { reinterpret_cast<const uint8_t*>(record) + RecordSize + IndexSize, configurationLength };
+            if (!entry.index.rebind(entry.configuration) && !entry.index.build(entry.configuration))
+                return false;
+            entry.cached = true;
+            return true;
+        }
+
+        /** Descriptors of a device: from the cache when seen before, otherwise walked and inserted
+         * @return `false` when the configuration descriptors are malformed
+        */
+        bool lookup(const DeviceDescriptor& device, Span<const uint8_t> configuration, Entry& entry)
+        {
+            const Key deviceKey = key(device, configuration);
+            if (find(deviceKey, entry) && (entry.configuration.size() == configuration.size())
+                && (std::memcmp(entry.configuration.data(), configuration.data(), configuration.size()) == 0))
+            {
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            entry.device = device;
+            entry.configuration = configuration;
+            entry.cached = false;
+            if (!entry.index.build(configuration))
+                return false;
+            if (insert(deviceKey, entry) && find(deviceKey, entry))
+                entry.cached = false; //< Bound to the mapped copy, but walked
+            return true;
+        }
+
+    private:
+        static constexpr char Magic[8] = { 'u', 's', 'b', 's', 't', 'd', 'D', 'C' };
+
+        struct FileHeader
+        {
+            char magic[8]; ///< Written last when creating the file
+            uint32_t version;
+            uint32_t slotCount;
+            uint32_t indexSize; ///< `sizeof(Index_t)`, its capacity changes the layout
+            uint32_t reserved;
+            uint64_t dataSize; ///< Bytes of the entry area
+            std::atomic<uint64_t> used; ///< Bytes of the entry area in use, written under the file lock
+            std::atomic<uint64_t> entries;
+        };
+
+        /// Entry: `Record`, then the `Index_t` image, then the configuration descriptors, each 8-byte aligned
+        struct Record
+        {
+            uint64_t hash;
+            uint16_t idVendor;
+            uint16_t idProduct;
+            uint16_t bcdDevice;
+            uint16_t configurationLength;
+            DeviceDescriptor device;
+            uint8_t reserved[6];
+        };
+
+        static constexpr size_t align(size_t size) { return (size + 7) & ~size_t(7); }
+        static constexpr size_t RecordSize = align(sizeof(Record));
+        static constexpr size_t IndexSize = align(sizeof(Index_t));
+        static constexpr size_t dataOffset(uint32_t slotCount) { return align(sizeof(FileHeader)) + sizeof(uint64_t) * slotCount; }
+
+        const FileHeader& header() const { return *reinterpret_cast<const FileHeader*>(data_); }
+        FileHeader& header() { return *reinterpret_cast<FileHeader*>(data_); }
+
+        /// Slot: file offset of its entry, 0 when empty
+        std::atomic<uint64_t>* slots() const { return reinterpret_cast<std::atomic<uint64_t>*>(data_ + align(sizeof(FileHeader))); }
+
+        /** Entry with `key`, or `nullptr` with `*empty` set to the first free slot on the probe sequence
+        */
+        const Record* probe(const Key& key, std::atomic<uint64_t>** empty) const
+        {
+            const uint32_t slotCount = header().slotCount;
+            const uint64_t mixed = key.hash ^ (uint64_t(key.idVendor) << 32 | uint64_t(key.idProduct) << 16 | key.bcdDevice);
+            size_t index = static_cast<size_t>((mixed * 0x9e3779b97f4a7c15ull) >> 32) % slotCount;
+            for (uint32_t probes = 0; probes < slotCount; ++probes, index = (index + 1 == slotCount) ? 0 : index + 1)
+            {
+                std::atomic<uint64_t>& slot = slots()[index];
+                const uint64_t offset = slot.load(std::memory_order_acquire);
+                if ((offset == 0) || (offset > size_ - RecordSize - IndexSize))
+                {
+                    if (empty != nullptr)
+                        *empty = (offset == 0) ? &slot : nullptr;
+                    return nullptr;
+                }
+                const Record* record = reinterpret_cast<const Record*>(data_ + offset);
+                if ((record->hash == key.hash) && (record->idVendor == key.idVendor) && (record->idProduct == key.idProduct)
+                    && (record->bcdDevice == key.bcdDevice) && (record->configurationLength <= size_ - offset - RecordSize - IndexSize))
+                    return record;
+            }
+            if (empty != nullptr)
+                *empty = nullptr;
+            return nullptr;
+        }
+
+        bool insert(const Key& key, const Entry& entry)
+        {
+            if (!ready() || readOnly_ || (entry.configuration.size() > UINT16_MAX))
+                return false;
+
+            std::lock_guard<std::mutex> threads(insertMutex_); //< flock does not exclude threads sharing the descriptor
+            if (::flock(fd_, LOCK_EX) != 0)
+                return false;
+
+            bool inserted = false;
+            std::atomic<uint64_t>* slot = nullptr;
+            FileHeader& file = header();
+            const uint64_t used = file.used.load(std::memory_order_relaxed);
+            const size_t size = RecordSize + IndexSize + align(entry.configuration.size());
+            if (probe(key, &slot) != nullptr)
+                inserted = true; //< Another process was first
+            else if ((slot != nullptr) && (used + size <= file.dataSize))
+            {
+                const uint64_t offset = dataOffset(file.slotCount) + used;
+                uint8_t* target = data_ + offset;
+
+                Record record = {};
+                record.hash = key.hash;
+                record.idVendor = key.idVendor;
+                record.idProduct = key.idProduct;
+                record.bcdDevice = key.bcdDevice;
+                record.configurationLength = static_cast<uint16_t>(entry.configuration.size());
+                record.device = entry.device;
+                std::memcpy(target, &record, sizeof(record));
+
+                Index_t image = entry.index;
+                static_cast<void>(image.rebind({})); //< No pointers into this process in the file
+                std::memcpy(target + RecordSize, &image, sizeof(image));
+                std::memcpy(target + RecordSize + IndexSize, entry.configuration.data(), entry.configuration.size());
+
+                file.used.store(used + size, std::memory_order_relaxed);
+                file.entries.fetch_add(1, std::memory_order_relaxed);
+                slot->store(offset, std::memory_order_release);
+                inserted = true;
+            }
+            ::flock(fd_, LOCK_UN);
+            return inserted;
+        }
+
+        bool map(size_t size)
+        {
+            void* data = ::mmap(nullptr, size, readOnly_ ? PROT_READ : (PROT_READ | PROT_WRITE), MAP_SHARED, fd_, 0);
+            if (data == MAP_FAILED)
+                return false;
+            data_ = static_cast<uint8_t*>(data);
+            size_ = size;
+            return true;
+        }
+
+        void close()
+        {
+            if (data_ != nullptr)
+                ::munmap(data_, size_);
+            if (fd_ >= 0)
+                ::close(fd_);
+            data_ = nullptr;
+            size_ = 0;
+            fd_ = -1;
+        }
+
+        int fd_ = -1;
+        uint8_t* data_ = nullptr;
+        size_t size_ = 0;
+        bool readOnly_;
+        std::atomic<uint64_t> hits_{ 0 };
+        std::atomic<uint64_t> misses_{ 0 };
+        std::mutex insertMutex_;
+    };
+
+} //END: host
+} //END: usbstd
\ No newline at end of file
@@ -0,0 +1,333 @@
+#pragma once
+
+#include <chrono> //< std::chrono::steady_clock
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t, uint32_t, uint64_t
+#include <cstring> //< std::memcmp
+#include <vector> //< std::vector
+
+#include "usb_control.hpp" //< usbstd::ControlPipe, usbstd::ControlLoopback
+#include "usb_descriptor.hpp" //< usbstd::DescriptorType
+#include "usb_helper_descriptorwalker.hpp" //< usbstd::helper::DescriptorRange
+#include "usb_helper_msos20.hpp" //< usbstd::helper::msos20::PlatformUuid
+#include "usb_request.hpp" //< usbstd::Request
+#include "usb_span.hpp" //< usbstd::Span
+#include "usbstd.hpp" //< usbstd::USB_GET_DESCRIPTOR, usbstd::USB_SET_ADDRESS, usbstd::USB_SET_CONFIGURATION
+
+namespace usbstd {
+namespace host {
+
+    /** Steps of `Enumerator::run()`, in request order
+    */
+    enum class EnumerationStage : uint8_t
+    {
+        DeviceShort, ///< GET_DESCRIPTOR(Device) with wLength 8, for bMaxPacketSize0
+        SetAddress,
+        Device,
+        ConfigurationShort, ///< GET_DESCRIPTOR(Configuration) with wLength 9, for wTotalLength
+        Configuration,
+        Languages, ///< GET_DESCRIPTOR(String 0)
+        Strings, ///< Every string index referenced by the descriptors, in every language
+        Bos, ///< Header, then the full BOS, when bcdUSB is 2.01 or later
+        MsOs20, ///< Vendor request for the MS OS 2.0 descriptor set, when the BOS announces one
+        SetConfiguration,
+        Count
+    };
+
+    inline const char* stageName(EnumerationStage stage)
+    {
+        switch (stage)
+        {
+        case EnumerationStage::DeviceShort: return "device_short";
+        case EnumerationStage::SetAddress: return "set_address";
+        case EnumerationStage::Device: return "device";
+        case EnumerationStage::ConfigurationShort: return "configuration_short";
+        case EnumerationStage::Configuration: return "configuration";
+        case EnumerationStage::Languages: return "languages";
+        case EnumerationStage::Strings: return "strings";
+        case EnumerationStage::Bos: return "bos";
+        case EnumerationStage::MsOs20: return "ms_os_20";
+        case EnumerationStage::SetConfiguration: return "set_configuration";
+        default: return "?";
+        }
+    }
+
+    struct EnumerationStageStatistics
+    {
+        uint64_t transfers = 0; ///< Control transfers
+        uint64_t bytes = 0; ///< Data stage bytes
+        uint64_t stalls = 0;
+        uint64_t handlerNanos = 0; ///< Time spent in the device's request handler
+    };
+
+    /** Statistics accumulated over one or more enumerations
+    */
+    struct EnumerationResult
+    {
+        static constexpr size_t StageCount = static_cast<size_t>(EnumerationStage::Count);
+
+        EnumerationStageStatistics stages[StageCount];
+        uint64_t enumerations = 0; ///< Completed enumerations
+        uint64_t failures = 0;
+        EnumerationStage failedStage = EnumerationStage::Count; ///< Stage of the last failure
+
+        const EnumerationStageStatistics& operator[](EnumerationStage stage) const { return stages[static_cast<size_t>(stage)]; }
+        EnumerationStageStatistics& operator[](EnumerationStage stage) { return stages[static_cast<size_t>(stage)]; }
+
+        EnumerationStageStatistics total() const
+        {
+            EnumerationStageStatistics sum;
+            for (const auto& stage : stages)
+            {
+                sum.transfers += stage.transfers;
+                sum.bytes += stage.bytes;
+                sum.stalls += stage.stalls;
+                sum.handlerNanos += stage.handlerNanos;
+            }
+            return sum;
+        }
+    };
+
+    /** In-memory device answering the standard enumeration requests from descriptor blobs, over `ControlPipe`
+     * @tparam  Strings_t  String descriptor source with `const uint16_t* generate(uint8_t index, uint16_t langid)`,
+     *  e.g. `helper::StringDescriptorGenerator` or `helper::StringDescriptorTable`
+     * @code
+     *   usbstd::host::VirtualDevice<decltype(usbStringGenerator)> device{ deviceBytes, configurationBytes, usbStringGenerator, bosBytes, msOs20Bytes, VendorCode };
+     *   usbstd::host::Enumerator enumerator;
+     *   usbstd::host::EnumerationResult result;
+     *   enumerator.run(device, result);
+     * @endcode
+    */
+    template<typename Strings_t>
+    class VirtualDevice
+    {
+    public:
+        /**
+         * @param msOs20  MS OS 2.0 descriptor set, answered to vendor request `vendorCode` with `wIndex` 7
+        */
+        VirtualDevice(Span<const uint8_t> device, Span<const uint8_t> configuration, Strings_t& strings
+            , Span<const uint8_t> bos = {}, Span<const uint8_t> msOs20 = {}, uint8_t vendorCode = 0)
+            : device_(device), configuration_(configuration), bos_(bos), msOs20_(msOs20), strings_(strings), vendorCode_(vendorCode)
+            , pipe_(loopback_, (device.size() > 7) ? device[7] : 64)
+        {}
+
+        uint8_t address() const { return address_; }
+        uint8_t configurationValue() const { return configurationValue_; }
+
+        /** Bus reset: default address, unconfigured
+        */
+        void reset()
+        {
+            address_ = 0;
+            configurationValue_ = 0;
+        }
+
+        /** Run one control transfer as the host
+         * @param handlerNanos  Accumulates the time spent in `setup()`
+         * @return Data stage bytes, or -1 when the device stalled
+        */
+        long transfer(const Request& request, Span<uint8_t> data, uint64_t& handlerNanos)
+        {
+            using Clock = std::chrono::steady_clock;
+            const long result = loopback_.transfer(pipe_, request, data, [&](auto& ep0) {
+                const auto start = Clock::now();
+                setup(ep0);
+                handlerNanos += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+            });
+            // The new address applies after the status stage
+            if ((result == 0) && (request.bmRequestType == 0x00) && (request.bRequest == USB_SET_ADDRESS))
+                address_ = static_cast<uint8_t>(request.wValue & 0x7f);
+            return result;
+        }
+
+    private:
+        template<typename Pipe_t>
+        void setup(Pipe_t& ep0)
+        {
+            const Request& request = ep0.request();
+            if (request.bmRequestType == 0x80 && request.bRequest == USB_GET_DESCRIPTOR)
+            {
+                const uint8_t index = static_cast<uint8_t>(request.wValue);
+                switch (static_cast<DescriptorType>(request.wValue >> 8))
+                {
+                case DescriptorType::Device:
+                    return respond(ep0, device_);
+                case DescriptorType::Configuration:
+                    return (index == 0) ? respond(ep0, configuration_) : ep0.stall();
+                case DescriptorType::BinaryObjectStore:
+                    return respond(ep0, bos_);
+                case DescriptorType::String:
+                    if (const uint16_t* string = strings_.generate(index, request.wIndex))
+                        return respond(ep0, { reinterpret_cast<const uint8_t*>(string), reinterpret_cast<const uint8_t*>(string)[0] });
+                    return ep0.stall();
+                default:
+                    return ep0.stall();
+                }
+            }
+            if ((request.bmRequestType == 0x00) && (request.bRequest == USB_SET_ADDRESS) && (request.wValue < 128))
+                return ep0.acknowledge();
+            if ((request.bmRequestType == 0x00) && (request.bRequest == USB_SET_CONFIGURATION) && (configuration_.size() > 5)
+                && ((request.wValue == 0) || (request.wValue == configuration_[5])))
+            {
+                configurationValue_ = static_cast<uint8_t>(request.wValue);
+                return ep0.acknowledge();
+            }
+            if ((request.bmRequestType == 0xc0) && (request.bRequest == vendorCode_) && (request.wIndex == MS_OS_20_DESCRIPTOR_INDEX))
+                return respond(ep0, msOs20_);
+            ep0.stall();
+        }
+
+        template<typename Pipe_t>
+        static void respond(Pipe_t& ep0, Span<const uint8_t> bytes)
+        {
+            if (bytes.empty())
+                ep0.stall();
+            else
+                ep0.send(bytes);
+        }
+
+        Span<const uint8_t> device_;
+        Span<const uint8_t> configuration_;
+        Span<const uint8_t> bos_;
+        Span<const uint8_t> msOs20_;
+        Strings_t& strings_;
+        uint8_t vendorCode_;
+        uint8_t address_ = 0;
+        uint8_t configurationValue_ = 0;
+        ControlLoopback loopback_;
+        ControlPipe<ControlLoopback> pipe_;
+    };
+
+    /** Host enumeration driver issuing the request sequence of a typical host, see `EnumerationStage`
+     * Reuses its buffer across runs, so repeated enumerations do not allocate.
+    */
+    class Enumerator
+    {
+    public:
+        /** Enumerate `device` once, accumulating into `result`
+         * @tparam  Device_t  Device with the `transfer()` of `VirtualDevice`
+         * @return `false` when a mandatory request stalled or returned a malformed descriptor
+        */
+        template<typename Device_t>
+        bool run(Device_t& device, EnumerationResult& result)
+        {
+            const auto fail = [&](EnumerationStage stage) {
+                ++result.failures;
+                result.failedStage = stage;
+                return false;
+            };
+
+            device.reset();
+            buffer_.resize(UINT16_MAX);
+
+            // Device descriptor: the first 8 bytes at the default address, then all of it
+            if (request(device, result, EnumerationStage::DeviceShort, { 0x80, USB_GET_DESCRIPTOR, 0x0100, 0, 8 }) < 8)
+                return fail(EnumerationStage::DeviceShort);
+            if (request(device, result, EnumerationStage::SetAddress, { 0x00, USB_SET_ADDRESS, 1, 0, 0 }) != 0)
+                return fail(EnumerationStage::SetAddress);
+            if (request(device, result, EnumerationStage::Device, { 0x80, USB_GET_DESCRIPTOR, 0x0100, 0, 18 }) != 18)
+                return fail(EnumerationStage::Device);
+            uint8_t deviceDescriptor[18];
+            std::memcpy(deviceDescriptor, buffer_.data(), sizeof(deviceDescriptor));
+            const uint16_t bcdUSB = static_cast<uint16_t>(deviceDescriptor[2] | (deviceDescriptor[3] << 8));
+
+            // Configuration descriptor: the header for wTotalLength, then all of it
+            if (request(device, result, EnumerationStage::ConfigurationShort, { 0x80, USB_GET_DESCRIPTOR, 0x0200, 0, 9 }) != 9)
+                return fail(EnumerationStage::ConfigurationShort);
+            const uint16_t totalLength = static_cast<uint16_t>(buffer_[2] | (buffer_[3] << 8));
+            if ((totalLength < 9) || (request(device, result, EnumerationStage::Configuration, { 0x80, USB_GET_DESCRIPTOR, 0x0200, 0, totalLength }) != totalLength))
+                return fail(EnumerationStage::Configuration);
+            const helper::DescriptorRange configuration{ Span<const uint8_t>{ buffer_.data(), totalLength } };
+            if (!configuration.valid())
+                return fail(EnumerationStage::Configuration);
+            const uint8_t configurationValue = buffer_[5];
+
+            // String indices referenced by the device, configuration, IAD and interface descriptors
+            uint32_t indices[8] = {};
+            const auto reference = [&](uint8_t index) { indices[index >> 5] |= (1u << (index & 31)); };
+            reference(deviceDescriptor[14]);
+            reference(deviceDescriptor[15]);
+            reference(deviceDescriptor[16]);
+            for (auto descriptor : configuration)
+            {
+                const uint8_t* bytes = descriptor.bytes().data();
+                if ((bytes[1] == static_cast<uint8_t>(DescriptorType::Configuration)) && (bytes[0] >= 9))
+                    reference(bytes[6]);
+                else if ((bytes[1] == static_cast<uint8_t>(DescriptorType::Interface)) && (bytes[0] >= 9))
+                    reference(bytes[8]);
+                else if ((bytes[1] == static_cast<uint8_t>(DescriptorType::InterfaceAssociation)) && (bytes[0] >= 8))
+                    reference(bytes[7]);
+            }
+            indices[0] &= ~1u; //< Index 0 is the language list, not a string
+
+            if (((indices[0] | indices[1] | indices[2] | indices[3] | indices[4] | indices[5] | indices[6] | indices[7]) != 0))
+            {
+                const long languagesLength = request(device, result, EnumerationStage::Languages, { 0x80, USB_GET_DESCRIPTOR, 0x0300, 0, 255 });
+                if (languagesLength >= 4)
+                {
+                    uint16_t languages[127];
+                    const size_t languageCount = (static_cast<size_t>(languagesLength) - 2) / 2;
+                    for (size_t i = 0; i < languageCount; ++i)
+                        languages[i] = static_cast<uint16_t>(buffer_[2 + 2 * i] | (buffer_[3 + 2 * i] << 8));
+                    for (size_t language = 0; language < languageCount; ++language)
+                    {
+                        for (unsigned index = 1; index < 256; ++index)
+                        {
+                            if ((indices[index >> 5] & (1u << (index & 31))) != 0)
+                                request(device, result, EnumerationStage::Strings, { 0x80, USB_GET_DESCRIPTOR, static_cast<uint16_t>(0x0300 | index), languages[language], 255 });
+                        }
+                    }
+                }
+            }
+
+            // BOS, and the MS OS 2.0 descriptor set it may announce
+            if (bcdUSB >= 0x0201)
+            {
+                const long bosHeader = request(device, result, EnumerationStage::Bos, { 0x80, USB_GET_DESCRIPTOR, 0x0f00, 0, 5 });
+                const uint16_t bosLength = static_cast<uint16_t>(buffer_[2] | (buffer_[3] << 8));
+                if ((bosHeader == 5) && (bosLength >= 5)
+                    && (request(device, result, EnumerationStage::Bos, { 0x80, USB_GET_DESCRIPTOR, 0x0f00, 0, bosLength }) == bosLength))
+                {
+                    uint8_t vendorCode = 0;
+                    uint16_t setLength = 0;
+                    for (auto capability : helper::DescriptorRange{ Span<const uint8_t>{ buffer_.data(), bosLength } })
+                    {
+                        const Span<const uint8_t> bytes = capability.bytes();
+                        if ((bytes.size() >= 28) && (bytes[1] == static_cast<uint8_t>(DescriptorType::DeviceCapability))
+                            && (bytes[2] == static_cast<uint8_t>(DeviceCapabilityType::Platform))
+                            && (std::memcmp(bytes.data() + 4, helper::msos20::PlatformUuid, 16) == 0))
+                        {
+                            setLength = static_cast<uint16_t>(bytes[24] | (bytes[25] << 8));
+                            vendorCode = bytes[26];
+                        }
+                    }
+                    if (setLength != 0)
+                        request(device, result, EnumerationStage::MsOs20, { 0xc0, vendorCode, 0, MS_OS_20_DESCRIPTOR_INDEX, setLength });
+                }
+            }
+
+            if (request(device, result, EnumerationStage::SetConfiguration, { 0x00, USB_SET_CONFIGURATION, configurationValue, 0, 0 }) != 0)
+                return fail(EnumerationStage::SetConfiguration);
+            ++result.enumerations;
+            return true;
+        }
+
+    private:
+        template<typename Device_t>
+        long request(Device_t& device, EnumerationResult& result, EnumerationStage stage, const Request& setup)
+        {
+            auto& statistics = result[stage];
+            ++statistics.transfers;
+            const long length = device.transfer(setup, Span<uint8_t>{ buffer_.data(), setup.wLength }, statistics.handlerNanos);
+            if (length < 0)
+                ++statistics.stalls;
+            else
+                statistics.bytes += static_cast<uint64_t>(length);
+            return length;
+        }
+
+        std::vector<uint8_t> buffer_;
+    };
+
+} //END: host
+} //END: usbstd
\ No newline at end of file
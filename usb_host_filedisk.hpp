@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint32_t
+
+#include <fcntl.h> //< open
+#include <sys/stat.h> //< fstat
+#include <unistd.h> //< pread, pwrite, fdatasync, ftruncate, close
+
+namespace usbstd {
+namespace host {
+
+    /** Block device backed by a disk image file (POSIX), for `msc::BulkOnlyTransport`
+     * Blocks are read and written in place with `pread`/`pwrite`, straight into the transport's buffers.
+     * @code
+     *   usbstd::host::FileDisk disk{ "disk.img", 16 * 1024 * 1024 / 512 };
+     *   usbstd::msc::BulkOnlyTransport<usbstd::host::FileDisk> msc{ disk };
+     * @endcode
+    */
+    class FileDisk
+    {
+    public:
+        /** Open `path`, creating it with `createBlocks` blocks when it does not exist
+         * @note Check `ready()` for success
+        */
+        explicit FileDisk(const char* path, uint32_t createBlocks = 0, uint32_t blockSize = 512, bool readOnly = false)
+            : blockSize_(blockSize), readOnly_(readOnly)
+        {
+            fd_ = ::open(path, readOnly ? O_RDONLY : ((createBlocks != 0) ? (O_RDWR | O_CREAT) : O_RDWR), 0644);
+            if (fd_ < 0)
+                return;
+
+            struct stat status = {};
+            off_t size = -1;
+            if (::fstat(fd_, &status) == 0)
+                size = status.st_size;
+            if ((size == 0) && (createBlocks != 0))
+                size = (::ftruncate(fd_, off_t(createBlocks) * blockSize) == 0) ? off_t(createBlocks) * blockSize : -1;
+
+            if (size >= off_t(blockSize))
+                blockCount_ = static_cast<uint32_t>(size / blockSize);
+            else
+                close();
+        }
+
+        FileDisk(const FileDisk&) = delete;
+        FileDisk& operator=(const FileDisk&) = delete;
+
+        ~FileDisk() { close(); }
+
+        uint32_t blockCount() const { return blockCount_; }
+        uint32_t blockSize() const { return blockSize_; }
+        bool ready() const { return fd_ >= 0; }
+        bool writeProtected() const { return readOnly_; }
+
+        bool read(uint32_t lba, uint32_t count, uint8_t* data)
+        {
+            return transfer(lba, count, [&](size_t done, size_t size, off_t offset) { return ::pread(fd_, data + done, size, offset); });
+        }
+
+        bool write(uint32_t lba, uint32_t count, const uint8_t* data)
+        {
+            return transfer(lba, count, [&](size_t done, size_t size, off_t offset) { return ::pwrite(fd_, data + done, size, offset); });
+        }
+
+        bool flush() { return ::fdatasync(fd_) == 0; }
+
+    private:
+        template<typename Io_t>
+        bool transfer(uint32_t lba, uint32_t count, Io_t&& io)
+        {
+            const size_t size = size_t(count) * blockSize_;
+            const off_t offset = off_t(lba) * blockSize_;
+            for (size_t done = 0; done < size; )
+            {
+                const ssize_t result = io(done, size - done, offset + off_t(done));
+                if (result <= 0)
+                    return false;
+                done += static_cast<size_t>(result);
+            }
+            return true;
+        }
+
+        void close()
+        {
+            if (fd_ >= 0)
+                ::close(fd_);
+            fd_ = -1;
+            blockCount_ = 0;
+        }
+
+        int fd_ = -1;
+        uint32_t blockCount_ = 0;
+        uint32_t blockSize_;
+        bool readOnly_;
+    };
+
+} //END: host
+} //END: usbstd
\ No newline at end of file
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm> //< std::fill
+#include <chrono> //< std::chrono::microseconds
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint32_t
+#include <thread> //< std::this_thread::sleep_for
+#include <vector> //< std::vector
+
+#include <fcntl.h> //< open
+#include <sys/stat.h> //< fstat
+#include <unistd.h> //< pread, pwrite, fdatasync, close
+
+namespace usbstd {
+namespace host {
+
+    /** NOR flash emulated in an image file (POSIX), for `dfu::FirmwareUpdate`
+     * Erase fills a sector with 0xff, programming can only clear bits, and both take a configurable time so the
+     * download pipeline and the `bwPollTimeout` prediction can be exercised against realistic flash timing.
+     * @code
+     *   usbstd::host::FileFlash flash{ "flash.img", 512 * 1024, 4096, 20000, 2000 };
+     *   usbstd::dfu::FirmwareUpdate<usbstd::host::FileFlash> dfu{ flash, micros };
+     * @endcode
+    */
+    class FileFlash
+    {
+    public:
+        /** Open `path`, creating it erased with `size` bytes when it does not exist
+         * @param eraseMicros  Time to erase one sector
+         * @param programMicrosPerKiB  Time to program 1024 bytes
+         * @note Check `ready()` for success
+        */
+        FileFlash(const char* path, uint32_t size, uint32_t sectorSize = 4096, uint32_t eraseMicros = 0, uint32_t programMicrosPerKiB = 0)
+            : sectorSize_(sectorSize), eraseMicros_(eraseMicros), programMicrosPerKiB_(programMicrosPerKiB), scratch_(sectorSize)
+        {
+            fd_ = ::open(path, O_RDWR | O_CREAT, 0644);
+            struct stat status = {};
+            bool valid = (fd_ >= 0) && (sectorSize != 0) && ((size % sectorSize) == 0) && (::fstat(fd_, &status) == 0);
+            if (valid && (status.st_size == 0))
+            {
+                // New image: fully erased, without the erase latency
+                std::fill(scratch_.begin(), scratch_.end(), uint8_t(0xff));
+                for (uint32_t address = 0; valid && (address < size); address += sectorSize)
+                    valid = ::pwrite(fd_, scratch_.data(), sectorSize, off_t(address)) == ssize_t(sectorSize);
+            }
+            else if (valid)
+                valid = status.st_size >= off_t(size);
+
+            if (valid)
+                size_ = size;
+            else
+                close();
+        }
+
+        FileFlash(const FileFlash&) = delete;
+        FileFlash& operator=(const FileFlash&) = delete;
+
+        ~FileFlash() { close(); }
+
+        bool ready() const { return fd_ >= 0; }
+        uint32_t size() const { return size_; }
+        uint32_t sectorSize() const { return sectorSize_; }
+
+        /// @{ Latency, changeable between operations
+        void eraseMicros(uint32_t micros) { eraseMicros_ = micros; }
+        void programMicrosPerKiB(uint32_t micros) { programMicrosPerKiB_ = micros; }
+        ///@}
+
+        bool erase(uint32_t address)
+        {
+            if ((fd_ < 0) || ((address % sectorSize_) != 0) || (address >= size_))
+                return false;
+            std::fill(scratch_.begin(), scratch_.end(), uint8_t(0xff));
+            const bool erased = ::pwrite(fd_, scratch_.data(), sectorSize_, off_t(address)) == ssize_t(sectorSize_);
+            delay(eraseMicros_);
+            return erased;
+        }
+
+        /** Program erased memory, clearing bits only
+         * @return `false` on I/O errors, out of range, or when the data needs bits that are not erased
+        */
+        bool program(uint32_t address, const uint8_t* data, size_t length)
+        {
+            if ((fd_ < 0) || (address > size_) || (length > size_ - address))
+                return false;
+            bool programmed = true;
+            for (size_t done = 0; done < length; )
+            {
+                const size_t count = ((length - done) < scratch_.size()) ? (length - done) : scratch_.size();
+                const off_t offset = off_t(address) + off_t(done);
+                if (::pread(fd_, scratch_.data(), count, offset) != ssize_t(count))
+                    return false;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    scratch_[i] &= data[done + i];
+                    programmed &= (scratch_[i] == data[done + i]);
+                }
+                if (::pwrite(fd_, scratch_.data(), count, offset) != ssize_t(count))
+                    return false;
+                done += count;
+            }
+            delay(static_cast<uint32_t>((uint64_t(programMicrosPerKiB_) * length) / 1024));
+            return programmed;
+        }
+
+        size_t read(uint32_t address, uint8_t* data, size_t length)
+        {
+            if ((fd_ < 0) || (address >= size_))
+                return 0;
+            length = (length < size_ - address) ? length : (size_ - address);
+            const ssize_t result = ::pread(fd_, data, length, off_t(address));
+            return (result > 0) ? static_cast<size_t>(result) : 0;
+        }
+
+        bool manifest() { return (fd_ >= 0) && (::fdatasync(fd_) == 0); }
+
+    private:
+        static void delay(uint32_t micros)
+        {
+            if (micros != 0)
+                std::this_thread::sleep_for(std::chrono::microseconds(micros));
+        }
+
+        void close()
+        {
+            if (fd_ >= 0)
+                ::close(fd_);
+            fd_ = -1;
+            size_ = 0;
+        }
+
+        int fd_ = -1;
+        uint32_t size_ = 0;
+        uint32_t sectorSize_;
+        uint32_t eraseMicros_;
+        uint32_t programMicrosPerKiB_;
+        std::vector<uint8_t> scratch_;
+    };
+
+} //END: host
+} //END: usbstd
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t
+
+#include <fcntl.h> //< open
+#include <sys/mman.h> //< mmap, munmap, madvise
+#include <sys/stat.h> //< fstat
+#include <unistd.h> //< close
+
+#include "usb_span.hpp" //< usbstd::Span
+
+namespace usbstd {
+namespace host {
+
+    /** Read-only memory mapping of a whole file (POSIX)
+     * @code
+     *   usbstd::host::MappedFile capture{ "usb.pcap" };
+     *   if (capture)
+     *       decode(capture.bytes());
+     * @endcode
+    */
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+
+        /** Map `path`, check `operator bool()` for success
+         * @param sequential  Advise the kernel the mapping is read front to back, enabling aggressive read-ahead
+        */
+        explicit MappedFile(const char* path, bool sequential = true)
+        {
+            const int fd = ::open(path, O_RDONLY);
+            if (fd < 0)
+                return;
+
+            struct stat status = {};
+            if ((::fstat(fd, &status) == 0) && (status.st_size > 0))
+            {
+                void* data = ::mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data != MAP_FAILED)
+                {
+                    data_ = static_cast<const uint8_t*>(data);
+                    size_ = static_cast<size_t>(status.st_size);
+                    ::madvise(data, size_, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+                }
+            }
+            ::close(fd); //< The mapping keeps the file referenced
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept : data_(other.data_), size_(other.size_)
+        {
+            other.data_ = nullptr;
+            other.size_ = 0;
+        }
+
+        MappedFile& operator=(MappedFile&& other) noexcept
+        {
+            if (this != &other)
+            {
+                unmap();
+                data_ = other.data_;
+                size_ = other.size_;
+                other.data_ = nullptr;
+                other.size_ = 0;
+            }
+            return *this;
+        }
+
+        ~MappedFile() { unmap(); }
+
+        explicit operator bool() const { return data_ != nullptr; }
+        Span<const uint8_t> bytes() const { return { data_, size_ }; }
+        size_t size() const { return size_; }
+
+    private:
+        void unmap()
+        {
+            if (data_ != nullptr)
+                ::munmap(const_cast<uint8_t*>(data_), size_);
+        }
+
+        const uint8_t* data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+} //END: host
+} //END: usbstd
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic> //< std::atomic
+#include <cstddef> //< size_t
+#include <cstdint> //< uint32_t, uint64_t
+#include <thread> //< std::thread
+#include <vector> //< std::vector
+
+#include "usb_helper_ringbuffer.hpp" //< USBSTD_CACHE_LINE_SIZE
+
+namespace usbstd {
+namespace host {
+
+    /** Work-stealing thread pool for a fixed set of indexed tasks
+     * Each worker owns a contiguous range of task indices and takes tasks from its front; a worker that runs out steals
+     * single tasks from the back of the other ranges. Ranges are a (front, back) pair in one atomic word, so taking and
+     * stealing are lock-free.
+     * @code
+     *   usbstd::host::WorkStealingPool pool{ std::thread::hardware_concurrency() };
+     *   pool.run(chunks.size(), [&](size_t chunk, size_t worker) { results[chunk] = analyse(chunks[chunk]); });
+     * @endcode
+    */
+    class WorkStealingPool
+    {
+    public:
+        explicit WorkStealingPool(size_t threads) : threads_((threads != 0) ? threads : 1) {}
+
+        size_t threads() const { return threads_; }
+
+        /** Run `task(index, worker)` for every index in [0, count) and wait for all of them
+         * The calling thread works as worker 0.
+        */
+        template<typename Task_t>
+        void run(size_t count, Task_t&& task)
+        {
+            const size_t workers = (count < threads_) ? ((count != 0) ? count : 1) : threads_;
+            std::vector<Range> ranges(workers);
+            for (size_t worker = 0; worker < workers; ++worker)
+                ranges[worker].set(static_cast<uint32_t>(count * worker / workers), static_cast<uint32_t>(count * (worker + 1) / workers));
+
+            auto work = [&](size_t worker)
+            {
+                uint32_t index;
+                while (ranges[worker].takeFront(index))
+                    task(index, worker);
+
+                for (size_t attempt = 1; attempt < workers; )
+                {
+                    auto& victim = ranges[(worker + attempt) % workers];
+                    if (victim.takeBack(index))
+                        task(index, worker);
+                    else
+                        ++attempt; //< Ranges only shrink, an empty victim stays empty
+                }
+            };
+
+            std::vector<std::thread> threads;
+            threads.reserve(workers - 1);
+            for (size_t worker = 1; worker < workers; ++worker)
+                threads.emplace_back(work, worker);
+            work(0);
+            for (auto& thread : threads)
+                thread.join();
+        }
+
+    private:
+        struct alignas(USBSTD_CACHE_LINE_SIZE) Range
+        {
+            std::atomic<uint64_t> bounds = { 0 }; ///< front in the low word, back in the high word
+
+            void set(uint32_t front, uint32_t back) { bounds.store(pack(front, back), std::memory_order_relaxed); }
+
+            bool takeFront(uint32_t& index)
+            {
+                uint64_t current = bounds.load(std::memory_order_relaxed);
+                do
+                {
+                    if (front(current) >= back(current))
+                        return false;
+                } while (!bounds.compare_exchange_weak(current, pack(front(current) + 1, back(current)), std::memory_order_acq_rel));
+                index = front(current);
+                return true;
+            }
+
+            bool takeBack(uint32_t& index)
+            {
+                uint64_t current = bounds.load(std::memory_order_relaxed);
+                do
+                {
+                    if (front(current) >= back(current))
+                        return false;
+                } while (!bounds.compare_exchange_weak(current, pack(front(current), back(current) - 1), std::memory_order_acq_rel));
+                index = back(current) - 1;
+                return true;
+            }
+
+            static uint64_t pack(uint32_t front, uint32_t back) { return (uint64_t(back) << 32) | front; }
+            static uint32_t front(uint64_t bounds) { return static_cast<uint32_t>(bounds); }
+            static uint32_t back(uint64_t bounds) { return static_cast<uint32_t>(bounds >> 32); }
+        };
+
+        size_t threads_;
+    };
+
+} //END: host
+} //END: usbstd
\ No newline at end of file
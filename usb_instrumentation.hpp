@@ -0,0 +1,290 @@
+#pragma once
+
+#include <atomic> //< std::atomic
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t, uint32_t
+#include <cstdio> //< std::snprintf
+#include <cstring> //< std::memcpy
+
+#include "usb_endian.hpp" //< usbstd::Le16, usbstd::Le32
+#include "usb_request.hpp" //< usbstd::Request
+#include "usb_span.hpp" //< usbstd::Span
+
+/// Set to 1 (CMake `-DUSBSTD_INSTRUMENTATION=ON`) to record request statistics, otherwise `RequestStats` compiles to nothing
+#ifndef USBSTD_INSTRUMENTATION
+#define USBSTD_INSTRUMENTATION 0
+#endif
+
+namespace usbstd {
+namespace instrumentation {
+
+    constexpr uint8_t SnapshotVersion = 1;
+    constexpr size_t HistogramBins = 16; ///< Bin 0: 0 ticks, bin n: [2^(n-1), 2^n) ticks, the last bin is open ended
+
+#pragma pack(push, 1)
+
+    /** Snapshot wire format, little-endian: a header followed by `entries` entries
+     * Read by the host with a vendor IN request answered from `RequestStats::snapshot()`.
+    */
+    struct SnapshotHeader
+    {
+        uint8_t  version; ///< `SnapshotVersion`
+        uint8_t  bins; ///< `HistogramBins`
+        Le16 entries; ///< Entries following the header
+        Le32 overflow; ///< Requests not recorded as the table was full
+    };
+
+    struct SnapshotEntry
+    {
+        uint8_t  bmRequestType;
+        uint8_t  bRequest;
+        Le16 reserved;
+        Le32 count;
+        Le32 stalls;
+        Le32 maxTicks;
+        Le32 totalTicks; ///< Wraps, use with `count` over short intervals
+        Le32 histogram[HistogramBins];
+    };
+
+#pragma pack(pop)
+
+    static_assert(sizeof(SnapshotHeader) == 8, "size is not correct");
+    static_assert(sizeof(SnapshotEntry) == 20 + 4 * HistogramBins, "size is not correct");
+
+    /** Histogram bin of a latency, its bit length clamped to the last bin
+    */
+    constexpr uint8_t histogramBin(uint32_t ticks)
+    {
+        uint8_t bin = 0;
+        while ((ticks != 0) && (bin < HistogramBins - 1))
+        {
+            ticks >>= 1;
+            ++bin;
+        }
+        return bin;
+    }
+
+    /** Walk a snapshot received from a device
+     * @param visit  `visit(const SnapshotEntry&)` for every complete entry
+     * @return The header, `version` 0 when `data` is not a snapshot
+    */
+    template<typename Visit_t>
+    SnapshotHeader parseSnapshot(Span<const uint8_t> data, Visit_t&& visit)
+    {
+        SnapshotHeader header = {};
+        if (data.size() < sizeof(header))
+            return header;
+        std::memcpy(&header, data.data(), sizeof(header));
+        if ((header.version != SnapshotVersion) || (header.bins != HistogramBins))
+            return SnapshotHeader{};
+
+        for (size_t i = 0; (i < header.entries) && (sizeof(header) + (i + 1) * sizeof(SnapshotEntry) <= data.size()); ++i)
+        {
+            SnapshotEntry entry;
+            std::memcpy(&entry, data.data() + sizeof(header) + i * sizeof(SnapshotEntry), sizeof(entry));
+            visit(entry);
+        }
+        return header;
+    }
+
+    /** Print an entry as one text line, the format of `RequestStats::print()`
+     * @return Characters written, as `snprintf`
+    */
+    inline int printEntry(char* text, size_t size, const SnapshotEntry& entry)
+    {
+        int length = std::snprintf(text, size, "%02x %02x count=%lu stalls=%lu max=%lu avg=%lu hist="
+            , entry.bmRequestType, entry.bRequest, static_cast<unsigned long>(entry.count), static_cast<unsigned long>(entry.stalls)
+            , static_cast<unsigned long>(entry.maxTicks), static_cast<unsigned long>((entry.count != 0) ? entry.totalTicks / entry.count : 0));
+        for (size_t bin = 0; bin < HistogramBins && length >= 0; ++bin)
+        {
+            const size_t used = static_cast<size_t>(length);
+            length += std::snprintf(text + ((used < size) ? used : size), (used < size) ? (size - used) : 0
+                , (bin + 1 < HistogramBins) ? "%lu," : "%lu\n", static_cast<unsigned long>(entry.histogram[bin]));
+        }
+        return length;
+    }
+
+#if USBSTD_INSTRUMENTATION
+
+    /** Per-(bmRequestType, bRequest) request counts and log2 latency histograms
+     * Slots are claimed on first use by compare-and-swap and updated with relaxed atomic increments, so `record()` may be
+     * called from any interrupt priority without locks. A snapshot is not atomic across fields, only each counter is.
+     * @note Needs lock-free 32-bit atomics, i.e. not ARMv6-M (Cortex-M0), where record from a single priority level only
+     * @code
+     *   usbstd::instrumentation::RequestStats<> stats;
+     *   void onSetup(const usbstd::Request& request) { setupTicks = timer(); ... }
+     *   void onControlDone(bool stalled) { stats.record(ep0.request(), timer() - setupTicks, stalled); }
+     *
+     *   // Vendor request for the host
+     *   uint8_t snapshot[1024];
+     *   ep0.send({ snapshot, stats.snapshot(snapshot) });
+     * @endcode
+     * @tparam  Slots  Distinct requests recorded, a power of two
+    */
+    template<size_t Slots = 32>
+    class RequestStats
+    {
+        static_assert((Slots != 0) && ((Slots & (Slots - 1)) == 0), "Slots must be a power of two");
+
+    public:
+        static constexpr bool Enabled = true;
+
+        /** Record a completed request
+         * @param ticks  Latency in any time base, e.g. SETUP to status stage in µs
+        */
+        void record(const Request& request, uint32_t ticks, bool stalled = false)
+        {
+            Slot* slot = find(request.bmRequestType, request.bRequest);
+            if (slot == nullptr)
+            {
+                overflow_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            slot->count.fetch_add(1, std::memory_order_relaxed);
+            if (stalled)
+                slot->stalls.fetch_add(1, std::memory_order_relaxed);
+            slot->totalTicks.fetch_add(ticks, std::memory_order_relaxed);
+            slot->histogram[histogramBin(ticks)].fetch_add(1, std::memory_order_relaxed);
+            uint32_t max = slot->maxTicks.load(std::memory_order_relaxed);
+            while ((ticks > max) && !slot->maxTicks.compare_exchange_weak(max, ticks, std::memory_order_relaxed))
+            {}
+        }
+
+        /** Write the binary snapshot, as many entries as fit
+         * @return Bytes written, 0 when `out` cannot hold the header
+        */
+        size_t snapshot(Span<uint8_t> out) const
+        {
+            if (out.size() < sizeof(SnapshotHeader))
+                return 0;
+
+            size_t used = sizeof(SnapshotHeader);
+            uint16_t entries = 0;
+            for (const Slot& slot : slots_)
+            {
+                if (used + sizeof(SnapshotEntry) > out.size())
+                    break;
+                SnapshotEntry entry;
+                if (!load(slot, entry))
+                    continue;
+                std::memcpy(out.data() + used, &entry, sizeof(entry));
+                used += sizeof(entry);
+                ++entries;
+            }
+
+            const SnapshotHeader header = { SnapshotVersion, HistogramBins, entries, overflow_.load(std::memory_order_relaxed) };
+            std::memcpy(out.data(), &header, sizeof(header));
+            return used;
+        }
+
+        /** Write the statistics as text, one `printEntry()` line per request
+         * @return Characters written, truncated to whole lines that fit
+        */
+        size_t print(char* text, size_t size) const
+        {
+            size_t used = 0;
+            for (const Slot& slot : slots_)
+            {
+                SnapshotEntry entry;
+                if (!load(slot, entry))
+                    continue;
+                const int length = printEntry(text + used, size - used, entry);
+                if ((length < 0) || (used + static_cast<size_t>(length) >= size))
+                    break;
+                used += static_cast<size_t>(length);
+            }
+            if (used < size)
+                text[used] = '\0';
+            return used;
+        }
+
+        /** Clear all counters, keeping the requests already seen
+        */
+        void reset()
+        {
+            for (Slot& slot : slots_)
+            {
+                slot.count.store(0, std::memory_order_relaxed);
+                slot.stalls.store(0, std::memory_order_relaxed);
+                slot.maxTicks.store(0, std::memory_order_relaxed);
+                slot.totalTicks.store(0, std::memory_order_relaxed);
+                for (auto& bin : slot.histogram)
+                    bin.store(0, std::memory_order_relaxed);
+            }
+            overflow_.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr uint32_t Claimed = 0x10000; ///< Key flag, 0 is an empty slot
+
+        struct Slot
+        {
+            std::atomic<uint32_t> key{ 0 }; ///< `Claimed | bmRequestType << 8 | bRequest`
+            std::atomic<uint32_t> count{ 0 };
+            std::atomic<uint32_t> stalls{ 0 };
+            std::atomic<uint32_t> maxTicks{ 0 };
+            std::atomic<uint32_t> totalTicks{ 0 };
+            std::atomic<uint32_t> histogram[HistogramBins] = {};
+        };
+
+        Slot* find(uint8_t bmRequestType, uint8_t bRequest)
+        {
+            const uint32_t key = Claimed | (static_cast<uint32_t>(bmRequestType) << 8) | bRequest;
+            size_t index = ((bmRequestType * 0x9du) ^ bRequest) & (Slots - 1);
+            for (size_t probe = 0; probe < Slots; ++probe, index = (index + 1) & (Slots - 1))
+            {
+                uint32_t current = slots_[index].key.load(std::memory_order_acquire);
+                if (current == key)
+                    return &slots_[index];
+                if ((current == 0) && (slots_[index].key.compare_exchange_strong(current, key, std::memory_order_acq_rel) || (current == key)))
+                    return &slots_[index];
+            }
+            return nullptr;
+        }
+
+        static bool load(const Slot& slot, SnapshotEntry& entry)
+        {
+            const uint32_t key = slot.key.load(std::memory_order_acquire);
+            if (key == 0)
+                return false;
+            entry.bmRequestType = static_cast<uint8_t>(key >> 8);
+            entry.bRequest = static_cast<uint8_t>(key);
+            entry.reserved = 0;
+            entry.count = slot.count.load(std::memory_order_relaxed);
+            entry.stalls = slot.stalls.load(std::memory_order_relaxed);
+            entry.maxTicks = slot.maxTicks.load(std::memory_order_relaxed);
+            entry.totalTicks = slot.totalTicks.load(std::memory_order_relaxed);
+            for (size_t bin = 0; bin < HistogramBins; ++bin)
+                entry.histogram[bin] = slot.histogram[bin].load(std::memory_order_relaxed);
+            return true;
+        }
+
+        Slot slots_[Slots];
+        std::atomic<uint32_t> overflow_{ 0 };
+    };
+
+#else
+
+    /** Instrumentation disabled: every call compiles to nothing, snapshots are empty
+    */
+    template<size_t Slots = 32>
+    class RequestStats
+    {
+    public:
+        static constexpr bool Enabled = false;
+
+        void record(const Request&, uint32_t, bool = false) {}
+        size_t snapshot(Span<uint8_t>) const { return 0; }
+        size_t print(char* text, size_t size) const
+        {
+            if (size != 0)
+                text[0] = '\0';
+            return 0;
+        }
+        void reset() {}
+    };
+
+#endif // USBSTD_INSTRUMENTATION
+
+} //END: instrumentation
+} //END: usbstd
\ No newline at end of file
@@ -0,0 +1,737 @@
+#pragma once
+
+#include <atomic> //< std::atomic
+#include <cstddef> //< size_t
+#include <cstdint> //< uint8_t, uint16_t, uint32_t
+#include <cstring> //< std::memcpy, std::memset
+
+#include "usb_endian.hpp" //< usbstd::Le32
+#include "usb_helper_ringbuffer.hpp" //< USBSTD_CACHE_LINE_SIZE
+#include "usb_span.hpp" //< usbstd::Span
+
+namespace usbstd {
+
+    /** Mass Storage class requests
+     * @see USB Mass Storage Class Bulk-Only Transport 1.0, 3.1 and 3.2
+    */
+    enum
+    {
+        USB_MSC_GET_MAX_LUN = 0xfe,
+        USB_MSC_BULK_ONLY_RESET = 0xff,
+    };
+
+    enum class MscSubClass : uint8_t
+    {
+        ScsiNotReported = 0x00,
+        Rbc = 0x01,
+        Mmc5 = 0x02,
+        Ufi = 0x04,
+        ScsiTransparent = 0x06, ///< SCSI transparent command set, used by USB flash drives and card readers
+    };
+
+    enum class MscProtocol : uint8_t
+    {
+        Cbi = 0x00, ///< Control/Bulk/Interrupt with command completion interrupt
+        CbiNoInterrupt = 0x01,
+        BulkOnly = 0x50, ///< Bulk-Only Transport (BOT)
+    };
+
+namespace msc {
+
+#pragma pack(push, 1)
+
+    /** Command Block Wrapper, sent by the host on bulk OUT to start a command
+    */
+    struct CommandBlockWrapper
+    {
+        static constexpr uint32_t Signature = 0x43425355; ///< "USBC"
+
+        Le32 dCBWSignature;
+        Le32 dCBWTag; ///< Echoed in the `CommandStatusWrapper`
+        Le32 dCBWDataTransferLength; ///< Bytes the host expects to transfer in the data stage
+        uint8_t  bmCBWFlags; ///< Bit 7: data stage direction, 1 = device to host
+        uint8_t  bCBWLUN;
+        uint8_t  bCBWCBLength; ///< Valid bytes in `CBWCB`, 1 to 16
+        uint8_t  CBWCB[16]; ///< SCSI command block
+    };
+    static_assert(sizeof(CommandBlockWrapper) == 31, "size is not correct");
+
+    enum class CswStatus : uint8_t
+    {
+        Passed = 0,
+        Failed = 1, ///< Host should issue REQUEST SENSE
+        PhaseError = 2, ///< Host must perform reset recovery
+    };
+
+    /** Command Status Wrapper, sent by the device on bulk IN to end a command
+    */
+    struct CommandStatusWrapper
+    {
+        static constexpr uint32_t Signature = 0x53425355; ///< "USBS"
+
+        Le32 dCSWSignature;
+        Le32 dCSWTag;
+        Le32 dCSWDataResidue; ///< `dCBWDataTransferLength` less the bytes actually processed
+        CswStatus bCSWStatus;
+    };
+    static_assert(sizeof(CommandStatusWrapper) == 13, "size is not correct");
+
+    /** SCSI operation codes used by USB mass storage hosts
+     * @see SCSI Primary Commands (SPC-4) and SCSI Block Commands (SBC-3)
+    */
+    enum class ScsiOpcode : uint8_t
+    {
+        TestUnitReady = 0x00,
+        RequestSense = 0x03,
+        Inquiry = 0x12,
+        ModeSelect6 = 0x15,
+        ModeSense6 = 0x1a,
+        StartStopUnit = 0x1b,
+        PreventAllowMediumRemoval = 0x1e,
+        ReadFormatCapacities = 0x23,
+        ReadCapacity10 = 0x25,
+        Read10 = 0x28,
+        Write10 = 0x2a,
+        Verify10 = 0x2f,
+        SynchronizeCache10 = 0x35,
+        ModeSense10 = 0x5a,
+    };
+
+    enum class SenseKey : uint8_t
+    {
+        NoSense = 0x0,
+        NotReady = 0x2,
+        MediumError = 0x3,
+        IllegalRequest = 0x5,
+        UnitAttention = 0x6,
+        DataProtect = 0x7,
+    };
+
+    /** Additional sense code and qualifier, in the high and low byte
+    */
+    enum class SenseCode : uint16_t
+    {
+        None = 0x0000,
+        WriteError = 0x0c00,
+        UnrecoveredReadError = 0x1100,
+        InvalidCommandOperationCode = 0x2000,
+        LbaOutOfRange = 0x2100,
+        InvalidFieldInCdb = 0x2400,
+        WriteProtected = 0x2700,
+        MediumNotPresent = 0x3a00,
+    };
+
+    /// @{ SCSI data is big-endian
+    constexpr uint16_t loadBe16(const uint8_t* data) { return static_cast<uint16_t>((data[0] << 8) | data[1]); }
+    constexpr uint32_t loadBe32(const uint8_t* data) { return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | data[3]; }
+    constexpr void storeBe16(uint8_t* data, uint16_t value) { data[0] = static_cast<uint8_t>(value >> 8); data[1] = static_cast<uint8_t>(value); }
+    constexpr void storeBe32(uint8_t* data, uint32_t value) { storeBe16(data, static_cast<uint16_t>(value >> 16)); storeBe16(data + 2, static_cast<uint16_t>(value)); }
+    ///@}
+
+    /** Standard INQUIRY data
+    */
+    struct InquiryData
+    {
+        uint8_t peripheral; ///< Qualifier and device type, 0x00 for a direct access block device
+        uint8_t rmb; ///< Bit 7: removable medium
+        uint8_t version; ///< 0x04 for SPC-2
+        uint8_t responseDataFormat; ///< 0x02
+        uint8_t additionalLength; ///< 31, the bytes following this field
+        uint8_t flags[3];
+        char    vendorId[8]; ///< ASCII, padded with spaces
+        char    productId[16];
+        char    productRevision[4];
+    };
+    static_assert(sizeof(InquiryData) == 36, "size is not correct");
+
+    /** Fixed format sense data, returned by REQUEST SENSE
+    */
+    struct SenseData
+    {
+        uint8_t responseCode; ///< 0x70 current error, bit 7 set when `information` is valid
+        uint8_t obsolete;
+        uint8_t senseKey; ///< `SenseKey` in bits 3..0
+        uint8_t information[4];
+        uint8_t additionalLength; ///< 10, the bytes following this field
+        uint8_t commandSpecific[4];
+        uint8_t asc;
+        uint8_t ascq;
+        uint8_t fieldReplaceableUnit;
+        uint8_t senseKeySpecific[3];
+    };
+    static_assert(sizeof(SenseData) == 18, "size is not correct");
+
+    struct ReadCapacity10Data
+    {
+        uint8_t lastLba[4]; ///< Big-endian address of the last block
+        uint8_t blockLength[4]; ///< Big-endian block size in bytes
+    };
+    static_assert(sizeof(ReadCapacity10Data) == 8, "size is not correct");
+
+    struct FormatCapacityList
+    {
+        uint8_t reserved[3];
+        uint8_t listLength; ///< 8, one current/maximum capacity descriptor
+        uint8_t blockCount[4];
+        uint8_t descriptorType; ///< 0x02 formatted media
+        uint8_t blockLength[3];
+    };
+    static_assert(sizeof(FormatCapacityList) == 12, "size is not correct");
+
+#pragma pack(pop)
+
+    /** Fields of a SCSI command block that the transport acts on
+    */
+    struct ScsiCommand
+    {
+        ScsiOpcode opcode;
+        uint32_t lba; ///< READ(10), WRITE(10), VERIFY(10)
+        uint32_t blocks; ///< Transfer length in blocks
+        uint16_t allocationLength; ///< Largest response the host accepts, for commands returning data
+
+        static constexpr ScsiCommand decode(const uint8_t* cb)
+        {
+            ScsiCommand command = { static_cast<ScsiOpcode>(cb[0]), 0, 0, 0 };
+            switch (command.opcode)
+            {
+            case ScsiOpcode::Read10:
+            case ScsiOpcode::Write10:
+            case ScsiOpcode::Verify10:
+                command.lba = loadBe32(cb + 2);
+                command.blocks = loadBe16(cb + 7);
+                break;
+            case ScsiOpcode::RequestSense:
+            case ScsiOpcode::Inquiry:
+            case ScsiOpcode::ModeSense6:
+                command.allocationLength = cb[4];
+                break;
+            case ScsiOpcode::ReadFormatCapacities:
+            case ScsiOpcode::ModeSense10:
+                command.allocationLength = loadBe16(cb + 7);
+                break;
+            default:
+                break;
+            }
+            return command;
+        }
+    };
+
+    /** Block device held in RAM, e.g. for tests and for small volatile volumes
+     * Also documents the block device interface `BulkOnlyTransport` expects.
+    */
+    template<uint32_t BlockCount, uint32_t BlockSize = 512>
+    class RamDisk
+    {
+    public:
+        uint32_t blockCount() const { return BlockCount; }
+        uint32_t blockSize() const { return BlockSize; }
+        bool ready() const { return true; } ///< Medium present
+        bool writeProtected() const { return false; }
+
+        /** Read `count` blocks starting at `lba` into `data`
+        */
+        bool read(uint32_t lba, uint32_t count, uint8_t* data)
+        {
+            std::memcpy(data, &storage_[size_t(lba) * BlockSize], size_t(count) * BlockSize);
+            return true;
+        }
+
+        /** Write `count` blocks starting at `lba` from `data`
+        */
+        bool write(uint32_t lba, uint32_t count, const uint8_t* data)
+        {
+            std::memcpy(&storage_[size_t(lba) * BlockSize], data, size_t(count) * BlockSize);
+            return true;
+        }
+
+        /** Commit cached writes to the medium (SYNCHRONIZE CACHE)
+        */
+        bool flush() { return true; }
+
+        uint8_t* data() { return storage_; }
+
+    private:
+        uint8_t storage_[size_t(BlockCount) * BlockSize] = {};
+    };
+
+    /** Bulk-Only Transport with the SCSI transparent command set, for one logical unit
+     * Data moves through two buffers: while the USB controller transfers one, `process()` reads the next blocks from (or
+     * writes the previous blocks to) storage in the other. The controller transfers straight from and into the buffers
+     * and the block device reads and writes them in place, so block data is never copied.
+     *
+     * The USB side (`rxBuffer()`, `outComplete()`, `txBuffer()`, `inComplete()`, `stall()`, `clearHalt()`) runs in the
+     * USB interrupt; `process()` runs in a task that may block on storage. Only buffer ownership and the phase are shared.
+     *
+     * @tparam  BlockDevice_t  Block device, with the interface of `RamDisk`
+     * @tparam  BufferSize  Size of each buffer, a multiple of the block size and of the bulk `wMaxPacketSize`
+     * @code
+     *   static usbstd::msc::RamDisk<128> disk;
+     *   static usbstd::msc::BulkOnlyTransport<decltype(disk)> msc{ disk, "usbstd", "RAM disk" };
+     *
+     *   // USB interrupt: arm OUT and IN transfers whenever the endpoint is idle
+     *   auto rx = msc.rxBuffer();  if (!rx.empty()) startOut(rx.data(), rx.size());
+     *   auto tx = msc.txBuffer();  if (!tx.empty()) startIn(tx.data(), tx.size());
+     *   ... msc.outComplete(received); ... msc.inComplete(sent);
+     *
+     *   // Task
+     *   for (;;) msc.process();
+     * @endcode
+    */
+    template<typename BlockDevice_t, size_t BufferSize = 4096>
+    class BulkOnlyTransport
+    {
+    public:
+        enum class Phase : uint8_t
+        {
+            Command, ///< Waiting for a CBW
+            Decode, ///< CBW received, waiting for `process()`
+            DataIn,
+            DataOut,
+            StallIn, ///< Data stage ended early, bulk IN halted until `clearHalt()`
+            StallOut, ///< Data stage ended early, bulk OUT halted until `clearHalt()`
+            Status, ///< CSW ready to send
+            ResetRecovery, ///< Invalid CBW, both endpoints halted until `reset()`
+        };
+
+        enum class Stall : uint8_t { None, In, Out, Both };
+
+        BulkOnlyTransport(BlockDevice_t& device, const char* vendor = "usbstd", const char* product = "Mass Storage", const char* revision = "1.0")
+            : device_(device)
+        {
+            inquiry_.peripheral = 0x00;
+            inquiry_.rmb = 0x80;
+            inquiry_.version = 0x04;
+            inquiry_.responseDataFormat = 0x02;
+            inquiry_.additionalLength = sizeof(InquiryData) - 5;
+            pad(inquiry_.vendorId, sizeof(inquiry_.vendorId), vendor);
+            pad(inquiry_.productId, sizeof(inquiry_.productId), product);
+            pad(inquiry_.productRevision, sizeof(inquiry_.productRevision), revision);
+            reset();
+        }
+
+        /** Highest logical unit number, the response to GET_MAX_LUN
+        */
+        static constexpr uint8_t maxLun() { return 0; }
+
+        /** Bulk-Only Mass Storage Reset: abandon the current command and wait for a CBW
+         * @note Must not run concurrently with `process()`
+        */
+        void reset()
+        {
+            for (auto& state : state_)
+                state.store(Free, std::memory_order_relaxed);
+            usbIndex_ = storageIndex_ = 0;
+            aborted_.store(false, std::memory_order_relaxed);
+            phase_.store(Phase::Command, std::memory_order_release);
+        }
+
+        Phase phase() const { return phase_.load(std::memory_order_acquire); }
+
+        /// @{ USB side
+
+        /** Buffer for the next bulk OUT transfer
+         * @return CBW or data buffer, or an empty span when OUT should NAK
+        */
+        Span<uint8_t> rxBuffer()
+        {
+            const auto phase = this->phase();
+            if (phase == Phase::Command)
+                return { buffers_[0], BufferSize };
+            if ((phase == Phase::DataOut) && (bytesToUsb_ != 0))
+            {
+                const size_t index = usbIndex_;
+                uint8_t state = state_[index].load(std::memory_order_acquire);
+                if ((state == Free) && state_[index].compare_exchange_strong(state, Receiving, std::memory_order_acq_rel))
+                    state = Receiving;
+                if (state == Receiving)
+                    return { buffers_[index], (bytesToUsb_ < BufferSize) ? bytesToUsb_ : BufferSize };
+            }
+            return {};
+        }
+
+        /** Bulk OUT transfer of `length` bytes into the last `rxBuffer()` completed
+        */
+        void outComplete(size_t length)
+        {
+            const auto phase = this->phase();
+            if (phase == Phase::Command)
+            {
+                std::memcpy(&cbw_, buffers_[0], sizeof(cbw_));
+                const bool valid = (length == sizeof(CommandBlockWrapper)) && (cbw_.dCBWSignature == CommandBlockWrapper::Signature)
+                    && (cbw_.bCBWLUN <= maxLun()) && (cbw_.bCBWCBLength >= 1) && (cbw_.bCBWCBLength <= 16);
+                phase_.store(valid ? Phase::Decode : Phase::ResetRecovery, std::memory_order_release);
+            }
+            else if (phase == Phase::DataOut)
+            {
+                const size_t index = usbIndex_;
+                length_[index] = length;
+                bytesToUsb_ = (length < bytesToUsb_) ? (bytesToUsb_ - length) : 0;
+                usbIndex_ ^= 1;
+                state_[index].store(Ready, std::memory_order_release);
+            }
+        }
+
+        /** Data for the next bulk IN transfer, the same until `inComplete()`
+         * @return Data or CSW, or an empty span when IN should NAK
+        */
+        Span<const uint8_t> txBuffer()
+        {
+            const auto phase = this->phase();
+            if (phase == Phase::Status)
+                return { reinterpret_cast<const uint8_t*>(&csw_), sizeof(csw_) };
+            if (phase == Phase::DataIn)
+            {
+                const size_t index = usbIndex_;
+                uint8_t state = state_[index].load(std::memory_order_acquire);
+                if ((state == Ready) && state_[index].compare_exchange_strong(state, Sending, std::memory_order_acq_rel))
+                    state = Sending;
+                if (state == Sending)
+                    return { buffers_[index], length_[index] };
+
+                if (aborted_.load(std::memory_order_acquire))
+                {
+                    // Storage failed, halt IN; the CSW reports the bytes not sent
+                    csw_.dCSWDataResidue += static_cast<uint32_t>(bytesToUsb_);
+                    phase_.store(Phase::StallIn, std::memory_order_release);
+                }
+            }
+            return {};
+        }
+
+        /** Bulk IN transfer of `length` bytes from the last `txBuffer()` completed
+        */
+        void inComplete(size_t length)
+        {
+            const auto phase = this->phase();
+            if (phase == Phase::Status)
+                phase_.store(Phase::Command, std::memory_order_release);
+            else if (phase == Phase::DataIn)
+            {
+                const size_t index = usbIndex_;
+                bytesToUsb_ = (length < bytesToUsb_) ? (bytesToUsb_ - length) : 0;
+                usbIndex_ ^= 1;
+                state_[index].store(Free, std::memory_order_release);
+                if (bytesToUsb_ == 0)
+                    phase_.store(stallAfterData_ ? Phase::StallIn : Phase::Status, std::memory_order_release);
+            }
+        }
+
+        /** Endpoints the controller should halt
+        */
+        Stall stall() const
+        {
+            switch (phase())
+            {
+            case Phase::StallIn: return Stall::In;
+            case Phase::StallOut: return Stall::Out;
+            case Phase::ResetRecovery: return Stall::Both;
+            default: return Stall::None;
+            }
+        }
+
+        /** Host cleared the halt of a data-stage stall (CLEAR_FEATURE(ENDPOINT_HALT)), continue with the CSW
+        */
+        void clearHalt()
+        {
+            const auto phase = this->phase();
+            if ((phase == Phase::StallIn) || (phase == Phase::StallOut))
+                phase_.store(Phase::Status, std::memory_order_release);
+        }
+        ///@}
+
+        /// @{ Storage side
+
+        /** Decode commands and move block data between storage and the buffers
+         * @return `true` when any work was done
+        */
+        bool process()
+        {
+            const auto phase = this->phase();
+            if (phase == Phase::Decode)
+            {
+                decode();
+                return true;
+            }
+
+            bool worked = false;
+            if ((phase == Phase::DataIn) && (blocksToStorage_ != 0))
+            {
+                // Read ahead into every free buffer, in transfer order
+                while ((blocksToStorage_ != 0) && (state_[storageIndex_].load(std::memory_order_acquire) == Free))
+                {
+                    const uint32_t count = (blocksToStorage_ < blocksPerBuffer()) ? blocksToStorage_ : blocksPerBuffer();
+                    if (!device_.read(lba_, count, buffers_[storageIndex_]))
+                    {
+                        fail(SenseKey::MediumError, SenseCode::UnrecoveredReadError);
+                        blocksToStorage_ = 0;
+                        aborted_.store(true, std::memory_order_release);
+                        return true;
+                    }
+                    length_[storageIndex_] = size_t(count) * device_.blockSize();
+                    lba_ += count;
+                    blocksToStorage_ -= count;
+                    state_[storageIndex_].store(Ready, std::memory_order_release);
+                    storageIndex_ ^= 1;
+                    worked = true;
+                }
+            }
+            else if (phase == Phase::DataOut)
+            {
+                while ((blocksToStorage_ != 0) && (state_[storageIndex_].load(std::memory_order_acquire) == Ready))
+                {
+                    const uint32_t received = static_cast<uint32_t>(length_[storageIndex_] / device_.blockSize());
+                    const uint32_t count = (received < blocksToStorage_) ? received : blocksToStorage_;
+                    if (!failed_ && !device_.write(lba_, count, buffers_[storageIndex_]))
+                        fail(SenseKey::MediumError, SenseCode::WriteError); //< Keep accepting the data stage, report in the CSW
+                    lba_ += count;
+                    blocksToStorage_ -= count;
+                    state_[storageIndex_].store(Free, std::memory_order_release);
+                    storageIndex_ ^= 1;
+                    worked = true;
+
+                    if (received == 0)
+                        blocksToStorage_ = 0; //< Host ended the data stage short
+                }
+                if (blocksToStorage_ == 0)
+                {
+                    csw_.dCSWDataResidue = bytesToUsb_ + residueAfterData_;
+                    phase_.store(stallAfterData_ ? Phase::StallOut : Phase::Status, std::memory_order_release);
+                }
+            }
+            return worked;
+        }
+        ///@}
+
+    private:
+        enum : uint8_t { Free, Receiving, Ready, Sending };
+
+        static void pad(char* field, size_t size, const char* text)
+        {
+            std::memset(field, ' ', size);
+            for (size_t i = 0; (i < size) && (text[i] != '\0'); ++i)
+                field[i] = text[i];
+        }
+
+        uint32_t blocksPerBuffer() const { return static_cast<uint32_t>(BufferSize / device_.blockSize()); }
+
+        void fail(SenseKey key, SenseCode code)
+        {
+            senseKey_ = key;
+            senseCode_ = code;
+            failed_ = true;
+            csw_.bCSWStatus = CswStatus::Failed;
+        }
+
+        /** Fail a command before its data stage
+        */
+        void reject(SenseKey key, SenseCode code)
+        {
+            fail(key, code);
+            finish(cbw_.dCBWDataTransferLength);
+        }
+
+        /** End a command without (further) data: stall a data stage the host expected, then send the CSW
+        */
+        void finish(uint32_t residue)
+        {
+            csw_.dCSWDataResidue = residue;
+            const bool hostIn = (cbw_.bmCBWFlags & 0x80) != 0;
+            phase_.store((residue == 0) ? Phase::Status : (hostIn ? Phase::StallIn : Phase::StallOut), std::memory_order_release);
+        }
+
+        /** Send `length` bytes prepared in the first buffer as the data stage
+        */
+        void respond(size_t length)
+        {
+            const uint32_t expected = cbw_.dCBWDataTransferLength;
+            if ((expected != 0) && ((cbw_.bmCBWFlags & 0x80) == 0))
+            {
+                csw_.bCSWStatus = CswStatus::PhaseError; //< Host sends data the device wants to send (case 10)
+                finish(expected);
+                return;
+            }
+            const size_t sent = (length < expected) ? length : expected;
+            if (sent == 0)
+            {
+                finish(expected);
+                return;
+            }
+            length_[0] = sent;
+            bytesToUsb_ = sent;
+            blocksToStorage_ = 0;
+            stallAfterData_ = (sent < expected);
+            csw_.dCSWDataResidue = static_cast<uint32_t>(expected - sent);
+            state_[0].store(Ready, std::memory_order_release);
+            phase_.store(Phase::DataIn, std::memory_order_release);
+        }
+
+        /** Set up READ(10) or WRITE(10), with the thirteen host/device expectation cases of BOT 6.7
+        */
+        void transfer(const ScsiCommand& command, bool write)
+        {
+            const uint32_t expected = cbw_.dCBWDataTransferLength;
+            const bool hostIn = (cbw_.bmCBWFlags & 0x80) != 0;
+            const uint64_t bytes = uint64_t(command.blocks) * device_.blockSize();
+
+            if (!device_.ready())
+                return reject(SenseKey::NotReady, SenseCode::MediumNotPresent);
+            if (write && device_.writeProtected())
+                return reject(SenseKey::DataProtect, SenseCode::WriteProtected);
+            if (uint64_t(command.lba) + command.blocks > device_.blockCount())
+                return reject(SenseKey::IllegalRequest, SenseCode::LbaOutOfRange);
+            if (((expected != 0) && (hostIn == write)) || (bytes > expected))
+            {
+                csw_.bCSWStatus = CswStatus::PhaseError; //< Wrong direction or host expects less than the device moves
+                return finish(expected);
+            }
+            if (bytes == 0)
+                return finish(expected);
+
+            lba_ = command.lba;
+            blocksToStorage_ = command.blocks;
+            bytesToUsb_ = static_cast<size_t>(bytes);
+            stallAfterData_ = (bytes < expected);
+            residueAfterData_ = static_cast<uint32_t>(expected - bytes);
+            csw_.dCSWDataResidue = residueAfterData_;
+            aborted_.store(false, std::memory_order_relaxed);
+            phase_.store(write ? Phase::DataOut : Phase::DataIn, std::memory_order_release);
+        }
+
+        void decode()
+        {
+            // The USB side leaves the buffers alone until the phase is published
+            for (auto& state : state_)
+                state.store(Free, std::memory_order_relaxed);
+            usbIndex_ = storageIndex_ = 0;
+
+            csw_ = { CommandStatusWrapper::Signature, cbw_.dCBWTag, 0, CswStatus::Passed };
+            failed_ = false;
+            stallAfterData_ = false;
+            residueAfterData_ = 0;
+
+            const auto command = ScsiCommand::decode(cbw_.CBWCB);
+            const uint32_t expected = cbw_.dCBWDataTransferLength;
+            uint8_t* response = buffers_[0];
+            const auto keep = [](size_t length, uint16_t allocation) { return (length < allocation) ? length : allocation; };
+
+            if (command.opcode != ScsiOpcode::RequestSense)
+            {
+                senseKey_ = SenseKey::NoSense;
+                senseCode_ = SenseCode::None;
+            }
+
+            switch (command.opcode)
+            {
+            case ScsiOpcode::TestUnitReady:
+                if (!device_.ready())
+                    fail(SenseKey::NotReady, SenseCode::MediumNotPresent);
+                return finish(expected);
+
+            case ScsiOpcode::RequestSense:
+            {
+                SenseData sense = {};
+                sense.responseCode = 0x70;
+                sense.senseKey = static_cast<uint8_t>(senseKey_);
+                sense.additionalLength = sizeof(SenseData) - 8;
+                sense.asc = static_cast<uint8_t>(static_cast<uint16_t>(senseCode_) >> 8);
+                sense.ascq = static_cast<uint8_t>(senseCode_);
+                std::memcpy(response, &sense, sizeof(sense));
+                senseKey_ = SenseKey::NoSense;
+                senseCode_ = SenseCode::None;
+                return respond(keep(sizeof(sense), command.allocationLength));
+            }
+
+            case ScsiOpcode::Inquiry:
+                if ((cbw_.CBWCB[1] & 0x01) != 0) //< Vital product data pages are not supported
+                    return reject(SenseKey::IllegalRequest, SenseCode::InvalidFieldInCdb);
+                std::memcpy(response, &inquiry_, sizeof(inquiry_));
+                return respond(keep(sizeof(inquiry_), command.allocationLength));
+
+            case ScsiOpcode::ModeSense6:
+            {
+                const uint8_t header[4] = { 3, 0, static_cast<uint8_t>(device_.writeProtected() ? 0x80 : 0x00), 0 };
+                std::memcpy(response, header, sizeof(header));
+                return respond(keep(sizeof(header), command.allocationLength));
+            }
+
+            case ScsiOpcode::ModeSense10:
+            {
+                const uint8_t header[8] = { 0, 6, 0, static_cast<uint8_t>(device_.writeProtected() ? 0x80 : 0x00), 0, 0, 0, 0 };
+                std::memcpy(response, header, sizeof(header));
+                return respond(keep(sizeof(header), command.allocationLength));
+            }
+
+            case ScsiOpcode::ReadCapacity10:
+            {
+                if (!device_.ready())
+                    return reject(SenseKey::NotReady, SenseCode::MediumNotPresent);
+                ReadCapacity10Data capacity = {};
+                storeBe32(capacity.lastLba, device_.blockCount() - 1);
+                storeBe32(capacity.blockLength, device_.blockSize());
+                std::memcpy(response, &capacity, sizeof(capacity));
+                return respond(sizeof(capacity));
+            }
+
+            case ScsiOpcode::ReadFormatCapacities:
+            {
+                FormatCapacityList list = {};
+                list.listLength = 8;
+                storeBe32(list.blockCount, device_.blockCount());
+                list.descriptorType = 0x02;
+                list.blockLength[0] = static_cast<uint8_t>(device_.blockSize() >> 16);
+                storeBe16(&list.blockLength[1], static_cast<uint16_t>(device_.blockSize()));
+                std::memcpy(response, &list, sizeof(list));
+                return respond(keep(sizeof(list), command.allocationLength));
+            }
+
+            case ScsiOpcode::Read10:
+                return transfer(command, false);
+
+            case ScsiOpcode::Write10:
+                return transfer(command, true);
+
+            case ScsiOpcode::SynchronizeCache10:
+                if (!device_.flush())
+                    fail(SenseKey::MediumError, SenseCode::WriteError);
+                return finish(expected);
+
+            case ScsiOpcode::StartStopUnit:
+            case ScsiOpcode::PreventAllowMediumRemoval:
+            case ScsiOpcode::Verify10:
+                return finish(expected);
+
+            default:
+                return reject(SenseKey::IllegalRequest, SenseCode::InvalidCommandOperationCode);
+            }
+        }
+
+        BlockDevice_t& device_;
+
+        alignas(USBSTD_CACHE_LINE_SIZE) uint8_t buffers_[2][BufferSize] = {};
+        size_t length_[2] = {}; ///< Valid bytes of a Ready buffer
+        std::atomic<uint8_t> state_[2] = {}; ///< `Free`, `Receiving`, `Ready` or `Sending`
+        std::atomic<Phase> phase_ = { Phase::Command };
+        std::atomic<bool> aborted_ = { false }; ///< Storage failed during DataIn
+
+        // USB side
+        size_t usbIndex_ = 0;
+        size_t bytesToUsb_ = 0;
+
+        // Storage side
+        size_t storageIndex_ = 0;
+        uint32_t lba_ = 0;
+        uint32_t blocksToStorage_ = 0;
+
+        // Command state, written by `decode()` before the phase is published
+        CommandBlockWrapper cbw_ = {};
+        CommandStatusWrapper csw_ = {};
+        InquiryData inquiry_ = {};
+        SenseKey senseKey_ = SenseKey::NoSense;
+        SenseCode senseCode_ = SenseCode::None;
+        bool failed_ = false;
+        bool stallAfterData_ = false;
+        uint32_t residueAfterData_ = 0;
+    };
+
+} //END: msc
+} //END: usbstd
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include <cstdint>
 
+#include "usb_endian.hpp"
+
 namespace usbstd
 {
 #pragma pack(push, 1)
@@ -9,9 +11,13 @@ namespace usbstd
 	{
 		uint8_t   bmRequestType;
 		uint8_t   bRequest;
-		uint16_t  wValue;
-		uint16_t  wIndex;
-		uint16_t  wLength;
+		Le16      wValue;
+		Le16      wIndex;
+		Le16      wLength;
+
+		constexpr uint8_t direction() const { return bmRequestType >> 7; } ///< Data stage direction, `USB_OUT_TRANSFER` or `USB_IN_TRANSFER`
+		constexpr uint8_t type() const { return (bmRequestType >> 5) & 0x03; } ///< `USB_STANDARD_REQUEST`, `USB_CLASS_REQUEST` or `USB_VENDOR_REQUEST`
+		constexpr uint8_t recipient() const { return bmRequestType & 0x1f; } ///< `USB_RECIPIENT_DEVICE`, `USB_RECIPIENT_INTERFACE`, `USB_RECIPIENT_ENDPOINT` or `USB_RECIPIENT_OTHER`
 	};
 
 
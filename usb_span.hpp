@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef> //< size_t
+#include <type_traits> //< std::remove_const_t, std::enable_if_t
+#include <utility> //< std::declval
+
+namespace usbstd {
+
+    /** Non-owning view of a contiguous sequence, a minimal C++17 stand-in for `std::span`
+     * @tparam  T  Element type, `const` qualified for read-only views
+    */
+    template<typename T>
+    class Span
+    {
+    public:
+        using element_type = T;
+        using value_type = std::remove_const_t<T>;
+        using iterator = T*;
+
+        constexpr Span() = default;
+        constexpr Span(T* data, size_t size) : data_(data), size_(size) {}
+        constexpr Span(T* begin, T* end) : data_(begin), size_(static_cast<size_t>(end - begin)) {}
+
+        template<size_t N>
+        constexpr Span(T(&array)[N]) : data_(array), size_(N) {}
+
+        /** Allow `Span<T>` to convert to `Span<const T>`
+        */
+        template<typename U, typename = std::enable_if_t<std::is_convertible_v<U(*)[], T(*)[]>>>
+        constexpr Span(const Span<U>& other) : data_(other.data()), size_(other.size()) {}
+
+        /** Construct from any contiguous container providing `data()` and `size()`, e.g. `std::array`
+        */
+        template<typename Container_t, typename = decltype(std::declval<Container_t&>().data())
+            , typename = std::enable_if_t<!std::is_same_v<std::decay_t<Container_t>, Span>>>
+        constexpr Span(Container_t& container) : data_(container.data()), size_(container.size()) {}
+
+        constexpr T* data() const { return data_; }
+        constexpr size_t size() const { return size_; }
+        constexpr size_t size_bytes() const { return size_ * sizeof(T); }
+        constexpr bool empty() const { return size_ == 0; }
+
+        constexpr T& operator[](size_t index) const { return data_[index]; }
+        constexpr T* begin() const { return data_; }
+        constexpr T* end() const { return data_ + size_; }
+
+        constexpr Span first(size_t count) const { return { data_, count }; }
+        constexpr Span last(size_t count) const { return { data_ + (size_ - count), count }; }
+        constexpr Span subspan(size_t offset) const { return { data_ + offset, size_ - offset }; }
+        constexpr Span subspan(size_t offset, size_t count) const { return { data_ + offset, count }; }
+
+    private:
+        T* data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+} //END: usbstd
\ No newline at end of file
@@ -27,6 +27,14 @@ namespace usbstd
 		USB_VENDOR_REQUEST = 2,
 	};
 
+	enum
+	{
+		USB_RECIPIENT_DEVICE = 0,
+		USB_RECIPIENT_INTERFACE = 1,
+		USB_RECIPIENT_ENDPOINT = 2,
+		USB_RECIPIENT_OTHER = 3,
+	};
+
 	enum
 	{
 		USB_OUT_TRANSFER = 0,